@@ -0,0 +1,32 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+int main(int argc, char *argv[])
+{
+	// Nothing is logged on the hot paths with the default log level. Informational messages of the setup would
+	// mix with the results on stdout.
+	spdlog::set_level(spdlog::level::warn);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	error_code error;
+	remove_all(bench_data_temp_path, error);
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_util.h"
+#include "devices/device_factory.h"
+#include "bench/bench_shared.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <unistd.h>
+
+using namespace std;
+using namespace filesystem;
+
+const path bench_data_temp_path(temp_directory_path() /
+		path(fmt::format("piscsi-bench-{}", getpid()))); // NOSONAR Publicly writable directory is fine here
+
+path CreateImageFile(const string& filename, size_t size)
+{
+	create_directories(bench_data_temp_path);
+
+	const path image = bench_data_temp_path / path(filename);
+	if (exists(image) && file_size(image) == size) {
+		return image;
+	}
+
+	ofstream out(image, ios::binary | ios::trunc);
+	vector<char> data(1024 * 1024);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<char>(i);
+	}
+	for (size_t written = 0; written < size; written += data.size()) {
+		out.write(data.data(), static_cast<streamsize>(min(data.size(), size - written)));
+	}
+
+	return image;
+}
+
+shared_ptr<StorageDevice> CreateHardDisk(const path& image)
+{
+	auto device = dynamic_pointer_cast<StorageDevice>(DeviceFactory().CreateDevice(SCHD, 0, image.string()));
+	device->SetFilename(image.string());
+	device->Open();
+	device->Init({});
+
+	return device;
+}
+
+vector<uint64_t> CreateZipfSequence(uint64_t n, double s, size_t count, mt19937_64& generator)
+{
+	vector<double> cdf(n);
+	double sum = 0;
+	for (uint64_t i = 0; i < n; i++) {
+		sum += 1.0 / pow(static_cast<double>(i + 1), s);
+		cdf[i] = sum;
+	}
+
+	uniform_real_distribution<double> distribution(0, sum);
+	vector<uint64_t> sequence(count);
+	for (auto& value : sequence) {
+		value = static_cast<uint64_t>(ranges::lower_bound(cdf, distribution(generator)) - cdf.begin());
+		value = min(value, n - 1);
+	}
+
+	// Spread the hot values across the whole range instead of having them all at the beginning
+	const uint64_t stride = 7919;
+	for (auto& value : sequence) {
+		value = (value * stride) % n;
+	}
+
+	return sequence;
+}
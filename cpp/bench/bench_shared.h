@@ -0,0 +1,30 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "devices/storage_device.h"
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace filesystem;
+
+extern const path bench_data_temp_path;
+
+// Creates an image file of the given size in the temporary directory, which is removed on exit
+path CreateImageFile(const string&, size_t);
+
+// A hard disk with a 512 bytes sector size, for an image file created by CreateImageFile()
+shared_ptr<StorageDevice> CreateHardDisk(const path&);
+
+// Zipf-distributed values from 0 to n - 1, with s being the exponent
+vector<uint64_t> CreateZipfSequence(uint64_t, double, size_t, mt19937_64&);
@@ -0,0 +1,110 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The selection-to-BSY latency, i.e. the time from passing the selection phase data byte to the routing until
+// the selected target asserts BSY. Only this time is reported, the remaining command is not part of the
+// measurement. The routing of ControllerManager is compared with the former search of a hash map.
+//
+//---------------------------------------------------------------------------
+
+#include "controllers/controller_manager.h"
+#include "controllers/scsi_controller.h"
+#include "test/bench_bus.h"
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+#include <unordered_map>
+
+using namespace std;
+
+static const int INITIATOR_ID = 7;
+
+static const vector<uint8_t> TEST_UNIT_READY = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static bool SetIterationTime(benchmark::State& state, const BenchBus& bus, uint64_t start)
+{
+	if (bus.GetBsyTicks() < start) {
+		state.SkipWithError("The target did not respond to the selection");
+		return false;
+	}
+
+	state.SetIterationTime(chrono::duration<double>(TickCounter::ToDuration(bus.GetBsyTicks() - start)).count());
+
+	return true;
+}
+
+// The served IDs are a bitmask, the data byte is decoded with an AND and a count of the trailing zeroes.
+// The argument is the number of targets, the one with the highest ID is selected.
+static void BM_SelectionToBsy_IdBitmask(benchmark::State& state)
+{
+	ScsiController::SetMinExecTime(0);
+
+	const path image = CreateImageFile("selection.hds", 1024 * 1024);
+	BenchBus bus;
+	ControllerManager controller_manager;
+	const auto targets = static_cast<int>(state.range(0));
+	vector<shared_ptr<StorageDevice>> devices;
+	for (int id = 0; id < targets; id++) {
+		devices.push_back(CreateHardDisk(image));
+		controller_manager.AttachToController(bus, id, devices.back());
+	}
+
+	const int id_data = (1 << INITIATOR_ID) | (1 << (targets - 1));
+
+	for (auto _ : state) {
+		bus.Select(id_data, TEST_UNIT_READY);
+		const uint64_t start = TickCounter::Now();
+		controller_manager.ProcessOnController(bus.GetDAT());
+		if (!SetIterationTime(state, bus, start)) {
+			break;
+		}
+	}
+
+	for (const auto& device : devices) {
+		device->CleanUp();
+	}
+}
+BENCHMARK(BM_SelectionToBsy_IdBitmask)->Arg(1)->Arg(7)->UseManualTime();
+
+// The routing before the ID bitmask: The controllers were mapped to their IDs, and the first one with its
+// ID bit set in the data byte was searched for
+static void BM_SelectionToBsy_HashMap(benchmark::State& state)
+{
+	ScsiController::SetMinExecTime(0);
+
+	const path image = CreateImageFile("selection.hds", 1024 * 1024);
+	BenchBus bus;
+	ControllerManager controller_manager;
+	const auto targets = static_cast<int>(state.range(0));
+	vector<shared_ptr<StorageDevice>> devices;
+	// The controllers are set up like for the ID bitmask, i.e. only the routing differs
+	unordered_map<int, shared_ptr<AbstractController>> controllers;
+	for (int id = 0; id < targets; id++) {
+		devices.push_back(CreateHardDisk(image));
+		controller_manager.AttachToController(bus, id, devices.back());
+		controllers[id] = controller_manager.FindController(id);
+	}
+
+	const int id_data = (1 << INITIATOR_ID) | (1 << (targets - 1));
+
+	for (auto _ : state) {
+		bus.Select(id_data, TEST_UNIT_READY);
+		const uint64_t start = TickCounter::Now();
+		const int data = bus.GetDAT();
+		if (const auto& it = ranges::find_if(controllers, [&data] (const auto& c) { return data & (1 << c.first); });
+			it != controllers.end()) {
+			it->second->ProcessOnController(data);
+		}
+		if (!SetIterationTime(state, bus, start)) {
+			break;
+		}
+	}
+
+	for (const auto& device : devices) {
+		device->CleanUp();
+	}
+}
+BENCHMARK(BM_SelectionToBsy_HashMap)->Arg(1)->Arg(7)->UseManualTime();
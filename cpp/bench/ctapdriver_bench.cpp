@@ -0,0 +1,56 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "devices/ctapdriver.h"
+#include <benchmark/benchmark.h>
+#include <numeric>
+
+using namespace std;
+
+static void Crc32(benchmark::State& state, uint32_t (*crc32)(span<const uint8_t>))
+{
+	vector<uint8_t> frame(state.range(0));
+	iota(frame.begin(), frame.end(), 0);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(crc32(frame));
+	}
+
+	state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+// The frame sizes are a minimum frame, a standard frame and a jumbo frame
+static void BM_CTapDriver_Crc32(benchmark::State& state)
+{
+	Crc32(state, &CTapDriver::Crc32);
+}
+BENCHMARK(BM_CTapDriver_Crc32)->Arg(60)->Arg(1514)->Arg(9000);
+
+static void BM_CTapDriver_Crc32Bitwise(benchmark::State& state)
+{
+	Crc32(state, &CTapDriver::Crc32Bitwise);
+}
+BENCHMARK(BM_CTapDriver_Crc32Bitwise)->Arg(60)->Arg(1514)->Arg(9000);
+
+static void BM_CTapDriver_Crc32Table(benchmark::State& state)
+{
+	Crc32(state, &CTapDriver::Crc32Table);
+}
+BENCHMARK(BM_CTapDriver_Crc32Table)->Arg(60)->Arg(1514)->Arg(9000);
+
+static void BM_CTapDriver_Crc32Hardware(benchmark::State& state)
+{
+	if (!CTapDriver::HasHardwareCrc32()) {
+		state.SkipWithError("The CPU does not support the CRC32 instructions");
+		return;
+	}
+
+	Crc32(state, &CTapDriver::Crc32Hardware);
+}
+BENCHMARK(BM_CTapDriver_Crc32Hardware)->Arg(60)->Arg(1514)->Arg(9000);
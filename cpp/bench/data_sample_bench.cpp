@@ -0,0 +1,41 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Decoding of raw GPIO samples for each connection type. The pins are compile-time constants in each
+// instance, so the connection types must not differ from each other and from a build with just one
+// CONNECT_TYPE.
+//
+//---------------------------------------------------------------------------
+
+#include "hal/data_sample_raspberry.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace std;
+
+template <typename C>
+static void BM_DataSample_Decode(benchmark::State& state)
+{
+	mt19937 generator(0);
+	vector<uint32_t> samples(1024);
+	ranges::generate(samples, generator);
+
+	size_t i = 0;
+	for (auto _ : state) {
+		const DataSample_Raspberry<C> sample(samples[i], 0);
+		benchmark::DoNotOptimize(sample.GetPhase());
+		benchmark::DoNotOptimize(sample.GetDAT());
+		i = (i + 1) % samples.size();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_DataSample_Decode, ConnectionStandard);
+BENCHMARK_TEMPLATE(BM_DataSample_Decode, ConnectionFullspec);
+BENCHMARK_TEMPLATE(BM_DataSample_Decode, ConnectionAibom);
+BENCHMARK_TEMPLATE(BM_DataSample_Decode, ConnectionGamernium);
+BENCHMARK_TEMPLATE(BM_DataSample_Decode, DefaultConnection);
@@ -0,0 +1,48 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The cost of a trace message per transferred block with the default log level, i.e. with trace logging disabled
+//
+//---------------------------------------------------------------------------
+
+#include "devices/device_logger.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using namespace std;
+
+// The message is built before the level is checked
+static void BM_DeviceLogger_TraceEager(benchmark::State& state)
+{
+	DeviceLogger logger;
+	logger.SetIdAndLun(0, 0);
+
+	uint64_t block = 0;
+	for (auto _ : state) {
+		logger.Trace("Transferring block " + to_string(block) + ", length is " + to_string(512));
+		benchmark::DoNotOptimize(++block);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeviceLogger_TraceEager);
+
+// The message is only formatted if the level is enabled
+static void BM_DeviceLogger_TraceLazy(benchmark::State& state)
+{
+	DeviceLogger logger;
+	logger.SetIdAndLun(0, 0);
+
+	uint64_t block = 0;
+	for (auto _ : state) {
+		logger.Trace("Transferring block {0}, length is {1}", block, 512);
+		benchmark::DoNotOptimize(++block);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeviceLogger_TraceLazy);
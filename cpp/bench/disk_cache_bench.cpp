@@ -0,0 +1,135 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// DiskCache sector access with different access patterns. The cache holds 16 tracks of 256 sectors, the
+// image is much larger, i.e. misses load (and for modified tracks save) DiskTrack instances.
+//
+//---------------------------------------------------------------------------
+
+#include "devices/disk_track.h"
+#include "devices/disk_cache.h"
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+
+using namespace std;
+
+static const int SECTOR_SIZE_SHIFT = 9;
+static const uint64_t SECTOR_COUNT = 64 * 1024;
+static const uint64_t SECTORS_PER_TRACK = 256;
+
+enum class access_pattern { sequential, random, zipf };
+
+static vector<uint64_t> CreateSequence(access_pattern pattern, uint64_t count)
+{
+	mt19937_64 generator(0);
+
+	switch (pattern) {
+		case access_pattern::random: {
+			uniform_int_distribution<uint64_t> distribution(0, SECTOR_COUNT - 1);
+			vector<uint64_t> sequence(count);
+			ranges::generate(sequence, [&] { return distribution(generator); });
+			return sequence;
+		}
+
+		case access_pattern::zipf:
+			return CreateZipfSequence(SECTOR_COUNT, 1.0, count, generator);
+
+		default: {
+			vector<uint64_t> sequence(count);
+			for (uint64_t i = 0; i < count; i++) {
+				sequence[i] = i % SECTOR_COUNT;
+			}
+			return sequence;
+		}
+	}
+}
+
+static void BM_DiskCache_Read(benchmark::State& state, access_pattern pattern)
+{
+	const path image = CreateImageFile("disk_cache.hds", SECTOR_COUNT << SECTOR_SIZE_SHIFT);
+	MetricsRegistry metrics;
+	DiskCache cache(metrics, image.string(), SECTOR_SIZE_SHIFT, SECTOR_COUNT);
+	const auto sequence = CreateSequence(pattern, SECTOR_COUNT);
+	vector<uint8_t> buf(1 << SECTOR_SIZE_SHIFT);
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(cache.ReadSector(buf, sequence[i]));
+		i = (i + 1) % sequence.size();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * buf.size());
+}
+BENCHMARK_CAPTURE(BM_DiskCache_Read, sequential, access_pattern::sequential);
+BENCHMARK_CAPTURE(BM_DiskCache_Read, random, access_pattern::random);
+BENCHMARK_CAPTURE(BM_DiskCache_Read, zipf, access_pattern::zipf);
+
+static void BM_DiskCache_Write(benchmark::State& state, access_pattern pattern)
+{
+	const path image = CreateImageFile("disk_cache.hds", SECTOR_COUNT << SECTOR_SIZE_SHIFT);
+	MetricsRegistry metrics;
+	DiskCache cache(metrics, image.string(), SECTOR_SIZE_SHIFT, SECTOR_COUNT);
+	const auto sequence = CreateSequence(pattern, SECTOR_COUNT);
+	const vector<uint8_t> buf(1 << SECTOR_SIZE_SHIFT, 0x55);
+
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(cache.WriteSector(buf, sequence[i]));
+		i = (i + 1) % sequence.size();
+	}
+
+	// Not timed, this is after the loop
+	cache.Save();
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * buf.size());
+}
+BENCHMARK_CAPTURE(BM_DiskCache_Write, sequential, access_pattern::sequential);
+BENCHMARK_CAPTURE(BM_DiskCache_Write, random, access_pattern::random);
+BENCHMARK_CAPTURE(BM_DiskCache_Write, zipf, access_pattern::zipf);
+
+// DiskTrack::Load() is private, it is measured by reading one sector of each track, i.e. each access is a miss
+static void BM_DiskTrack_Load(benchmark::State& state)
+{
+	const path image = CreateImageFile("disk_cache.hds", SECTOR_COUNT << SECTOR_SIZE_SHIFT);
+	MetricsRegistry metrics;
+	DiskCache cache(metrics, image.string(), SECTOR_SIZE_SHIFT, SECTOR_COUNT);
+	vector<uint8_t> buf(1 << SECTOR_SIZE_SHIFT);
+
+	uint64_t sector = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(cache.ReadSector(buf, sector));
+		sector = (sector + SECTORS_PER_TRACK) % SECTOR_COUNT;
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * (SECTORS_PER_TRACK << SECTOR_SIZE_SHIFT));
+}
+BENCHMARK(BM_DiskTrack_Load);
+
+// Writing one sector of each track means that each access evicts a modified track, i.e. a DiskTrack::Save()
+// plus a DiskTrack::Load()
+static void BM_DiskTrack_Save(benchmark::State& state)
+{
+	const path image = CreateImageFile("disk_cache.hds", SECTOR_COUNT << SECTOR_SIZE_SHIFT);
+	MetricsRegistry metrics;
+	DiskCache cache(metrics, image.string(), SECTOR_SIZE_SHIFT, SECTOR_COUNT);
+	const vector<uint8_t> buf(1 << SECTOR_SIZE_SHIFT, 0xaa);
+
+	uint64_t sector = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(cache.WriteSector(buf, sector));
+		sector = (sector + SECTORS_PER_TRACK) % SECTOR_COUNT;
+	}
+
+	// Not timed, this is after the loop
+	cache.Save();
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DiskTrack_Save);
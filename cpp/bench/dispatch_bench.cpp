@@ -0,0 +1,146 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Command dispatch and mode page generation, without any phase handling or data transfer
+//
+//---------------------------------------------------------------------------
+
+#include "controllers/scsi_controller.h"
+#include "test/bench_bus.h"
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <functional>
+
+using namespace std;
+using namespace scsi_defs;
+
+namespace
+{
+	// The phases following the command execution are not part of the dispatch
+	class BenchController : public ScsiController
+	{
+
+	public:
+
+		using ScsiController::ScsiController;
+		using AbstractController::SetCmdByte;
+
+		void Status() override {
+			// Not part of the dispatch
+		}
+		void DataIn() override {
+			// Not part of the dispatch
+		}
+		void DataOut() override {
+			// Not part of the dispatch
+		}
+	};
+}
+
+static void BM_PrimaryDevice_Dispatch(benchmark::State& state, scsi_command cmd, const vector<int>& cdb)
+{
+	const path image = CreateImageFile("dispatch.hds", 16 * 1024 * 1024);
+	BenchBus bus;
+	BenchController controller(bus, 0);
+	const auto device = CreateHardDisk(image);
+	controller.AddDevice(device);
+
+	controller.SetCmdByte(0, static_cast<int>(cmd));
+	for (size_t i = 0; i < cdb.size(); i++) {
+		controller.SetCmdByte(static_cast<int>(i) + 1, cdb[i]);
+	}
+
+	for (auto _ : state) {
+		device->Dispatch(cmd);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+
+	device->CleanUp();
+}
+BENCHMARK_CAPTURE(BM_PrimaryDevice_Dispatch, TestUnitReady, scsi_command::eCmdTestUnitReady, vector<int>{});
+BENCHMARK_CAPTURE(BM_PrimaryDevice_Dispatch, Inquiry, scsi_command::eCmdInquiry, vector<int>{ 0, 0, 0, 255 });
+BENCHMARK_CAPTURE(BM_PrimaryDevice_Dispatch, RequestSense, scsi_command::eCmdRequestSense, vector<int>{ 0, 0, 0, 255 });
+BENCHMARK_CAPTURE(BM_PrimaryDevice_Dispatch, Read10, scsi_command::eCmdRead10,
+		vector<int>{ 0, 0, 0, 0x10, 0, 0, 0, 8 });
+BENCHMARK_CAPTURE(BM_PrimaryDevice_Dispatch, Write10, scsi_command::eCmdWrite10,
+		vector<int>{ 0, 0, 0, 0x10, 0, 0, 0, 8 });
+
+// All pages (0x3f) with the current values
+static void BM_ModePageDevice_ModeSense(benchmark::State& state, scsi_command cmd, const vector<int>& cdb)
+{
+	BM_PrimaryDevice_Dispatch(state, cmd, cdb);
+}
+BENCHMARK_CAPTURE(BM_ModePageDevice_ModeSense, ModeSense6_AllPages, scsi_command::eCmdModeSense6,
+		vector<int>{ 0, 0x3f, 0, 255 });
+BENCHMARK_CAPTURE(BM_ModePageDevice_ModeSense, ModeSense10_AllPages, scsi_command::eCmdModeSense10,
+		vector<int>{ 0, 0x3f, 0, 0, 0, 0, 0x10, 0 });
+BENCHMARK_CAPTURE(BM_ModePageDevice_ModeSense, ModeSense6_CachingPage, scsi_command::eCmdModeSense6,
+		vector<int>{ 0, 0x08, 0, 255 });
+
+// The dispatch mechanism alone, with trivial handlers: The opcode indexed table of PrimaryDevice compared to
+// a switch statement as the baseline. The opcodes are alternated in order to not only measure a predicted branch.
+static const array<scsi_command, 4> DISPATCH_OPCODES = { scsi_command::eCmdTestUnitReady, scsi_command::eCmdRead10,
+		scsi_command::eCmdInquiry, scsi_command::eCmdWrite10 };
+
+static void BM_Dispatch_Table(benchmark::State& state)
+{
+	array<function<void()>, 256> commands = {};
+	array<int, 4> counters = {};
+	commands[static_cast<int>(scsi_command::eCmdTestUnitReady)] = [&counters] { ++counters[0]; };
+	commands[static_cast<int>(scsi_command::eCmdRead10)] = [&counters] { ++counters[1]; };
+	commands[static_cast<int>(scsi_command::eCmdInquiry)] = [&counters] { ++counters[2]; };
+	commands[static_cast<int>(scsi_command::eCmdWrite10)] = [&counters] { ++counters[3]; };
+
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto cmd = DISPATCH_OPCODES[i++ % DISPATCH_OPCODES.size()];
+		if (const auto& execute = commands[static_cast<int>(cmd)]; execute) {
+			execute();
+		}
+		benchmark::DoNotOptimize(counters);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Dispatch_Table);
+
+static void BM_Dispatch_Switch(benchmark::State& state)
+{
+	array<int, 4> counters = {};
+
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto cmd = DISPATCH_OPCODES[i++ % DISPATCH_OPCODES.size()];
+		benchmark::DoNotOptimize(cmd);
+		switch (cmd) {
+			case scsi_command::eCmdTestUnitReady:
+				++counters[0];
+				break;
+
+			case scsi_command::eCmdRead10:
+				++counters[1];
+				break;
+
+			case scsi_command::eCmdInquiry:
+				++counters[2];
+				break;
+
+			case scsi_command::eCmdWrite10:
+				++counters[3];
+				break;
+
+			default:
+				break;
+		}
+		benchmark::DoNotOptimize(counters);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Dispatch_Switch);
@@ -0,0 +1,84 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The GPIO code paths of each connection type, with the GPIO registers emulated in memory. The connection type
+// selected at startup only picks the template instance, the pins of each instance are compile-time constants
+// like with a connection type selected at build time. The build default (DefaultConnection) is what a binary
+// built for a single connection type executes, the other instances are expected to be as fast.
+//
+//---------------------------------------------------------------------------
+
+#include "hal/gpiobus_raspberry.h"
+#include <benchmark/benchmark.h>
+
+using namespace std;
+
+namespace
+{
+	template <typename C>
+	class BenchGpiobusRaspberry : public GPIOBUS_RaspberryConnection<C>
+	{
+
+	public:
+
+		BenchGpiobusRaspberry() {
+			this->gpio = registers.data();
+			this->level = &registers[GPIOBUS_Raspberry::GPIO_LEV_0];
+			BuildTables();
+		}
+		~BenchGpiobusRaspberry() override = default;
+
+		void BuildTables() { this->MakeTable(); }
+
+	private:
+
+		array<uint32_t, 64> registers = {};
+	};
+}
+
+template <typename C>
+static void BM_GpiobusRaspberry_MakeTable(benchmark::State& state)
+{
+	BenchGpiobusRaspberry<C> bus;
+
+	for (auto _ : state) {
+		bus.BuildTables();
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(BM_GpiobusRaspberry_MakeTable<DefaultConnection>);
+BENCHMARK(BM_GpiobusRaspberry_MakeTable<ConnectionStandard>);
+BENCHMARK(BM_GpiobusRaspberry_MakeTable<ConnectionFullspec>);
+BENCHMARK(BM_GpiobusRaspberry_MakeTable<ConnectionAibom>);
+BENCHMARK(BM_GpiobusRaspberry_MakeTable<ConnectionGamernium>);
+
+// The target side of a byte-wise DATA IN handshake without waiting for the initiator, called through BUS like
+// the controllers do
+template <typename C>
+static void BM_GpiobusRaspberry_Handshake(benchmark::State& state)
+{
+	BenchGpiobusRaspberry<C> b;
+	BUS& bus = b;
+
+	uint8_t data = 0;
+	for (auto _ : state) {
+		bus.SetDAT(data++);
+		bus.SetREQ(true);
+		bus.Acquire();
+		benchmark::DoNotOptimize(bus.GetACK());
+		bus.SetREQ(false);
+		bus.Acquire();
+		benchmark::DoNotOptimize(bus.GetACK());
+	}
+
+	state.SetBytesProcessed(state.iterations());
+}
+BENCHMARK(BM_GpiobusRaspberry_Handshake<DefaultConnection>);
+BENCHMARK(BM_GpiobusRaspberry_Handshake<ConnectionStandard>);
+BENCHMARK(BM_GpiobusRaspberry_Handshake<ConnectionFullspec>);
+BENCHMARK(BM_GpiobusRaspberry_Handshake<ConnectionAibom>);
+BENCHMARK(BM_GpiobusRaspberry_Handshake<ConnectionGamernium>);
@@ -0,0 +1,67 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Complete commands, from the selection to the bus free phase, processed by ScsiController. The bus does not
+// cost anything, i.e. this is the processing overhead of piscsi for each command. The minimum execution time
+// is disabled, it is a deliberate delay.
+//
+//---------------------------------------------------------------------------
+
+#include "controllers/controller_manager.h"
+#include "controllers/scsi_controller.h"
+#include "test/bench_bus.h"
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+
+using namespace std;
+using namespace scsi_defs;
+
+static const uint32_t SECTOR_COUNT = 32 * 1024;
+
+static void BM_ScsiController(benchmark::State& state, scsi_command cmd)
+{
+	ScsiController::SetMinExecTime(0);
+
+	const path image = CreateImageFile("controller.hds", SECTOR_COUNT * 512);
+	BenchBus bus;
+	ControllerManager controller_manager;
+	const auto device = CreateHardDisk(image);
+	controller_manager.AttachToController(bus, 0, device);
+
+	const auto blocks = static_cast<uint32_t>(state.range(0));
+	vector<uint8_t> cdb(10);
+	cdb[0] = static_cast<uint8_t>(cmd);
+	cdb[7] = static_cast<uint8_t>(blocks >> 8);
+	cdb[8] = static_cast<uint8_t>(blocks);
+
+	// Initiator ID 7, target ID 0
+	const int id_data = 0b10000001;
+
+	uint32_t lba = 0;
+	for (auto _ : state) {
+		cdb[2] = static_cast<uint8_t>(lba >> 24);
+		cdb[3] = static_cast<uint8_t>(lba >> 16);
+		cdb[4] = static_cast<uint8_t>(lba >> 8);
+		cdb[5] = static_cast<uint8_t>(lba);
+		bus.Select(id_data, cdb);
+		controller_manager.ProcessOnController(bus.GetDAT());
+		if (bus.GetStatus() != static_cast<uint8_t>(status::good)) {
+			state.SkipWithError("Command failed");
+			break;
+		}
+
+		lba = (lba + blocks) % (SECTOR_COUNT - blocks);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	// Without the status and message bytes
+	state.SetBytesProcessed(static_cast<int64_t>(bus.GetBytesIn() + bus.GetBytesOut()) - state.iterations() * 2);
+
+	device->CleanUp();
+}
+BENCHMARK_CAPTURE(BM_ScsiController, Read10, scsi_command::eCmdRead10)->Arg(1)->Arg(8)->Arg(128);
+BENCHMARK_CAPTURE(BM_ScsiController, Write10, scsi_command::eCmdWrite10)->Arg(1)->Arg(8)->Arg(128);
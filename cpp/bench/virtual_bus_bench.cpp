@@ -0,0 +1,115 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Complete commands on a shared virtual bus, with an initiator and a target thread. This includes the
+// selection and the byte-wise handshakes, i.e. the latency and throughput depend on the number of CPUs.
+//
+//---------------------------------------------------------------------------
+
+#include "controllers/controller_manager.h"
+#include "controllers/scsi_controller.h"
+#include "hal/gpiobus_virtual.h"
+#include "initiator/initiator_executor.h"
+#include "bench/bench_shared.h"
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+#include <thread>
+
+using namespace std;
+using namespace scsi_defs;
+
+namespace
+{
+	// The bus loop of piscsi for a single hard disk with ID 0
+	class VirtualBusTarget
+	{
+
+	public:
+
+		VirtualBusTarget(const string& name, const path& image) : bus(name) {
+			bus.Init(BUS::mode_e::TARGET);
+			bus.Reset();
+			device = CreateHardDisk(image);
+			controller_manager.AttachToController(bus, 0, device);
+			target_thread = jthread([this] (stop_token token) { Run(token); });
+		}
+		~VirtualBusTarget() {
+			target_thread.request_stop();
+			target_thread.join();
+			device->CleanUp();
+			bus.Cleanup();
+		}
+
+	private:
+
+		void Run(const stop_token& token) {
+			while (!token.stop_requested()) {
+				bus.Acquire();
+				if (bus.GetSEL()) {
+					controller_manager.ProcessOnController(bus.GetDAT());
+				}
+				else {
+					this_thread::yield();
+				}
+			}
+		}
+
+		GPIOBUS_Virtual bus;
+		ControllerManager controller_manager;
+		shared_ptr<StorageDevice> device;
+		jthread target_thread;
+	};
+}
+
+static void BM_VirtualBus(benchmark::State& state, scsi_command cmd)
+{
+	ScsiController::SetMinExecTime(0);
+
+	const string name = "/piscsi_bench_" + to_string(getpid());
+	const path image = CreateImageFile("virtual_bus.hds", 1024 * 1024);
+	VirtualBusTarget target(name, image);
+
+	GPIOBUS_Virtual bus(name);
+	if (!bus.Init(BUS::mode_e::INITIATOR)) {
+		state.SkipWithError("Can't initialize virtual bus");
+		return;
+	}
+	bus.Reset();
+	InitiatorExecutor executor(bus, 7);
+	executor.SetTarget(0, 0);
+
+	const auto blocks = static_cast<int>(state.range(0));
+	vector<uint8_t> buffer(blocks * 512);
+	uint64_t bytes = 0;
+	for (auto _ : state) {
+		vector<uint8_t> cdb(blocks ? 10 : 6);
+		if (blocks) {
+			cdb[8] = static_cast<uint8_t>(blocks);
+		}
+		try {
+			if (executor.Execute(cmd, cdb, buffer, static_cast<int>(buffer.size())) != static_cast<int>(status::good)) {
+				// A pending UNIT ATTENTION after the first command is fine
+				continue;
+			}
+		}
+		catch (const phase_exception& e) {
+			state.SkipWithError(e.what());
+			break;
+		}
+		bytes += executor.GetByteCount();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(static_cast<int64_t>(bytes));
+
+	bus.Cleanup();
+}
+// The latency of a command without data phase, mostly selection and phase changes
+BENCHMARK_CAPTURE(BM_VirtualBus, TestUnitReady, scsi_command::eCmdTestUnitReady)->Arg(0)->UseRealTime();
+// The handshake throughput of a data phase
+BENCHMARK_CAPTURE(BM_VirtualBus, Read10, scsi_command::eCmdRead10)->Arg(1)->Arg(128)->UseRealTime();
+BENCHMARK_CAPTURE(BM_VirtualBus, Write10, scsi_command::eCmdWrite10)->Arg(1)->Arg(128)->UseRealTime();
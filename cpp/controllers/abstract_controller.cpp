@@ -19,11 +19,12 @@ AbstractController::AbstractController(BUS& bus, int target_id, int max_luns) :
 	device_logger.SetIdAndLun(target_id, -1);
 }
 
-void AbstractController::AllocateCmd(size_t size)
+vector<uint8_t>& AbstractController::GetDataBuffer()
 {
-	if (size > ctrl.cmd.size()) {
-		ctrl.cmd.resize(size);
-	}
+	// The size may have been changed since the last access
+	data_buffer.resize(data_buffer_size);
+
+	return data_buffer;
 }
 
 void AbstractController::AllocateBuffer(size_t size)
@@ -42,12 +43,13 @@ void AbstractController::SetByteTransfer(bool b)
 	 }
 }
 
-unordered_set<shared_ptr<PrimaryDevice>> AbstractController::GetDevices() const
+vector<shared_ptr<PrimaryDevice>> AbstractController::GetDevices() const
 {
-	unordered_set<shared_ptr<PrimaryDevice>> devices;
+	vector<shared_ptr<PrimaryDevice>> devices;
+	devices.reserve(luns.size());
 
 	// "luns | views:values" is not supported by the bullseye compiler
-	ranges::transform(luns, inserter(devices, devices.begin()), [] (const auto& l) { return l.second; } );
+	ranges::transform(luns, back_inserter(devices), [] (const auto& l) { return l.second; } );
 
 	return devices;
 }
@@ -79,7 +81,7 @@ void AbstractController::ProcessOnController(int id_data)
 
 	const int initiator_id = ExtractInitiatorId(id_data);
 	if (initiator_id != UNKNOWN_INITIATOR_ID) {
-		LogTrace("++++ Starting processing for initiator ID " + to_string(initiator_id));
+		LogTrace("++++ Starting processing for initiator ID {}", initiator_id);
 	}
 	else {
 		LogTrace("++++ Starting processing for unknown initiator ID");
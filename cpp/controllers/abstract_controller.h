@@ -15,9 +15,9 @@
 #include "hal/bus.h"
 #include "phase_handler.h"
 #include "devices/device_logger.h"
-#include <unordered_set>
 #include <unordered_map>
 #include <span>
+#include <array>
 #include <vector>
 #include <memory>
 #include <functional>
@@ -50,6 +50,11 @@ public:
 	// Get requested LUN based on IDENTIFY message, with LUN from the CDB as fallback
 	virtual int GetEffectiveLun() const = 0;
 
+	// Installed by a device when a command enters a block-oriented data phase. Called with the number of the
+	// current block, reads this block into (DATA IN) or processes this block from (DATA OUT) the transfer
+	// buffer and returns the length of the next block. Throws scsi_exception on errors.
+	using transfer_handler = function<int(uint64_t)>;
+
 	void ScheduleShutdown(piscsi_shutdown_mode mode) { shutdown_mode = mode; }
 	piscsi_shutdown_mode GetShutdownMode() const { return shutdown_mode; }
 
@@ -57,13 +62,30 @@ public:
 	int GetMaxLuns() const { return max_luns; }
 	int GetLunCount() const { return static_cast<int>(luns.size()); }
 
-	unordered_set<shared_ptr<PrimaryDevice>> GetDevices() const;
+	vector<shared_ptr<PrimaryDevice>> GetDevices() const;
 	shared_ptr<PrimaryDevice> GetDeviceForLun(int) const;
 	bool AddDevice(shared_ptr<PrimaryDevice>);
 	bool RemoveDevice(PrimaryDevice&);
 	bool HasDeviceForLun(int) const;
 	void ProcessOnController(int);
 
+	// The commands received before the controller disconnected from the bus
+	virtual bool HasQueuedCommands() const { return false; }
+	// Reselects the initiator of the next queued command and executes this command
+	virtual void ProcessQueuedCommand() {
+		// Only controllers supporting disconnection have queued commands
+	}
+
+	// The buffers of READ BUFFER and WRITE BUFFER. They are only allocated when being used.
+	vector<uint8_t>& GetDataBuffer();
+	vector<uint8_t>& GetEchoBuffer() { return echo_buffer; }
+	static void SetDataBufferSize(uint32_t size) { data_buffer_size = size; }
+	static uint32_t GetDataBufferSize() { return data_buffer_size; }
+
+	// The largest echo buffer permitted by SPC
+	static constexpr uint32_t ECHO_BUFFER_SIZE = 4096;
+	static constexpr uint32_t DEFAULT_DATA_BUFFER_SIZE = 65536;
+
 	// TODO These should probably be extracted into a new TransferHandler class
 	void AllocateBuffer(size_t);
 	auto& GetBuffer() { return ctrl.buffer; }
@@ -79,12 +101,14 @@ public:
 	void IncrementNext() { ++ctrl.next; }
 	int GetMessage() const { return ctrl.message; }
 	void SetMessage(int m) { ctrl.message = m; }
-	auto GetCmd() const { return ctrl.cmd; }
+	cdb_t GetCmd() const { return ctrl.cmd; }
 	int GetCmdByte(int index) const { return ctrl.cmd[index]; }
 	bool IsByteTransfer() const { return is_byte_transfer; }
 	void SetByteTransfer(bool);
 	auto GetBytesToTransfer() const { return bytes_to_transfer; }
 	void SetBytesToTransfer(uint32_t b) { bytes_to_transfer = b; }
+	int GetOffset() const { return ctrl.offset; }
+	void SetTransferHandler(const transfer_handler& h) { ctrl.handler = h; }
 
 protected:
 
@@ -93,29 +117,39 @@ protected:
 	auto GetOpcode() const { return static_cast<scsi_defs::scsi_command>(ctrl.cmd[0]); }
 	int GetLun() const { return (ctrl.cmd[1] >> 5) & 0x07; }
 
-	void AllocateCmd(size_t);
-
-	void SetCmdByte(int index, int value) { ctrl.cmd[index] = value; }
+	void SetCmdByte(int index, int value) { ctrl.cmd[index] = static_cast<uint8_t>(value); }
 
 	// TODO These should probably be extracted into a new TransferHandler class
 	bool HasValidLength() const { return ctrl.length != 0; }
-	int GetOffset() const { return ctrl.offset; }
+	bool HasTransferHandler() const { return ctrl.handler != nullptr; }
+	int TransferBlock(uint64_t block) const { return ctrl.handler(block); }
+	void ClearTransferHandler() { ctrl.handler = nullptr; }
 	void ResetOffset() { ctrl.offset = 0; }
 	void UpdateOffsetAndLength() { ctrl.offset += ctrl.length; ctrl.length = 0; }
 
-	void LogTrace(const string& s) const { device_logger.Trace(s); }
-	void LogDebug(const string& s) const { device_logger.Debug(s); }
-	void LogInfo(const string& s) const { device_logger.Info(s); }
-	void LogWarn(const string& s) const { device_logger.Warn(s); }
-	void LogError(const string& s) const { device_logger.Error(s); }
+	void LogTrace(string_view s) const { device_logger.Trace(s); }
+	void LogDebug(string_view s) const { device_logger.Debug(s); }
+	void LogInfo(string_view s) const { device_logger.Info(s); }
+	void LogWarn(string_view s) const { device_logger.Warn(s); }
+	void LogError(string_view s) const { device_logger.Error(s); }
+
+	// Formatting is deferred until the level is known to be enabled
+	template<typename... Args>
+	void LogTrace(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Trace(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogDebug(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Debug(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogWarn(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Warn(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogError(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Error(f, forward<Args>(args)...); }
 
 private:
 
 	int ExtractInitiatorId(int) const;
 
 	struct ctrl_t {
-		// Command data, dynamically resized if required
-		vector<int> cmd = vector<int>(16);
+		// Command data, large enough for the longest CDB
+		array<uint8_t, 16> cmd;
 
 		scsi_defs::status status;		// Status data
 		int message;					// Message data
@@ -126,10 +160,18 @@ private:
 		uint64_t next;					// Next record
 		uint32_t offset;				// Transfer offset
 		uint32_t length;				// Transfer remaining length
+
+		// Processes the blocks of the current data phase
+		transfer_handler handler;
 	};
 
 	ctrl_t ctrl = {};
 
+	// Only used for measuring the transfer rate of the bus, i.e. the data are never stored
+	vector<uint8_t> data_buffer;
+	vector<uint8_t> echo_buffer;
+	static inline uint32_t data_buffer_size = DEFAULT_DATA_BUFFER_SIZE;
+
 	BUS& bus;
 
 	DeviceLogger device_logger;
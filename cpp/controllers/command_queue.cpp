@@ -0,0 +1,166 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/scsi.h"
+#include "devices/scsi_command_util.h"
+#include "command_queue.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace scsi_defs;
+using namespace scsi_command_util;
+
+bool CommandQueue::Add(int initiator_id, uint8_t tag, tag_type type, span<const uint8_t> cdb)
+{
+	if (static_cast<int>(commands.size()) >= depth) {
+		return false;
+	}
+
+	queued_command command = {};
+	command.initiator_id = initiator_id;
+	command.tag = tag;
+	command.type = type;
+	ranges::copy(cdb.first(min(cdb.size(), command.cdb.size())), command.cdb.begin());
+	command.sequence = sequence++;
+	SetBlockRange(command);
+
+	// The capacity has been reserved, i.e. this does not allocate
+	commands.push_back(command);
+
+	return true;
+}
+
+bool CommandQueue::Contains(int initiator_id, uint8_t tag) const
+{
+	return ranges::any_of(commands, [&] (const queued_command& c)
+			{ return c.initiator_id == initiator_id && c.tag == tag; });
+}
+
+bool CommandQueue::Remove(int initiator_id, uint8_t tag)
+{
+	return erase_if(commands, [&] (const queued_command& c)
+			{ return c.initiator_id == initiator_id && c.tag == tag; }) > 0;
+}
+
+void CommandQueue::RemoveAll(int initiator_id)
+{
+	erase_if(commands, [initiator_id] (const queued_command& c) { return c.initiator_id == initiator_id; });
+}
+
+const CommandQueue::queued_command *CommandQueue::Peek() const
+{
+	const queued_command *head_of_queue = nullptr;
+	const queued_command *ordered = nullptr;
+	for (const auto& c : commands) {
+		if (c.type == tag_type::head_of_queue && (head_of_queue == nullptr || c.sequence < head_of_queue->sequence)) {
+			head_of_queue = &c;
+		}
+		if (c.type == tag_type::ordered && (ordered == nullptr || c.sequence < ordered->sequence)) {
+			ordered = &c;
+		}
+	}
+
+	if (head_of_queue != nullptr) {
+		return head_of_queue;
+	}
+
+	// Only the commands received before the oldest ORDERED command may be reordered
+	const uint64_t barrier = ordered != nullptr ? ordered->sequence : UINT64_MAX;
+
+	const queued_command *next = nullptr;
+	const auto is_better = [this] (const queued_command& c, const queued_command& n) {
+		if (!c.has_blocks || !n.has_blocks) {
+			return !c.has_blocks && (n.has_blocks || c.sequence < n.sequence);
+		}
+
+		// C-LOOK: The blocks at or after the head position come first
+		if ((c.start >= head_position) != (n.start >= head_position)) {
+			return c.start >= head_position;
+		}
+
+		return c.start < n.start || (c.start == n.start && c.sequence < n.sequence);
+	};
+	for (const auto& c : commands) {
+		if (c.sequence < barrier && (next == nullptr || is_better(c, *next))) {
+			next = &c;
+		}
+	}
+
+	return next != nullptr ? next : ordered;
+}
+
+CommandQueue::queued_command CommandQueue::Pop()
+{
+	const queued_command *next = Peek();
+	assert(next != nullptr);
+
+	const queued_command command = *next;
+	if (command.has_blocks) {
+		head_position = command.start + command.count;
+	}
+
+	commands.erase(commands.begin() + (next - commands.data()));
+
+	return command;
+}
+
+pair<uint64_t, uint64_t> CommandQueue::GetMergedReadRange(const queued_command& command) const
+{
+	assert(command.has_blocks && command.is_read);
+
+	uint64_t end = command.start + command.count;
+
+	// The queue is short, i.e. a repeated search is cheaper than sorting
+	bool extended = true;
+	while (extended) {
+		extended = false;
+		for (const auto& c : commands) {
+			if (c.has_blocks && c.is_read && c.start == end && c.count) {
+				end += c.count;
+				extended = true;
+			}
+		}
+	}
+
+	return { command.start, end - command.start };
+}
+
+void CommandQueue::SetBlockRange(queued_command& command)
+{
+	const auto& cdb = command.cdb;
+
+	switch (static_cast<scsi_command>(cdb[0])) {
+		case scsi_command::eCmdRead6:
+		case scsi_command::eCmdWrite6:
+			command.start = GetInt24(cdb, 1) & 0x1fffff;
+			// 0 means 256 blocks
+			command.count = cdb[4] ? cdb[4] : 256;
+			break;
+
+		case scsi_command::eCmdRead10:
+		case scsi_command::eCmdWrite10:
+			command.start = GetInt32(cdb, 2);
+			command.count = GetInt16(cdb, 7);
+			break;
+
+		case scsi_command::eCmdRead16:
+		case scsi_command::eCmdWrite16:
+			command.start = GetInt64(cdb, 2);
+			command.count = GetInt32(cdb, 10);
+			break;
+
+		default:
+			return;
+	}
+
+	command.has_blocks = true;
+	const auto opcode = static_cast<scsi_command>(cdb[0]);
+	command.is_read = opcode == scsi_command::eCmdRead6 || opcode == scsi_command::eCmdRead10 ||
+			opcode == scsi_command::eCmdRead16;
+}
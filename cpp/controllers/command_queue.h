@@ -0,0 +1,98 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The tagged commands of a logical unit, which have been received before the target disconnected. They are
+// executed after reselecting the initiator, not in the order of their arrival but in elevator order:
+//   - HEAD OF QUEUE commands are executed first.
+//   - An ORDERED command is executed after all commands received before it and before all commands received after it.
+//   - Commands without a block address, e.g. TEST UNIT READY, are executed before READ and WRITE.
+//   - READ and WRITE are executed in ascending block order, starting at the block following the previous command
+//     and wrapping around to the lowest block (C-LOOK), i.e. adjacent ranges are executed back to back.
+// Adjacent READ ranges are merged, so that the device can prefetch them with a single pass.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <span>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class CommandQueue
+{
+
+public:
+
+	// The message codes of the queue tag messages
+	enum class tag_type : uint8_t {
+		simple = 0x20,
+		head_of_queue = 0x21,
+		ordered = 0x22
+	};
+
+	struct queued_command {
+		int initiator_id;
+		uint8_t tag;
+		tag_type type;
+		array<uint8_t, 16> cdb;
+		// Only READ and WRITE have a block range
+		bool has_blocks;
+		bool is_read;
+		uint64_t start;
+		uint32_t count;
+		// The order of arrival
+		uint64_t sequence;
+	};
+
+	explicit CommandQueue(int depth) : depth(depth) { commands.reserve(depth); }
+	~CommandQueue() = default;
+
+	// Returns false if the queue is full
+	bool Add(int, uint8_t, tag_type, span<const uint8_t>);
+	bool Contains(int, uint8_t) const;
+	// Returns false if there is no such command
+	bool Remove(int, uint8_t);
+	void RemoveAll(int);
+	void Clear() { commands.clear(); }
+
+	bool IsEmpty() const { return commands.empty(); }
+	int GetSize() const { return static_cast<int>(commands.size()); }
+
+	// The command to be executed next, nullptr if the queue is empty
+	const queued_command *Peek() const;
+	// Removes the command returned by Peek(), the following READ or WRITE is selected relative to its end
+	queued_command Pop();
+
+	// The start and the count of the range covered by the READ and the queued READs adjacent to it
+	pair<uint64_t, uint64_t> GetMergedReadRange(const queued_command&) const;
+
+	// 0 disables tagged queuing
+	static void SetMaxDepth(int d) { max_depth = d; }
+	static int GetMaxDepth() { return max_depth; }
+
+	static inline const int MAX_DEPTH = 64;
+
+private:
+
+	static void SetBlockRange(queued_command&);
+
+	int depth;
+
+	// Not sorted, with a small queue depth a linear search is faster than maintaining an order
+	vector<queued_command> commands;
+
+	// The block following the most recent READ or WRITE
+	uint64_t head_position = 0;
+
+	uint64_t sequence = 0;
+
+	static inline int max_depth = 0;
+};
@@ -0,0 +1,278 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_exceptions.h"
+#include "command_recorder.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+using namespace std;
+
+CommandRecorder::~CommandRecorder()
+{
+	Close();
+}
+
+bool CommandRecorder::Open(const string& filename)
+{
+	Close();
+
+	file.open(filename, ios::binary | ios::trunc);
+	if (file.fail()) {
+		return false;
+	}
+
+	buffer.reserve(BUFFER_SIZE);
+	write_buffer.reserve(BUFFER_SIZE);
+	dropped_records = 0;
+	is_command_dropped = false;
+	write_error = false;
+
+	Append(span(reinterpret_cast<const uint8_t *>(MAGIC.data()), MAGIC.size()));
+	Append(VERSION);
+	file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+	buffer.clear();
+	if (file.fail()) {
+		file.close();
+		return false;
+	}
+
+	is_open = true;
+
+	return true;
+}
+
+void CommandRecorder::Start()
+{
+	if (is_open && !writer.joinable()) {
+		writer = jthread([this] (stop_token token) { Write(token); });
+	}
+}
+
+void CommandRecorder::Close()
+{
+	if (!is_open) {
+		return;
+	}
+
+	is_open = false;
+
+	// The writer writes the remaining data before it terminates
+	{
+		scoped_lock<mutex> lock(write_mutex);
+		write_buffer.insert(write_buffer.end(), buffer.begin(), buffer.end());
+	}
+	buffer.clear();
+
+	if (writer.joinable()) {
+		writer.request_stop();
+		writer.join();
+	}
+	else {
+		// Without a writer thread the caller writes the data
+		stop_source source;
+		source.request_stop();
+		Write(source.get_token());
+	}
+
+	file.close();
+
+	if (dropped_records) {
+		spdlog::warn("The command recording is incomplete, {} record(s) were dropped because the writer could not keep up",
+				dropped_records);
+	}
+}
+
+void CommandRecorder::AddCommand(uint64_t timestamp, int initiator_id, int target_id, int lun, span<const uint8_t> cdb)
+{
+	if (!is_open) {
+		return;
+	}
+
+	// The data out records of a dropped command would be assigned to the preceding command
+	is_command_dropped = !Reserve(14 + cdb.size());
+	if (is_command_dropped) {
+		return;
+	}
+
+	Append(static_cast<uint8_t>('C'));
+	Append(timestamp);
+	Append(static_cast<int8_t>(initiator_id));
+	Append(static_cast<uint8_t>(target_id));
+	Append(static_cast<uint8_t>(lun));
+	Append(static_cast<uint8_t>(cdb.size()));
+	Append(cdb);
+
+	if (buffer.size() >= FLUSH_THRESHOLD) {
+		HandOver();
+	}
+}
+
+void CommandRecorder::AddDataOut(span<const uint8_t> data)
+{
+	if (!is_open) {
+		return;
+	}
+
+	if (is_command_dropped) {
+		++dropped_records;
+		return;
+	}
+
+	if (!Reserve(5 + data.size())) {
+		return;
+	}
+
+	Append(static_cast<uint8_t>('D'));
+	Append(static_cast<uint32_t>(data.size()));
+	Append(data);
+
+	if (buffer.size() >= FLUSH_THRESHOLD) {
+		HandOver();
+	}
+}
+
+void CommandRecorder::Append(span<const uint8_t> data)
+{
+	buffer.insert(buffer.end(), data.begin(), data.end());
+}
+
+bool CommandRecorder::Reserve(size_t size)
+{
+	if (buffer.size() + size > BUFFER_SIZE) {
+		HandOver();
+
+		if (buffer.size() + size > BUFFER_SIZE) {
+			++dropped_records;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CommandRecorder::HandOver()
+{
+	// The bus thread must not wait for the writer. If the writer has not taken the previous buffer yet
+	// the buffer is handed over with the next record.
+	unique_lock<mutex> lock(write_mutex, try_to_lock);
+	if (!lock.owns_lock() || !write_buffer.empty()) {
+		return;
+	}
+
+	buffer.swap(write_buffer);
+	lock.unlock();
+
+	write_condition.notify_one();
+}
+
+void CommandRecorder::Write(const stop_token& token)
+{
+	vector<uint8_t> data;
+	data.reserve(BUFFER_SIZE);
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(write_mutex);
+			write_condition.wait(lock, token, [this] { return !write_buffer.empty(); });
+
+			// When stopping the loop continues until there is no more data
+			if (write_buffer.empty()) {
+				break;
+			}
+
+			data.swap(write_buffer);
+		}
+
+		// After an error the remaining data are discarded, the recording is incomplete anyway
+		if (!write_error) {
+			file.write(reinterpret_cast<const char *>(data.data()), data.size());
+			file.flush();
+			if (file.fail()) {
+				write_error = true;
+				spdlog::error("Can't write command recording, recording stopped");
+			}
+		}
+		data.clear();
+	}
+}
+
+vector<CommandRecorder::command_t> CommandRecorder::Read(const string& filename)
+{
+	ifstream in(filename, ios::binary);
+	if (in.fail()) {
+		throw io_exception("Can't open recording '" + filename + "'");
+	}
+
+	const auto read = [&in, &filename] (void *data, size_t size) {
+		in.read(static_cast<char *>(data), size);
+		if (in.fail()) {
+			throw io_exception("Recording '" + filename + "' is truncated");
+		}
+	};
+
+	const auto read_value = [&read] <typename T> (T& value) {
+		array<uint8_t, sizeof(T)> bytes;
+		read(bytes.data(), bytes.size());
+		make_unsigned_t<T> v = 0;
+		for (size_t i = 0; i < sizeof(T); i++) {
+			v |= static_cast<make_unsigned_t<T>>(static_cast<make_unsigned_t<T>>(bytes[i]) << (i * 8));
+		}
+		value = static_cast<T>(v);
+	};
+
+	array<char, MAGIC.size()> magic;
+	uint32_t version;
+	read(magic.data(), magic.size());
+	read_value(version);
+	if (magic != MAGIC || version != VERSION) {
+		throw io_exception("'" + filename + "' is not a supported command recording");
+	}
+
+	vector<command_t> commands;
+
+	char type;
+	while (in.get(type)) {
+		if (type == 'C') {
+			command_t command = {};
+			int8_t initiator_id;
+			uint8_t target_id;
+			uint8_t lun;
+			uint8_t length;
+			read_value(command.timestamp);
+			read_value(initiator_id);
+			read_value(target_id);
+			read_value(lun);
+			read_value(length);
+			command.initiator_id = initiator_id;
+			command.target_id = target_id;
+			command.lun = lun;
+			command.cdb.resize(length);
+			read(command.cdb.data(), length);
+
+			commands.push_back(command);
+		}
+		else if (type == 'D' && !commands.empty()) {
+			uint32_t length;
+			read_value(length);
+			if (length > MAX_DATA_LENGTH) {
+				throw io_exception("Recording '" + filename + "' is corrupt, invalid data length " + to_string(length));
+			}
+			vector<uint8_t> data(length);
+			read(data.data(), length);
+
+			commands.back().data_out.push_back(data);
+		}
+		else {
+			throw io_exception("Recording '" + filename + "' is corrupt");
+		}
+	}
+
+	return commands;
+}
@@ -0,0 +1,120 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Records the commands received by piscsi, including their data out payloads, in a compact binary file.
+// The recording can be replayed with scsireplay without any SCSI hardware.
+//
+// The file is written by a separate thread, i.e. the bus thread only appends to a memory buffer. The buffers have a
+// fixed size. If the writer cannot keep up, records are dropped and counted instead of growing the buffer.
+//
+// File format (little endian regardless of the host byte order):
+//   Header:  "PISCSIRC", uint32 version
+//   Command: 'C', uint64 timestamp in ns, int8 initiator ID, uint8 target ID, uint8 LUN, uint8 CDB length, CDB
+//   Data:    'D', uint32 length, data out bytes of the preceding command
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string>
+#include <span>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <type_traits>
+
+using namespace std;
+
+class CommandRecorder
+{
+
+public:
+
+	struct command_t {
+		uint64_t timestamp;
+		int initiator_id;
+		int target_id;
+		int lun;
+		vector<uint8_t> cdb;
+		// The data out chunks in the order they were received
+		vector<vector<uint8_t>> data_out;
+	};
+
+	static constexpr uint32_t VERSION = 1;
+
+	CommandRecorder() = default;
+	~CommandRecorder();
+
+	bool Open(const string&);
+	// Starts the writer thread. Until then the records are only buffered. The thread inherits the CPU affinity
+	// of the calling thread, i.e. with piscsi it must not be started before the thread layout has been set up.
+	void Start();
+	void Close();
+	bool IsOpen() const { return is_open; }
+
+	// Must only be called by a single thread, i.e. the bus thread
+	void AddCommand(uint64_t, int, int, int, span<const uint8_t>);
+	void AddDataOut(span<const uint8_t>);
+
+	// The records dropped because the writer could not keep up. The data of a dropped command are also dropped.
+	uint64_t GetDroppedRecords() const { return dropped_records; }
+	bool HasWriteError() const { return write_error; }
+
+	// Throws io_exception if the file cannot be read or is not a valid recording
+	static vector<command_t> Read(const string&);
+
+private:
+
+	void Append(span<const uint8_t>);
+	template<typename T>
+	void Append(T value)
+	{
+		for (size_t i = 0; i < sizeof(T); i++) {
+			buffer.push_back(static_cast<uint8_t>(static_cast<make_unsigned_t<T>>(value) >> (i * 8)));
+		}
+	}
+
+	bool Reserve(size_t);
+	void HandOver();
+	void Write(const stop_token&);
+
+	static constexpr array<char, 8> MAGIC = { 'P', 'I', 'S', 'C', 'S', 'I', 'R', 'C' };
+
+	// The buffer is handed over to the writer thread in chunks
+	static constexpr size_t FLUSH_THRESHOLD = 65536;
+
+	// The capacity of each buffer, it is never exceeded
+	static constexpr size_t BUFFER_SIZE = FLUSH_THRESHOLD * 16;
+
+	// SCSI data out chunks are much smaller, larger lengths are the result of a corrupt file
+	static constexpr uint32_t MAX_DATA_LENGTH = BUFFER_SIZE;
+
+	ofstream file;
+
+	bool is_open = false;
+
+	// Filled by the bus thread
+	vector<uint8_t> buffer;
+
+	// Only accessed by the bus thread
+	uint64_t dropped_records = 0;
+	bool is_command_dropped = false;
+
+	atomic_bool write_error = false;
+
+	// Handed over to the writer thread, empty when the writer has taken it
+	vector<uint8_t> write_buffer;
+	mutex write_mutex;
+	condition_variable_any write_condition;
+
+	jthread writer;
+};
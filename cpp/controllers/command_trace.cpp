@@ -0,0 +1,99 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/scsi.h"
+#include "command_trace.h"
+#include <spdlog/fmt/fmt.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+using namespace scsi_defs;
+
+void CommandTrace::Add(const command_record& record)
+{
+	const uint64_t index = count.load(memory_order_relaxed);
+	slot_t& slot = slots[index & (CAPACITY - 1)];
+
+	// Readers discard the slot while the sequence number is odd or has changed during the copy
+	slot.sequence.store(2 * index + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	slot.record = record;
+	slot.sequence.store(2 * index + 2, memory_order_release);
+
+	count.store(index + 1, memory_order_release);
+}
+
+vector<CommandTrace::command_record> CommandTrace::GetRecords() const
+{
+	const uint64_t end = count.load(memory_order_acquire);
+	const uint64_t start = end > CAPACITY ? end - CAPACITY : 0;
+
+	vector<command_record> records;
+	records.reserve(end - start);
+
+	for (uint64_t index = start; index < end; index++) {
+		const slot_t& slot = slots[index & (CAPACITY - 1)];
+
+		const uint64_t sequence = slot.sequence.load(memory_order_acquire);
+		const command_record record = slot.record;
+		atomic_thread_fence(memory_order_acquire);
+
+		// Skip records that have been overwritten in the meantime
+		if (sequence == 2 * index + 2 && slot.sequence.load(memory_order_relaxed) == sequence) {
+			records.push_back(record);
+		}
+	}
+
+	return records;
+}
+
+uint64_t CommandTrace::GetTimestamp()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+string CommandTrace::GetChromeTrace(span<const command_record> records)
+{
+	string json = "{\"traceEvents\":[";
+
+	// Chrome trace timestamps are in microseconds. The target ID is represented as process, the LUN as thread.
+	const auto add_event = [&json] (const command_record& record, string_view name, uint64_t start,
+			uint32_t duration, string_view args) {
+		if (json.back() != '[') {
+			json += ',';
+		}
+		json += fmt::format(R"({{"name":"{}","cat":"scsi","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{}{}}})",
+				name, static_cast<double>(start) / 1000, static_cast<double>(duration) / 1000, record.target_id,
+				record.lun, args);
+	};
+
+	for (const auto& record : records) {
+		const uint64_t total = static_cast<uint64_t>(record.selection_duration) + record.command_duration
+				+ record.data_duration + record.status_duration;
+		add_event(record, GetCommandDescriptor(static_cast<scsi_command>(record.opcode)).name, record.timestamp,
+				static_cast<uint32_t>(min(total, static_cast<uint64_t>(UINT32_MAX))),
+				fmt::format(R"(,"args":{{"opcode":"${:02x}","lba":{},"length":{},"status":"${:02x}","initiator_id":{}}})",
+						record.opcode, record.lba, record.length, record.status, record.initiator_id));
+
+		uint64_t start = record.timestamp;
+		for (const auto& [name, duration] : { pair { "selection", record.selection_duration },
+				pair { "command", record.command_duration }, pair { "data", record.data_duration },
+				pair { "status", record.status_duration } }) {
+			if (duration) {
+				add_event(record, name, start, duration, "");
+			}
+			start += duration;
+		}
+	}
+
+	json += "]}";
+
+	return json;
+}
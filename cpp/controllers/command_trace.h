@@ -0,0 +1,79 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Fixed-size ring buffer with the phase timings of the most recently executed commands.
+// Records are added by the bus thread and can be read concurrently by any other thread without locking.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <string>
+#include <span>
+
+using namespace std;
+
+class CommandTrace
+{
+
+public:
+
+	struct command_record {
+		// Start of the selection phase in ns, based on the steady clock
+		uint64_t timestamp;
+		// LBA and transfer length as encoded in the CDB
+		uint64_t lba;
+		uint32_t length;
+		// Phase durations in ns. The command duration covers the CDB transfer and the command execution
+		// up to the data or status phase. The status duration covers the status and message in phases.
+		uint32_t selection_duration;
+		uint32_t command_duration;
+		uint32_t data_duration;
+		uint32_t status_duration;
+		uint8_t opcode;
+		uint8_t status;
+		int8_t initiator_id;
+		uint8_t target_id;
+		uint8_t lun;
+	};
+
+	// Must be a power of 2
+	static constexpr size_t CAPACITY = 1024;
+
+	CommandTrace() = default;
+	~CommandTrace() = default;
+
+	// Must only be called by a single thread, i.e. the bus thread
+	void Add(const command_record&);
+
+	// The records still available in the buffer, oldest first
+	vector<command_record> GetRecords() const;
+
+	uint64_t GetCount() const { return count.load(memory_order_acquire); }
+
+	static uint64_t GetTimestamp();
+
+	// JSON in the Chrome trace event format, with one complete event per command and per phase
+	static string GetChromeTrace(span<const command_record>);
+
+private:
+
+	struct slot_t {
+		// Odd while the record is being written, 2 * (record index + 1) when complete
+		atomic<uint64_t> sequence;
+		command_record record;
+	};
+
+	array<slot_t, CAPACITY> slots = {};
+
+	// Total number of records added so far
+	atomic<uint64_t> count = 0;
+};
@@ -10,13 +10,20 @@
 #include "devices/primary_device.h"
 #include "scsi_controller.h"
 #include "controller_manager.h"
+#include <bit>
 
 using namespace std;
 
-shared_ptr<ScsiController> ControllerManager::CreateScsiController(BUS& bus, int id) const
+shared_ptr<ScsiController> ControllerManager::CreateScsiController(BUS& bus, int id)
 {
 	auto controller = make_shared<ScsiController>(bus, id);
-	controller->Init();
+	controller->SetCommandTrace(&command_trace);
+	controller->SetDelayProfiles(&delay_profiles);
+	controller->SetHandshakeStatistics(&handshake_statistics);
+	controller->SetSelectionStatistics(&selection_statistics);
+	if (command_recorder.IsOpen()) {
+		controller->SetCommandRecorder(&command_recorder);
+	}
 
 	return controller;
 }
@@ -28,13 +35,22 @@ bool ControllerManager::AttachToController(BUS& bus, int id, shared_ptr<PrimaryD
 			return false;
 		}
 
-		return controller->AddDevice(device);
+		if (!controller->AddDevice(device)) {
+			return false;
+		}
+
+		device->SetIdleScheduler(idle_scheduler);
+
+		return true;
 	}
 
 	// If this is LUN 0 create a new controller
 	if (!device->GetLun()) {
 		if (auto controller = CreateScsiController(bus, id); controller->AddDevice(device)) {
 			controllers[id] = controller;
+			served_ids |= 1 << id;
+
+			device->SetIdleScheduler(idle_scheduler);
 
 			return true;
 		}
@@ -49,50 +65,93 @@ bool ControllerManager::DeleteController(const AbstractController& controller)
 		device->CleanUp();
 	}
 
-	return controllers.erase(controller.GetTargetId()) == 1;
+	const int id = controller.GetTargetId();
+	if (!HasController(id)) {
+		return false;
+	}
+
+	served_ids &= ~(1 << id);
+	controllers[id].reset();
+
+	return true;
 }
 
 void ControllerManager::DeleteAllControllers()
 {
-	unordered_set<shared_ptr<AbstractController>> values;
-	ranges::transform(controllers, inserter(values, values.begin()), [] (const auto& controller) { return controller.second; } );
+	for (const auto& c : controllers) {
+		// Deleting resets the array entry, i.e. the controller must be kept alive until the deletion is complete
+		if (const auto controller = c; controller != nullptr) {
+			DeleteController(*controller);
+		}
+	}
 
-	for (const auto& controller : values) {
-		DeleteController(*controller);
+	assert(!served_ids);
+}
+
+AbstractController::piscsi_shutdown_mode ControllerManager::ProcessOnController(int id_data, uint64_t select_timestamp)
+{
+	// Selections of IDs without a controller are ignored without any further processing
+	const int ids = id_data & served_ids;
+	if (!ids) {
+		return AbstractController::piscsi_shutdown_mode::NONE;
+	}
+
+	// If the data byte contains more than one served ID the lowest one is selected
+	const int id = countr_zero(static_cast<unsigned int>(ids));
+	const auto& controller = controllers[id];
+	selection_statistics.SetSelectTimestamp(select_timestamp);
+	controller->ProcessOnController(id_data);
+
+	if (controller->HasQueuedCommands()) {
+		queued_ids |= 1 << id;
 	}
 
-	assert(controllers.empty());
+	return controller->GetShutdownMode();
 }
 
-AbstractController::piscsi_shutdown_mode ControllerManager::ProcessOnController(int id_data) const
+AbstractController::piscsi_shutdown_mode ControllerManager::ProcessQueuedCommand()
 {
-	if (const auto& it = ranges::find_if(controllers, [&] (const auto& c) { return (id_data & (1 << c.first)); } );
-		it != controllers.end()) {
-		(*it).second->ProcessOnController(id_data);
+	if (!queued_ids) {
+		return AbstractController::piscsi_shutdown_mode::NONE;
+	}
 
-		return (*it).second->GetShutdownMode();
+	const int id = bit_width(static_cast<unsigned int>(queued_ids)) - 1;
+
+	// The controller may have been deleted or reset in the meantime
+	const auto& controller = controllers[id];
+	if (controller != nullptr && controller->HasQueuedCommands()) {
+		controller->ProcessQueuedCommand();
+	}
+
+	if (controller == nullptr || !controller->HasQueuedCommands()) {
+		queued_ids &= ~(1 << id);
 	}
 
-	return AbstractController::piscsi_shutdown_mode::NONE;
+	return controller != nullptr ? controller->GetShutdownMode() : AbstractController::piscsi_shutdown_mode::NONE;
 }
 
 shared_ptr<AbstractController> ControllerManager::FindController(int target_id) const
 {
-	const auto& it = controllers.find(target_id);
-	return it == controllers.end() ? nullptr : it->second;
+	return HasController(target_id) ? controllers[target_id] : nullptr;
 }
 
 bool ControllerManager::HasController(int target_id) const {
-	return controllers.contains(target_id);
+	return target_id >= 0 && target_id < static_cast<int>(controllers.size()) && (served_ids & (1 << target_id));
 }
 
-unordered_set<shared_ptr<PrimaryDevice>> ControllerManager::GetAllDevices() const
+vector<shared_ptr<PrimaryDevice>> ControllerManager::GetAllDevices() const
 {
-	unordered_set<shared_ptr<PrimaryDevice>> devices;
-
-	for (const auto& [_, controller] : controllers) {
-		const auto& d = controller->GetDevices();
-		devices.insert(d.begin(), d.end());
+	vector<shared_ptr<PrimaryDevice>> devices;
+
+	// A device is attached to exactly one LUN of one controller, there are no duplicates
+	for (const auto& controller : controllers) {
+		if (controller != nullptr) {
+			for (int lun = 0; lun < controller->GetMaxLuns(); lun++) {
+				if (const auto& device = controller->GetDeviceForLun(lun); device != nullptr) {
+					devices.push_back(device);
+				}
+			}
+		}
 	}
 
 	return devices;
@@ -13,8 +13,14 @@
 
 #include "hal/bus.h"
 #include "controllers/abstract_controller.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "controllers/command_trace.h"
+#include "controllers/command_recorder.h"
+#include "controllers/delay_profiles.h"
+#include "controllers/handshake_statistics.h"
+#include "controllers/idle_scheduler.h"
+#include "controllers/selection_statistics.h"
+#include <array>
+#include <vector>
 #include <memory>
 
 using namespace std;
@@ -32,20 +38,64 @@ public:
 	bool AttachToController(BUS&, int, shared_ptr<PrimaryDevice>);
 	bool DeleteController(const AbstractController&);
 	void DeleteAllControllers();
-	AbstractController::piscsi_shutdown_mode ProcessOnController(int) const;
+	// The optional timestamp is the time of the SEL edge, see SelectionStatistics
+	AbstractController::piscsi_shutdown_mode ProcessOnController(int, uint64_t = 0);
+	// Whether a controller has queued commands, which are executed after reselecting the initiator
+	bool HasQueuedCommands() const { return queued_ids; }
+	// Executes a queued command of the controller with the highest ID, like the arbitration would do
+	AbstractController::piscsi_shutdown_mode ProcessQueuedCommand();
 	shared_ptr<AbstractController> FindController(int) const;
 	bool HasController(int) const;
-	unordered_set<shared_ptr<PrimaryDevice>> GetAllDevices() const;
+	// Bit n is set if there is a controller for ID n
+	int GetServedIds() const { return served_ids; }
+	// Ordered by ID and LUN
+	vector<shared_ptr<PrimaryDevice>> GetAllDevices() const;
 	bool HasDeviceForIdAndLun(int, int) const;
 	shared_ptr<PrimaryDevice> GetDeviceForIdAndLun(int, int) const;
 
+	const CommandTrace& GetCommandTrace() const { return command_trace; }
+	CommandRecorder& GetCommandRecorder() { return command_recorder; }
+	DelayProfiles& GetDelayProfiles() { return delay_profiles; }
+	const HandshakeStatistics& GetHandshakeStatistics() const { return handshake_statistics; }
+	SelectionStatistics& GetSelectionStatistics() { return selection_statistics; }
+	IdleScheduler& GetIdleScheduler() { return idle_scheduler; }
+	// The statistics which are not device specific
+	const MetricsRegistry& GetMetrics() const { return metrics; }
+	MetricsRegistry& GetMetrics() { return metrics; }
+
 	static int GetScsiIdMax() { return 8; }
 	static int GetScsiLunMax() { return 32; }
 
 private:
 
-	shared_ptr<ScsiController> CreateScsiController(BUS&, int) const;
+	shared_ptr<ScsiController> CreateScsiController(BUS&, int);
+
+	// Must be declared first, the statistics of the other members are added to it
+	MetricsRegistry metrics;
+
+	// Must outlive the devices, which remove their tasks when being destroyed
+	IdleScheduler idle_scheduler { metrics };
+
+	// Controllers indexed by their device IDs
+	array<shared_ptr<AbstractController>, 8> controllers;
+
+	// The IDs with a controller as a bitmask, for decoding the selection phase data byte without a lookup
+	int served_ids = 0;
+
+	// The IDs of the controllers with queued commands, only accessed by the bus thread
+	int queued_ids = 0;
+
+	// Shared by all controllers, which are all processed by the bus thread
+	CommandTrace command_trace;
+
+	// Only records if a recording file has been opened
+	CommandRecorder command_recorder;
+
+	// Only accessed by the bus thread or while holding the execution lock
+	DelayProfiles delay_profiles;
+
+	// Only updated if handshake timing is enabled on the bus
+	HandshakeStatistics handshake_statistics { metrics };
 
-	// Controllers mapped to their device IDs
-	unordered_map<int, shared_ptr<AbstractController>> controllers;
+	SelectionStatistics selection_statistics { metrics };
 };
@@ -0,0 +1,164 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_util.h"
+#include "delay_profiles.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+using namespace piscsi_util;
+
+string DelayProfiles::SetProfile(int initiator_id, const string& name)
+{
+	if (initiator_id < 0 || initiator_id >= static_cast<int>(profiles.size())) {
+		return "Invalid initiator ID " + to_string(initiator_id) + " (0-" + to_string(profiles.size() - 1) + ")";
+	}
+
+	entry_t profile;
+	if (!ParseProfile(name, profile)) {
+		return "Invalid delay profile '" + name + "'";
+	}
+
+	profiles[initiator_id] = profile;
+
+	return "";
+}
+
+vector<DelayProfiles::profile_t> DelayProfiles::GetProfiles(uint32_t default_delay) const
+{
+	vector<profile_t> result;
+
+	for (size_t id = 0; id < profiles.size(); id++) {
+		result.push_back({ static_cast<int>(id), profiles[id].name, GetDelay(static_cast<int>(id), default_delay) });
+	}
+
+	return result;
+}
+
+void DelayProfiles::AddResult(int initiator_id, bool success, uint32_t default_delay)
+{
+	if (initiator_id < 0 || initiator_id >= static_cast<int>(profiles.size())) {
+		return;
+	}
+
+	auto& profile = profiles[initiator_id];
+	if (profile.type != profile_type::adaptive) {
+		return;
+	}
+
+	if (!profile.learning) {
+		profile.delay = default_delay;
+		profile.learning = true;
+	}
+
+	if (success) {
+		if (profile.delay > profile.floor && ++profile.successes >= ADAPTIVE_INTERVAL) {
+			profile.delay = profile.delay - profile.floor > ADAPTIVE_STEP ? profile.delay - ADAPTIVE_STEP : profile.floor;
+			profile.successes = 0;
+		}
+	}
+	else {
+		// Back off, but never beyond the default delay, which is assumed to work
+		profile.delay = min(profile.delay + ADAPTIVE_BACKOFF, max(profile.delay, default_delay));
+		profile.floor = profile.delay;
+		profile.successes = 0;
+	}
+}
+
+string DelayProfiles::Load(const string& filename)
+{
+	ifstream file(filename);
+	if (file.fail()) {
+		return "Can't open delay profiles file '" + filename + "'";
+	}
+
+	string line;
+	while (getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		// Format: ID PROFILE [DELAY FLOOR], the delays are only present for adaptive profiles that are learning
+		istringstream s(line);
+		string id;
+		string name;
+		s >> id >> name;
+
+		int initiator_id;
+		if (!GetAsUnsignedInt(id, initiator_id)) {
+			return "Invalid initiator ID '" + id + "' in '" + filename + "'";
+		}
+
+		if (const string error = SetProfile(initiator_id, name); !error.empty()) {
+			return error + " in '" + filename + "'";
+		}
+
+		if (uint32_t delay, floor; s >> delay >> floor && profiles[initiator_id].type == profile_type::adaptive) {
+			profiles[initiator_id].delay = delay;
+			profiles[initiator_id].floor = floor;
+			profiles[initiator_id].learning = true;
+		}
+	}
+
+	return "";
+}
+
+string DelayProfiles::Save(const string& filename) const
+{
+	ofstream file(filename, ios::trunc);
+	if (file.fail()) {
+		return "Can't create delay profiles file '" + filename + "'";
+	}
+
+	file << "# piscsi delay profiles: ID PROFILE [DELAY FLOOR]\n";
+
+	for (size_t id = 0; id < profiles.size(); id++) {
+		if (const auto& profile = profiles[id]; profile.type != profile_type::standard) {
+			file << id << ' ' << profile.name;
+			if (profile.learning) {
+				file << ' ' << profile.delay << ' ' << profile.floor;
+			}
+			file << '\n';
+		}
+	}
+
+	file.close();
+
+	return file.fail() ? "Can't write delay profiles file '" + filename + "'" : "";
+}
+
+bool DelayProfiles::ParseProfile(const string& name, entry_t& profile)
+{
+	static const unordered_map<string, uint32_t> PRESETS = { { "none", 0 }, { "fast", 10 }, { "slow", 200 } };
+
+	profile.name = name;
+
+	if (name == "default") {
+		profile.type = profile_type::standard;
+	}
+	else if (name == "adaptive") {
+		profile.type = profile_type::adaptive;
+	}
+	else if (const auto& it = PRESETS.find(name); it != PRESETS.end()) {
+		profile.type = profile_type::fixed;
+		profile.delay = it->second;
+	}
+	else if (int delay; GetAsUnsignedInt(name, delay)) {
+		profile.type = profile_type::fixed;
+		profile.delay = delay;
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Per-initiator minimum execution time, i.e. the delay between the start of a command and its data or status
+// phase. Most initiators do not require any delay, but some older ones fail without it.
+//
+// Profiles:
+//   "default":  The delay configured with the piscsi -s option
+//   "none", "fast", "slow": Fixed delays of 0, 10 and 200 us
+//   "adaptive": Starts with the default delay and lowers it as long as the commands succeed. On an error the
+//               delay is increased again and not lowered below this value anymore.
+//   A number:   A fixed delay in us
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class DelayProfiles
+{
+
+public:
+
+	struct profile_t {
+		int initiator_id;
+		string name;
+		// The current delay in us
+		uint32_t delay;
+	};
+
+	DelayProfiles() = default;
+	~DelayProfiles() = default;
+
+	// Returns an error message, which is empty on success
+	string SetProfile(int, const string&);
+	vector<profile_t> GetProfiles(uint32_t) const;
+
+	// Called by the bus thread for each command, with the default delay as the fallback
+	uint32_t GetDelay(int initiator_id, uint32_t default_delay) const
+	{
+		if (initiator_id < 0 || initiator_id >= static_cast<int>(profiles.size())) {
+			return default_delay;
+		}
+
+		const auto& profile = profiles[initiator_id];
+		return profile.type == profile_type::standard || (profile.type == profile_type::adaptive && !profile.learning)
+				? default_delay : profile.delay;
+	}
+	void AddResult(int, bool, uint32_t);
+
+	// Persistence, the methods return an error message, which is empty on success
+	string Load(const string&);
+	string Save(const string&) const;
+
+	static inline const int ADAPTIVE_INTERVAL = 500;
+	static inline const uint32_t ADAPTIVE_STEP = 5;
+	static inline const uint32_t ADAPTIVE_BACKOFF = 10;
+
+private:
+
+	enum class profile_type { standard, fixed, adaptive };
+
+	struct entry_t {
+		profile_type type = profile_type::standard;
+		string name = "default";
+		uint32_t delay = 0;
+		// The adaptive delay is not lowered below this value
+		uint32_t floor = 0;
+		// Set as soon as the adaptive delay has been derived from the default delay
+		bool learning = false;
+		int successes = 0;
+	};
+
+	static bool ParseProfile(const string&, entry_t&);
+
+	// Indexed by the initiator ID
+	array<entry_t, 8> profiles;
+};
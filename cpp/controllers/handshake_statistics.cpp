@@ -0,0 +1,62 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/deadline.h"
+#include "handshake_statistics.h"
+
+using namespace std;
+
+void HandshakeStatistics::Add(int initiator_id, const HandshakeTiming::totals_t& totals)
+{
+	if (!totals.bytes) {
+		return;
+	}
+
+	auto& entry = GetEntry(initiator_id);
+
+	const uint64_t ack_assert = TickCounter::ToDuration(totals.ack_assert_ticks).count();
+	const uint64_t ack_deassert = TickCounter::ToDuration(totals.ack_deassert_ticks).count();
+	const uint64_t delay = TickCounter::ToDuration(totals.delay_ticks).count();
+	const uint64_t total = TickCounter::ToDuration(totals.total_ticks).count();
+	const uint64_t host = ack_assert + ack_deassert;
+	const uint64_t target = total > host ? total - host : 0;
+
+	entry.transfers.Increment();
+	entry.bytes.Increment(totals.bytes);
+	entry.ack_assert.Increment(ack_assert);
+	entry.ack_deassert.Increment(ack_deassert);
+	entry.delay.Increment(delay);
+	entry.target.Increment(target);
+	entry.slowest_byte.SetMax(TickCounter::ToDuration(totals.slowest_byte_ticks).count());
+
+	entry.host_histogram.Record(host / totals.bytes);
+	entry.target_histogram.Record(target / totals.bytes);
+}
+
+HandshakeStatistics::entry_t& HandshakeStatistics::GetEntry(int initiator_id)
+{
+	const int index = initiator_id >= 0 && initiator_id < 8 ? initiator_id : 8;
+	if (entries[index] == nullptr) {
+		const string suffix = "_initiator_" + (index < 8 ? to_string(index) : "unknown");
+
+		entries[index] = make_unique<entry_t>(entry_t {
+			metrics.AddCounter(HANDSHAKE_TRANSFERS + suffix),
+			metrics.AddCounter(HANDSHAKE_BYTES + suffix),
+			metrics.AddCounter(HANDSHAKE_ACK_ASSERT + suffix),
+			metrics.AddCounter(HANDSHAKE_ACK_DEASSERT + suffix),
+			metrics.AddCounter(HANDSHAKE_DELAY + suffix),
+			metrics.AddCounter(HANDSHAKE_TARGET + suffix),
+			metrics.AddGauge(HANDSHAKE_SLOWEST_BYTE + suffix),
+			metrics.AddHistogram(HANDSHAKE_HOST_HISTOGRAM + suffix),
+			metrics.AddHistogram(HANDSHAKE_TARGET_HISTOGRAM + suffix)
+		});
+	}
+
+	return *entries[index];
+}
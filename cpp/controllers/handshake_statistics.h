@@ -0,0 +1,70 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Per-initiator aggregation of the handshake timings recorded by the bus. The time per byte is split into
+// the host time (waiting for ACK) and the target time (everything else, including the settle delays), which
+// shows whether a slow transfer is caused by the initiator or by piscsi.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/handshake_timing.h"
+#include "devices/metrics_registry.h"
+#include <array>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class HandshakeStatistics
+{
+
+public:
+
+	// The statistics are added to the registry when an initiator has its first transfer, i.e. only initiators
+	// with transfers are reported
+	explicit HandshakeStatistics(MetricsRegistry& metrics) : metrics(metrics) {}
+	~HandshakeStatistics() = default;
+
+	// Called by the bus thread after each handshake, the initiator ID may be unknown (-1)
+	void Add(int, const HandshakeTiming::totals_t&);
+
+	// The keys have the initiator as suffix, e.g. "handshake_bytes_initiator_7" or
+	// "handshake_bytes_initiator_unknown"
+	inline static const string HANDSHAKE_TRANSFERS = "handshake_transfers";
+	inline static const string HANDSHAKE_BYTES = "handshake_bytes";
+	inline static const string HANDSHAKE_ACK_ASSERT = "handshake_ack_assert_ns";
+	inline static const string HANDSHAKE_ACK_DEASSERT = "handshake_ack_deassert_ns";
+	inline static const string HANDSHAKE_DELAY = "handshake_delay_ns";
+	inline static const string HANDSHAKE_TARGET = "handshake_target_ns";
+	inline static const string HANDSHAKE_SLOWEST_BYTE = "handshake_slowest_byte_ns";
+	inline static const string HANDSHAKE_HOST_HISTOGRAM = "handshake_host_ns_per_byte";
+	inline static const string HANDSHAKE_TARGET_HISTOGRAM = "handshake_target_ns_per_byte";
+
+private:
+
+	// Updated by the bus thread and read by the service thread. Times are in ns.
+	struct entry_t {
+		Counter& transfers;
+		Counter& bytes;
+		Counter& ack_assert;
+		Counter& ack_deassert;
+		Counter& delay;
+		Counter& target;
+		Gauge& slowest_byte;
+		Histogram& host_histogram;
+		Histogram& target_histogram;
+	};
+
+	entry_t& GetEntry(int);
+
+	MetricsRegistry& metrics;
+
+	// Indexed by the initiator ID, the last entry is for an unknown initiator. Only accessed by the bus thread.
+	array<unique_ptr<entry_t>, 9> entries;
+};
@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "idle_scheduler.h"
+#include <condition_variable>
+#include <cassert>
+
+using namespace std;
+
+IdleScheduler::IdleScheduler(MetricsRegistry& metrics)
+	: command_rate(metrics.AddGauge(IDLE_BUS_COMMAND_RATE)),
+	  step_count(metrics.AddCounter(IDLE_TASK_STEP_COUNT)),
+	  preempted_count(metrics.AddCounter(IDLE_TASK_PREEMPTED_COUNT)),
+	  task_time(metrics.AddCounter(IDLE_TASK_TIME))
+{
+}
+
+void IdleScheduler::Start()
+{
+	assert(!worker.joinable());
+
+	worker = jthread([this] (stop_token token) { Run(token); });
+}
+
+void IdleScheduler::Stop()
+{
+	if (worker.joinable()) {
+		worker.request_stop();
+		worker.join();
+	}
+}
+
+int IdleScheduler::AddTask(const task& t)
+{
+	scoped_lock<mutex> lock(task_mutex);
+
+	tasks.push_back({ next_id, t });
+
+	return next_id++;
+}
+
+void IdleScheduler::RemoveTask(int id)
+{
+	scoped_lock<mutex> lock(task_mutex);
+
+	erase_if(tasks, [id] (const task_t& t) { return t.id == id; });
+}
+
+void IdleScheduler::BusFree()
+{
+	// There is one command per selection
+	command_count.fetch_add(1, memory_order_relaxed);
+	bus_free_time.store(GetTime(), memory_order_relaxed);
+	busy.store(false, memory_order_release);
+}
+
+bool IdleScheduler::IsIdle() const
+{
+	return !IsPreempted() &&
+			GetTime() - bus_free_time.load(memory_order_relaxed) >= chrono::nanoseconds(idle_delay).count();
+}
+
+int IdleScheduler::RunTasks()
+{
+	scoped_lock<mutex> lock(task_mutex);
+
+	const int64_t start = GetTime();
+
+	// Round-robin, i.e. a long-running task does not delay the others
+	vector<bool> pending(tasks.size(), true);
+	int steps = 0;
+	bool has_work = true;
+	while (has_work) {
+		has_work = false;
+
+		for (size_t i = 0; i < tasks.size(); i++) {
+			if (!pending[i]) {
+				continue;
+			}
+
+			if (IsPreempted()) {
+				preempted_count.Increment();
+				has_work = false;
+				break;
+			}
+
+			steps++;
+			pending[i] = tasks[i].t(*this);
+			has_work |= pending[i];
+		}
+	}
+
+	step_count.Increment(steps);
+	task_time.Increment(GetTime() - start);
+
+	return steps;
+}
+
+void IdleScheduler::Run(const stop_token& token)
+{
+	mutex m;
+	condition_variable_any cv;
+
+	while (!token.stop_requested()) {
+		{
+			unique_lock<mutex> lock(m);
+			cv.wait_for(lock, token, POLL_INTERVAL, [] { return false; });
+		}
+
+		UpdateCommandRate();
+
+		if (IsIdle()) {
+			RunTasks();
+		}
+	}
+}
+
+void IdleScheduler::UpdateCommandRate()
+{
+	const int64_t now = GetTime();
+	if (now - rate_time < 1'000'000'000) {
+		return;
+	}
+
+	const uint64_t count = command_count.load(memory_order_relaxed);
+	if (rate_time) {
+		command_rate.Set((count - rate_command_count) * 1'000'000'000 / (now - rate_time));
+	}
+
+	rate_command_count = count;
+	rate_time = now;
+}
+
+int64_t IdleScheduler::GetTime()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
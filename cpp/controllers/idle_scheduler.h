@@ -0,0 +1,109 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Runs low-priority device tasks, e.g. writing back the disk cache, on a worker thread while the bus is idle.
+// The bus is idle when there has been no selection for the idle delay. The worker does not hold the execution
+// lock, i.e. the bus thread never waits for a task when responding to a selection. The tasks have to synchronize
+// with the bus thread themselves and must keep each step short, because the bus thread may need their data while
+// processing a command. When SEL is asserted the bus thread preempts the tasks, they are checked for preemption
+// after each step.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "devices/metrics_registry.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class IdleScheduler
+{
+
+public:
+
+	// Performs a step of the task and returns true if there is more work, i.e. if the task wants to be called
+	// again during the current idle window. Long-running tasks return early if IsPreempted() is true.
+	using task = function<bool(const IdleScheduler&)>;
+
+	// The statistics are added to the registry, they are not device specific
+	explicit IdleScheduler(MetricsRegistry&);
+	~IdleScheduler() { Stop(); }
+
+	void Start();
+	void Stop();
+
+	// Returns an ID for removing the task
+	int AddTask(const task&);
+	// Waits for the task to complete if it is running
+	void RemoveTask(int);
+
+	// Called by the bus thread when SEL is asserted and when the bus is free again
+	void BusBusy() { busy.store(true, memory_order_release); }
+	void BusFree();
+
+	bool IsPreempted() const { return busy.load(memory_order_acquire); }
+
+	// Whether there has been no selection for the idle delay
+	bool IsIdle() const;
+
+	void SetIdleDelay(chrono::milliseconds delay) { idle_delay = delay; }
+
+	// Runs the tasks until they are done or until they are preempted, returns the number of steps
+	int RunTasks();
+
+	static constexpr chrono::milliseconds DEFAULT_IDLE_DELAY = 100ms;
+
+	inline static const string IDLE_BUS_COMMAND_RATE = "idle_bus_command_rate";
+	inline static const string IDLE_TASK_STEP_COUNT = "idle_task_step_count";
+	inline static const string IDLE_TASK_PREEMPTED_COUNT = "idle_task_preempted_count";
+	inline static const string IDLE_TASK_TIME = "idle_task_time_ns";
+
+private:
+
+	void Run(const stop_token&);
+	void UpdateCommandRate();
+
+	static int64_t GetTime();
+
+	struct task_t {
+		int id;
+		task t;
+	};
+
+	// Protects the tasks, is held while running them
+	mutex task_mutex;
+	vector<task_t> tasks;
+	int next_id = 0;
+
+	chrono::milliseconds idle_delay = DEFAULT_IDLE_DELAY;
+
+	// The worker checks the bus activity with this interval
+	static constexpr chrono::milliseconds POLL_INTERVAL = 10ms;
+
+	// Updated by the bus thread. Times are steady clock times in ns.
+	atomic<bool> busy = false;
+	atomic<int64_t> bus_free_time = 0;
+	atomic<uint64_t> command_count = 0;
+
+	// Only accessed by the worker, the command rate is updated every second
+	uint64_t rate_command_count = 0;
+	int64_t rate_time = 0;
+
+	Gauge& command_rate;
+	Counter& step_count;
+	Counter& preempted_count;
+	Counter& task_time;
+
+	jthread worker;
+};
@@ -9,14 +9,16 @@
 
 #include "phase_handler.h"
 
-void PhaseHandler::Init()
-{
-	phase_executors[phase_t::busfree] = [this] () { BusFree(); };
-	phase_executors[phase_t::selection] = [this] () { Selection(); };
-	phase_executors[phase_t::dataout] = [this] () { DataOut(); };
-	phase_executors[phase_t::datain] = [this] () { DataIn(); };
-	phase_executors[phase_t::command] = [this] () { Command(); };
-	phase_executors[phase_t::status] = [this] () { Status(); };
-	phase_executors[phase_t::msgout] = [this] () { MsgOut(); };
-	phase_executors[phase_t::msgin] = [this] () { MsgIn(); };
-}
+const array<PhaseHandler::phase_executor, static_cast<int>(phase_t::reserved) + 1> PhaseHandler::phase_executors = {
+	&PhaseHandler::BusFree,		// busfree
+	nullptr,					// arbitration
+	&PhaseHandler::Selection,	// selection
+	nullptr,					// reselection
+	&PhaseHandler::Command,		// command
+	&PhaseHandler::DataIn,		// datain
+	&PhaseHandler::DataOut,		// dataout
+	&PhaseHandler::Status,		// status
+	&PhaseHandler::MsgIn,		// msgin
+	&PhaseHandler::MsgOut,		// msgout
+	nullptr						// reserved
+};
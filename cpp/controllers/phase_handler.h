@@ -11,8 +11,7 @@
 
 #include "shared/scsi.h"
 #include "shared/piscsi_exceptions.h"
-#include <unordered_map>
-#include <functional>
+#include <array>
 
 using namespace scsi_defs;
 
@@ -25,8 +24,6 @@ public:
 	PhaseHandler() = default;
 	virtual ~PhaseHandler() = default;
 
-	void Init();
-
 	virtual void BusFree() = 0;
 	virtual void Selection() = 0;
 	virtual void Command() = 0;
@@ -51,17 +48,20 @@ protected:
 	bool IsMsgIn() const { return phase == phase_t::msgin; }
 	bool IsMsgOut() const { return phase == phase_t::msgout; }
 
-	void ProcessPhase() const
+	void ProcessPhase()
 	{
-		try {
-			phase_executors.at(phase)();
-		}
-		catch(const out_of_range&) {
+		const auto executor = phase_executors[static_cast<int>(phase)];
+		if (executor == nullptr) {
 			throw scsi_exception(sense_key::aborted_command);
 		}
+
+		(this->*executor)();
 	}
 
 private:
 
-	unordered_map<phase_t, function<void()>> phase_executors;
+	using phase_executor = void (PhaseHandler::*)();
+
+	// Phase handlers indexed by phase, phases that cannot be handled by a target are nullptr
+	static const array<phase_executor, static_cast<int>(phase_t::reserved) + 1> phase_executors;
 };
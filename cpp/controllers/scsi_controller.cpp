@@ -17,17 +17,15 @@
 #include "hal/gpiobus.h"
 #include "hal/systimer.h"
 #include "controllers/controller_manager.h"
-#include "devices/scsi_daynaport.h"
-#include "devices/mode_page_device.h"
-#include "devices/disk.h"
+#include "devices/primary_device.h"
+#include "devices/scsi_command_util.h"
 #include "scsi_controller.h"
-#include <sstream>
-#include <iomanip>
 #ifdef __linux__
 #include <linux/if_tun.h>
 #endif
 
 using namespace scsi_defs;
+using namespace scsi_command_util;
 
 ScsiController::ScsiController(BUS& bus, int target_id) : AbstractController(bus, target_id, ControllerManager::GetScsiLunMax())
 {
@@ -38,6 +36,12 @@ ScsiController::ScsiController(BUS& bus, int target_id) : AbstractController(bus
 
 void ScsiController::Reset()
 {
+	// A bus reset during a command may be the reaction of the initiator to timing problems
+	if (command_executed) {
+		transfer_error = true;
+		AddDelayProfileResult();
+	}
+
 	AbstractController::Reset();
 
 	execstart = 0;
@@ -45,6 +49,14 @@ void ScsiController::Reset()
 	initiator_id = UNKNOWN_INITIATOR_ID;
 
 	scsi = {};
+
+	// A reset clears all queued commands
+	nexus = {};
+	command_queues.clear();
+	reselected = false;
+	reselection_failures = 0;
+
+	timestamps = {};
 }
 
 bool ScsiController::Process(int id)
@@ -79,6 +91,17 @@ void ScsiController::BusFree()
 {
 	if (!IsBusFree()) {
 		LogTrace("Bus Free phase");
+
+		if (timestamps.command) {
+			AddCommandTraceRecord();
+		}
+		timestamps = {};
+
+		if (command_executed) {
+			AddCommandTime();
+			AddDelayProfileResult();
+		}
+
 		SetPhase(phase_t::busfree);
 
 		GetBus().SetREQ(false);
@@ -95,6 +118,8 @@ void ScsiController::BusFree()
 		scsi.atnmsg = false;
 
 		identified_lun = -1;
+		nexus = {};
+		reselected = false;
 
 		SetByteTransfer(false);
 
@@ -112,9 +137,11 @@ void ScsiController::Selection()
 	if (!IsSelection()) {
 		LogTrace("Selection phase");
 		SetPhase(phase_t::selection);
+		SetTimestamp(timestamps.selection);
 
 		// Raise BSY and respond
 		GetBus().SetBSY(true);
+		AddSelectionLatency();
 		return;
 	}
 
@@ -136,16 +163,16 @@ void ScsiController::Command()
 	if (!IsCommand()) {
 		LogTrace("Command phase");
 		SetPhase(phase_t::command);
+		SetTimestamp(timestamps.command);
 
 		GetBus().SetMSG(false);
 		GetBus().SetCD(true);
 		GetBus().SetIO(false);
 
 		const int actual_count = GetBus().CommandHandShake(GetBuffer());
+		AddHandshakeTiming();
 		if (actual_count == 0) {
-			stringstream s;
-			s << "Received unknown command: $" << setfill('0') << setw(2) << hex << GetBuffer()[0];
-			LogTrace(s.str());
+			LogTrace("Received unknown command: ${:02x}", GetBuffer()[0]);
 
 			Error(sense_key::illegal_request, asc::invalid_command_operation_code);
 			return;
@@ -155,42 +182,50 @@ void ScsiController::Command()
 
 		// If not able to receive all, move to the status phase
 		if (actual_count != command_byte_count) {
-			stringstream s;
-			s << "Command byte count mismatch for command $" << setfill('0') << setw(2) << hex << GetBuffer()[0];
-			LogError(s.str() + ": expected " + to_string(command_byte_count) + " bytes, received"
-					+ to_string(actual_count) + " byte(s)");
+			LogError("Command byte count mismatch for command ${0:02x}: expected {1} bytes, received {2} byte(s)",
+					GetBuffer()[0], command_byte_count, actual_count);
 			Error(sense_key::aborted_command);
 			return;
 		}
 
 		// Command data transfer
-		AllocateCmd(command_byte_count);
 		for (int i = 0; i < command_byte_count; i++) {
 			SetCmdByte(i, GetBuffer()[i]);
 		}
 
 		SetLength(0);
 
-		Execute();
+		if (!QueueCommand()) {
+			Execute();
+		}
 	}
 }
 
 void ScsiController::Execute()
 {
-    if (spdlog::get_level() == spdlog::level::trace) {
-        stringstream s;
-        s << "Controller is executing " << command_mapping.find(GetOpcode())->second.second << ", CDB $"
-            << setfill('0') << hex;
-        for (int i = 0; i < BUS::GetCommandByteCount(static_cast<uint8_t>(GetOpcode())); i++) {
-            s << setw(2) << GetCmdByte(i);
-        }
-        LogTrace(s.str());
-    }
+	if (DeviceLogger::IsTraceEnabled()) {
+		const auto& descriptor = GetCommandDescriptor(GetOpcode());
+		const auto& cmd = GetCmd();
+		LogTrace("Controller is executing {0}, CDB ${1:02x}", descriptor.name,
+				fmt::join(span(cmd).first(descriptor.cdb_length), ""));
+	}
+
+	if (command_recorder != nullptr) {
+		const auto& cmd = GetCmd();
+		const auto length = max(GPIOBUS::GetCommandByteCount(static_cast<uint8_t>(cmd[0])), 1);
+		command_recorder->AddCommand(CommandTrace::GetTimestamp(), initiator_id, GetTargetId(), GetEffectiveLun(),
+				span(cmd).first(length));
+	}
 
 	// Initialization for data transfer
 	ResetOffset();
 	SetBlocks(1);
+	ClearTransferHandler();
 	execstart = SysTimer::GetTimerLow();
+	command_executed = true;
+	command_lun = -1;
+	command_start = CommandTrace::GetTimestamp();
+	transfer_error = false;
 
 	// Discard pending sense data from the previous command if the current command is not REQUEST SENSE
 	if (GetOpcode() != scsi_command::eCmdRequestSense) {
@@ -200,7 +235,7 @@ void ScsiController::Execute()
 	int lun = GetEffectiveLun();
 	if (!HasDeviceForLun(lun)) {
 		if (GetOpcode() != scsi_command::eCmdInquiry && GetOpcode() != scsi_command::eCmdRequestSense) {
-			LogTrace("Invalid LUN " + to_string(lun));
+			LogTrace("Invalid LUN {}", lun);
 
 			Error(sense_key::illegal_request, asc::invalid_lun);
 
@@ -214,7 +249,7 @@ void ScsiController::Execute()
 
 	// SCSI-2 4.4.3 Incorrect logical unit handling
 	if (GetOpcode() == scsi_command::eCmdInquiry && !HasDeviceForLun(lun)) {
-		LogTrace("Reporting LUN" + to_string(GetEffectiveLun()) + " as not supported");
+		LogTrace("Reporting LUN {} as not supported", GetEffectiveLun());
 
 		GetBuffer().data()[0] = 0x7f;
 
@@ -222,6 +257,7 @@ void ScsiController::Execute()
 	}
 
 	auto device = GetDeviceForLun(lun);
+	command_lun = lun;
 
 	// Discard pending sense data from the previous command if the current command is not REQUEST SENSE
 	if (GetOpcode() != scsi_command::eCmdRequestSense) {
@@ -244,18 +280,17 @@ void ScsiController::Execute()
 void ScsiController::Status()
 {
 	if (!IsStatus()) {
-		// Minimum execution time
-		// TODO Why is a delay needed? Is this covered by the SCSI specification?
+		// Minimum execution time, some older initiators fail if the status phase follows the command too quickly.
+		// This is not covered by the SCSI specification, see DelayProfiles.
 		if (execstart > 0) {
 			Sleep();
 		} else {
 			SysTimer::SleepUsec(5);
 		}
 
-		stringstream s;
-		s << "Status phase, status is $" << setfill('0') << setw(2) << hex << static_cast<int>(GetStatus());
-		LogTrace(s.str());
+		LogTrace("Status phase, status is ${:02x}", static_cast<int>(GetStatus()));
 		SetPhase(phase_t::status);
+		SetTimestamp(timestamps.status);
 
 		// Signal line operated by the target
 		GetBus().SetMSG(false);
@@ -335,6 +370,7 @@ void ScsiController::DataIn()
 
 		LogTrace("Data In phase");
 		SetPhase(phase_t::datain);
+		SetTimestamp(timestamps.data);
 
 		GetBus().SetMSG(false);
 		GetBus().SetCD(false);
@@ -364,6 +400,7 @@ void ScsiController::DataOut()
 
 		LogTrace("Data Out phase");
 		SetPhase(phase_t::dataout);
+		SetTimestamp(timestamps.data);
 
 		GetBus().SetMSG(false);
 		GetBus().SetCD(false);
@@ -411,10 +448,7 @@ void ScsiController::Error(sense_key sense_key, asc asc, status status)
 	}
 
 	if (sense_key != sense_key::no_sense || asc != asc::no_additional_sense_information) {
-		stringstream s;
-		s << setfill('0') << hex << "Error status: Sense Key $" << setw(2) << static_cast<int>(sense_key)
-				<< ", ASC $" << setw(2) << static_cast<int>(asc);
-		LogDebug(s.str());
+		LogDebug("Error status: Sense Key ${0:02x}, ASC ${1:02x}", static_cast<int>(sense_key), static_cast<int>(asc));
 
 		// Set Sense Key and ASC for a subsequent REQUEST SENSE
 		GetDeviceForLun(lun)->SetStatusCode((static_cast<int>(sense_key) << 16) | (static_cast<int>(asc) << 8));
@@ -431,15 +465,22 @@ void ScsiController::Send()
 	assert(!GetBus().GetREQ());
 	assert(GetBus().GetIO());
 
+	if (IsDataIn() && HasTransferHandler()) {
+		SendBlocks();
+		return;
+	}
+
 	if (HasValidLength()) {
-		LogTrace("Sending data, offset: " + to_string(GetOffset()) + ", length: " + to_string(GetLength()));
+		LogTrace("Sending data, offset: {0}, length: {1}", GetOffset(), GetLength());
 
 		// The delay should be taken from the respective LUN, but as there are no Daynaport drivers for
 		// LUNs other than 0 this work-around works.
-		if (const int len = GetBus().SendHandShake(GetBuffer().data() + GetOffset(), GetLength(),
+		const int len = GetBus().SendHandShake(GetBuffer().data() + GetOffset(), GetLength(),
 				HasDeviceForLun(0) ? GetDeviceForLun(0)->GetSendDelay() : 0);
-			len != static_cast<int>(GetLength())) {
+		AddHandshakeTiming();
+		if (len != static_cast<int>(GetLength())) {
 			// If you cannot send all, move to status phase
+			transfer_error = true;
 			Error(sense_key::aborted_command);
 			return;
 		}
@@ -454,7 +495,7 @@ void ScsiController::Send()
 	// Processing after data collection (read/data-in only)
 	if (IsDataIn() && HasBlocks()) {
 		// set next buffer (set offset, length)
-		if (!XferIn(GetBuffer())) {
+		if (!XferIn()) {
 			// If result FALSE, move to status phase
 			Error(sense_key::aborted_command);
 			return;
@@ -472,7 +513,7 @@ void ScsiController::Send()
 	}
 
 	// Move to next phase
-	LogTrace("All data transferred, moving to next phase: " + string(BUS::GetPhaseStrRaw(GetPhase())));
+	LogTrace("All data transferred, moving to next phase: {}", BUS::GetPhaseStrRaw(GetPhase()));
 	switch (GetPhase()) {
 		case phase_t::msgin:
 			// Completed sending response to extended message of IDENTIFY message
@@ -480,6 +521,13 @@ void ScsiController::Send()
 				scsi.atnmsg = false;
 
 				Command();
+			}
+			// Completed sending the IDENTIFY and the queue tag message after a reselection
+			else if (reselected) {
+				reselected = false;
+
+				SetTimestamp(timestamps.command);
+				Execute();
 			} else {
 				BusFree();
 			}
@@ -507,16 +555,27 @@ void ScsiController::Receive()
 	assert(!GetBus().GetREQ());
 	assert(!GetBus().GetIO());
 
+	if (IsDataOut() && HasTransferHandler() && !IsByteTransfer()) {
+		ReceiveBlocks();
+		return;
+	}
+
 	if (HasValidLength()) {
-		LogTrace("Receiving data, transfer length: " + to_string(GetLength()) + " byte(s)");
+		LogTrace("Receiving data, transfer length: {} byte(s)", GetLength());
 
 		// If not able to receive all, move to status phase
-		if (uint32_t len = GetBus().ReceiveHandShake(GetBuffer().data() + GetOffset(), GetLength()); len != GetLength()) {
-			LogError("Not able to receive " + to_string(GetLength()) + " byte(s) of data, only received "
-					+ to_string(len));
+		const uint32_t len = GetBus().ReceiveHandShake(GetBuffer().data() + GetOffset(), GetLength());
+		AddHandshakeTiming();
+		if (len != GetLength()) {
+			LogError("Not able to receive {0} byte(s) of data, only received {1}", GetLength(), len);
+			transfer_error = true;
 			Error(sense_key::aborted_command);
 			return;
 		}
+
+		if (command_recorder != nullptr && IsDataOut()) {
+			command_recorder->AddDataOut(span(GetBuffer().data() + GetOffset(), GetLength()));
+		}
 	}
 
 	if (IsByteTransfer()) {
@@ -533,7 +592,7 @@ void ScsiController::Receive()
 	bool result = true;
 
 	// Processing after receiving data (by phase)
-	LogTrace("Phase: " + string(BUS::GetPhaseStrRaw(GetPhase())));
+	LogTrace("Phase: {}", BUS::GetPhaseStrRaw(GetPhase()));
 	switch (GetPhase()) {
 		case phase_t::dataout:
 			if (!HasBlocks()) {
@@ -597,6 +656,83 @@ void ScsiController::Receive()
 	}
 }
 
+// Block-oriented DATA IN (e.g. READ): The blocks are sent in a single loop instead of returning to the phase
+// loop after each block. The command has already been validated and the first block has been provided by the device.
+void ScsiController::SendBlocks()
+{
+	// See Send() regarding the delay
+	const int delay = HasDeviceForLun(0) ? GetDeviceForLun(0)->GetSendDelay() : 0;
+
+	while (true) {
+		if (HasValidLength()) {
+			const int len = GetBus().SendHandShake(GetBuffer().data() + GetOffset(), GetLength(), delay);
+			AddHandshakeTiming();
+			if (len != static_cast<int>(GetLength())) {
+				transfer_error = true;
+				Error(sense_key::aborted_command);
+				return;
+			}
+
+			UpdateOffsetAndLength();
+		}
+
+		DecrementBlocks();
+		if (!HasBlocks()) {
+			break;
+		}
+
+		try {
+			SetLength(TransferBlock(GetNext()));
+		}
+		catch(const scsi_exception&) {
+			Error(sense_key::aborted_command);
+			return;
+		}
+
+		IncrementNext();
+		ResetOffset();
+	}
+
+	Status();
+}
+
+// Block-oriented DATA OUT (e.g. WRITE): The blocks are received in a single loop instead of returning to the phase
+// loop after each block
+void ScsiController::ReceiveBlocks()
+{
+	while (true) {
+		if (HasValidLength()) {
+			const uint32_t len = GetBus().ReceiveHandShake(GetBuffer().data() + GetOffset(), GetLength());
+			AddHandshakeTiming();
+			if (len != GetLength()) {
+				LogError("Not able to receive {0} byte(s) of data, only received {1}", GetLength(), len);
+				transfer_error = true;
+				Error(sense_key::aborted_command);
+				return;
+			}
+
+			if (command_recorder != nullptr) {
+				command_recorder->AddDataOut(span(GetBuffer().data() + GetOffset(), GetLength()));
+			}
+
+			UpdateOffsetAndLength();
+		}
+
+		DecrementBlocks();
+
+		if (!XferOutBlockOriented(HasBlocks())) {
+			Error(sense_key::aborted_command);
+			return;
+		}
+
+		if (!HasBlocks()) {
+			break;
+		}
+	}
+
+	Status();
+}
+
 bool ScsiController::XferMsg(int msg)
 {
 	assert(IsMsgOut());
@@ -622,7 +758,7 @@ void ScsiController::ReceiveBytes()
 	bool result = true;
 
 	// Processing after receiving data (by phase)
-	LogTrace("Phase: " + string(BUS::GetPhaseStrRaw(GetPhase())));
+	LogTrace("Phase: {}", BUS::GetPhaseStrRaw(GetPhase()));
 	switch (GetPhase()) {
 		case phase_t::dataout:
 			result = XferOut(false);
@@ -689,28 +825,9 @@ void ScsiController::DataOutNonBlockOriented() const
 {
 	assert(IsDataOut());
 
-	switch (GetOpcode()) {
-		case scsi_command::eCmdWrite6:
-		case scsi_command::eCmdWrite10:
-		case scsi_command::eCmdWrite16:
-		case scsi_command::eCmdWriteLong10:
-		case scsi_command::eCmdWriteLong16:
-		case scsi_command::eCmdVerify10:
-		case scsi_command::eCmdVerify16:
-		case scsi_command::eCmdModeSelect6:
-		case scsi_command::eCmdModeSelect10:
-			break;
-
-		case scsi_command::eCmdSetMcastAddr:
-			// TODO: Eventually, we should store off the multicast address configuration data here...
-			break;
-
-		default:
-			stringstream s;
-			s << "Unexpected Data Out phase for command $" << setfill('0') << setw(2) << hex
-					<< static_cast<int>(GetOpcode());
-			LogWarn(s.str());
-			break;
+	// TODO: Eventually, we should store off the SetMcastAddr multicast address configuration data here...
+	if (GetCommandDescriptor(GetOpcode()).direction != transfer_direction::out) {
+		LogWarn("Unexpected Data Out phase for command ${:02x}", static_cast<int>(GetOpcode()));
 	}
 }
 
@@ -720,43 +837,28 @@ void ScsiController::DataOutNonBlockOriented() const
 //	*Reset offset and length
 //
 //---------------------------------------------------------------------------
-bool ScsiController::XferIn(vector<uint8_t>& buf)
+bool ScsiController::XferIn()
 {
 	assert(IsDataIn());
 
-	stringstream s;
-	s << "Command: $" << setfill('0') << setw(2) << hex << static_cast<int>(GetOpcode());
-	LogTrace(s.str());
+	LogTrace("Command: ${:02x}", static_cast<int>(GetOpcode()));
 
-	const int lun = GetEffectiveLun();
-	if (!HasDeviceForLun(lun)) {
+	if (!HasTransferHandler()) {
 		return false;
 	}
 
-	// Limited to read commands
-	switch (GetOpcode()) {
-		case scsi_command::eCmdRead6:
-		case scsi_command::eCmdRead10:
-		case scsi_command::eCmdRead16:
-			// Read from StorageDevice
-			try {
-				SetLength(dynamic_pointer_cast<StorageDevice>(GetDeviceForLun(lun))->Read(buf, GetNext()));
-			}
-			catch(const scsi_exception&) {
-				// If there is an error, go to the status phase
-				return false;
-			}
-
-			IncrementNext();
+	try {
+		SetLength(TransferBlock(GetNext()));
+	}
+	catch(const scsi_exception&) {
+		// If there is an error, go to the status phase
+		return false;
+	}
 
-			// If things are normal, work setting
-			ResetOffset();
-			break;
+	IncrementNext();
 
-		default:
-			assert(false);
-			return false;
-	}
+	// If things are normal, work setting
+	ResetOffset();
 
 	return true;
 }
@@ -766,104 +868,29 @@ bool ScsiController::XferIn(vector<uint8_t>& buf)
 //	Data transfer OUT
 //	*If cont=true, reset the offset and length
 //
-// TODO Try to use less casts
-//
 //---------------------------------------------------------------------------
 bool ScsiController::XferOutBlockOriented(bool cont)
 {
-	auto device = GetDeviceForLun(GetEffectiveLun());
-
-	// Limited to write commands
-	switch (GetOpcode()) {
-		case scsi_command::eCmdModeSelect6:
-		case scsi_command::eCmdModeSelect10:
-		{
-			auto mode_page_device = dynamic_pointer_cast<ModePageDevice>(device);
-			if (mode_page_device == nullptr) {
-				return false;
-			}
-
-			try {
-				mode_page_device->ModeSelect(GetOpcode(), GetCmd(), GetBuffer(), GetOffset());
-			}
-			catch(const scsi_exception& e) {
-				Error(e.get_sense_key(), e.get_asc());
-				return false;
-			}
-
-			break;
-		}
-
-		case scsi_command::eCmdWrite6:
-		case scsi_command::eCmdWrite10:
-		case scsi_command::eCmdWrite16:
-		{
-			// TODO Get rid of this special case for SCDP
-			if (auto daynaport = dynamic_pointer_cast<SCSIDaynaPort>(device); daynaport) {
-				if (!daynaport->Write(GetCmd(), GetBuffer())) {
-					return false;
-				}
-
-				ResetOffset();
-				break;
-			}
-
-			auto storage = dynamic_pointer_cast<StorageDevice>(device);
-			if (storage == nullptr) {
-				return false;
-			}
-
-			try {
-				storage->Write(GetBuffer(), GetNext() - 1);
-			}
-			catch(const scsi_exception& e) {
-				Error(e.get_sense_key(), e.get_asc());
-
-				return false;
-			}
-
-			// If you do not need the next block, end here
-			IncrementNext();
-			if (cont) {
-				SetLength(storage->GetSectorSizeInBytes());
-				ResetOffset();
-			}
-
-			break;
-		}
-
-		case scsi_command::eCmdVerify10:
-		case scsi_command::eCmdVerify16:
-		{
-			auto storage = dynamic_pointer_cast<StorageDevice>(device);
-			if (storage == nullptr) {
-				return false;
-			}
-
-			// If you do not need the next block, end here
-			IncrementNext();
-			if (cont) {
-				SetLength(storage->GetSectorSizeInBytes());
-				ResetOffset();
-			}
-
-			break;
-		}
-
-		case scsi_command::eCmdSetMcastAddr:
-			LogTrace("Done with DaynaPort Set Multicast Address");
-			break;
+	// Commands without a handler do not need any processing of their block, unexpected Data Out phases are
+	// reported by DataOutNonBlockOriented()
+	if (!HasTransferHandler()) {
+		return true;
+	}
 
-		case scsi_command::eCmdSetIfaceMode:
-            LogTrace("Done with setting DaynaPort MAC address (ignore)");
-            break;
+	int length;
+	try {
+		length = TransferBlock(GetNext() - 1);
+	}
+	catch(const scsi_exception& e) {
+		Error(e.get_sense_key(), e.get_asc());
+		return false;
+	}
 
-		default:
-			stringstream s;
-			s << "Received an unexpected command ($" << setfill('0') << setw(2) << hex
-					<< static_cast<int>(GetOpcode()) << ")";
-			LogWarn(s.str());
-			break;
+	// If you do not need the next block, end here
+	IncrementNext();
+	if (cont) {
+		SetLength(length);
+		ResetOffset();
 	}
 
 	return true;
@@ -873,15 +900,14 @@ void ScsiController::ProcessCommand()
 {
 	const uint32_t len = GPIOBUS::GetCommandByteCount(GetBuffer()[0]);
 
-	stringstream s;
-	s << "CDB=$" << setfill('0') << setw(2) << hex;
 	for (uint32_t i = 0; i < len; i++) {
 		SetCmdByte(i, GetBuffer()[i]);
-		s << GetCmdByte(i);
 	}
-	LogTrace(s.str());
+	LogTrace("CDB=${:02x}", fmt::join(span(GetBuffer().data(), len), ""));
 
-	Execute();
+	if (!QueueCommand()) {
+		Execute();
+	}
 }
 
 void ScsiController::ParseMessage()
@@ -892,6 +918,10 @@ void ScsiController::ParseMessage()
 
 		if (message_type == 0x06) {
 			LogTrace("Received ABORT message");
+			// The queued commands of the initiator are aborted, too
+			if (auto it = command_queues.find(identified_lun); it != command_queues.end()) {
+				it->second.RemoveAll(initiator_id);
+			}
 			BusFree();
 			return;
 		}
@@ -902,13 +932,55 @@ void ScsiController::ParseMessage()
 			if (auto device = GetDeviceForLun(identified_lun); device != nullptr) {
 				device->DiscardReservation();
 			}
+			command_queues.clear();
+			BusFree();
+			return;
+		}
+
+		if (IsQueueTagMessage(message_type)) {
+			// Without queuing the initiator has to continue with an untagged command.
+			// The remaining bytes are not parsed, the tag byte may look like an IDENTIFY message.
+			if (!CommandQueue::GetMaxDepth() || i + 1 >= scsi.msc) {
+				LogTrace("Rejecting queue tag message ${:02x}", message_type);
+				SetLength(1);
+				SetBlocks(1);
+				GetBuffer()[0] = 0x07;
+				MsgIn();
+				return;
+			}
+
+			nexus.tagged = true;
+			nexus.type = static_cast<CommandQueue::tag_type>(message_type);
+			nexus.tag = scsi.msb[i + 1];
+			LogTrace("Received queue tag message ${0:02x}, tag {1}", message_type, nexus.tag);
+
+			// Skip the tag byte
+			i += 2;
+			continue;
+		}
+
+		if (message_type == 0x0D) {
+			LogTrace("Received ABORT TAG message for tag {}", nexus.tag);
+			if (auto it = command_queues.find(identified_lun); nexus.tagged && it != command_queues.end()) {
+				it->second.Remove(initiator_id, nexus.tag);
+			}
+			BusFree();
+			return;
+		}
+
+		if (message_type == 0x0E) {
+			LogTrace("Received CLEAR QUEUE message");
+			if (auto it = command_queues.find(identified_lun); it != command_queues.end()) {
+				it->second.Clear();
+			}
 			BusFree();
 			return;
 		}
 
 		if (message_type >= 0x80) {
 			identified_lun = static_cast<int>(message_type) & 0x1F;
-			LogTrace("Received IDENTIFY message for LUN " + to_string(identified_lun));
+			nexus.can_disconnect = message_type & 0x40;
+			LogTrace("Received IDENTIFY message for LUN {}", identified_lun);
 		}
 
 		if (message_type == 0x01) {
@@ -963,6 +1035,11 @@ void ScsiController::ProcessMessage()
 
 	if (scsi.atnmsg) {
 		ParseMessage();
+
+		// A response message (the command phase follows after it has been sent) or bus free
+		if (!IsMsgOut()) {
+			return;
+		}
 	}
 
 	// Initialize ATN message reception status
@@ -971,6 +1048,205 @@ void ScsiController::ProcessMessage()
 	Command();
 }
 
+bool ScsiController::IsQueueTagMessage(uint8_t message_type)
+{
+	// SIMPLE QUEUE TAG, HEAD OF QUEUE TAG, ORDERED QUEUE TAG
+	return message_type >= 0x20 && message_type <= 0x22;
+}
+
+CommandQueue& ScsiController::GetCommandQueue(int lun)
+{
+	return command_queues.try_emplace(lun, CommandQueue::GetMaxDepth()).first->second;
+}
+
+bool ScsiController::QueueCommand()
+{
+	// Untagged commands and commands of initiators that cannot be reselected are executed immediately
+	if (!nexus.tagged || !nexus.can_disconnect || initiator_id == UNKNOWN_INITIATOR_ID || !GetBus().CanReselect()) {
+		return false;
+	}
+
+	const int lun = GetEffectiveLun();
+	if (const auto& device = GetDeviceForLun(lun); device == nullptr || !device->SupportsCommandQueuing()) {
+		return false;
+	}
+
+	auto& queue = GetCommandQueue(lun);
+
+	// SCSI-2 7.5.2: A tag that is still in use aborts all commands of the initiator
+	if (queue.Contains(initiator_id, nexus.tag)) {
+		LogWarn("Initiator ID {0} reused tag {1}, aborting its queued commands", initiator_id, nexus.tag);
+		queue.RemoveAll(initiator_id);
+		Error(sense_key::aborted_command, asc::overlapped_commands_attempted);
+		return true;
+	}
+
+	if (!queue.Add(initiator_id, nexus.tag, nexus.type, GetCmd())) {
+		LogTrace("Queue of LUN {} is full", lun);
+		Error(sense_key::no_sense, asc::no_additional_sense_information, status::queue_full);
+		return true;
+	}
+
+	LogTrace("Queued command ${0:02x} with tag {1}, disconnecting", static_cast<int>(GetOpcode()), nexus.tag);
+
+	// The command is traced when it is executed after the reselection
+	timestamps = {};
+
+	SetLength(1);
+	SetBlocks(1);
+	GetBuffer()[0] = 0x04;
+	MsgIn();
+
+	return true;
+}
+
+bool ScsiController::HasQueuedCommands() const
+{
+	return ranges::any_of(command_queues, [] (const auto& q) { return !q.second.IsEmpty(); });
+}
+
+void ScsiController::ProcessQueuedCommand()
+{
+	const int max_luns = GetMaxLuns();
+	int lun = -1;
+	for (int i = 0; i < max_luns; i++) {
+		const int l = (next_queue_lun + i) % max_luns;
+		if (const auto& it = command_queues.find(l); it != command_queues.end() && !it->second.IsEmpty()) {
+			lun = l;
+			break;
+		}
+	}
+	if (lun == -1) {
+		return;
+	}
+	next_queue_lun = (lun + 1) % max_luns;
+
+	auto& queue = command_queues.at(lun);
+	const auto& next = *queue.Peek();
+
+	// Reading the blocks before reselecting lets the initiator use the bus in the meantime
+	if (const auto& device = GetDeviceForLun(lun); device != nullptr && next.has_blocks && next.is_read) {
+		const auto [start, count] = queue.GetMergedReadRange(next);
+		device->Prefetch(start, count);
+	}
+
+	if (!GetBus().Reselect(GetTargetId(), next.initiator_id)) {
+		if (++reselection_failures >= MAX_RESELECTION_ATTEMPTS) {
+			LogWarn("Initiator ID {} does not respond to the reselection, discarding its queued commands",
+					next.initiator_id);
+			queue.RemoveAll(next.initiator_id);
+			reselection_failures = 0;
+		}
+		return;
+	}
+	reselection_failures = 0;
+
+	const auto command = queue.Pop();
+
+	SetPhase(phase_t::reselection);
+	SetTimestamp(timestamps.selection);
+	initiator_id = command.initiator_id;
+	identified_lun = lun;
+	nexus = { .tagged = true, .type = command.type, .tag = command.tag, .can_disconnect = true };
+	for (size_t i = 0; i < command.cdb.size(); i++) {
+		SetCmdByte(static_cast<int>(i), command.cdb[i]);
+	}
+
+	LogTrace("Reselected initiator ID {0} for tag {1}", initiator_id, command.tag);
+
+	// IDENTIFY and SIMPLE QUEUE TAG restore the nexus of the command
+	SetLength(3);
+	SetBlocks(1);
+	GetBuffer()[0] = static_cast<uint8_t>(0x80 | lun);
+	GetBuffer()[1] = static_cast<uint8_t>(CommandQueue::tag_type::simple);
+	GetBuffer()[2] = command.tag;
+	reselected = true;
+	MsgIn();
+
+	while (Process(initiator_id)) {
+		// Process the command until the bus is free
+	}
+}
+
+void ScsiController::AddHandshakeTiming()
+{
+	if (handshake_statistics != nullptr && GetBus().GetHandshakeTiming().IsEnabled()) {
+		handshake_statistics->Add(initiator_id, GetBus().GetHandshakeTiming().GetTotals());
+	}
+}
+
+void ScsiController::AddSelectionLatency()
+{
+	if (selection_statistics == nullptr) {
+		return;
+	}
+
+	if (const uint64_t latency = selection_statistics->Add(GetTargetId());
+			selection_statistics->IsAboveThreshold(latency)) {
+		LogWarn("Selection by initiator ID {0} took {1} us, the threshold is {2} us", initiator_id, latency / 1000,
+				selection_statistics->GetWarningThreshold());
+	}
+}
+
+void ScsiController::AddCommandTraceRecord()
+{
+	const uint64_t now = CommandTrace::GetTimestamp();
+
+	// Phases that were not entered, e.g. because of an error, have a duration of 0
+	const uint64_t command_end = timestamps.data ? timestamps.data : (timestamps.status ? timestamps.status : now);
+	const uint64_t status = timestamps.status ? timestamps.status : now;
+	const auto duration = [] (uint64_t start, uint64_t end) {
+		return start && end > start ? static_cast<uint32_t>(min(end - start, static_cast<uint64_t>(UINT32_MAX))) : 0;
+	};
+
+	CommandTrace::command_record record = {};
+	record.timestamp = timestamps.selection ? timestamps.selection : timestamps.command;
+	record.selection_duration = duration(timestamps.selection, timestamps.command);
+	record.command_duration = duration(timestamps.command, command_end);
+	record.data_duration = duration(timestamps.data, status);
+	record.status_duration = duration(timestamps.status, now);
+
+	const auto opcode = GetOpcode();
+	record.opcode = static_cast<uint8_t>(opcode);
+	record.status = static_cast<uint8_t>(GetStatus());
+	record.initiator_id = static_cast<int8_t>(initiator_id);
+	record.target_id = static_cast<uint8_t>(GetTargetId());
+	record.lun = static_cast<uint8_t>(GetEffectiveLun());
+
+	const int cdb_length = GetCommandDescriptor(opcode).cdb_length;
+	array<uint8_t, 16> cdb = {};
+	for (int i = 0; i < cdb_length; i++) {
+		cdb[i] = GetCmdByte(i);
+	}
+
+	switch (cdb_length) {
+		case 6:
+			record.lba = GetInt24(cdb, 1) & 0x1fffff;
+			record.length = cdb[4];
+			break;
+
+		case 10:
+			record.lba = GetInt32(cdb, 2);
+			record.length = GetInt16(cdb, 7);
+			break;
+
+		case 12:
+			record.lba = GetInt32(cdb, 2);
+			record.length = GetInt32(cdb, 6);
+			break;
+
+		case 16:
+			record.lba = GetInt64(cdb, 2);
+			record.length = GetInt32(cdb, 10);
+			break;
+
+		default:
+			break;
+	}
+
+	command_trace->Add(record);
+}
+
 int ScsiController::GetEffectiveLun() const
 {
 	// Return LUN from IDENTIFY message, or return the LUN from the CDB as fallback
@@ -979,10 +1255,29 @@ int ScsiController::GetEffectiveLun() const
 
 void ScsiController::Sleep()
 {
-	if (const uint32_t time = SysTimer::GetTimerLow() - execstart; time < MIN_EXEC_TIME) {
-		SysTimer::SleepUsec(MIN_EXEC_TIME - time);
+	const uint32_t min_exec_time = delay_profiles != nullptr ?
+			delay_profiles->GetDelay(initiator_id, MIN_EXEC_TIME) : MIN_EXEC_TIME;
+	if (const uint32_t time = SysTimer::GetTimerLow() - execstart; time < min_exec_time) {
+		SysTimer::SleepUsec(min_exec_time - time);
 	}
 	execstart = 0;
 }
 
+void ScsiController::AddCommandTime() const
+{
+	// The device may have been detached in the meantime
+	if (const auto& device = GetDeviceForLun(command_lun); device != nullptr) {
+		device->AddCommandTime((CommandTrace::GetTimestamp() - command_start) / 1000);
+	}
+}
+
+void ScsiController::AddDelayProfileResult()
+{
+	if (delay_profiles != nullptr) {
+		delay_profiles->AddResult(initiator_id, !transfer_error, MIN_EXEC_TIME);
+	}
+
+	command_executed = false;
+}
+
 unsigned int ScsiController::MIN_EXEC_TIME = 50;
@@ -16,7 +16,14 @@
 
 #include "shared/scsi.h"
 #include "abstract_controller.h"
+#include "command_queue.h"
+#include "command_trace.h"
+#include "command_recorder.h"
+#include "delay_profiles.h"
+#include "handshake_statistics.h"
+#include "selection_statistics.h"
 #include <array>
+#include <unordered_map>
 
 using namespace std;
 
@@ -66,6 +73,24 @@ public:
 
 	int GetInitiatorId() const override { return initiator_id; }
 
+	bool HasQueuedCommands() const override;
+	void ProcessQueuedCommand() override;
+
+	// Records the phase timings of each command if set
+	void SetCommandTrace(CommandTrace *trace) { command_trace = trace; }
+
+	// Records the CDB and the data out payload of each command if set
+	void SetCommandRecorder(CommandRecorder *recorder) { command_recorder = recorder; }
+
+	// Provides the minimum execution time for the current initiator if set, MIN_EXEC_TIME otherwise
+	void SetDelayProfiles(DelayProfiles *profiles) { delay_profiles = profiles; }
+
+	// Aggregates the handshake timings of the bus if set and if the bus records them
+	void SetHandshakeStatistics(HandshakeStatistics *statistics) { handshake_statistics = statistics; }
+
+	// Records the selection response time if set
+	void SetSelectionStatistics(SelectionStatistics *statistics) { selection_statistics = statistics; }
+
 	// Phases
 	void BusFree() override;
 	void Selection() override;
@@ -76,6 +101,26 @@ public:
 	void DataIn() override;
 	void DataOut() override;
 
+protected:
+
+	void ParseMessage();
+
+	scsi_t scsi = {};
+
+	// The I_T_L_Q nexus of the current command, from the IDENTIFY and the queue tag messages
+	struct nexus_t {
+		bool tagged;
+		CommandQueue::tag_type type;
+		uint8_t tag;
+		// The initiator permits disconnecting
+		bool can_disconnect;
+	};
+	nexus_t nexus = {};
+
+	// The tagged commands of each LUN, only created for LUNs with tagged commands
+	unordered_map<int, CommandQueue> command_queues;
+	CommandQueue& GetCommandQueue(int);
+
 private:
 
 	// Execution start time
@@ -87,26 +132,78 @@ private:
 	// The LUN from the IDENTIFY message
 	int identified_lun = -1;
 
+	CommandTrace *command_trace = nullptr;
+
+	CommandRecorder *command_recorder = nullptr;
+
+	DelayProfiles *delay_profiles = nullptr;
+
+	HandshakeStatistics *handshake_statistics = nullptr;
+	void AddHandshakeTiming();
+
+	SelectionStatistics *selection_statistics = nullptr;
+	void AddSelectionLatency();
+
+	// The outcome of the current command, for adaptive delay profiles
+	bool command_executed = false;
+	bool transfer_error = false;
+	void AddDelayProfileResult();
+
+	// The LUN and the start time of the current command, for the command time statistics of the device
+	int command_lun = -1;
+	uint64_t command_start = 0;
+	void AddCommandTime() const;
+
+	// Start times of the phases of the current command, 0 if a phase has not been entered
+	struct phase_timestamps_t {
+		uint64_t selection;
+		uint64_t command;
+		uint64_t data;
+		uint64_t status;
+	};
+	phase_timestamps_t timestamps = {};
+
+	void SetTimestamp(uint64_t& timestamp) const
+	{
+		if (command_trace != nullptr) {
+			timestamp = CommandTrace::GetTimestamp();
+		}
+	}
+	void AddCommandTraceRecord();
+
 	// Data transfer
 	void Send();
+	void SendBlocks();
 	bool XferMsg(int);
-	bool XferIn(vector<uint8_t>&);
+	bool XferIn();
 	bool XferOut(bool);
 	bool XferOutBlockOriented(bool);
 	void ReceiveBytes();
 
 	void DataOutNonBlockOriented() const;
 	void Receive();
+	void ReceiveBlocks();
 
 	// TODO Make non-virtual as soon as SysTimer calls do not segfault anymore on a regular PC, e.g. by using ifdef __arm__.
 	virtual void Execute();
 
 	void ProcessCommand();
-	void ParseMessage();
 	void ProcessMessage();
+	static bool IsQueueTagMessage(uint8_t);
 
-	void Sleep();
+	// Queues a tagged command and disconnects, returns false if the command has to be executed immediately
+	bool QueueCommand();
 
-	scsi_t scsi = {};
+	// The command being executed after a reselection
+	bool reselected = false;
+
+	// Consecutive reselections without a response from the initiator
+	int reselection_failures = 0;
+	static const int MAX_RESELECTION_ATTEMPTS = 3;
+
+	// The LUN to start searching for queued commands with, the LUNs are served in turns
+	int next_queue_lun = 0;
+
+	void Sleep();
 };
 
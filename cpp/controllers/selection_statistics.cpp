@@ -0,0 +1,57 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "selection_statistics.h"
+#include <chrono>
+
+using namespace std;
+
+SelectionStatistics::SelectionStatistics(MetricsRegistry& metrics) : metrics(metrics)
+{
+	// There is no threshold to be exceeded unless it has been set
+	metrics.SetCondition(SELECTION_THRESHOLD_EXCEEDED, [this] { return warning_threshold != 0; });
+}
+
+uint64_t SelectionStatistics::Add(int target_id)
+{
+	const uint64_t timestamp = select_timestamp;
+	select_timestamp = 0;
+
+	if (!timestamp || target_id < 0 || target_id >= static_cast<int>(entries.size())) {
+		return 0;
+	}
+
+	const uint64_t now = GetTimestamp();
+	// The time may not be 0, because 0 means that there is no latency
+	const uint64_t latency = now > timestamp ? now - timestamp : 1;
+
+	auto& entry = entries[target_id];
+	if (entry == nullptr) {
+		const metric_labels_t labels = { .id = target_id };
+		entry = make_unique<entry_t>(entry_t {
+			metrics.AddHistogram(SELECTION_LATENCY, PbStatisticsCategory::CATEGORY_INFO, labels),
+			metrics.AddGauge(SELECTION_LATENCY_MAX, PbStatisticsCategory::CATEGORY_INFO, labels),
+			metrics.AddCounter(SELECTION_THRESHOLD_EXCEEDED, PbStatisticsCategory::CATEGORY_INFO, labels)
+		});
+	}
+
+	entry->latency.Record(latency);
+	entry->max.SetMax(latency);
+	if (IsAboveThreshold(latency)) {
+		entry->exceeded.Increment();
+	}
+
+	return latency;
+}
+
+uint64_t SelectionStatistics::GetTimestamp()
+{
+	// The kernel timestamps of the SEL edges are based on the monotonic clock (since Linux 5.7), like steady_clock
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,71 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Per-target aggregation of the selection response time, i.e. the time from the SEL edge to the assertion
+// of BSY. Hosts give up on a target that does not respond within the selection timeout, and some hosts
+// use a much shorter timeout than the 250 ms recommended by the standard.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "devices/metrics_registry.h"
+#include <array>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class SelectionStatistics
+{
+
+public:
+
+	// The statistics are added to the registry with the target ID when a target is selected for the first time,
+	// i.e. only targets with selections are reported
+	explicit SelectionStatistics(MetricsRegistry&);
+	~SelectionStatistics() = default;
+
+	// Called by the bus thread with the time of the SEL edge, before the selection is processed
+	void SetSelectTimestamp(uint64_t timestamp) { select_timestamp = timestamp; }
+
+	// Called by the bus thread when BSY has been asserted. Returns the response time in ns, or 0 if there is
+	// no SEL timestamp, e.g. for a selection that was not reported by the selection loop.
+	uint64_t Add(int);
+
+	// In us, 0 means no threshold
+	void SetWarningThreshold(uint32_t threshold) { warning_threshold = threshold; }
+	uint32_t GetWarningThreshold() const { return warning_threshold; }
+	bool IsAboveThreshold(uint64_t ns) const { return warning_threshold && ns > warning_threshold * 1000ULL; }
+
+	// The time base of the SEL timestamps, in ns
+	static uint64_t GetTimestamp();
+
+	// The number of selections is the count of the histogram
+	inline static const string SELECTION_LATENCY = "selection_latency_ns";
+	inline static const string SELECTION_LATENCY_MAX = "selection_latency_max_ns";
+	inline static const string SELECTION_THRESHOLD_EXCEEDED = "selection_threshold_exceeded_count";
+
+private:
+
+	// Updated by the bus thread and read by the service thread. Times are in ns.
+	struct entry_t {
+		Histogram& latency;
+		Gauge& max;
+		Counter& exceeded;
+	};
+
+	MetricsRegistry& metrics;
+
+	// Indexed by the target ID, only accessed by the bus thread
+	array<unique_ptr<entry_t>, 8> entries;
+
+	// Only accessed by the bus thread, reset as soon as it has been used
+	uint64_t select_timestamp = 0;
+
+	uint32_t warning_threshold = 0;
+};
@@ -24,6 +24,10 @@
 #include <linux/if_tun.h>
 #include <linux/sockios.h>
 #endif
+#if defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
 
 using namespace std;
 using namespace piscsi_util;
@@ -80,6 +84,11 @@ bool CTapDriver::Init(const param_map& const_params)
 		interfaces.push_back(interface);
 	}
 	inet = params["inet"];
+	if (params["fcs"] != "true" && params["fcs"] != "false") {
+		spdlog::error("Invalid fcs setting '" + params["fcs"] + "', must be 'true' or 'false'");
+		return false;
+	}
+	fcs = params["fcs"] == "true";
 
 	spdlog::trace("Opening tap device");
 	// TAP device initilization
@@ -217,7 +226,8 @@ param_map CTapDriver::GetDefaultParams() const
 {
 	return {
 		{ "interface", Join(GetNetworkInterfaces(), ",") },
-		{ "inet", DEFAULT_IP }
+		{ "inet", DEFAULT_IP },
+		{ "fcs", "true" }
 	};
 }
 
@@ -340,8 +350,16 @@ bool CTapDriver::HasPendingPackets() const
 	return fds.revents & POLLIN;
 }
 
+uint32_t CTapDriver::Crc32(span<const uint8_t> data)
+{
+	// The CPU features are only checked once
+	static const auto crc32 = HasHardwareCrc32() ? &Crc32Hardware : &Crc32Table;
+
+	return crc32(data);
+}
+
 // See https://stackoverflow.com/questions/21001659/crc32-algorithm-implementation-in-c-without-a-look-up-table-and-with-a-public-li
-uint32_t CTapDriver::Crc32(span<const uint8_t> data) {
+uint32_t CTapDriver::Crc32Bitwise(span<const uint8_t> data) {
    uint32_t crc = 0xffffffff;
    for (const auto d: data) {
       crc ^= d;
@@ -353,6 +371,76 @@ uint32_t CTapDriver::Crc32(span<const uint8_t> data) {
    return ~crc;
 }
 
+// Table n contains the CRC of a byte followed by n zero bytes, which is what slicing-by-8 is based on
+static constexpr auto CRC32_TABLES = [] {
+	array<array<uint32_t, 256>, 8> tables = {};
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (int j = 0; j < 8; j++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+		tables[0][i] = crc;
+	}
+	for (uint32_t i = 0; i < 256; i++) {
+		for (size_t n = 1; n < tables.size(); n++) {
+			tables[n][i] = (tables[n - 1][i] >> 8) ^ tables[0][tables[n - 1][i] & 0xff];
+		}
+	}
+	return tables;
+}();
+
+uint32_t CTapDriver::Crc32Table(span<const uint8_t> data)
+{
+	const auto& t = CRC32_TABLES;
+
+	uint32_t crc = 0xffffffff;
+	size_t i = 0;
+	for (; i + 8 <= data.size(); i += 8) {
+		const uint32_t low = crc ^ (data[i] | data[i + 1] << 8 | data[i + 2] << 16 |
+				static_cast<uint32_t>(data[i + 3]) << 24);
+		crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+				t[3][data[i + 4]] ^ t[2][data[i + 5]] ^ t[1][data[i + 6]] ^ t[0][data[i + 7]];
+	}
+	for (; i < data.size(); i++) {
+		crc = (crc >> 8) ^ t[0][(crc ^ data[i]) & 0xff];
+	}
+	return ~crc;
+}
+
+#if defined(__aarch64__) && defined(__linux__)
+// The ARMv8 CRC32 instructions (not CRC32C) use the Ethernet polynomial
+__attribute__((target("+crc")))
+uint32_t CTapDriver::Crc32Hardware(span<const uint8_t> data)
+{
+	uint32_t crc = 0xffffffff;
+	size_t i = 0;
+	for (; i + 8 <= data.size(); i += 8) {
+		uint64_t d;
+		memcpy(&d, &data[i], sizeof(d));
+		crc = __crc32d(crc, d);
+	}
+	for (; i < data.size(); i++) {
+		crc = __crc32b(crc, data[i]);
+	}
+	return ~crc;
+}
+
+bool CTapDriver::HasHardwareCrc32()
+{
+	return getauxval(AT_HWCAP) & HWCAP_CRC32;
+}
+#else
+uint32_t CTapDriver::Crc32Hardware(span<const uint8_t> data)
+{
+	return Crc32Table(data);
+}
+
+bool CTapDriver::HasHardwareCrc32()
+{
+	return false;
+}
+#endif
+
 int CTapDriver::Receive(uint8_t *buf) const
 {
 	assert(m_hTAP != -1);
@@ -373,16 +461,16 @@ int CTapDriver::Receive(uint8_t *buf) const
 	if (dwReceived > 0) {
 		// We need to add the Frame Check Status (FCS) CRC back onto the end of the packet.
 		// The Linux network subsystem removes it, since most software apps shouldn't ever
-		// need it.
-		const int crc = Crc32(span(buf, dwReceived));
+		// need it. When the FCS is disabled the frame still has the FCS size, with a zero FCS.
+		const int crc = fcs ? Crc32(span(buf, dwReceived)) : 0;
 
 		buf[dwReceived + 0] = (uint8_t)((crc >> 0) & 0xFF);
 		buf[dwReceived + 1] = (uint8_t)((crc >> 8) & 0xFF);
 		buf[dwReceived + 2] = (uint8_t)((crc >> 16) & 0xFF);
 		buf[dwReceived + 3] = (uint8_t)((crc >> 24) & 0xFF);
 
-		spdlog::trace("CRC is " + to_string(crc) + " - " + to_string(buf[dwReceived+0]) + " " + to_string(buf[dwReceived+1]) +
-				" " + to_string(buf[dwReceived+2]) + " " + to_string(buf[dwReceived+3]));
+		spdlog::trace("CRC is {0} - {1} {2} {3} {4}", crc, buf[dwReceived + 0], buf[dwReceived + 1], buf[dwReceived + 2],
+				buf[dwReceived + 3]);
 
 		// Add FCS size to the received message size
 		dwReceived += 4;
@@ -52,8 +52,16 @@ public:
 	string IpLink(bool) const;	// Enable/Disable the piscsi0 interface
 	void Flush() const;			// Purge all of the packets that are waiting to be processed
 
+	// The Ethernet FCS, calculated with the fastest implementation supported by the CPU
 	static uint32_t Crc32(span<const uint8_t>);
 
+	// The individual implementations, all with identical results. The hardware implementation requires
+	// HasHardwareCrc32() to be true.
+	static uint32_t Crc32Bitwise(span<const uint8_t>);
+	static uint32_t Crc32Table(span<const uint8_t>);
+	static uint32_t Crc32Hardware(span<const uint8_t>);
+	static bool HasHardwareCrc32();
+
 private:
 
 	static string SetUpEth0(int, const string&);
@@ -68,5 +76,8 @@ private:
 	vector<string> interfaces;
 
 	string inet;
+
+	// No known driver checks the FCS, i.e. calculating it can be skipped
+	bool fcs = true;
 };
 
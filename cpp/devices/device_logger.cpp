@@ -12,39 +12,38 @@
 using namespace std;
 using namespace spdlog;
 
-void DeviceLogger::Trace(const string& message) const
-{
-	Log(level::trace, message);
-}
-
-void DeviceLogger::Debug(const string& message) const
+void DeviceLogger::Debug(string_view message) const
 {
 	Log(level::debug, message);
 }
 
-void DeviceLogger::Info(const string& message) const
+void DeviceLogger::Info(string_view message) const
 {
 	Log(level::info, message);
 }
 
-void DeviceLogger::Warn(const string& message) const
+void DeviceLogger::Warn(string_view message) const
 {
 	Log(level::warn, message);
 }
 
-void DeviceLogger::Error(const string& message) const
+void DeviceLogger::Error(string_view message) const
 {
 	Log(level::err, message);
 }
 
-void DeviceLogger::Log(level::level_enum level, const string& message) const
+void DeviceLogger::Log(level::level_enum level, string_view message) const
 {
+    if (!should_log(level)) {
+        return;
+    }
+
     if ((log_device_id == -1 || log_device_id == id) && (lun == -1 || log_device_lun == -1 || log_device_lun == lun)) {
         if (lun == -1) {
-            log(level, "(ID " + to_string(id) + ") - " + message);
+            log(level, "(ID {0}) - {1}", id, message);
         }
         else {
-            log(level, "(ID:LUN " + to_string(id) + ":" + to_string(lun) + ") - " + message);
+            log(level, "(ID:LUN {0}:{1}) - {2}", id, lun, message);
         }
     }
 }
@@ -11,9 +11,18 @@
 
 #include "spdlog/spdlog.h"
 #include <string>
+#include <string_view>
+#include <utility>
 
 using namespace std;
 
+// Trace logging can be removed at compile time with -DDISABLE_TRACE_LOGGING
+#ifdef DISABLE_TRACE_LOGGING
+static constexpr bool TRACE_LOGGING = false;
+#else
+static constexpr bool TRACE_LOGGING = true;
+#endif
+
 class DeviceLogger
 {
 
@@ -22,18 +31,58 @@ public:
 	DeviceLogger() = default;
 	~DeviceLogger() = default;
 
-	void Trace(const string&) const;
-	void Debug(const string&) const;
-	void Info(const string&) const;
-	void Warn(const string&) const;
-	void Error(const string&) const;
+	// Messages are passed as string_view so that string literals do not have to be copied if the level is disabled
+	void Trace(string_view s) const { if constexpr (TRACE_LOGGING) { Log(spdlog::level::trace, s); } }
+	void Debug(string_view) const;
+	void Info(string_view) const;
+	void Warn(string_view) const;
+	void Error(string_view) const;
+
+	// The message is only formatted if the level is enabled
+	template<typename... Args>
+	void Trace(fmt::format_string<Args...> format, Args&&... args) const
+	{
+		if constexpr (TRACE_LOGGING) {
+			Log(spdlog::level::trace, format, forward<Args>(args)...);
+		}
+	}
+	template<typename... Args>
+	void Debug(fmt::format_string<Args...> format, Args&&... args) const
+	{
+		Log(spdlog::level::debug, format, forward<Args>(args)...);
+	}
+	template<typename... Args>
+	void Info(fmt::format_string<Args...> format, Args&&... args) const
+	{
+		Log(spdlog::level::info, format, forward<Args>(args)...);
+	}
+	template<typename... Args>
+	void Warn(fmt::format_string<Args...> format, Args&&... args) const
+	{
+		Log(spdlog::level::warn, format, forward<Args>(args)...);
+	}
+	template<typename... Args>
+	void Error(fmt::format_string<Args...> format, Args&&... args) const
+	{
+		Log(spdlog::level::err, format, forward<Args>(args)...);
+	}
+
+	static bool IsTraceEnabled() { return TRACE_LOGGING && spdlog::should_log(spdlog::level::trace); }
 
 	void SetIdAndLun(int, int);
 	static void SetLogIdAndLun(int, int);
 
 private:
 
-	void Log(spdlog::level::level_enum, const string&) const;
+	void Log(spdlog::level::level_enum, string_view) const;
+
+	template<typename... Args>
+	void Log(spdlog::level::level_enum level, fmt::format_string<Args...> format, Args&&... args) const
+	{
+		if (spdlog::should_log(level)) {
+			Log(level, fmt::format(format, forward<Args>(args)...));
+		}
+	}
 
 	int id = -1;
 	int lun = -1;
@@ -17,12 +17,19 @@
 #include "shared/piscsi_exceptions.h"
 #include "scsi_command_util.h"
 #include "disk.h"
-#include <sstream>
-#include <iomanip>
 
 using namespace scsi_defs;
 using namespace scsi_command_util;
 
+Disk::Disk(PbDeviceType type, int lun, const unordered_set<uint32_t>& s) : StorageDevice(type, lun, s)
+{
+	// There is nothing written to read-only media
+	const auto& is_writable = [this] { return !IsReadOnly(); };
+	GetMetrics().SetCondition(SECTOR_WRITE_COUNT, is_writable);
+	GetMetrics().SetCondition(DiskCache::CACHE_MISS_WRITE_COUNT, is_writable);
+	GetMetrics().SetCondition(DiskCache::WRITE_ERROR_COUNT, is_writable);
+}
+
 bool Disk::Init(const param_map& params)
 {
 	StorageDevice::Init(params);
@@ -47,6 +54,8 @@ bool Disk::Init(const param_map& params)
 	AddCommand(scsi_command::eCmdSynchronizeCache10, [this] { SynchronizeCache(); });
 	AddCommand(scsi_command::eCmdSynchronizeCache16, [this] { SynchronizeCache(); });
 	AddCommand(scsi_command::eCmdReadDefectData10, [this] { ReadDefectData10(); });
+	AddCommand(scsi_command::eCmdLogSelect, [this] { LogSelect(); });
+	AddCommand(scsi_command::eCmdLogSense, [this] { LogSense(); });
 	AddCommand(scsi_command::eCmdRead16,[this] { Read16(); });
 	AddCommand(scsi_command::eCmdWrite16, [this] { Write16(); });
 	AddCommand(scsi_command::eCmdVerify16, [this] { Verify16(); });
@@ -55,13 +64,44 @@ bool Disk::Init(const param_map& params)
 	return true;
 }
 
+Disk::~Disk()
+{
+	RemoveWriteBackTask();
+}
+
 void Disk::CleanUp()
 {
+	RemoveWriteBackTask();
+
 	FlushCache();
 
 	StorageDevice::CleanUp();
 }
 
+void Disk::SetIdleScheduler(IdleScheduler& scheduler)
+{
+	RemoveWriteBackTask();
+
+	idle_scheduler = &scheduler;
+	write_back_task = scheduler.AddTask([this] (const IdleScheduler&) { return WriteBack(); });
+}
+
+bool Disk::WriteBack()
+{
+	scoped_lock<mutex> lock(cache_mutex);
+
+	// A few sectors per step, the scheduler checks for a selection between the steps
+	return cache != nullptr && cache->SaveChangedSectors();
+}
+
+void Disk::RemoveWriteBackTask()
+{
+	if (idle_scheduler != nullptr) {
+		idle_scheduler->RemoveTask(write_back_task);
+		idle_scheduler = nullptr;
+	}
+}
+
 void Disk::Dispatch(scsi_command cmd)
 {
 	// Media changes must be reported on the next access, i.e. not only for TEST UNIT READY
@@ -79,16 +119,29 @@ void Disk::Dispatch(scsi_command cmd)
 
 void Disk::SetUpCache(off_t image_offset, bool raw)
 {
-	cache = make_unique<DiskCache>(GetFilename(), size_shift_count, GetBlockCount(), image_offset);
+	scoped_lock<mutex> lock(cache_mutex);
+
+	cache = make_unique<DiskCache>(GetMetrics(), GetFilename(), size_shift_count, GetBlockCount(), image_offset);
 	cache->SetRawMode(raw);
 }
 
 void Disk::ResizeCache(const string& path, bool raw)
 {
-	cache.reset(new DiskCache(path, size_shift_count, GetBlockCount()));
+	scoped_lock<mutex> lock(cache_mutex);
+
+	cache.reset(new DiskCache(GetMetrics(), path, size_shift_count, GetBlockCount()));
 	cache->SetRawMode(raw);
 }
 
+void Disk::Prefetch(uint64_t start, uint64_t count)
+{
+	scoped_lock<mutex> lock(cache_mutex);
+
+	if (cache != nullptr && IsReady() && start < GetBlockCount()) {
+		cache->Prefetch(start, min(count, GetBlockCount() - start));
+	}
+}
+
 void Disk::FlushCache()
 {
 	if (cache != nullptr && IsReady()) {
@@ -115,11 +168,13 @@ void Disk::Read(access_mode mode)
 		GetController()->SetBlocks(blocks);
 		GetController()->SetLength(Read(GetController()->GetBuffer(), start));
 
-		LogTrace("Length is " + to_string(GetController()->GetLength()));
+		LogTrace("Length is {}", GetController()->GetLength());
 
 		// Set next block
 		GetController()->SetNext(start + 1);
 
+		SetReadHandler();
+
 		EnterDataInPhase();
 	}
 	else {
@@ -151,7 +206,7 @@ void Disk::ReadWriteLong16() const
 	EnterStatusPhase();
 }
 
-void Disk::Write(access_mode mode) const
+void Disk::Write(access_mode mode)
 {
 	if (IsProtected()) {
 		throw scsi_exception(sense_key::data_protect, asc::write_protected);
@@ -165,6 +220,8 @@ void Disk::Write(access_mode mode) const
 		// Set next block
 		GetController()->SetNext(start + 1);
 
+		SetWriteHandler();
+
 		EnterDataOutPhase();
 	}
 	else {
@@ -189,6 +246,8 @@ void Disk::Verify(access_mode mode)
 		// Set next block
 		GetController()->SetNext(start + 1);
 
+		SetVerifyHandler();
+
 		EnterDataOutPhase();
 	}
 	else {
@@ -207,6 +266,10 @@ void Disk::StartStopUnit()
 	else {
 		LogTrace(start ? "Starting unit" : "Stopping unit");
 
+		if (start && IsStopped()) {
+			start_stop_cycle_count.Increment();
+		}
+
 		SetStopped(!start);
 	}
 
@@ -252,18 +315,179 @@ void Disk::ReadDefectData10() const
 	EnterDataInPhase();
 }
 
+void Disk::LogSense() const
+{
+	const auto& cmd = GetController()->GetCmd();
+
+	// Saving parameters and subpages are not supported
+	if ((cmd[1] & 0x01) || cmd[3]) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	const int page = cmd[2] & 0x3f;
+	const int parameter_pointer = GetInt16(cmd, 5);
+
+	LogTrace("Requesting log page ${:02x}", page);
+
+	vector<uint8_t> buf(4);
+	buf[0] = static_cast<uint8_t>(page);
+
+	if (page == SUPPORTED_LOG_PAGES) {
+		if (parameter_pointer) {
+			throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+		}
+
+		buf.insert(buf.end(), LOG_PAGES.begin(), LOG_PAGES.end());
+	}
+	else if (ranges::find(LOG_PAGES, page) != LOG_PAGES.end()) {
+		// There are no thresholds, only the current cumulative values are non-zero
+		for (const auto& [code, parameter] : GetLogParameters(page, (cmd[2] & 0xc0) == 0x40)) {
+			if (code >= parameter_pointer) {
+				buf.insert(buf.end(), parameter.begin(), parameter.end());
+			}
+		}
+	}
+	else {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	SetInt16(buf, 2, static_cast<int>(buf.size()) - 4);
+
+	const size_t length = min(buf.size(), static_cast<size_t>(GetInt16(cmd, 7)));
+	copy_n(buf.begin(), length, GetController()->GetBuffer().begin());
+	GetController()->SetLength(static_cast<uint32_t>(length));
+
+	EnterDataInPhase();
+}
+
+void Disk::LogSelect()
+{
+	const auto& cmd = GetController()->GetCmd();
+
+	// Saving parameters and setting parameter values are not supported, the parameters can only be reset
+	if ((cmd[1] & 0x01) || GetInt16(cmd, 7)) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	// The log pages are based on the device statistics, i.e. these are also reset
+	if (cmd[1] & 0x02) {
+		LogTrace("Resetting log parameters");
+
+		GetMetrics().Reset();
+	}
+
+	EnterStatusPhase();
+}
+
+map<int, vector<uint8_t>> Disk::GetLogParameters(int page, bool cumulative) const
+{
+	const auto& value = [cumulative] (uint64_t v) { return cumulative ? v : 0; };
+
+	const uint64_t sector_size = GetSectorSizeInBytes();
+	const uint64_t read_count = sector_read_count.Get();
+	const uint64_t write_count = sector_write_count.Get();
+	const uint64_t track_load_count = GetMetrics().GetValue(DiskCache::CACHE_MISS_READ_COUNT);
+
+	map<int, vector<uint8_t>> parameters;
+
+	switch (page) {
+		case WRITE_ERROR_COUNTER_PAGE:
+		case READ_ERROR_COUNTER_PAGE: {
+			// There are no corrected errors, only the processed bytes and the uncorrected errors are counted
+			for (int code = 0x0000; code <= 0x0004; code++) {
+				AddLogCounter(parameters, code, 0, 4);
+			}
+			const bool is_read = page == READ_ERROR_COUNTER_PAGE;
+			AddLogCounter(parameters, 0x0005, value((is_read ? read_count : write_count) * sector_size), 8);
+			AddLogCounter(parameters, 0x0006, value(GetMetrics().GetValue(is_read ?
+					DiskCache::READ_ERROR_COUNT : DiskCache::WRITE_ERROR_COUNT)), 4);
+			break;
+		}
+
+		case START_STOP_CYCLE_COUNTER_PAGE: {
+			// The date of manufacture and the accounting date are unknown, i.e. blank (ASCII format list)
+			const array<uint8_t, 6> date = { ' ', ' ', ' ', ' ', ' ', ' ' };
+			AddLogParameter(parameters, 0x0001, 0x01, date);
+			AddLogParameter(parameters, 0x0002, 0x01, date);
+			// There is no limit for the number of cycles (binary format list)
+			AddLogCounter(parameters, 0x0003, 0, 4, 0x03);
+			AddLogCounter(parameters, 0x0004, value(start_stop_cycle_count.Get()), 4, 0x03);
+			break;
+		}
+
+		case PISCSI_STATISTICS_PAGE: {
+			// The cache hit ratio in units of 0.01%, a hit is a sector access that does not require a track load
+			const uint64_t access_count = read_count + write_count;
+			const uint64_t hit_ratio = access_count ?
+					(access_count - min(track_load_count, access_count)) * 10000 / access_count : 0;
+			AddLogCounter(parameters, 0x0000, value(hit_ratio), 2, 0x03);
+
+			// The average time from the command phase until bus free in microseconds
+			const Histogram& command_time = GetCommandTime();
+			const uint64_t command_count = command_time.GetCount();
+			AddLogCounter(parameters, 0x0001,
+					value(command_count ? command_time.GetSum() / command_count : 0), 4, 0x03);
+
+			AddLogCounter(parameters, 0x0002, value(read_count * sector_size), 8);
+			AddLogCounter(parameters, 0x0003, value(write_count * sector_size), 8);
+			AddLogCounter(parameters, 0x0004, value(command_count), 8);
+			break;
+		}
+
+		case CACHE_STATISTICS_PAGE:
+			AddLogCounter(parameters, 0x0000, value(read_count), 8);
+			AddLogCounter(parameters, 0x0001, value(write_count), 8);
+			AddLogCounter(parameters, 0x0002, value(track_load_count), 8);
+			AddLogCounter(parameters, 0x0003, value(GetMetrics().GetValue(DiskCache::CACHE_MISS_WRITE_COUNT)), 8);
+			break;
+
+		default:
+			break;
+	}
+
+	return parameters;
+}
+
+void Disk::AddLogParameter(map<int, vector<uint8_t>>& parameters, int code, int control, span<const uint8_t> value)
+{
+	vector<uint8_t>& parameter = parameters[code];
+	parameter.resize(4);
+	SetInt16(parameter, 0, code);
+	parameter[2] = static_cast<uint8_t>(control);
+	parameter[3] = static_cast<uint8_t>(value.size());
+	parameter.insert(parameter.end(), value.begin(), value.end());
+}
+
+void Disk::AddLogCounter(map<int, vector<uint8_t>>& parameters, int code, uint64_t value, int length, int control)
+{
+	// Big-endian, saturated if the value does not fit
+	if (length < 8 && value >= (1ULL << (length * 8))) {
+		value = (1ULL << (length * 8)) - 1;
+	}
+
+	vector<uint8_t> buf(length);
+	for (int i = length - 1; i >= 0; i--) {
+		buf[i] = static_cast<uint8_t>(value);
+		value >>= 8;
+	}
+
+	AddLogParameter(parameters, code, control, buf);
+}
+
 bool Disk::Eject(bool force)
 {
 	const bool status = PrimaryDevice::Eject(force);
 	if (status) {
 		FlushCache();
-		cache.reset();
+		{
+			scoped_lock<mutex> lock(cache_mutex);
+			cache.reset();
+		}
 
 		// The image file for this drive is not in use anymore
 		UnreserveFile();
 
-		sector_read_count = 0;
-		sector_write_count = 0;
+		GetMetrics().Reset();
 	}
 
 	return status;
@@ -388,6 +612,12 @@ void Disk::SetUpModePages(map<int, vector<byte>>& pages, int page, bool changeab
 	AddVendorPage(pages, page, changeable);
 }
 
+optional<uint64_t> Disk::GetModePageState() const
+{
+	// The mode pages of all disk types only depend on the medium geometry and on whether a medium is present
+	return (GetBlockCount() << 8) | (GetSectorSizeShiftCount() << 1) | (IsReady() ? 1 : 0);
+}
+
 void Disk::AddErrorPage(map<int, vector<byte>>& pages, bool) const
 {
 	// Retry count is 0, limit time uses internal default value
@@ -502,7 +732,7 @@ int Disk::Read(span<uint8_t> buf, uint64_t block)
 		throw scsi_exception(sense_key::medium_error, asc::read_fault);
 	}
 
-	++sector_read_count;
+	sector_read_count.Increment();
 
 	return GetSectorSizeInBytes();
 }
@@ -517,7 +747,7 @@ void Disk::Write(span<const uint8_t> buf, uint64_t block)
 		throw scsi_exception(sense_key::medium_error, asc::write_fault);
 	}
 
-	++sector_write_count;
+	sector_write_count.Increment();
 }
 
 void Disk::Seek()
@@ -623,8 +853,7 @@ void Disk::ValidateBlockAddress(access_mode mode) const
 	const uint64_t block = mode == RW16 ? GetInt64(GetController()->GetCmd(), 2) : GetInt32(GetController()->GetCmd(), 2);
 
 	if (block > GetBlockCount()) {
-		LogTrace("Capacity of " + to_string(GetBlockCount()) + " block(s) exceeded: Trying to access block "
-				+ to_string(block));
+		LogTrace("Capacity of {0} block(s) exceeded: Trying to access block {1}", GetBlockCount(), block);
 		throw scsi_exception(sense_key::illegal_request, asc::lba_out_of_range);
 	}
 }
@@ -656,14 +885,12 @@ tuple<bool, uint64_t, uint32_t> Disk::CheckAndGetStartAndCount(access_mode mode)
 		}
 	}
 
-	stringstream s;
-	s << "READ/WRITE/VERIFY/SEEK, start block: $" << setfill('0') << setw(8) << hex << start;
-	LogTrace(s.str() + ", blocks: " + to_string(count));
+	LogTrace("READ/WRITE/VERIFY/SEEK, start block: ${0:08x}, blocks: {1}", start, count);
 
 	// Check capacity
 	if (uint64_t capacity = GetBlockCount(); !capacity || start > capacity || start + count > capacity) {
-		LogTrace("Capacity of " + to_string(capacity) + " block(s) exceeded: Trying to access block "
-				+ to_string(start) + ", block count " + to_string(count));
+		LogTrace("Capacity of {0} block(s) exceeded: Trying to access block {1}, block count {2}", capacity, start,
+				count);
 		throw scsi_exception(sense_key::illegal_request, asc::lba_out_of_range);
 	}
 
@@ -685,35 +912,3 @@ bool Disk::SetConfiguredSectorSize(uint32_t configured_size)
 
 	return true;
 }
-
-vector<PbStatistics> Disk::GetStatistics() const
-{
-	vector<PbStatistics> statistics = PrimaryDevice::GetStatistics();
-
-	// Enrich cache statistics with device information before adding them to device statistics
-	if (cache) {
-		for (auto& s : cache->GetStatistics(IsReadOnly())) {
-			s.set_id(GetId());
-			s.set_unit(GetLun());
-			statistics.push_back(s);
-		}
-	}
-
-	PbStatistics s;
-	s.set_id(GetId());
-	s.set_unit(GetLun());
-
-	s.set_category(PbStatisticsCategory::CATEGORY_INFO);
-
-	s.set_key(SECTOR_READ_COUNT);
-	s.set_value(sector_read_count);
-	statistics.push_back(s);
-
-	if (!IsReadOnly()) {
-		s.set_key(SECTOR_WRITE_COUNT);
-		s.set_value(sector_write_count);
-		statistics.push_back(s);
-	}
-
-	return statistics;
-}
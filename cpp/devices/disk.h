@@ -18,9 +18,13 @@
 #include "shared/piscsi_util.h"
 #include "disk_track.h"
 #include "disk_cache.h"
+#include "controllers/command_queue.h"
 #include "interfaces/scsi_block_commands.h"
 #include "storage_device.h"
 #include <string>
+#include <array>
+#include <map>
+#include <mutex>
 #include <span>
 #include <unordered_set>
 #include <unordered_map>
@@ -33,22 +37,45 @@ class Disk : public StorageDevice, private ScsiBlockCommands
 	enum access_mode { RW6, RW10, RW16, SEEK6, SEEK10 };
 
 	unique_ptr<DiskCache> cache;
+	// Protects the cache from being replaced or released while it is written back by the idle scheduler thread
+	mutex cache_mutex;
 
-	uint64_t sector_read_count = 0;
-	uint64_t sector_write_count = 0;
+	IdleScheduler *idle_scheduler = nullptr;
+	int write_back_task = -1;
+	bool WriteBack();
+	void RemoveWriteBackTask();
 
 	inline static const string SECTOR_READ_COUNT = "sector_read_count";
 	inline static const string SECTOR_WRITE_COUNT = "sector_write_count";
+	inline static const string START_STOP_CYCLE_COUNT = "start_stop_cycle_count";
+
+	Counter& sector_read_count = GetMetrics().AddCounter(SECTOR_READ_COUNT);
+	Counter& sector_write_count = GetMetrics().AddCounter(SECTOR_WRITE_COUNT);
+	Counter& start_stop_cycle_count = GetMetrics().AddCounter(START_STOP_CYCLE_COUNT);
+
+	static const int SUPPORTED_LOG_PAGES = 0x00;
+	static const int WRITE_ERROR_COUNTER_PAGE = 0x02;
+	static const int READ_ERROR_COUNTER_PAGE = 0x03;
+	static const int START_STOP_CYCLE_COUNTER_PAGE = 0x0e;
+	// Vendor specific pages
+	static const int PISCSI_STATISTICS_PAGE = 0x30;
+	static const int CACHE_STATISTICS_PAGE = 0x37;
+
+	// In ascending order, as required for the supported pages page
+	static constexpr array<uint8_t, 6> LOG_PAGES = { SUPPORTED_LOG_PAGES, WRITE_ERROR_COUNTER_PAGE,
+			READ_ERROR_COUNTER_PAGE, START_STOP_CYCLE_COUNTER_PAGE, PISCSI_STATISTICS_PAGE, CACHE_STATISTICS_PAGE };
 
 public:
 
-	Disk(PbDeviceType type, int lun, const unordered_set<uint32_t>& s)
-		: StorageDevice(type, lun, s) {}
-	~Disk() override = default;
+	Disk(PbDeviceType, int, const unordered_set<uint32_t>&);
+	~Disk() override;
 
 	bool Init(const param_map&) override;
 	void CleanUp() override;
 
+	// Writes back the changed tracks of the cache while the bus is idle
+	void SetIdleScheduler(IdleScheduler&) override;
+
 	void Dispatch(scsi_command) override;
 
 	bool Eject(bool) override;
@@ -61,7 +88,8 @@ public:
 	bool SetConfiguredSectorSize(uint32_t);
 	void FlushCache() override;
 
-	vector<PbStatistics> GetStatistics() const override;
+	bool SupportsCommandQueuing() const override { return CommandQueue::GetMaxDepth() > 0; }
+	void Prefetch(uint64_t, uint64_t) override;
 
 private:
 
@@ -69,6 +97,8 @@ private:
 	void StartStopUnit();
 	void SynchronizeCache();
 	void ReadDefectData10() const;
+	void LogSense() const;
+	void LogSelect();
 	virtual void Read6() { Read(RW6); }
 	void Read10() override { Read(RW10); }
 	void Read16() override { Read(RW16); }
@@ -84,7 +114,7 @@ private:
 	void FormatUnit() override;
 	void Seek6();
 	void Read(access_mode);
-	void Write(access_mode) const;
+	void Write(access_mode);
 	void Verify(access_mode);
 	void ReadWriteLong10() const;
 	void ReadWriteLong16() const;
@@ -97,6 +127,11 @@ private:
 	int ModeSense6(cdb_t, vector<uint8_t>&) const override;
 	int ModeSense10(cdb_t, vector<uint8_t>&) const override;
 
+	// Returns the encoded parameters of a log page by parameter code
+	map<int, vector<uint8_t>> GetLogParameters(int, bool) const;
+	static void AddLogParameter(map<int, vector<uint8_t>>&, int, int, span<const uint8_t>);
+	static void AddLogCounter(map<int, vector<uint8_t>>&, int, uint64_t, int, int = 0x00);
+
 protected:
 
 	void SetUpCache(off_t, bool = false);
@@ -107,5 +142,6 @@ protected:
 	virtual void AddFormatPage(map<int, vector<byte>>&, bool) const;
 	virtual void AddDrivePage(map<int, vector<byte>>&, bool) const;
 	void AddCachePage(map<int, vector<byte>>&, bool) const;
+	optional<uint64_t> GetModePageState() const override;
 
 };
@@ -20,8 +20,12 @@
 #include <cassert>
 #include <algorithm>
 
-DiskCache::DiskCache(const string& path, int size, uint64_t blocks, off_t imgoff)
-	: sec_path(path), sec_size(size), sec_blocks(blocks), imgoffset(imgoff)
+DiskCache::DiskCache(MetricsRegistry& metrics, const string& path, int size, uint64_t blocks, off_t imgoff)
+	: sec_path(path), sec_size(size), sec_blocks(blocks), imgoffset(imgoff),
+	  read_error_count(metrics.AddCounter(READ_ERROR_COUNT, PbStatisticsCategory::CATEGORY_ERROR)),
+	  write_error_count(metrics.AddCounter(WRITE_ERROR_COUNT, PbStatisticsCategory::CATEGORY_ERROR)),
+	  cache_miss_read_count(metrics.AddCounter(CACHE_MISS_READ_COUNT)),
+	  cache_miss_write_count(metrics.AddCounter(CACHE_MISS_WRITE_COUNT))
 {
 	assert(blocks > 0);
 	assert(imgoff >= 0);
@@ -29,9 +33,41 @@ DiskCache::DiskCache(const string& path, int size, uint64_t blocks, off_t imgoff
 
 bool DiskCache::Save()
 {
+	scoped_lock<mutex> lock(cache_mutex);
+
 	// Save valid tracks
 	return ranges::none_of(cache.begin(), cache.end(), [this](const cache_t& c)
-			{ return c.disktrk != nullptr && !c.disktrk->Save(sec_path, cache_miss_write_count); });
+			{ return c.disktrk != nullptr && !Save(*c.disktrk); });
+}
+
+bool DiskCache::SaveChangedSectors()
+{
+	scoped_lock<mutex> lock(cache_mutex);
+
+	const auto& it = ranges::find_if(cache, [] (const cache_t& c) { return c.disktrk != nullptr && c.disktrk->IsChanged(); });
+	if (it == cache.end()) {
+		return false;
+	}
+
+	// The lock is only held for a few sectors, i.e. a command does not have to wait for a whole track
+	if (!it->disktrk->Save(sec_path, cache_miss_write_count, WRITE_BACK_SECTORS)) {
+		write_error_count.Increment();
+
+		return false;
+	}
+
+	return true;
+}
+
+bool DiskCache::Save(DiskTrack& disktrk)
+{
+	if (!disktrk.Save(sec_path, cache_miss_write_count)) {
+		write_error_count.Increment();
+
+		return false;
+	}
+
+	return true;
 }
 
 shared_ptr<DiskTrack> DiskCache::GetTrack(uint64_t block)
@@ -48,6 +84,8 @@ shared_ptr<DiskTrack> DiskCache::GetTrack(uint64_t block)
 
 bool DiskCache::ReadSector(span<uint8_t> buf, uint64_t block)
 {
+	scoped_lock<mutex> lock(cache_mutex);
+
 	shared_ptr<DiskTrack> disktrk = GetTrack(block);
 	if (disktrk == nullptr) {
 		return false;
@@ -59,6 +97,8 @@ bool DiskCache::ReadSector(span<uint8_t> buf, uint64_t block)
 
 bool DiskCache::WriteSector(span<const uint8_t> buf, uint64_t block)
 {
+	scoped_lock<mutex> lock(cache_mutex);
+
 	shared_ptr<DiskTrack> disktrk = GetTrack(block);
 	if (disktrk == nullptr) {
 		return false;
@@ -68,6 +108,25 @@ bool DiskCache::WriteSector(span<const uint8_t> buf, uint64_t block)
 	return disktrk->WriteSector(buf, block & 0xff);
 }
 
+void DiskCache::Prefetch(uint64_t block, uint64_t count)
+{
+	if (!count) {
+		return;
+	}
+
+	scoped_lock<mutex> lock(cache_mutex);
+
+	// At most half of the cache, so that the tracks of the other commands are not evicted
+	const int64_t first = block >> 8;
+	const int64_t last = min(static_cast<int64_t>((block + count - 1) >> 8), first + CACHE_MAX / 2 - 1);
+	for (int64_t track = first; track <= last; track++) {
+		UpdateSerialNumber();
+		if (Assign(track) == nullptr) {
+			break;
+		}
+	}
+}
+
 //---------------------------------------------------------------------------
 //
 //	Track Assignment
@@ -120,7 +179,7 @@ shared_ptr<DiskTrack> DiskCache::Assign(int64_t track)
 	}
 
 	// Save this track
-	if (!cache[c].disktrk->Save(sec_path, cache_miss_write_count)) {
+	if (!Save(*cache[c].disktrk)) {
 		return nullptr;
 	}
 
@@ -164,7 +223,7 @@ bool DiskCache::Load(int index, int64_t track, shared_ptr<DiskTrack> disktrk)
 
 	// Try loading
 	if (!disktrk->Load(sec_path, cache_miss_read_count)) {
-		++read_error_count;
+		read_error_count.Increment();
 
 		return false;
 	}
@@ -188,36 +247,3 @@ void DiskCache::UpdateSerialNumber()
 		c.serial = 0;
 	}
 }
-
-vector<PbStatistics> DiskCache::GetStatistics(bool is_read_only) const
-{
-	vector<PbStatistics> statistics;
-
-	PbStatistics s;
-
-	s.set_category(PbStatisticsCategory::CATEGORY_INFO);
-
-	s.set_key(CACHE_MISS_READ_COUNT);
-	s.set_value(cache_miss_read_count);
-	statistics.push_back(s);
-
-	if (!is_read_only) {
-		s.set_key(CACHE_MISS_WRITE_COUNT);
-		s.set_value(cache_miss_write_count);
-		statistics.push_back(s);
-	}
-
-	s.set_category(PbStatisticsCategory::CATEGORY_ERROR);
-
-	s.set_key(READ_ERROR_COUNT);
-	s.set_value(read_error_count);
-	statistics.push_back(s);
-
-	if (!is_read_only) {
-		s.set_key(WRITE_ERROR_COUNT);
-		s.set_value(write_error_count);
-		statistics.push_back(s);
-	}
-
-	return statistics;
-}
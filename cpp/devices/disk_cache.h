@@ -15,10 +15,11 @@
 
 #pragma once
 
-#include "generated/piscsi_interface.pb.h"
+#include "metrics_registry.h"
 #include <span>
 #include <array>
 #include <memory>
+#include <mutex>
 #include <string>
 
 using namespace std;
@@ -29,34 +30,33 @@ class DiskCache
 	// Number of tracks to cache
 	static const int64_t CACHE_MAX = 16;
 
-	uint64_t read_error_count = 0;
-	uint64_t write_error_count = 0;
-	uint64_t cache_miss_read_count = 0;
-	uint64_t cache_miss_write_count = 0;
+	// Maximum number of sectors saved by a write-back step
+	static const int WRITE_BACK_SECTORS = 32;
+
+public:
 
 	inline static const string READ_ERROR_COUNT = "read_error_count";
 	inline static const string WRITE_ERROR_COUNT = "write_error_count";
 	inline static const string CACHE_MISS_READ_COUNT = "cache_miss_read_count";
 	inline static const string CACHE_MISS_WRITE_COUNT = "cache_miss_write_count";
 
-public:
-
 	// Internal data definition
 	using cache_t = struct {
 		shared_ptr<DiskTrack> disktrk;	// Disk Track
 		uint32_t serial;				// Serial
 	};
 
-	DiskCache(const string&, int, uint64_t, off_t = 0);
+	// The metrics are added to the registry of the device
+	DiskCache(MetricsRegistry&, const string&, int, uint64_t, off_t = 0);
 	~DiskCache() = default;
 
 	void SetRawMode(bool b) { cd_raw = b; }		// CD-ROM raw mode setting
 
 	bool Save();							// Save and release all
+	bool SaveChangedSectors();				// Save some changed sectors, false if there are none
 	bool ReadSector(span<uint8_t>, uint64_t);			// Sector Read
 	bool WriteSector(span<const uint8_t>, uint64_t);	// Sector Write
-
-	vector<PbStatistics> GetStatistics(bool) const;
+	void Prefetch(uint64_t, uint64_t);					// Load the tracks of a block range
 
 private:
 
@@ -64,8 +64,12 @@ private:
 	shared_ptr<DiskTrack> Assign(int64_t);
 	shared_ptr<DiskTrack> GetTrack(uint64_t);
 	bool Load(int index, int64_t track, shared_ptr<DiskTrack>);
+	bool Save(DiskTrack&);
 	void UpdateSerialNumber();
 
+	// The cache is written back by the idle scheduler thread while the bus thread may be using it
+	mutex cache_mutex;
+
 	// Internal data
 	array<cache_t, CACHE_MAX> cache = {};		// Cache management
 	uint32_t serial = 0;						// Last serial number
@@ -74,5 +78,10 @@ private:
 	int64_t sec_blocks;								// Blocks per sector
 	bool cd_raw = false;						// CD-ROM RAW mode
 	off_t imgoffset;							// Offset to actual data
+
+	Counter& read_error_count;
+	Counter& write_error_count;
+	Counter& cache_miss_read_count;
+	Counter& cache_miss_write_count;
 };
 
@@ -18,6 +18,7 @@
 #include <spdlog/spdlog.h>
 #include <cassert>
 #include <cstdlib>
+#include <algorithm>
 #include <fstream>
 
 DiskTrack::~DiskTrack()
@@ -48,7 +49,7 @@ void DiskTrack::Init(int track, int size, int sectors, bool raw, off_t imgoff)
 	dt.imgoffset = imgoff;
 }
 
-bool DiskTrack::Load(const string& path, uint64_t& cache_miss_read_count)
+bool DiskTrack::Load(const string& path, Counter& cache_miss_read_count)
 {
 	// Not needed if already loaded
 	if (dt.init) {
@@ -56,7 +57,7 @@ bool DiskTrack::Load(const string& path, uint64_t& cache_miss_read_count)
 		return true;
 	}
 
-	++cache_miss_read_count;
+	cache_miss_read_count.Increment();
 
 	// Calculate offset (previous tracks are considered to hold 256 sectors)
 	off_t offset = ((off_t)dt.track << 8);
@@ -140,7 +141,7 @@ bool DiskTrack::Load(const string& path, uint64_t& cache_miss_read_count)
 	return true;
 }
 
-bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
+bool DiskTrack::Save(const string& path, Counter& cache_miss_write_count, int max_sectors)
 {
 	// Not needed if not initialized
 	if (!dt.init) {
@@ -152,8 +153,6 @@ bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
 		return true;
 	}
 
-	++cache_miss_write_count;
-
 	// Need to write
 	assert(dt.buffer);
 	assert((dt.sectors > 0) && (dt.sectors <= 0x100));
@@ -176,9 +175,10 @@ bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
 		return false;
 	}
 
-	// Partial write loop
+	// Partial write loop, up to max_sectors sectors
 	int total;
-	for (int i = 0; i < dt.sectors;) {
+	int count = 0;
+	for (int i = 0; i < dt.sectors && count < max_sectors;) {
 		// If changed
 		if (dt.changemap[i]) {
 			// Initialize write size
@@ -191,7 +191,7 @@ bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
 
 			// Consectutive sector length
 			int j;
-			for (j = i; j < dt.sectors; j++) {
+			for (j = i; j < dt.sectors && count < max_sectors; j++) {
 				// end when interrupted
 				if (!dt.changemap[j]) {
 					break;
@@ -199,6 +199,7 @@ bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
 
 				// Add one sector
 				total += length;
+				count++;
 			}
 
 			out.write((const char *)&dt.buffer[i << dt.size], total);
@@ -206,17 +207,21 @@ bool DiskTrack::Save(const string& path, uint64_t& cache_miss_write_count)
 				return false;
 			}
 
-			// To unmodified sector
-			i = j;
+			// To unmodified sector, drop the change flags of the saved sectors
+			for (; i < j; i++) {
+				dt.changemap[i] = false;
+			}
 		} else {
 			// Next Sector
 			i++;
 		}
 	}
 
-	// Drop the change flag and exit
-	fill(dt.changemap.begin(), dt.changemap.end(), false); //NOSONAR ranges::fill() cannot be applied to vector<bool>
-	dt.changed = false;
+	// Drop the change flag when all sectors have been saved
+	dt.changed = find(dt.changemap.begin(), dt.changemap.end(), true) != dt.changemap.end(); //NOSONAR ranges::find() cannot be applied to vector<bool>
+	if (!dt.changed) {
+		cache_miss_write_count.Increment();
+	}
 
 	return true;
 }
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include "metrics_registry.h"
 #include <cstdlib>
 #include <cstdint>
 #include <span>
@@ -50,11 +51,13 @@ private:
 	friend class DiskCache;
 
 	void Init(int track, int size, int sectors, bool raw = false, off_t imgoff = 0);
-	bool Load(const string& path, uint64_t&);
-	bool Save(const string& path, uint64_t&);
+	bool Load(const string& path, Counter&);
+	// Saves up to the given number of changed sectors, the track remains changed if there are more
+	bool Save(const string& path, Counter&, int = 0x100);
 
 	bool ReadSector(span<uint8_t>, int) const;				// Sector Read
 	bool WriteSector(span<const uint8_t> buf, int);			// Sector Write
 
 	int GetTrack() const		{ return dt.track; }		// Get track
+	bool IsChanged() const		{ return dt.init && dt.changed; }	// Has to be saved
 };
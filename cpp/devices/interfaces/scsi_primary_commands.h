@@ -29,4 +29,6 @@ public:
 	virtual void ReleaseUnit() = 0;
 	virtual void ReserveUnit() = 0;
 	virtual void SendDiagnostic() = 0;
+	virtual void ReadBuffer10() = 0;
+	virtual void WriteBuffer10() = 0;
 };
@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "metrics_registry.h"
+#include <cassert>
+
+using namespace std;
+
+void Histogram::Reset()
+{
+	for (auto& bucket : buckets) {
+		bucket.store(0, memory_order_relaxed);
+	}
+	count.store(0, memory_order_relaxed);
+	sum.store(0, memory_order_relaxed);
+}
+
+Counter& MetricsRegistry::AddCounter(const string& key, PbStatisticsCategory category, metric_labels_t labels)
+{
+	return Add<Counter>(key, category, labels);
+}
+
+Gauge& MetricsRegistry::AddGauge(const string& key, PbStatisticsCategory category, metric_labels_t labels)
+{
+	return Add<Gauge>(key, category, labels);
+}
+
+Histogram& MetricsRegistry::AddHistogram(const string& key, PbStatisticsCategory category, metric_labels_t labels)
+{
+	return Add<Histogram>(key, category, labels);
+}
+
+template<typename T>
+T& MetricsRegistry::Add(const string& key, PbStatisticsCategory category, metric_labels_t labels)
+{
+	scoped_lock<mutex> lock(entries_mutex);
+
+	for (const auto& entry : entries) {
+		if (entry.key == key && entry.labels.id == labels.id && entry.labels.lun == labels.lun) {
+			// Keys are constants, i.e. a type mismatch is a programming error
+			assert(holds_alternative<unique_ptr<T>>(entry.metric));
+			return *get<unique_ptr<T>>(entry.metric);
+		}
+	}
+
+	auto metric = make_unique<T>();
+	T& m = *metric;
+	entries.push_back({ key, category, labels, std::move(metric) });
+
+	return m;
+}
+
+void MetricsRegistry::SetCondition(const string& key, const function<bool()>& condition)
+{
+	scoped_lock<mutex> lock(entries_mutex);
+
+	conditions[key] = condition;
+}
+
+void MetricsRegistry::Reset()
+{
+	scoped_lock<mutex> lock(entries_mutex);
+
+	for (const auto& entry : entries) {
+		visit([] (const auto& metric) { metric->Reset(); }, entry.metric);
+	}
+}
+
+uint64_t MetricsRegistry::GetValue(const string& key, metric_labels_t labels) const
+{
+	scoped_lock<mutex> lock(entries_mutex);
+
+	for (const auto& entry : entries) {
+		if (entry.key == key && entry.labels.id == labels.id && entry.labels.lun == labels.lun) {
+			if (holds_alternative<unique_ptr<Counter>>(entry.metric)) {
+				return get<unique_ptr<Counter>>(entry.metric)->Get();
+			}
+			if (holds_alternative<unique_ptr<Gauge>>(entry.metric)) {
+				return get<unique_ptr<Gauge>>(entry.metric)->Get();
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+vector<PbStatistics> MetricsRegistry::GetStatistics(int id, int lun) const
+{
+	vector<PbStatistics> statistics;
+
+	PbStatistics s;
+
+	scoped_lock<mutex> lock(entries_mutex);
+
+	for (const auto& entry : entries) {
+		if (const auto& it = conditions.find(entry.key); it != conditions.end() && !it->second()) {
+			continue;
+		}
+
+		s.set_id(entry.labels.id != -1 ? entry.labels.id : id);
+		s.set_unit(entry.labels.lun != -1 ? entry.labels.lun : lun);
+		s.set_category(entry.category);
+
+		if (holds_alternative<unique_ptr<Counter>>(entry.metric)) {
+			s.set_key(entry.key);
+			s.set_value(get<unique_ptr<Counter>>(entry.metric)->Get());
+			statistics.push_back(s);
+		}
+		else if (holds_alternative<unique_ptr<Gauge>>(entry.metric)) {
+			s.set_key(entry.key);
+			s.set_value(get<unique_ptr<Gauge>>(entry.metric)->Get());
+			statistics.push_back(s);
+		}
+		else {
+			const auto& histogram = *get<unique_ptr<Histogram>>(entry.metric);
+
+			s.set_key(entry.key + "_count");
+			s.set_value(histogram.GetCount());
+			statistics.push_back(s);
+
+			s.set_key(entry.key + "_sum");
+			s.set_value(histogram.GetSum());
+			statistics.push_back(s);
+
+			for (int n = 0; n < Histogram::BUCKET_COUNT; n++) {
+				if (const uint64_t count = histogram.GetBucket(n); count) {
+					s.set_key(entry.key + "_le_" + to_string(Histogram::GetUpperBound(n)));
+					s.set_value(count);
+					statistics.push_back(s);
+				}
+			}
+		}
+	}
+
+	return statistics;
+}
@@ -0,0 +1,150 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The metrics of a device, or the metrics which are not device specific. The metrics are updated by the bus
+// thread with relaxed atomic operations, i.e. without any locking, and are read by the service thread.
+// Adding a metric is a single line, e.g.
+//   Counter& sector_read_count = metrics.AddCounter(SECTOR_READ_COUNT);
+// The registry owns the metrics, the references remain valid for the lifetime of the registry.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "generated/piscsi_interface.pb.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+using namespace std;
+using namespace piscsi_interface;
+
+class Counter
+{
+
+public:
+
+	void Increment(uint64_t n = 1) { value.fetch_add(n, memory_order_relaxed); }
+	uint64_t Get() const { return value.load(memory_order_relaxed); }
+	void Reset() { value.store(0, memory_order_relaxed); }
+
+private:
+
+	atomic<uint64_t> value = 0;
+};
+
+class Gauge
+{
+
+public:
+
+	void Set(uint64_t v) { value.store(v, memory_order_relaxed); }
+	// Only sets the value if it is larger than the current value
+	void SetMax(uint64_t v)
+	{
+		uint64_t current = value.load(memory_order_relaxed);
+		while (v > current && !value.compare_exchange_weak(current, v, memory_order_relaxed)) {}
+	}
+	uint64_t Get() const { return value.load(memory_order_relaxed); }
+	void Reset() { value.store(0, memory_order_relaxed); }
+
+private:
+
+	atomic<uint64_t> value = 0;
+};
+
+// Bucket n counts the values with n significant bits, i.e. bucket 0 counts 0, bucket n counts the values
+// from 2^(n-1) to 2^n - 1
+class Histogram
+{
+
+public:
+
+	void Record(uint64_t v)
+	{
+		buckets[bit_width(v)].fetch_add(1, memory_order_relaxed);
+		count.fetch_add(1, memory_order_relaxed);
+		sum.fetch_add(v, memory_order_relaxed);
+	}
+
+	uint64_t GetCount() const { return count.load(memory_order_relaxed); }
+	uint64_t GetSum() const { return sum.load(memory_order_relaxed); }
+	uint64_t GetBucket(int n) const { return buckets[n].load(memory_order_relaxed); }
+	void Reset();
+
+	// The largest value counted by bucket n
+	static uint64_t GetUpperBound(int n) { return n < 64 ? (1ULL << n) - 1 : UINT64_MAX; }
+
+	static const int BUCKET_COUNT = 65;
+
+private:
+
+	array<atomic<uint64_t>, BUCKET_COUNT> buckets = {};
+	atomic<uint64_t> count = 0;
+	atomic<uint64_t> sum = 0;
+};
+
+// The ID and LUN a metric is reported for. -1 means that the metric is not specific for an ID or a LUN.
+struct metric_labels_t {
+	int id = -1;
+	int lun = -1;
+};
+
+class MetricsRegistry
+{
+
+public:
+
+	MetricsRegistry() = default;
+	~MetricsRegistry() = default;
+
+	// Adding a metric with the key and labels of an existing metric of the same type returns the existing metric
+	Counter& AddCounter(const string&, PbStatisticsCategory = PbStatisticsCategory::CATEGORY_INFO, metric_labels_t = {});
+	Gauge& AddGauge(const string&, PbStatisticsCategory = PbStatisticsCategory::CATEGORY_INFO, metric_labels_t = {});
+	Histogram& AddHistogram(const string&, PbStatisticsCategory = PbStatisticsCategory::CATEGORY_INFO, metric_labels_t = {});
+
+	// A metric is only reported if the condition is true, e.g. write counters are not reported for read-only media.
+	// The condition may be set before the metric is added.
+	void SetCondition(const string&, const function<bool()>&);
+
+	void Reset();
+
+	// The value of a counter or gauge, 0 if there is no such metric
+	uint64_t GetValue(const string&, metric_labels_t = {}) const;
+
+	// Histograms are reported as KEY_count, KEY_sum and KEY_le_UPPER_BOUND for each non-empty bucket.
+	// Metrics without an ID or LUN label are reported with the ID and LUN passed, e.g. those of the device.
+	vector<PbStatistics> GetStatistics(int = -1, int = -1) const;
+
+private:
+
+	using metric_t = variant<unique_ptr<Counter>, unique_ptr<Gauge>, unique_ptr<Histogram>>;
+
+	struct entry_t {
+		string key;
+		PbStatisticsCategory category;
+		metric_labels_t labels;
+		metric_t metric;
+	};
+
+	template<typename T>
+	T& Add(const string&, PbStatisticsCategory, metric_labels_t);
+
+	// Protects the list of metrics, not the values
+	mutable mutex entries_mutex;
+
+	vector<entry_t> entries;
+
+	unordered_map<string, function<bool()>> conditions;
+};
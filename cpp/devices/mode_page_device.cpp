@@ -13,8 +13,6 @@
 #include "scsi_command_util.h"
 #include "mode_page_device.h"
 #include <cstddef>
-#include <sstream>
-#include <iomanip>
 
 using namespace std;
 using namespace scsi_defs;
@@ -44,23 +42,47 @@ int ModePageDevice::AddModePages(cdb_t cdb, vector<uint8_t>& buf, int offset, in
 	// Get page code (0x3f means all pages)
 	const int page = cdb[2] & 0x3f;
 
-	stringstream s;
-	s << "Requesting mode page $" << setfill('0') << setw(2) << hex << page;
-	LogTrace(s.str());
+	LogTrace("Requesting mode page ${:02x}", page);
 
+	// Holds all mode page data
+	vector<byte>& result = mode_page_cache[changeable ? page + 0x40 : page];
+
+	if (const auto state = GetModePageState(); !state) {
+		result.clear();
+	}
+	else if (state != mode_page_state) {
+		for (auto& data : mode_page_cache) {
+			data.clear();
+		}
+		mode_page_state = state;
+	}
+
+	if (result.empty()) {
+		AssembleModePages(result, page, changeable);
+	}
+
+	if (static_cast<int>(result.size()) > max_size) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	const auto size = static_cast<int>(min(static_cast<size_t>(max_length), result.size()));
+	memcpy(&buf.data()[offset], result.data(), size);
+
+	// Do not return more than the requested number of bytes
+	return size + offset < length ? size + offset : length;
+}
+
+void ModePageDevice::AssembleModePages(vector<byte>& result, int page, bool changeable) const
+{
 	// Mode page data mapped to the respective page numbers, C++ maps are ordered by key
 	map<int, vector<byte>> pages;
 	SetUpModePages(pages, page, changeable);
 
 	if (pages.empty()) {
-		s << "Unsupported mode page $" << page;
-		LogTrace(s.str());
+		LogTrace("Unsupported mode page ${:02x}", page);
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
 	}
 
-	// Holds all mode page data
-	vector<byte> result;
-
 	vector<byte> page0;
 	for (const auto& [index, data] : pages) {
 		// The specification mandates that page 0 must be returned after all others
@@ -88,16 +110,6 @@ int ModePageDevice::AddModePages(cdb_t cdb, vector<uint8_t>& buf, int offset, in
 		// Page payload size
 		result[off + 1] = (byte)(page0.size() - 2);
 	}
-
-	if (static_cast<int>(result.size()) > max_size) {
-		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
-	}
-
-	const auto size = static_cast<int>(min(static_cast<size_t>(max_length), result.size()));
-	memcpy(&buf.data()[offset], result.data(), size);
-
-	// Do not return more than the requested number of bytes
-	return size + offset < length ? size + offset : length;
 }
 
 void ModePageDevice::ModeSense6() const
@@ -120,19 +132,19 @@ void ModePageDevice::ModeSelect(scsi_command, cdb_t, span<const uint8_t>, int)
 	throw scsi_exception(sense_key::illegal_request, asc::invalid_command_operation_code);
 }
 
-void ModePageDevice::ModeSelect6() const
+void ModePageDevice::ModeSelect6()
 {
 	SaveParametersCheck(GetController()->GetCmdByte(4));
 }
 
-void ModePageDevice::ModeSelect10() const
+void ModePageDevice::ModeSelect10()
 {
 	const auto length = min(GetController()->GetBuffer().size(), static_cast<size_t>(GetInt16(GetController()->GetCmd(), 7)));
 
 	SaveParametersCheck(static_cast<uint32_t>(length));
 }
 
-void ModePageDevice::SaveParametersCheck(int length) const
+void ModePageDevice::SaveParametersCheck(int length)
 {
 	if (!SupportsSaveParameters() && (GetController()->GetCmdByte(1) & 0x01)) {
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
@@ -140,5 +152,11 @@ void ModePageDevice::SaveParametersCheck(int length) const
 
 	GetController()->SetLength(length);
 
+	GetController()->SetTransferHandler([this] (uint64_t) {
+		ModeSelect(static_cast<scsi_command>(GetController()->GetCmdByte(0)), GetController()->GetCmd(),
+				GetController()->GetBuffer(), GetController()->GetOffset());
+		return 0;
+	});
+
 	EnterDataOutPhase();
 }
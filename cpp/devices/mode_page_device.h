@@ -14,6 +14,8 @@
 #include <span>
 #include <vector>
 #include <map>
+#include <array>
+#include <optional>
 
 class ModePageDevice : public PrimaryDevice
 {
@@ -35,17 +37,27 @@ protected:
 		// Nothing to add by default
 	}
 
+	// The assembled mode page data are cached until this value changes. Devices with mode page data that depend
+	// on more than their state, e.g. on the current time, must not cache them.
+	virtual optional<uint64_t> GetModePageState() const { return nullopt; }
+
 private:
 
 	bool supports_save_parameters = false;
 
+	void AssembleModePages(vector<byte>&, int, bool) const;
+
+	// Indexed by page code, with 0x40 added for changeable values
+	mutable array<vector<byte>, 0x80> mode_page_cache;
+	mutable optional<uint64_t> mode_page_state;
+
 	virtual int ModeSense6(cdb_t, vector<uint8_t>&) const = 0;
 	virtual int ModeSense10(cdb_t, vector<uint8_t>&) const = 0;
 
 	void ModeSense6() const;
 	void ModeSense10() const;
-	void ModeSelect6() const;
-	void ModeSelect10() const;
+	void ModeSelect6();
+	void ModeSelect10();
 
-	void SaveParametersCheck(int) const;
+	void SaveParametersCheck(int);
 };
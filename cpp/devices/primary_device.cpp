@@ -10,8 +10,6 @@
 #include "shared/piscsi_exceptions.h"
 #include "scsi_command_util.h"
 #include "primary_device.h"
-#include <sstream>
-#include <iomanip>
 
 using namespace std;
 using namespace scsi_defs;
@@ -29,6 +27,8 @@ bool PrimaryDevice::Init(const param_map& params)
 	AddCommand(scsi_command::eCmdReserve6, [this] { ReserveUnit(); });
 	AddCommand(scsi_command::eCmdRelease6, [this] { ReleaseUnit(); });
 	AddCommand(scsi_command::eCmdSendDiagnostic, [this] { SendDiagnostic(); });
+	AddCommand(scsi_command::eCmdReadBuffer10, [this] { ReadBuffer10(); });
+	AddCommand(scsi_command::eCmdWriteBuffer10, [this] { WriteBuffer10(); });
 
 	SetParams(params);
 
@@ -37,21 +37,18 @@ bool PrimaryDevice::Init(const param_map& params)
 
 void PrimaryDevice::AddCommand(scsi_command cmd, const operation& execute)
 {
-	commands[cmd] = execute;
+	commands[static_cast<int>(cmd)] = execute;
 }
 
 void PrimaryDevice::Dispatch(scsi_command cmd)
 {
-	stringstream s;
-	s << "$" << setfill('0') << setw(2) << hex << static_cast<int>(cmd);
+	if (const auto& execute = commands[static_cast<int>(cmd)]; execute) {
+		LogDebug("Device is executing {0} (${1:02x})", GetCommandDescriptor(cmd).name, static_cast<int>(cmd));
 
-	if (const auto& it = commands.find(cmd); it != commands.end()) {
-		LogDebug("Device is executing " + command_mapping.find(cmd)->second.second + " (" + s.str() + ")");
-
-		it->second();
+		execute();
 	}
 	else {
-		LogTrace("Received unsupported command: " + s.str());
+		LogTrace("Received unsupported command: ${:02x}", static_cast<int>(cmd));
 
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_command_operation_code);
 	}
@@ -73,6 +70,8 @@ void PrimaryDevice::SetController(AbstractController *c)
 {
 	controller = c;
 
+	InvalidateInquiryData();
+
 	device_logger.SetIdAndLun(GetId(), GetLun());
 }
 
@@ -90,11 +89,13 @@ void PrimaryDevice::Inquiry()
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
 	}
 
-	const vector<uint8_t> buf = InquiryInternal();
+	if (!inquiry_data_cacheable || inquiry_data.empty()) {
+		inquiry_data = InquiryInternal();
+	}
 
-	const size_t allocation_length = min(buf.size(), static_cast<size_t>(GetInt16(GetController()->GetCmd(), 3)));
+	const size_t allocation_length = min(inquiry_data.size(), static_cast<size_t>(GetInt16(GetController()->GetCmd(), 3)));
 
-	memcpy(GetController()->GetBuffer().data(), buf.data(), allocation_length);
+	memcpy(GetController()->GetBuffer().data(), inquiry_data.data(), allocation_length);
 	GetController()->SetLength(static_cast<uint32_t>(allocation_length));
 
 	// Report if the device does not support the requested LUN
@@ -155,7 +156,7 @@ void PrimaryDevice::RequestSense()
 		GetController()->SetStatus(status::good);
 	}
 
-    vector<byte> buf = GetController()->GetDeviceForLun(lun)->HandleRequestSense();
+    const auto buf = GetController()->GetDeviceForLun(lun)->HandleRequestSense();
 
 	const size_t allocation_length = min(buf.size(), static_cast<size_t>(GetController()->GetCmdByte(4)));
 
@@ -180,6 +181,102 @@ void PrimaryDevice::SendDiagnostic()
 	EnterStatusPhase();
 }
 
+void PrimaryDevice::ReadBuffer10()
+{
+	const auto& cmd = GetController()->GetCmd();
+	const int mode = cmd[1] & 0x1f;
+	const uint32_t offset = GetInt24(cmd, 3);
+	const uint32_t allocation_length = GetInt24(cmd, 6);
+
+	// There is only buffer 0
+	if (cmd[2]) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	// The data are copied from the controller memory, there is no access to any medium
+	vector<uint8_t> descriptor(4);
+	span<const uint8_t> data;
+	switch (mode) {
+		case BUFFER_MODE_DATA: {
+			const auto& buf = GetController()->GetDataBuffer();
+			if (offset > buf.size()) {
+				throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+			}
+			data = span(buf).subspan(offset);
+			break;
+		}
+
+		case BUFFER_MODE_DESCRIPTOR:
+			// Any offset is permitted, i.e. the offset boundary is 0
+			SetInt24(descriptor, 1, AbstractController::GetDataBufferSize());
+			data = descriptor;
+			break;
+
+		case BUFFER_MODE_ECHO:
+			// The echo buffer is empty until it has been written
+			if (GetController()->GetEchoBuffer().empty()) {
+				throw scsi_exception(sense_key::illegal_request, asc::command_sequence_error);
+			}
+			data = GetController()->GetEchoBuffer();
+			break;
+
+		case BUFFER_MODE_ECHO_DESCRIPTOR:
+			SetInt16(descriptor, 2, AbstractController::ECHO_BUFFER_SIZE);
+			data = descriptor;
+			break;
+
+		default:
+			throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	const auto length = static_cast<uint32_t>(min(data.size(), static_cast<size_t>(allocation_length)));
+
+	LogTrace("Reading {0} byte(s) from buffer in mode ${1:02x}", length, mode);
+
+	GetController()->AllocateBuffer(length);
+	memcpy(GetController()->GetBuffer().data(), data.data(), length);
+	GetController()->SetLength(length);
+
+	EnterDataInPhase();
+}
+
+void PrimaryDevice::WriteBuffer10()
+{
+	const auto& cmd = GetController()->GetCmd();
+	const int mode = cmd[1] & 0x1f;
+	const uint32_t offset = GetInt24(cmd, 3);
+	const uint32_t length = GetInt24(cmd, 6);
+
+	if (cmd[2] || (mode != BUFFER_MODE_DATA && mode != BUFFER_MODE_ECHO)) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	if (mode == BUFFER_MODE_DATA ?
+			static_cast<uint64_t>(offset) + length > AbstractController::GetDataBufferSize() :
+			length > AbstractController::ECHO_BUFFER_SIZE) {
+		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
+	}
+
+	LogTrace("Writing {0} byte(s) to buffer in mode ${1:02x}", length, mode);
+
+	GetController()->AllocateBuffer(length);
+	GetController()->SetLength(length);
+
+	GetController()->SetTransferHandler([this, mode, offset, length] (uint64_t) {
+		const auto& buf = GetController()->GetBuffer();
+		if (mode == BUFFER_MODE_DATA) {
+			memcpy(GetController()->GetDataBuffer().data() + offset, buf.data(), length);
+		}
+		else {
+			// Reading the echo buffer returns exactly the data of the last write
+			GetController()->GetEchoBuffer().assign(buf.begin(), buf.begin() + length);
+		}
+		return 0;
+	});
+
+	EnterDataOutPhase();
+}
+
 void PrimaryDevice::CheckReady()
 {
 	// Not ready if reset
@@ -221,6 +318,10 @@ vector<uint8_t> PrimaryDevice::HandleInquiry(device_type type, scsi_level level,
 	buf[3] = level >= scsi_level::scsi_2 ?
 			static_cast<uint8_t>(scsi_level::scsi_2) : static_cast<uint8_t>(scsi_level::scsi_1_ccs);
 	buf[4] = 0x1F;
+	// CmdQue
+	if (level >= scsi_level::scsi_2 && SupportsCommandQueuing()) {
+		buf[7] = 0x02;
+	}
 
 	// Padded vendor, product, revision
 	memcpy(&buf.data()[8], GetPaddedName().c_str(), 28);
@@ -228,7 +329,7 @@ vector<uint8_t> PrimaryDevice::HandleInquiry(device_type type, scsi_level level,
 	return buf;
 }
 
-vector<byte> PrimaryDevice::HandleRequestSense() const
+array<byte, 18> PrimaryDevice::HandleRequestSense() const
 {
 	// Return not ready only if there are no errors
 	if (!GetStatusCode() && !IsReady()) {
@@ -237,7 +338,7 @@ vector<byte> PrimaryDevice::HandleRequestSense() const
 
 	// Set 18 bytes including extended sense data
 
-	vector<byte> buf(18);
+	array<byte, 18> buf = {};
 
 	// Current error
 	buf[0] = (byte)0x70;
@@ -247,12 +348,8 @@ vector<byte> PrimaryDevice::HandleRequestSense() const
 	buf[12] = (byte)(GetStatusCode() >> 8);
 	buf[13] = (byte)GetStatusCode();
 
-	stringstream s;
-	s << setfill('0') << setw(2) << hex
-			<< "Status $" << static_cast<int>(GetController()->GetStatus())
-			<< ", Sense Key $" << static_cast<int>(buf[2])
-			<< ", ASC $" << static_cast<int>(buf[12]);
-	LogTrace(s.str());
+	LogTrace("Status ${0:02x}, Sense Key ${1:02x}, ASC ${2:02x}", static_cast<int>(GetController()->GetStatus()),
+			static_cast<int>(buf[2]), static_cast<int>(buf[12]));
 
 	return buf;
 }
@@ -269,7 +366,7 @@ void PrimaryDevice::ReserveUnit()
 	reserving_initiator = GetController()->GetInitiatorId();
 
 	if (reserving_initiator != -1) {
-		LogTrace("Reserved device for initiator ID " + to_string(reserving_initiator));
+		LogTrace("Reserved device for initiator ID {}", reserving_initiator);
 	}
 	else {
 		LogTrace("Reserved device for unknown initiator");
@@ -281,7 +378,7 @@ void PrimaryDevice::ReserveUnit()
 void PrimaryDevice::ReleaseUnit()
 {
 	if (reserving_initiator != -1) {
-		LogTrace("Released device reserved by initiator ID " + to_string(reserving_initiator));
+		LogTrace("Released device reserved by initiator ID {}", reserving_initiator);
 	}
 	else {
 		LogTrace("Released device reserved by unknown initiator");
@@ -308,7 +405,7 @@ bool PrimaryDevice::CheckReservation(int initiator_id, scsi_command cmd, bool pr
 	}
 
 	if (initiator_id != -1) {
-		LogTrace("Initiator ID " + to_string(initiator_id) + " tries to access reserved device");
+		LogTrace("Initiator ID {} tries to access reserved device", initiator_id);
 	}
 	else {
 		LogTrace("Unknown initiator tries to access reserved device");
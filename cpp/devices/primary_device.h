@@ -14,10 +14,12 @@
 #include "shared/scsi.h"
 #include "interfaces/scsi_primary_commands.h"
 #include "controllers/abstract_controller.h"
+#include "controllers/idle_scheduler.h"
 #include "device.h"
 #include "device_logger.h"
+#include "metrics_registry.h"
 #include <string>
-#include <unordered_map>
+#include <array>
 #include <span>
 #include <functional>
 
@@ -57,12 +59,23 @@ public:
 		// Devices with a cache have to override this method
 	}
 
-	virtual vector<PbStatistics> GetStatistics() const {
-		// Devices which provide statistics have to override this method
+	virtual void SetIdleScheduler(IdleScheduler&) {
+		// Devices with background work, which must only be done while the bus is idle, have to override this method
+	}
 
-		return vector<PbStatistics>();
+	// Devices which benefit from executing their commands in block order have to override this method
+	virtual bool SupportsCommandQueuing() const { return false; }
+	// Called with the blocks of the next queued READ commands before the initiator is reselected
+	virtual void Prefetch(uint64_t, uint64_t) {
+		// Devices with a cache have to override this method
 	}
 
+	// The metrics with the ID and LUN of the device
+	vector<PbStatistics> GetStatistics() const { return metrics.GetStatistics(GetId(), GetLun()); }
+
+	// Called by the controller with the time from the command phase until bus free
+	void AddCommandTime(uint64_t us) { command_time.Record(us); }
+
 protected:
 
 	void AddCommand(scsi_command, const operation&);
@@ -73,6 +86,11 @@ protected:
 
 	void SetSendDelay(int s) { send_delay = s; }
 
+	// For devices with INQUIRY data that only change when a new medium is inserted, saves rebuilding the data
+	// for each INQUIRY command
+	void SetInquiryDataCacheable() { inquiry_data_cacheable = true; }
+	void InvalidateInquiryData() { inquiry_data.clear(); }
+
 	void SendDiagnostic() override;
 	void ReserveUnit() override;
 	void ReleaseUnit() override;
@@ -83,24 +101,46 @@ protected:
 
 	auto GetController() const { return controller; }
 
-	void LogTrace(const string& s) const { device_logger.Trace(s); }
-	void LogDebug(const string& s) const { device_logger.Debug(s); }
-	void LogInfo(const string& s) const { device_logger.Info(s); }
-	void LogWarn(const string& s) const { device_logger.Warn(s); }
-	void LogError(const string& s) const { device_logger.Error(s); }
+	MetricsRegistry& GetMetrics() { return metrics; }
+	const MetricsRegistry& GetMetrics() const { return metrics; }
+	const Histogram& GetCommandTime() const { return command_time; }
+
+	void LogTrace(string_view s) const { device_logger.Trace(s); }
+	void LogDebug(string_view s) const { device_logger.Debug(s); }
+	void LogInfo(string_view s) const { device_logger.Info(s); }
+	void LogWarn(string_view s) const { device_logger.Warn(s); }
+	void LogError(string_view s) const { device_logger.Error(s); }
+
+	// Formatting is deferred until the level is known to be enabled
+	template<typename... Args>
+	void LogTrace(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Trace(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogDebug(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Debug(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogWarn(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Warn(f, forward<Args>(args)...); }
+	template<typename... Args>
+	void LogError(fmt::format_string<Args...> f, Args&&... args) const { device_logger.Error(f, forward<Args>(args)...); }
 
 private:
 
 	static const int NOT_RESERVED = -2;
 
+	// The modes of READ BUFFER and WRITE BUFFER
+	static const int BUFFER_MODE_DATA = 0x02;
+	static const int BUFFER_MODE_DESCRIPTOR = 0x03;
+	static const int BUFFER_MODE_ECHO = 0x0a;
+	static const int BUFFER_MODE_ECHO_DESCRIPTOR = 0x0b;
+
 	void SetController(AbstractController *);
 
 	void TestUnitReady() override;
 	void RequestSense() override;
 	void ReportLuns() override;
 	void Inquiry() override;
+	void ReadBuffer10() override;
+	void WriteBuffer10() override;
 
-	vector<byte> HandleRequestSense() const;
+	array<byte, 18> HandleRequestSense() const;
 
 	// TODO Try to remove this field and use controller->Log*() methods instead
 	DeviceLogger device_logger;
@@ -108,9 +148,20 @@ private:
 	// Owned by the controller manager
 	AbstractController *controller = nullptr;
 
-	unordered_map<scsi_command, operation> commands;
+	// Command handlers indexed by opcode, unsupported opcodes have no handler
+	array<operation, 256> commands = {};
 
 	int send_delay = BUS::SEND_NO_DELAY;
 
+	bool inquiry_data_cacheable = false;
+	vector<uint8_t> inquiry_data;
+
 	int reserving_initiator = NOT_RESERVED;
+
+	// Base class members are initialized first, i.e. subclasses can add their metrics in member initializers
+	MetricsRegistry metrics;
+
+	inline static const string COMMAND_TIME = "command_time_us";
+
+	Histogram& command_time = metrics.AddHistogram(COMMAND_TIME);
 };
@@ -106,7 +106,7 @@ void scsi_command_util::AddAppleVendorModePage(map<int, vector<byte>>& pages, bo
 
 
 
-uint32_t scsi_command_util::GetInt32(span <const int> buf, int offset)
+uint32_t scsi_command_util::GetInt32(span<const uint8_t> buf, int offset)
 {
 	assert(buf.size() > static_cast<size_t>(offset) + 3);
 
@@ -114,7 +114,7 @@ uint32_t scsi_command_util::GetInt32(span <const int> buf, int offset)
 			(static_cast<uint32_t>(buf[offset + 2]) << 8) | static_cast<uint32_t>(buf[offset + 3]);
 }
 
-uint64_t scsi_command_util::GetInt64(span<const int> buf, int offset)
+uint64_t scsi_command_util::GetInt64(span<const uint8_t> buf, int offset)
 {
 	assert(buf.size() > static_cast<size_t>(offset) + 7);
 
@@ -68,7 +68,7 @@ namespace scsi_command_util
 
 		return (int(buf[offset]) << 16) | (int(buf[offset + 1]) << 8) | buf[offset + 2];
 	}
-	uint32_t GetInt32(span <const int>, int);
-	uint64_t GetInt64(span<const int>, int);
+	uint32_t GetInt32(span<const uint8_t>, int);
+	uint64_t GetInt64(span<const uint8_t>, int);
 	void SetInt64(vector<uint8_t>&, int, uint64_t);
 }
@@ -127,7 +127,7 @@ int SCSIDaynaPort::Read(cdb_t cdb, vector<uint8_t>& buf, uint64_t)
 
 	const int requested_length = cdb[4];
 
-	LogTrace("Read maximum length: " + to_string(requested_length));
+	LogTrace("Read maximum length: {}", requested_length);
 
 	// At startup the host may send a READ(6) command with a sector count of 1 to read the root sector.
 	// We should respond by going into the status mode with a code of 0x02.
@@ -156,9 +156,9 @@ int SCSIDaynaPort::Read(cdb_t cdb, vector<uint8_t>& buf, uint64_t)
 			return DAYNAPORT_READ_HEADER_SZ;
 		}
 
-        byte_read_count += rx_packet_size;
+        byte_read_count.Increment(rx_packet_size);
 
-		LogTrace("Packet Size " + to_string(rx_packet_size) + ", read count: " + to_string(read_count));
+		LogTrace("Packet size {0}, read count: {1}", rx_packet_size, read_count);
 
 		// This is a very basic filter to prevent unnecessary packets from
 		// being sent to the SCSI initiator.
@@ -262,15 +262,15 @@ bool SCSIDaynaPort::Write(cdb_t cdb, span<const uint8_t> buf)
 	if (const int data_format = cdb[5]; data_format == 0x00) {
 		const int data_length = GetInt16(cdb, 3);
 		tap.Send(buf.data(), data_length);
-		byte_write_count += data_length;
-		LogTrace("Transmitted " + to_string(data_length) + " byte(s) (00 format)");
+		byte_write_count.Increment(data_length);
+		LogTrace("Transmitted {} byte(s) (00 format)", data_length);
 	}
 	else if (data_format == 0x80) {
 		// The data length is specified in the first 2 bytes of the payload
 		const int data_length = buf[1] + ((static_cast<int>(buf[0]) & 0xff) << 8);
 		tap.Send(&(buf.data()[4]), data_length);
-		byte_write_count += data_length;
-		LogTrace("Transmitted " + to_string(data_length) + "byte(s) (80 format)");
+		byte_write_count.Increment(data_length);
+		LogTrace("Transmitted {} byte(s) (80 format)", data_length);
 	}
 	else {
 		stringstream s;
@@ -321,7 +321,7 @@ void SCSIDaynaPort::Read6()
 	// If any commands have a bogus control value, they were probably not
 	// generated by the DaynaPort driver so ignore them
 	if (GetController()->GetCmdByte(5) != 0xc0 && GetController()->GetCmdByte(5) != 0x80) {
-		LogTrace("Control value: " + to_string(GetController()->GetCmdByte(5)));
+		LogTrace("Control value: {}", GetController()->GetCmdByte(5));
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
 	}
 
@@ -330,7 +330,7 @@ void SCSIDaynaPort::Read6()
 	LogTrace(s.str());
 
 	GetController()->SetLength(Read(GetController()->GetCmd(), GetController()->GetBuffer(), record));
-	LogTrace("Length is " + to_string(GetController()->GetLength()));
+	LogTrace("Length is {}", GetController()->GetLength());
 
 	// Set next block
 	GetController()->SetNext(record + 1);
@@ -338,7 +338,7 @@ void SCSIDaynaPort::Read6()
 	EnterDataInPhase();
 }
 
-void SCSIDaynaPort::Write6() const
+void SCSIDaynaPort::Write6()
 {
 	// Ensure a sufficient buffer size (because it is not transfer for each block)
 	GetController()->AllocateBuffer(DAYNAPORT_BUFFER_SIZE);
@@ -369,6 +369,11 @@ void SCSIDaynaPort::Write6() const
 	GetController()->SetBlocks(1);
 	GetController()->SetNext(1);
 
+	GetController()->SetTransferHandler([this] (uint64_t) {
+		Write(GetController()->GetCmd(), GetController()->GetBuffer());
+		return 0;
+	});
+
 	EnterDataOutPhase();
 }
 
@@ -484,24 +489,3 @@ void SCSIDaynaPort::EnableInterface() const
 
 	EnterStatusPhase();
 }
-
-vector<PbStatistics> SCSIDaynaPort::GetStatistics() const
-{
-	vector<PbStatistics> statistics = PrimaryDevice::GetStatistics();
-
-	PbStatistics s;
-	s.set_id(GetId());
-	s.set_unit(GetLun());
-
-	s.set_category(PbStatisticsCategory::CATEGORY_INFO);
-
-	s.set_key(BYTE_READ_COUNT);
-	s.set_value(byte_read_count);
-	statistics.push_back(s);
-
-	s.set_key(BYTE_WRITE_COUNT);
-	s.set_value(byte_write_count);
-	statistics.push_back(s);
-
-	return statistics;
-}
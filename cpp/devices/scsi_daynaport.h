@@ -42,12 +42,12 @@
 //===========================================================================
 class SCSIDaynaPort : public PrimaryDevice
 {
-	uint64_t byte_read_count = 0;
-	uint64_t byte_write_count = 0;
-
 	inline static const string BYTE_READ_COUNT = "byte_read_count";
 	inline static const string BYTE_WRITE_COUNT = "byte_write_count";
 
+	Counter& byte_read_count = GetMetrics().AddCounter(BYTE_READ_COUNT);
+	Counter& byte_write_count = GetMetrics().AddCounter(BYTE_WRITE_COUNT);
+
 public:
 
 	explicit SCSIDaynaPort(int);
@@ -67,13 +67,12 @@ public:
 
 	void TestUnitReady() override;
 	void Read6();
-	void Write6() const;
+	void Write6();
 	void RetrieveStatistics() const;
 	void SetInterfaceMode() const;
 	void SetMcastAddr() const;
 	void EnableInterface() const;
 
-	vector<PbStatistics> GetStatistics() const override;
 
 	static const int DAYNAPORT_BUFFER_SIZE = 0x1000000;
 
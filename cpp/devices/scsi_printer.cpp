@@ -111,13 +111,13 @@ void SCSIPrinter::Print()
 {
 	const uint32_t length = GetInt24(GetController()->GetCmd(), 2);
 
-	LogTrace("Expecting to receive " + to_string(length) + " byte(s) to be printed");
+	LogTrace("Expecting to receive {} byte(s) to be printed", length);
 
 	if (length > GetController()->GetBuffer().size()) {
 		LogError("Transfer buffer overflow: Buffer size is " + to_string(GetController()->GetBuffer().size()) +
 				" bytes, " + to_string(length) + " bytes expected");
 
-		++print_error_count;
+		print_error_count.Increment();
 
 		throw scsi_exception(sense_key::illegal_request, asc::invalid_field_in_cdb);
 	}
@@ -133,7 +133,7 @@ void SCSIPrinter::SynchronizeBuffer()
 	if (!out.is_open()) {
 		LogWarn("Nothing to print");
 
-		++print_warning_count;
+		print_warning_count.Increment();
 
 		throw scsi_exception(sense_key::aborted_command);
 	}
@@ -153,13 +153,15 @@ void SCSIPrinter::SynchronizeBuffer()
 	if (system(cmd.c_str())) {
 		LogError("Printing file '" + filename + "' failed, the printing system might not be configured");
 
-		++print_error_count;
+		print_error_count.Increment();
 
 		CleanUp();
 
 		throw scsi_exception(sense_key::aborted_command);
 	}
 
+	file_print_count.Increment();
+
 	CleanUp();
 
 	EnterStatusPhase();
@@ -167,7 +169,7 @@ void SCSIPrinter::SynchronizeBuffer()
 
 bool SCSIPrinter::WriteByteSequence(span<const uint8_t> buf)
 {
-	byte_receive_count += buf.size();
+	byte_receive_count.Increment(buf.size());
 
 	if (!out.is_open()) {
 		vector<char> f(file_template.begin(), file_template.end());
@@ -178,7 +180,7 @@ bool SCSIPrinter::WriteByteSequence(span<const uint8_t> buf)
 		if (fd == -1) {
 			LogError("Can't create printer output file for pattern '" + filename + "': " + strerror(errno));
 
-			++print_error_count;
+			print_error_count.Increment();
 
 			return false;
 		}
@@ -188,7 +190,7 @@ bool SCSIPrinter::WriteByteSequence(span<const uint8_t> buf)
 
 		out.open(filename, ios::binary);
 		if (out.fail()) {
-			++print_error_count;
+			print_error_count.Increment();
 
 			throw scsi_exception(sense_key::aborted_command);
 		}
@@ -196,47 +198,14 @@ bool SCSIPrinter::WriteByteSequence(span<const uint8_t> buf)
 		LogTrace("Created printer output file '" + filename + "'");
 	}
 
-	LogTrace("Appending " + to_string(buf.size()) + " byte(s) to printer output file ''" + filename + "'");
+	LogTrace("Appending {0} byte(s) to printer output file '{1}'", buf.size(), filename);
 
 	out.write((const char *)buf.data(), buf.size());
 
 	const bool status = out.fail();
 	if (status) {
-		++print_error_count;
+		print_error_count.Increment();
 	}
 
 	return !status;
 }
-
-vector<PbStatistics> SCSIPrinter::GetStatistics() const
-{
-	vector<PbStatistics> statistics = PrimaryDevice::GetStatistics();
-
-	PbStatistics s;
-	s.set_id(GetId());
-	s.set_unit(GetLun());
-
-	s.set_category(PbStatisticsCategory::CATEGORY_INFO);
-
-	s.set_key(FILE_PRINT_COUNT);
-	s.set_value(file_print_count);
-	statistics.push_back(s);
-
-	s.set_key(BYTE_RECEIVE_COUNT);
-	s.set_value(byte_receive_count);
-	statistics.push_back(s);
-
-	s.set_category(PbStatisticsCategory::CATEGORY_ERROR);
-
-	s.set_key(PRINT_ERROR_COUNT);
-	s.set_value(print_error_count);
-	statistics.push_back(s);
-
-	s.set_category(PbStatisticsCategory::CATEGORY_WARNING);
-
-	s.set_key(PRINT_WARNING_COUNT);
-	s.set_value(print_warning_count);
-	statistics.push_back(s);
-
-	return statistics;
-}
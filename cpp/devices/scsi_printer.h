@@ -21,11 +21,6 @@ using namespace std;
 
 class SCSIPrinter : public PrimaryDevice, private ScsiPrinterCommands
 {
-	uint64_t file_print_count = 0;
-	uint64_t byte_receive_count = 0;
-	uint64_t print_error_count = 0;
-	uint64_t print_warning_count = 0;
-
 	static const int NOT_RESERVED = -2;
 
 	static constexpr const char *PRINTER_FILE_PATTERN = "/piscsi_sclp-XXXXXX";
@@ -35,6 +30,11 @@ class SCSIPrinter : public PrimaryDevice, private ScsiPrinterCommands
 	inline static const string PRINT_ERROR_COUNT = "print_error_count";
 	inline static const string PRINT_WARNING_COUNT = "print_warning_count";
 
+	Counter& file_print_count = GetMetrics().AddCounter(FILE_PRINT_COUNT);
+	Counter& byte_receive_count = GetMetrics().AddCounter(BYTE_RECEIVE_COUNT);
+	Counter& print_error_count = GetMetrics().AddCounter(PRINT_ERROR_COUNT, PbStatisticsCategory::CATEGORY_ERROR);
+	Counter& print_warning_count = GetMetrics().AddCounter(PRINT_WARNING_COUNT, PbStatisticsCategory::CATEGORY_WARNING);
+
 public:
 
 	explicit SCSIPrinter(int);
@@ -49,7 +49,6 @@ public:
 
 	bool WriteByteSequence(span<const uint8_t>) override;
 
-	vector<PbStatistics> GetStatistics() const override;
 
 private:
 
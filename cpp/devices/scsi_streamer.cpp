@@ -452,11 +452,13 @@ Table 178 - READ command
 	auto len = file.read(GetController()->GetBuffer().data(), GetSectorSizeInBytes());
 	GetController()->SetLength(GetSectorSizeInBytes());
 
-	LogTrace("Length is " + to_string(len));
+	LogTrace("Length is {}", len);
 
 	// Set next block
 	GetController()->SetNext(file.tell() / GetSectorSizeInBytes());
 
+	SetReadHandler();
+
 	EnterDataInPhase();
 }
 
@@ -631,6 +633,8 @@ Table 191 - WRITE command
 	// Set next block
 	GetController()->SetNext(file.tell() / GetSectorSizeInBytes() + 1);
 
+	SetWriteHandler();
+
 	EnterDataOutPhase();
 }
 
@@ -22,6 +22,7 @@ StorageDevice::StorageDevice(PbDeviceType type, int lun, const unordered_set<uin
 {
 	SupportsFile(true);
 	SetStoppable(true);
+	SetInquiryDataCacheable();
 }
 
 bool StorageDevice::Init(const param_map &pm)
@@ -70,6 +71,9 @@ void StorageDevice::ValidateFile()
 		SetProtected(false);
 	}
 
+	// The product data may depend on the medium
+	InvalidateInquiryData();
+
 	SetStopped(false);
 	SetRemoved(false);
 	SetLocked(false);
@@ -187,3 +191,22 @@ uint32_t StorageDevice::GetConfiguredSectorSize() const
 }
 
 
+
+void StorageDevice::SetReadHandler()
+{
+	GetController()->SetTransferHandler([this] (uint64_t block) { return Read(GetController()->GetBuffer(), block); });
+}
+
+void StorageDevice::SetWriteHandler()
+{
+	GetController()->SetTransferHandler([this] (uint64_t block) {
+		Write(GetController()->GetBuffer(), block);
+		return static_cast<int>(GetSectorSizeInBytes());
+	});
+}
+
+void StorageDevice::SetVerifyHandler()
+{
+	// Verification is limited to the checks already done for the command
+	GetController()->SetTransferHandler([this] (uint64_t) { return static_cast<int>(GetSectorSizeInBytes()); });
+}
@@ -74,6 +74,11 @@ protected:
 
 	off_t GetFileSize() const;
 
+	// Transfer handlers for the blocks of block-oriented READ, WRITE and VERIFY data phases
+	void SetReadHandler();
+	void SetWriteHandler();
+	void SetVerifyHandler();
+
 protected:
 	// Sector size shift count (9=512, 10=1024, 11=2048, 12=4096)
 	uint32_t size_shift_count = 0;
@@ -21,9 +21,7 @@ using namespace scsi_defs;
 //---------------------------------------------------------------------------
 int BUS::GetCommandByteCount(uint8_t opcode)
 {
-	const auto& mapping = command_mapping.find(static_cast<scsi_command>(opcode));
-
-	return mapping != command_mapping.end() ? mapping->second.first : 0;
+	return command_table[opcode].cdb_length;
 }
 
 //---------------------------------------------------------------------------
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "hal/data_sample.h"
+#include "hal/handshake_timing.h"
 #include "hal/pin_control.h"
 #include "shared/config.h"
 #include "shared/scsi.h"
@@ -94,6 +95,8 @@ class BUS : public PinControl
 
     // SEL signal event polling
     virtual bool PollSelectEvent() = 0;
+    // Kernel timestamp of the SEL event returned by the last poll in ns, 0 if not available
+    virtual uint64_t GetSelectEventTimestamp() const = 0;
 
     virtual bool GetSignal(int pin) const = 0;
     // Get SCSI input signal value
@@ -101,6 +104,42 @@ class BUS : public PinControl
     // Set SCSI output signal value
     static const int SEND_NO_DELAY = -1;
     // Passed into SendHandShake when we don't want to delay
+
+    // The totals of the most recent target mode handshake, if enabled
+    HandshakeTiming &GetHandshakeTiming()
+    {
+        return handshake_timing;
+    }
+    const HandshakeTiming &GetHandshakeTiming() const
+    {
+        return handshake_timing;
+    }
+
+    // Traces the signals during the handshakes into BASE_NAME.vcd and BASE_NAME.json, returns an error message
+    virtual string StartTrace(const string &)
+    {
+        return "This bus does not support tracing";
+    }
+    virtual void StopTrace()
+    {
+        // Nothing to stop
+    }
+
+    // Whether the target can arbitrate for the bus and reselect an initiator, which is required for disconnecting
+    virtual bool CanReselect() const
+    {
+        return false;
+    }
+    // Target mode: Arbitrates for the bus and reselects the initiator. On success BSY is asserted by the target
+    // and the bus is in a MESSAGE IN phase-compatible state.
+    virtual bool Reselect(int, int)
+    {
+        return false;
+    }
+
+  protected:
+    HandshakeTiming handshake_timing;
+
   private:
     static const array<phase_t, 8> phase_table;
 
@@ -0,0 +1,121 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/bus_tracer.h"
+#include <spdlog/spdlog.h>
+#include <bit>
+#include <cassert>
+
+using namespace std;
+
+BusTracer::~BusTracer()
+{
+    Stop();
+}
+
+string BusTracer::Start(const string &base_name, const decoder &d)
+{
+    assert(has_single_bit(capacity));
+
+    if (IsActive()) {
+        return "Bus trace is already active";
+    }
+
+    if (base_name.empty()) {
+        return "Missing bus trace file name";
+    }
+
+    vcd_file.open(base_name + ".vcd");
+    json_file.open(base_name + ".json");
+    if (vcd_file.fail() || json_file.fail()) {
+        vcd_file.close();
+        json_file.close();
+        return "Can't create bus trace files '" + base_name + ".vcd' and '" + base_name + ".json'";
+    }
+
+    // The memory is only required while tracing
+    samples.resize(capacity);
+    head = 0;
+    tail = 0;
+    dropped = 0;
+    last_signals = UINT64_MAX;
+    written = 0;
+    create_sample = d;
+
+    vcd_writer = make_unique<VcdWriter>(vcd_file);
+    json_writer = make_unique<JsonWriter>(json_file);
+    vcd_writer->WriteHeader();
+    json_writer->WriteHeader();
+
+    start_ticks = TickCounter::Now();
+
+    drain_thread = jthread([this](stop_token token) { Drain(token); });
+
+    active.store(true, memory_order_release);
+
+    spdlog::info("Started bus trace to '" + base_name + ".vcd' and '" + base_name + ".json'");
+
+    return "";
+}
+
+void BusTracer::Stop()
+{
+    if (!IsActive()) {
+        return;
+    }
+
+    active.store(false, memory_order_release);
+
+    drain_thread.request_stop();
+    drain_thread.join();
+
+    // What was added after the last iteration of the drain thread
+    WriteSamples();
+
+    json_writer->WriteFooter();
+    vcd_writer.reset();
+    json_writer.reset();
+    vcd_file.close();
+    json_file.close();
+
+    samples.clear();
+    samples.shrink_to_fit();
+
+    spdlog::info("Stopped bus trace, recorded " + to_string(written) + " sample(s), dropped " +
+                 to_string(GetDroppedCount()) + " sample(s)");
+}
+
+void BusTracer::Drain(const stop_token &token)
+{
+    while (!token.stop_requested()) {
+        WriteSamples();
+
+        // Formatting is much slower than recording, i.e. the writes are batched
+        this_thread::sleep_for(5ms);
+    }
+}
+
+void BusTracer::WriteSamples()
+{
+    const uint64_t h = head.load(memory_order_acquire);
+
+    uint64_t t;
+    for (t = tail.load(memory_order_relaxed); t != h; t++) {
+        const auto &[ticks, signals] = samples[t & (capacity - 1)];
+        const auto timestamp = static_cast<uint64_t>(TickCounter::ToDuration(ticks - start_ticks).count());
+
+        const auto sample = create_sample(signals, timestamp);
+        vcd_writer->WriteSample(*sample, timestamp);
+        json_writer->WriteSample(*sample);
+    }
+
+    written += h - tail.load(memory_order_relaxed);
+
+    tail.store(t, memory_order_release);
+}
@@ -0,0 +1,117 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Records the bus signals during the handshakes, so that traces can be captured without a second board
+// running scsimon. The bus thread adds the raw signals to a single-producer/single-consumer ring buffer,
+// a background thread writes them to a VCD and a JSON file in the formats of scsimon.
+// Each change costs a signal read, a counter read and a store. When the ring buffer is full, i.e. when
+// the files cannot be written fast enough, the samples are dropped and counted.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/data_sample.h"
+#include "hal/deadline.h"
+#include "hal/sample_writers.h"
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class BusTracer
+{
+  public:
+    // Creates a sample from the raw signals and a timestamp in ns
+    using decoder = function<unique_ptr<DataSample>(uint32_t, uint64_t)>;
+
+    static const size_t DEFAULT_CAPACITY = 1 << 18;
+
+    explicit BusTracer(size_t capacity = DEFAULT_CAPACITY) : capacity(capacity) {}
+    ~BusTracer();
+
+    // Creates BASE_NAME.vcd and BASE_NAME.json, returns an error message if not possible.
+    // Start() and Stop() must not be called while a handshake is in progress.
+    string Start(const string &, const decoder &);
+    void Stop();
+
+    bool IsActive() const
+    {
+        return active.load(memory_order_relaxed);
+    }
+
+    // Only called by the bus thread while active. Unchanged signals are not recorded.
+    void Add(uint32_t signals)
+    {
+        if (signals == last_signals) {
+            return;
+        }
+        last_signals = signals;
+
+        const uint64_t h = head.load(memory_order_relaxed);
+        if (h - tail.load(memory_order_acquire) == capacity) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        samples[h & (capacity - 1)] = {TickCounter::Now(), signals};
+        head.store(h + 1, memory_order_release);
+    }
+
+    uint64_t GetSampleCount() const
+    {
+        return written;
+    }
+    uint64_t GetDroppedCount() const
+    {
+        return dropped.load(memory_order_relaxed);
+    }
+
+  private:
+    struct sample_t {
+        uint64_t ticks;
+        uint32_t signals;
+    };
+
+    void Drain(const stop_token &);
+    void WriteSamples();
+
+    // A power of 2
+    size_t capacity;
+
+    vector<sample_t> samples;
+
+    // Incremented by the bus thread
+    atomic<uint64_t> head = 0;
+    // Incremented by the drain thread
+    atomic<uint64_t> tail = 0;
+
+    atomic<uint64_t> dropped = 0;
+
+    atomic<bool> active = false;
+
+    // Wider than the signals, i.e. the first sample is always recorded
+    uint64_t last_signals = UINT64_MAX;
+
+    uint64_t start_ticks = 0;
+
+    uint64_t written = 0;
+
+    decoder create_sample;
+
+    ofstream vcd_file;
+    ofstream json_file;
+    unique_ptr<VcdWriter> vcd_writer;
+    unique_ptr<JsonWriter> json_writer;
+
+    jthread drain_thread;
+};
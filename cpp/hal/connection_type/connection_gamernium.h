@@ -10,47 +10,48 @@
 
 #pragma once
 
-#include <string>
-
 //
 // RaSCSI Adapter GAMERnium.com version
 //
-
-const std::string CONNECT_DESC = "GAMERnium.com version"; // Startup message
-
-// Select signal control mode
-const static int SIGNAL_CONTROL_MODE = 0; // SCSI logical specification
-
-// Control signal output logic
-#define ACT_ON ON  // ACTIVE SIGNAL ON
-#define ENB_ON ON  // ENABLE SIGNAL ON
-#define IND_IN OFF // INITIATOR SIGNAL INPUT
-#define TAD_IN OFF // TARGET SIGNAL INPUT
-#define DTD_IN ON  // DATA SIGNAL INPUT
-
-// Control signal pin assignment (-1 means no control)
-const static int PIN_ACT = 14; // ACTIVE
-const static int PIN_ENB = 6;  // ENABLE
-const static int PIN_IND = 7;  // INITIATOR CTRL DIRECTION
-const static int PIN_TAD = 8;  // TARGET CTRL DIRECTION
-const static int PIN_DTD = 5;  // DATA DIRECTION
-
-// SCSI signal pin assignment
-const static int PIN_DT0 = 21; // Data 0
-const static int PIN_DT1 = 26; // Data 1
-const static int PIN_DT2 = 20; // Data 2
-const static int PIN_DT3 = 19; // Data 3
-const static int PIN_DT4 = 16; // Data 4
-const static int PIN_DT5 = 13; // Data 5
-const static int PIN_DT6 = 12; // Data 6
-const static int PIN_DT7 = 11; // Data 7
-const static int PIN_DP  = 25; // Data parity
-const static int PIN_ATN = 10; // ATN
-const static int PIN_RST = 22; // RST
-const static int PIN_ACK = 24; // ACK
-const static int PIN_REQ = 15; // REQ
-const static int PIN_MSG = 17; // MSG
-const static int PIN_CD  = 18; // CD
-const static int PIN_IO  = 4;  // IO
-const static int PIN_BSY = 27; // BSY
-const static int PIN_SEL = 23; // SEL
+struct ConnectionGamernium
+{
+    static constexpr const char *NAME = "gamernium";
+    static constexpr const char *DESC = "GAMERnium.com version"; // Startup message
+
+    // Select signal control mode
+    static constexpr int SIGNAL_CONTROL_MODE = 0; // SCSI logical specification
+
+    // Control signal output logic
+    static constexpr bool ACT_ON = true;  // ACTIVE SIGNAL ON
+    static constexpr bool ENB_ON = true;  // ENABLE SIGNAL ON
+    static constexpr bool IND_IN = false; // INITIATOR SIGNAL INPUT
+    static constexpr bool TAD_IN = false; // TARGET SIGNAL INPUT
+    static constexpr bool DTD_IN = true;  // DATA SIGNAL INPUT
+
+    // Control signal pin assignment (-1 means no control)
+    static constexpr int PIN_ACT = 14; // ACTIVE
+    static constexpr int PIN_ENB = 6;  // ENABLE
+    static constexpr int PIN_IND = 7;  // INITIATOR CTRL DIRECTION
+    static constexpr int PIN_TAD = 8;  // TARGET CTRL DIRECTION
+    static constexpr int PIN_DTD = 5;  // DATA DIRECTION
+
+    // SCSI signal pin assignment
+    static constexpr int PIN_DT0 = 21; // Data 0
+    static constexpr int PIN_DT1 = 26; // Data 1
+    static constexpr int PIN_DT2 = 20; // Data 2
+    static constexpr int PIN_DT3 = 19; // Data 3
+    static constexpr int PIN_DT4 = 16; // Data 4
+    static constexpr int PIN_DT5 = 13; // Data 5
+    static constexpr int PIN_DT6 = 12; // Data 6
+    static constexpr int PIN_DT7 = 11; // Data 7
+    static constexpr int PIN_DP  = 25; // Data parity
+    static constexpr int PIN_ATN = 10; // ATN
+    static constexpr int PIN_RST = 22; // RST
+    static constexpr int PIN_ACK = 24; // ACK
+    static constexpr int PIN_REQ = 15; // REQ
+    static constexpr int PIN_MSG = 17; // MSG
+    static constexpr int PIN_CD  = 18; // CD
+    static constexpr int PIN_IO  = 4;  // IO
+    static constexpr int PIN_BSY = 27; // BSY
+    static constexpr int PIN_SEL = 23; // SEL
+};
@@ -0,0 +1,67 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// All connection types are available at runtime. The one selected with CONNECT_TYPE_* at build time is the
+// default, and its pin assignment is also available as global constants for the tools that only support the
+// default connection type (scsimon, scsiloop, the virtual bus).
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/connection_type/connection_standard.h"
+#include "hal/connection_type/connection_fullspec.h"
+#include "hal/connection_type/connection_aibom.h"
+#include "hal/connection_type/connection_gamernium.h"
+#include <string>
+
+#if defined CONNECT_TYPE_STANDARD
+using DefaultConnection = ConnectionStandard;
+#elif defined CONNECT_TYPE_FULLSPEC
+using DefaultConnection = ConnectionFullspec;
+#elif defined CONNECT_TYPE_AIBOM
+using DefaultConnection = ConnectionAibom;
+#elif defined CONNECT_TYPE_GAMERNIUM
+using DefaultConnection = ConnectionGamernium;
+#else
+#error Invalid connection type or none specified
+#endif
+
+const std::string CONNECT_DESC = DefaultConnection::DESC; // Startup message
+
+const static int SIGNAL_CONTROL_MODE = DefaultConnection::SIGNAL_CONTROL_MODE;
+
+const static bool ACT_ON = DefaultConnection::ACT_ON;
+const static bool ENB_ON = DefaultConnection::ENB_ON;
+const static bool IND_IN = DefaultConnection::IND_IN;
+const static bool TAD_IN = DefaultConnection::TAD_IN;
+const static bool DTD_IN = DefaultConnection::DTD_IN;
+
+const static int PIN_ACT = DefaultConnection::PIN_ACT;
+const static int PIN_ENB = DefaultConnection::PIN_ENB;
+const static int PIN_IND = DefaultConnection::PIN_IND;
+const static int PIN_TAD = DefaultConnection::PIN_TAD;
+const static int PIN_DTD = DefaultConnection::PIN_DTD;
+
+const static int PIN_DT0 = DefaultConnection::PIN_DT0;
+const static int PIN_DT1 = DefaultConnection::PIN_DT1;
+const static int PIN_DT2 = DefaultConnection::PIN_DT2;
+const static int PIN_DT3 = DefaultConnection::PIN_DT3;
+const static int PIN_DT4 = DefaultConnection::PIN_DT4;
+const static int PIN_DT5 = DefaultConnection::PIN_DT5;
+const static int PIN_DT6 = DefaultConnection::PIN_DT6;
+const static int PIN_DT7 = DefaultConnection::PIN_DT7;
+const static int PIN_DP  = DefaultConnection::PIN_DP;
+const static int PIN_ATN = DefaultConnection::PIN_ATN;
+const static int PIN_RST = DefaultConnection::PIN_RST;
+const static int PIN_ACK = DefaultConnection::PIN_ACK;
+const static int PIN_REQ = DefaultConnection::PIN_REQ;
+const static int PIN_MSG = DefaultConnection::PIN_MSG;
+const static int PIN_CD  = DefaultConnection::PIN_CD;
+const static int PIN_IO  = DefaultConnection::PIN_IO;
+const static int PIN_BSY = DefaultConnection::PIN_BSY;
+const static int PIN_SEL = DefaultConnection::PIN_SEL;
@@ -11,21 +11,12 @@
 
 #pragma once
 
+#include "hal/connection_type/connection_types.h"
 #include "hal/data_sample.h"
 #include "shared/scsi.h"
 
-#if defined CONNECT_TYPE_STANDARD
-#include "hal/connection_type/connection_standard.h"
-#elif defined CONNECT_TYPE_FULLSPEC
-#include "hal/connection_type/connection_fullspec.h"
-#elif defined CONNECT_TYPE_AIBOM
-#include "hal/connection_type/connection_aibom.h"
-#elif defined CONNECT_TYPE_GAMERNIUM
-#include "hal/connection_type/connection_gamernium.h"
-#else
-#error Invalid connection type or none specified
-#endif
-
+// The connection type is a template parameter because the pin assignment is required for decoding a sample
+template <typename C = DefaultConnection>
 class DataSample_Raspberry final : public DataSample
 {
   public:
@@ -36,55 +27,55 @@ class DataSample_Raspberry final : public DataSample
 
     bool GetBSY() const override
     {
-        return GetSignal(PIN_BSY);
+        return GetSignal(C::PIN_BSY);
     }
     bool GetSEL() const override
     {
-        return GetSignal(PIN_SEL);
+        return GetSignal(C::PIN_SEL);
     }
     bool GetATN() const override
     {
-        return GetSignal(PIN_ATN);
+        return GetSignal(C::PIN_ATN);
     }
     bool GetACK() const override
     {
-        return GetSignal(PIN_ACK);
+        return GetSignal(C::PIN_ACK);
     }
     bool GetRST() const override
     {
-        return GetSignal(PIN_RST);
+        return GetSignal(C::PIN_RST);
     }
     bool GetMSG() const override
     {
-        return GetSignal(PIN_MSG);
+        return GetSignal(C::PIN_MSG);
     }
     bool GetCD() const override
     {
-        return GetSignal(PIN_CD);
+        return GetSignal(C::PIN_CD);
     }
     bool GetIO() const override
     {
-        return GetSignal(PIN_IO);
+        return GetSignal(C::PIN_IO);
     }
     bool GetREQ() const override
     {
-        return GetSignal(PIN_REQ);
+        return GetSignal(C::PIN_REQ);
     }
     bool GetACT() const override
     {
-        return GetSignal(PIN_ACT);
+        return GetSignal(C::PIN_ACT);
     }
     uint8_t GetDAT() const override
     {
         uint8_t ret_val = 0;
-        ret_val |= (data >> (PIN_DT0 - 0)) & 0x01; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT1 - 1)) & 0x02; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT2 - 2)) & 0x04; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT3 - 3)) & 0x08; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT4 - 4)) & 0x10; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT5 - 5)) & 0x20; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT6 - 6)) & 0x40; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
-        ret_val |= (data >> (PIN_DT7 - 7)) & 0x80; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT0 - 0)) & 0x01; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT1 - 1)) & 0x02; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT2 - 2)) & 0x04; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT3 - 3)) & 0x08; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT4 - 4)) & 0x10; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT5 - 5)) & 0x20; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT6 - 6)) & 0x40; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
+        ret_val |= (data >> (C::PIN_DT7 - 7)) & 0x80; // NOSONAR: GCC 10 doesn't support shift operations on std::byte
         return ret_val;
     }
 
@@ -0,0 +1,36 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/deadline.h"
+
+using namespace std;
+
+uint64_t TickCounter::Calibrate()
+{
+#if defined(__aarch64__)
+    uint64_t frequency;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    return frequency;
+#elif defined(__x86_64__)
+    // The TSC frequency is not exposed, i.e. it has to be measured. 10 ms result in an error of well below 0.1%.
+    const auto start = chrono::steady_clock::now();
+    const uint64_t start_ticks = Now();
+    auto now = start;
+    while (now - start < 10ms) {
+        now = chrono::steady_clock::now();
+    }
+    const uint64_t ticks = Now() - start_ticks;
+
+    return static_cast<uint64_t>(static_cast<double>(ticks) * 1'000'000'000 /
+            chrono::duration_cast<chrono::nanoseconds>(now - start).count());
+#else
+    // The monotonic clock counts ns
+    return 1'000'000'000;
+#endif
+}
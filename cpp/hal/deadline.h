@@ -0,0 +1,82 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Low-overhead timing for poll loops. TickCounter reads the cheapest monotonic counter of the platform:
+//   ARM64:  The generic timer (CNTVCT_EL0), which is readable from user space, with its frequency from CNTFRQ_EL0
+//   x86-64: The time stamp counter, calibrated once against the monotonic clock
+//   Others: The monotonic clock, which is implemented in the vDSO and does not require a system call
+//
+// A Deadline converts its timeout into counter ticks once, i.e. each check is a counter read and a compare.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+class TickCounter
+{
+  public:
+    static uint64_t Now()
+    {
+#if defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#elif defined(__x86_64__)
+        return __rdtsc();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+#endif
+    }
+
+    // Ticks per second
+    static uint64_t GetFrequency()
+    {
+        static const uint64_t frequency = Calibrate();
+        return frequency;
+    }
+
+    static uint64_t ToTicks(chrono::nanoseconds duration)
+    {
+        return static_cast<uint64_t>(static_cast<double>(duration.count()) * GetFrequency() / 1'000'000'000);
+    }
+
+    static chrono::nanoseconds ToDuration(uint64_t ticks)
+    {
+        return chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(ticks) * 1'000'000'000 / GetFrequency()));
+    }
+
+  private:
+    static uint64_t Calibrate();
+};
+
+class Deadline
+{
+  public:
+    explicit Deadline(chrono::nanoseconds timeout) : end(TickCounter::Now() + TickCounter::ToTicks(timeout))
+    {
+    }
+    ~Deadline() = default;
+
+    bool IsExpired() const
+    {
+        return TickCounter::Now() >= end;
+    }
+
+  private:
+    uint64_t end;
+};
@@ -9,6 +9,7 @@
 //
 //---------------------------------------------------------------------------
 
+#include "hal/deadline.h"
 #include "hal/gpiobus.h"
 #include "hal/sbc_version.h"
 #include "hal/systimer.h"
@@ -19,7 +20,6 @@
 #ifdef __linux__
 #include <sys/epoll.h>
 #endif
-#include <chrono>
 
 using namespace std;
 
@@ -33,6 +33,16 @@ bool GPIOBUS::Init(mode_e mode)
     return true;
 }
 
+string GPIOBUS::StartTrace(const string &base_name)
+{
+    return bus_tracer.Start(base_name, GetSampleDecoder());
+}
+
+void GPIOBUS::StopTrace()
+{
+    bus_tracer.Stop();
+}
+
 //---------------------------------------------------------------------------
 //
 //	Receive command handshake
@@ -46,21 +56,30 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
 	GPIO_FUNCTION_TRACE
 
     DisableIRQ();
+    TraceSignals();
+
+    handshake_timing.StartTransfer();
+    handshake_timing.StartByte();
 
     // Assert REQ signal
     SetREQ(ON);
+    TraceSignals();
 
     // Wait for ACK signal
     bool ret = WaitACK(ON);
+    TraceSignals();
+    handshake_timing.AckAsserted();
 
     // Wait until the signal line stabilizes
     SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+    handshake_timing.Delayed();
 
     // Get data
     buf[0] = GetDAT();
 
     // Disable REQ signal
     SetREQ(OFF);
+    TraceSignals();
 
     // Timeout waiting for ACK assertion
     if (!ret) {
@@ -70,6 +89,8 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
 
     // Wait for ACK to clear
     ret = WaitACK(OFF);
+    TraceSignals();
+    handshake_timing.AckDeasserted();
 
     // Timeout waiting for ACK to clear
     if (!ret) {
@@ -77,6 +98,8 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
         return 0;
     }
 
+    handshake_timing.EndByte();
+
     // The ICD AdSCSI ST, AdSCSI Plus ST and AdSCSI Micro ST host adapters allow SCSI devices to be connected
     // to the ACSI bus of Atari ST/TT computers and some clones. ICD-aware drivers prepend a $1F byte in front
     // of the CDB (effectively resulting in a custom SCSI command) in order to get access to the full SCSI
@@ -87,16 +110,23 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
 
     // PiSCSI becomes ICD compatible by ignoring the prepended $1F byte before processing the CDB.
     if (buf[0] == 0x1F) {
+        handshake_timing.StartByte();
+
         SetREQ(ON);
+        TraceSignals();
 
         ret = WaitACK(ON);
+        TraceSignals();
+        handshake_timing.AckAsserted();
 
         SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+        handshake_timing.Delayed();
 
         // Get the actual SCSI command
         buf[0] = GetDAT();
 
         SetREQ(OFF);
+        TraceSignals();
 
         if (!ret) {
             EnableIRQ();
@@ -104,11 +134,15 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
         }
 
         WaitACK(OFF);
+        TraceSignals();
+        handshake_timing.AckDeasserted();
 
         if (!ret) {
             EnableIRQ();
             return 0;
         }
+
+        handshake_timing.EndByte();
     }
 
     const int command_byte_count = GetCommandByteCount(buf[0]);
@@ -124,20 +158,27 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
     for (bytes_received = 1; bytes_received < command_byte_count; bytes_received++) {
         ++offset;
 
+        handshake_timing.StartByte();
+
         // Assert REQ signal
         SetREQ(ON);
+        TraceSignals();
 
         // Wait for ACK signal
         ret = WaitACK(ON);
+        TraceSignals();
+        handshake_timing.AckAsserted();
 
         // Wait until the signal line stabilizes
         SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+        handshake_timing.Delayed();
 
         // Get data
         buf[offset] = GetDAT();
 
         // Clear the REQ signal
         SetREQ(OFF);
+        TraceSignals();
 
         // Check for timeout waiting for ACK assertion
         if (!ret) {
@@ -146,13 +187,19 @@ int GPIOBUS::CommandHandShake(vector<uint8_t> &buf)
 
         // Wait for ACK to clear
         ret = WaitACK(OFF);
+        TraceSignals();
+        handshake_timing.AckDeasserted();
 
         // Check for timeout waiting for ACK to clear
         if (!ret) {
             break;
         }
+
+        handshake_timing.EndByte();
     }
 
+    handshake_timing.EndTransfer();
+
     EnableIRQ();
 
     return bytes_received;
@@ -170,23 +217,33 @@ int GPIOBUS::ReceiveHandShake(uint8_t *buf, int count)
 
     // Disable IRQs
     DisableIRQ();
+    TraceSignals();
 
     if (actmode == mode_e::TARGET) {
+        handshake_timing.StartTransfer();
+
         for (i = 0; i < count; i++) {
+            handshake_timing.StartByte();
+
             // Assert the REQ signal
             SetREQ(ON);
+            TraceSignals();
 
             // Wait for ACK
             bool ret = WaitACK(ON);
+            TraceSignals();
+            handshake_timing.AckAsserted();
 
             // Wait until the signal line stabilizes
             SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+            handshake_timing.Delayed();
 
             // Get data
             *buf = GetDAT();
 
             // Clear the REQ signal
             SetREQ(OFF);
+            TraceSignals();
 
             // Check for timeout waiting for ACK signal
             if (!ret) {
@@ -195,15 +252,21 @@ int GPIOBUS::ReceiveHandShake(uint8_t *buf, int count)
 
             // Wait for ACK to clear
             ret = WaitACK(OFF);
+            TraceSignals();
+            handshake_timing.AckDeasserted();
 
             // Check for timeout waiting for ACK to clear
             if (!ret) {
                 break;
             }
 
+            handshake_timing.EndByte();
+
             // Advance the buffer pointer to receive the next byte
             buf++;
         }
+
+        handshake_timing.EndTransfer();
     } else {
         // Get phase
         Acquire();
@@ -212,6 +275,7 @@ int GPIOBUS::ReceiveHandShake(uint8_t *buf, int count)
         for (i = 0; i < count; i++) {
             // Wait for the REQ signal to be asserted
             bool ret = WaitREQ(ON);
+            TraceSignals();
 
             // Check for timeout waiting for REQ signal
             if (!ret) {
@@ -232,21 +296,25 @@ int GPIOBUS::ReceiveHandShake(uint8_t *buf, int count)
 
             // Assert the ACK signal
             SetACK(ON);
+            TraceSignals();
 
             // Wait for REQ to clear
             ret = WaitREQ(OFF);
+            TraceSignals();
 
             // Clear the ACK signal
             SetACK(OFF);
+            TraceSignals();
 
             // Check for timeout waiting for REQ to clear
             if (!ret) {
                 break;
             }
 
-            // Phase error
+            // The byte has been transferred, a phase change means that the target does not expect any more bytes
             Acquire();
             if (GetPhase() != phase) {
+                i++;
                 break;
             }
 
@@ -274,9 +342,14 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
 
     // Disable IRQs
     DisableIRQ();
+    TraceSignals();
 
     if (actmode == mode_e::TARGET) {
+        handshake_timing.StartTransfer();
+
         for (i = 0; i < count; i++) {
+            handshake_timing.StartByte();
+
             if (i == delay_after_bytes) {
                 spdlog::trace("DELAYING for " + to_string(SCSI_DELAY_SEND_DATA_DAYNAPORT_NS) + " ns after " +
                 		to_string(delay_after_bytes) + " bytes");
@@ -284,13 +357,17 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
                 const timespec ts = { .tv_sec = 0, .tv_nsec = SCSI_DELAY_SEND_DATA_DAYNAPORT_NS};
                 nanosleep(&ts, nullptr);
                 DisableIRQ();
+                handshake_timing.Delayed();
             }
 
             // Set the DATA signals
             SetDAT(*buf);
+            TraceSignals();
 
             // Wait for ACK to clear
             bool ret = WaitACK(OFF);
+            TraceSignals();
+            handshake_timing.AckDeasserted();
 
             // Check for timeout waiting for ACK to clear
             if (!ret) {
@@ -301,24 +378,34 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
 
             // Assert the REQ signal
             SetREQ(ON);
+            TraceSignals();
 
             // Wait for ACK
             ret = WaitACK(ON);
+            TraceSignals();
+            handshake_timing.AckAsserted();
 
             // Clear REQ signal
             SetREQ(OFF);
+            TraceSignals();
 
             // Check for timeout waiting for ACK to clear
             if (!ret) {
                 break;
             }
 
+            handshake_timing.EndByte();
+
             // Advance the data buffer pointer to receive the next byte
             buf++;
         }
 
         // Wait for ACK to clear
         WaitACK(OFF);
+        TraceSignals();
+        handshake_timing.AckDeasserted();
+
+        handshake_timing.EndTransfer();
     } else {
         // Get Phase
         Acquire();
@@ -327,9 +414,11 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
         for (i = 0; i < count; i++) {
             // Set the DATA signals
             SetDAT(*buf);
+            TraceSignals();
 
             // Wait for REQ to be asserted
             bool ret = WaitREQ(ON);
+            TraceSignals();
 
             // Check for timeout waiting for REQ to be asserted
             if (!ret) {
@@ -339,6 +428,7 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
            	// Signal the last MESSAGE OUT byte
             if (phase == phase_t::msgout && i == count - 1) {
             	SetATN(false);
+            	TraceSignals();
             }
 
             // Phase error
@@ -351,21 +441,25 @@ int GPIOBUS::SendHandShake(uint8_t *buf, int count, int delay_after_bytes)
 
             // Assert the ACK signal
             SetACK(ON);
+            TraceSignals();
 
             // Wait for REQ to clear
             ret = WaitREQ(OFF);
+            TraceSignals();
 
             // Clear the ACK signal
             SetACK(OFF);
+            TraceSignals();
 
             // Check for timeout waiting for REQ to clear
             if (!ret) {
                 break;
             }
 
-            // Phase error
+            // The byte has been transferred, a phase change means that the target does not expect any more bytes
             Acquire();
             if (GetPhase() != phase) {
+                i++;
                 break;
             }
 
@@ -399,20 +493,23 @@ bool GPIOBUS::PollSelectEvent()
         return false;
     }
 
-    if (gpioevent_data gpev; read(selevreq.fd, &gpev, sizeof(gpev)) < 0) {
+    gpioevent_data gpev;
+    if (read(selevreq.fd, &gpev, sizeof(gpev)) < 0) {
         spdlog::warn("read failed");
         return false;
     }
 
+    select_event_timestamp = gpev.timestamp;
+
     return true;
 #endif
 }
 
-bool GPIOBUS::WaitSignal(int pin, bool ast)
+bool GPIOBUS::WaitSignal(int pin, bool ast, chrono::nanoseconds timeout)
 {
-    const auto now = chrono::steady_clock::now();
+    // By default wait up to 3 s
+    const Deadline deadline(timeout);
 
-    // Wait up to 3 s
     do {
         Acquire();
 
@@ -424,7 +521,7 @@ bool GPIOBUS::WaitSignal(int pin, bool ast)
         if (GetRST()) {
             return false;
         }
-    } while ((chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - now).count()) < 3);
+    } while (!deadline.IsExpired());
 
     return false;
 }
@@ -11,7 +11,9 @@
 #pragma once
 
 #include "hal/bus.h"
+#include "hal/bus_tracer.h"
 #include "shared/scsi.h"
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -29,17 +31,7 @@
 //#define CONNECT_TYPE_AIBOM		// AIBOM version (positive logic, unique pin assignment)
 //#define CONNECT_TYPE_GAMERNIUM	// GAMERnium.com version (standard logic, unique pin assignment)
 
-#if defined CONNECT_TYPE_STANDARD
-#include "hal/connection_type/connection_standard.h"
-#elif defined CONNECT_TYPE_FULLSPEC
-#include "hal/connection_type/connection_fullspec.h"
-#elif defined CONNECT_TYPE_AIBOM
-#include "hal/connection_type/connection_aibom.h"
-#elif defined CONNECT_TYPE_GAMERNIUM
-#include "hal/connection_type/connection_gamernium.h"
-#else
-#error Invalid connection type or none specified
-#endif
+#include "hal/connection_type/connection_types.h"
 
 // #define ENABLE_GPIO_TRACE
 #ifdef ENABLE_GPIO_TRACE
@@ -182,13 +174,23 @@ class GPIOBUS : public BUS
 
     // SEL signal event polling
     bool PollSelectEvent() override;
+    uint64_t GetSelectEventTimestamp() const override
+    {
+        return select_event_timestamp;
+    }
+
+    string StartTrace(const string &) override;
+    void StopTrace() override;
 
   protected:
     virtual void MakeTable() = 0;
 
+    // Creates samples from the signals returned by Acquire(), independent of the lifetime of the bus
+    virtual BusTracer::decoder GetSampleDecoder() const = 0;
+
     bool GetSignal(int pin) const override     = 0;
     void SetSignal(int pin, bool ast) override = 0;
-    bool WaitSignal(int pin, bool ast);
+    bool WaitSignal(int pin, bool ast, chrono::nanoseconds = 3s);
 
     // Wait for a signal to change
     virtual bool WaitREQ(bool ast) = 0;
@@ -213,4 +215,18 @@ class GPIOBUS : public BUS
     int epfd = 0;
 
 #endif
+
+    // Timestamp of the last SEL event
+    uint64_t select_event_timestamp = 0;
+
+  private:
+    // Records the current signals if tracing is active
+    void TraceSignals()
+    {
+        if (bus_tracer.IsActive()) {
+            bus_tracer.Add(Acquire());
+        }
+    }
+
+    BusTracer bus_tracer;
 };
@@ -15,30 +15,39 @@
 #include "hal/gpiobus_virtual.h"
 #include "hal/sbc_version.h"
 #include <unistd.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 using namespace std;
 
-unique_ptr<BUS> GPIOBUS_Factory::Create(BUS::mode_e mode)
+unique_ptr<BUS> GPIOBUS_Factory::Create(BUS::mode_e mode, const string& connection_type)
 {
 	unique_ptr<BUS> bus;
 
     try {
         SBC_Version::Init();
-        if (SBC_Version::IsRaspberryPi()) {
+        // A shared virtual bus is also used on a Pi, e.g. for testing without any SCSI hardware
+        if (const string name = GPIOBUS_Virtual::GetSharedMemoryName(); !name.empty()) {
+            bus = make_unique<GPIOBUS_Virtual>(name);
+        } else if (SBC_Version::IsRaspberryPi()) {
         	if (getuid()) {
         		spdlog::error("GPIO bus access requires root permissions. Are you running as root?");
         		return nullptr;
         	}
 
-            bus = make_unique<GPIOBUS_Raspberry>();
+            bus = CreateRaspberry(connection_type.empty() ? DefaultConnection::NAME : connection_type);
+            if (bus == nullptr) {
+                spdlog::error("Invalid connection type '" + connection_type + "'");
+                return nullptr;
+            }
         } else {
             bus = make_unique<GPIOBUS_Virtual>();
         }
 
-        if (bus->Init(mode)) {
-        	bus->Reset();
+        if (!bus->Init(mode)) {
+            return nullptr;
         }
+        bus->Reset();
     } catch (const invalid_argument& e) {
         spdlog::error(string("Exception while trying to initialize GPIO bus: ") + e.what());
         return nullptr;
@@ -46,3 +55,58 @@ unique_ptr<BUS> GPIOBUS_Factory::Create(BUS::mode_e mode)
 
     return bus;
 }
+
+bool GPIOBUS_Factory::IsValidConnectionType(const string& connection_type)
+{
+	const auto& types = GetConnectionTypes();
+	return find(types.begin(), types.end(), connection_type) != types.end();
+}
+
+vector<string> GPIOBUS_Factory::GetConnectionTypes()
+{
+	return { ConnectionStandard::NAME, ConnectionFullspec::NAME, ConnectionAibom::NAME, ConnectionGamernium::NAME };
+}
+
+string GPIOBUS_Factory::GetConnectionDescription(const string& connection_type)
+{
+	const string& type = connection_type.empty() ? DefaultConnection::NAME : connection_type;
+	if (type == ConnectionStandard::NAME) {
+		return ConnectionStandard::DESC;
+	}
+	if (type == ConnectionFullspec::NAME) {
+		return ConnectionFullspec::DESC;
+	}
+	if (type == ConnectionAibom::NAME) {
+		return ConnectionAibom::DESC;
+	}
+	if (type == ConnectionGamernium::NAME) {
+		return ConnectionGamernium::DESC;
+	}
+
+	return "";
+}
+
+unique_ptr<BUS> GPIOBUS_Factory::CreateRaspberry(const string& connection_type)
+{
+	// The connection type is only evaluated once, the bus methods use the pin assignment of their template instance
+	if (connection_type == ConnectionStandard::NAME) {
+		return CreateRaspberry<ConnectionStandard>();
+	}
+	if (connection_type == ConnectionFullspec::NAME) {
+		return CreateRaspberry<ConnectionFullspec>();
+	}
+	if (connection_type == ConnectionAibom::NAME) {
+		return CreateRaspberry<ConnectionAibom>();
+	}
+	if (connection_type == ConnectionGamernium::NAME) {
+		return CreateRaspberry<ConnectionGamernium>();
+	}
+
+	return nullptr;
+}
+
+template <typename C>
+unique_ptr<BUS> GPIOBUS_Factory::CreateRaspberry()
+{
+	return make_unique<GPIOBUS_RaspberryConnection<C>>();
+}
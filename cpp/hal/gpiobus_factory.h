@@ -11,10 +11,24 @@
 
 #include "hal/bus.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 class GPIOBUS_Factory
 {
   public:
 
-  static unique_ptr<BUS> Create(BUS::mode_e mode);
+  // An empty connection type selects the connection type the binary was built for
+  static unique_ptr<BUS> Create(BUS::mode_e mode, const string& connection_type = "");
+
+  static bool IsValidConnectionType(const string&);
+  static vector<string> GetConnectionTypes();
+  // An empty connection type is the connection type the binary was built for
+  static string GetConnectionDescription(const string&);
+
+  private:
+
+  static unique_ptr<BUS> CreateRaspberry(const string&);
+  template <typename C>
+  static unique_ptr<BUS> CreateRaspberry();
 };
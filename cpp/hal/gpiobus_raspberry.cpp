@@ -71,11 +71,6 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
     level = new uint32_t();
     return true;
 #else
-    int i;
-#ifdef USE_SEL_EVENT_ENABLE
-    epoll_event ev = {};
-#endif
-
     // Get the base address
     baseaddr = (uint32_t)bcm_host_get_peripheral_address();
 
@@ -142,15 +137,29 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
     // Set Drive Strength to 16mA
     DrvConfig(7);
 
-    // Set pull up/pull down
-#if SIGNAL_CONTROL_MODE == 0
-    int pullmode = GPIO_PULLNONE;
-#elif SIGNAL_CONTROL_MODE == 1
-    int pullmode = GPIO_PULLUP;
+    return true;
+#endif // ifdef __x86_64__ || __X86__
+}
+
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::Init(mode_e mode)
+{
+    if (!GPIOBUS_Raspberry::Init(mode)) {
+        return false;
+    }
+
+#if defined(__x86_64__) || defined(__X86__)
+    return true;
 #else
-    int pullmode = GPIO_PULLDOWN;
+    int i;
+#ifdef USE_SEL_EVENT_ENABLE
+    epoll_event ev = {};
 #endif
 
+    // Set pull up/pull down
+    constexpr int pullmode = C::SIGNAL_CONTROL_MODE == 0 ? GPIO_PULLNONE :
+            (C::SIGNAL_CONTROL_MODE == 1 ? GPIO_PULLUP : GPIO_PULLDOWN);
+
     // Initialize all signals
     for (i = 0; SignalTable[i] >= 0; i++) {
         int j = SignalTable[i];
@@ -160,19 +169,19 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
     }
 
     // Set control signals
-    PinSetSignal(PIN_ACT, OFF);
-    PinSetSignal(PIN_TAD, OFF);
-    PinSetSignal(PIN_IND, OFF);
-    PinSetSignal(PIN_DTD, OFF);
-    PinConfig(PIN_ACT, GPIO_OUTPUT);
-    PinConfig(PIN_TAD, GPIO_OUTPUT);
-    PinConfig(PIN_IND, GPIO_OUTPUT);
-    PinConfig(PIN_DTD, GPIO_OUTPUT);
+    PinSetSignal(C::PIN_ACT, OFF);
+    PinSetSignal(C::PIN_TAD, OFF);
+    PinSetSignal(C::PIN_IND, OFF);
+    PinSetSignal(C::PIN_DTD, OFF);
+    PinConfig(C::PIN_ACT, GPIO_OUTPUT);
+    PinConfig(C::PIN_TAD, GPIO_OUTPUT);
+    PinConfig(C::PIN_IND, GPIO_OUTPUT);
+    PinConfig(C::PIN_DTD, GPIO_OUTPUT);
 
     // Set the ENABLE signal
     // This is used to show that the application is running
-    PinSetSignal(PIN_ENB, ENB_OFF);
-    PinConfig(PIN_ENB, GPIO_OUTPUT);
+    PinSetSignal(C::PIN_ENB, !C::ENB_ON);
+    PinConfig(C::PIN_ENB, GPIO_OUTPUT);
 
     // GPIO Function Select (GPFSEL) registers backup
     gpfsel[0] = gpio[GPIO_FSEL_0];
@@ -183,7 +192,7 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
     // Initialize SEL signal interrupt
 #ifdef USE_SEL_EVENT_ENABLE
     // GPIO chip open
-    fd = open("/dev/gpiochip0", 0);
+    int fd = open("/dev/gpiochip0", 0);
     if (fd == -1) {
         spdlog::error("Unable to open /dev/gpiochip0. If PiSCSI is running, please shut it down first.");
         return false;
@@ -191,13 +200,9 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
 
     // Event request setting
     strcpy(selevreq.consumer_label, "PiSCSI");
-    selevreq.lineoffset  = PIN_SEL;
+    selevreq.lineoffset  = C::PIN_SEL;
     selevreq.handleflags = GPIOHANDLE_REQUEST_INPUT;
-#if SIGNAL_CONTROL_MODE < 2
-    selevreq.eventflags  = GPIOEVENT_REQUEST_FALLING_EDGE;
-#else
-    selevreq.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
-#endif // SIGNAL_CONTROL_MODE
+    selevreq.eventflags  = C::SIGNAL_CONTROL_MODE < 2 ? GPIOEVENT_REQUEST_FALLING_EDGE : GPIOEVENT_REQUEST_RISING_EDGE;
 
     // Get event request
     if (ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &selevreq) == -1) {
@@ -216,14 +221,14 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
     epoll_ctl(epfd, EPOLL_CTL_ADD, selevreq.fd, &ev);
 #else
     // Edge detection setting
-#if SIGNAL_CONTROL_MODE == 2
-    gpio[GPIO_AREN_0] = 1 << PIN_SEL;
-#else
-    gpio[GPIO_AFEN_0] = 1 << PIN_SEL;
-#endif // SIGNAL_CONTROL_MODE
+    if constexpr (C::SIGNAL_CONTROL_MODE == 2) {
+        gpio[GPIO_AREN_0] = 1 << C::PIN_SEL;
+    } else {
+        gpio[GPIO_AFEN_0] = 1 << C::PIN_SEL;
+    }
 
     // Clear event - GPIO Pin Event Detect Status
-    gpio[GPIO_EDS_0] = 1 << PIN_SEL;
+    gpio[GPIO_EDS_0] = 1 << C::PIN_SEL;
 
     // Register interrupt handler
     setIrqFuncAddress(IrqHandler);
@@ -269,13 +274,14 @@ bool GPIOBUS_Raspberry::Init(mode_e mode)
 
     // Finally, enable ENABLE
     // Show the user that this app is running
-    SetControl(PIN_ENB, ENB_ON);
+    SetControl(C::PIN_ENB, C::ENB_ON);
 
     return true;
 #endif // ifdef __x86_64__ || __X86__
 }
 
-void GPIOBUS_Raspberry::Cleanup()
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::Cleanup()
 {
 #if defined(__x86_64__) || defined(__X86__)
     return;
@@ -286,15 +292,15 @@ void GPIOBUS_Raspberry::Cleanup()
 #endif // USE_SEL_EVENT_ENABLE
 
     // Set control signals
-    PinSetSignal(PIN_ENB, OFF);
-    PinSetSignal(PIN_ACT, OFF);
-    PinSetSignal(PIN_TAD, OFF);
-    PinSetSignal(PIN_IND, OFF);
-    PinSetSignal(PIN_DTD, OFF);
-    PinConfig(PIN_ACT, GPIO_INPUT);
-    PinConfig(PIN_TAD, GPIO_INPUT);
-    PinConfig(PIN_IND, GPIO_INPUT);
-    PinConfig(PIN_DTD, GPIO_INPUT);
+    PinSetSignal(C::PIN_ENB, OFF);
+    PinSetSignal(C::PIN_ACT, OFF);
+    PinSetSignal(C::PIN_TAD, OFF);
+    PinSetSignal(C::PIN_IND, OFF);
+    PinSetSignal(C::PIN_DTD, OFF);
+    PinConfig(C::PIN_ACT, GPIO_INPUT);
+    PinConfig(C::PIN_TAD, GPIO_INPUT);
+    PinConfig(C::PIN_IND, GPIO_INPUT);
+    PinConfig(C::PIN_DTD, GPIO_INPUT);
 
     // Initialize all signals
     for (int i = 0; SignalTable[i] >= 0; i++) {
@@ -309,7 +315,8 @@ void GPIOBUS_Raspberry::Cleanup()
 #endif // ifdef __x86_64__ || __X86__
 }
 
-void GPIOBUS_Raspberry::Reset()
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::Reset()
 {
 #if defined(__x86_64__) || defined(__X86__)
     return;
@@ -318,7 +325,7 @@ void GPIOBUS_Raspberry::Reset()
     int j;
 
     // Turn off active signal
-    SetControl(PIN_ACT, ACT_OFF);
+    SetControl(C::PIN_ACT, !C::ACT_ON);
 
     // Set all signals to off
     for (i = 0;; i++) {
@@ -334,60 +341,60 @@ void GPIOBUS_Raspberry::Reset()
         // Target mode
 
         // Set target signal to input
-        SetControl(PIN_TAD, TAD_IN);
-        SetMode(PIN_BSY, IN);
-        SetMode(PIN_MSG, IN);
-        SetMode(PIN_CD, IN);
-        SetMode(PIN_REQ, IN);
-        SetMode(PIN_IO, IN);
+        SetControl(C::PIN_TAD, C::TAD_IN);
+        SetMode(C::PIN_BSY, IN);
+        SetMode(C::PIN_MSG, IN);
+        SetMode(C::PIN_CD, IN);
+        SetMode(C::PIN_REQ, IN);
+        SetMode(C::PIN_IO, IN);
 
         // Set the initiator signal to input
-        SetControl(PIN_IND, IND_IN);
-        SetMode(PIN_SEL, IN);
-        SetMode(PIN_ATN, IN);
-        SetMode(PIN_ACK, IN);
-        SetMode(PIN_RST, IN);
+        SetControl(C::PIN_IND, C::IND_IN);
+        SetMode(C::PIN_SEL, IN);
+        SetMode(C::PIN_ATN, IN);
+        SetMode(C::PIN_ACK, IN);
+        SetMode(C::PIN_RST, IN);
 
         // Set data bus signals to input
-        SetControl(PIN_DTD, DTD_IN);
-        SetMode(PIN_DT0, IN);
-        SetMode(PIN_DT1, IN);
-        SetMode(PIN_DT2, IN);
-        SetMode(PIN_DT3, IN);
-        SetMode(PIN_DT4, IN);
-        SetMode(PIN_DT5, IN);
-        SetMode(PIN_DT6, IN);
-        SetMode(PIN_DT7, IN);
-        SetMode(PIN_DP, IN);
+        SetControl(C::PIN_DTD, C::DTD_IN);
+        SetMode(C::PIN_DT0, IN);
+        SetMode(C::PIN_DT1, IN);
+        SetMode(C::PIN_DT2, IN);
+        SetMode(C::PIN_DT3, IN);
+        SetMode(C::PIN_DT4, IN);
+        SetMode(C::PIN_DT5, IN);
+        SetMode(C::PIN_DT6, IN);
+        SetMode(C::PIN_DT7, IN);
+        SetMode(C::PIN_DP, IN);
     } else {
         // Initiator mode
 
         // Set target signal to input
-        SetControl(PIN_TAD, TAD_IN);
-        SetMode(PIN_BSY, IN);
-        SetMode(PIN_MSG, IN);
-        SetMode(PIN_CD, IN);
-        SetMode(PIN_REQ, IN);
-        SetMode(PIN_IO, IN);
+        SetControl(C::PIN_TAD, C::TAD_IN);
+        SetMode(C::PIN_BSY, IN);
+        SetMode(C::PIN_MSG, IN);
+        SetMode(C::PIN_CD, IN);
+        SetMode(C::PIN_REQ, IN);
+        SetMode(C::PIN_IO, IN);
 
         // Set the initiator signal to output
-        SetControl(PIN_IND, IND_OUT);
-        SetMode(PIN_SEL, OUT);
-        SetMode(PIN_ATN, OUT);
-        SetMode(PIN_ACK, OUT);
-        SetMode(PIN_RST, OUT);
+        SetControl(C::PIN_IND, !C::IND_IN);
+        SetMode(C::PIN_SEL, OUT);
+        SetMode(C::PIN_ATN, OUT);
+        SetMode(C::PIN_ACK, OUT);
+        SetMode(C::PIN_RST, OUT);
 
         // Set the data bus signals to output
-        SetControl(PIN_DTD, DTD_OUT);
-        SetMode(PIN_DT0, OUT);
-        SetMode(PIN_DT1, OUT);
-        SetMode(PIN_DT2, OUT);
-        SetMode(PIN_DT3, OUT);
-        SetMode(PIN_DT4, OUT);
-        SetMode(PIN_DT5, OUT);
-        SetMode(PIN_DT6, OUT);
-        SetMode(PIN_DT7, OUT);
-        SetMode(PIN_DP, OUT);
+        SetControl(C::PIN_DTD, !C::DTD_IN);
+        SetMode(C::PIN_DT0, OUT);
+        SetMode(C::PIN_DT1, OUT);
+        SetMode(C::PIN_DT2, OUT);
+        SetMode(C::PIN_DT3, OUT);
+        SetMode(C::PIN_DT4, OUT);
+        SetMode(C::PIN_DT5, OUT);
+        SetMode(C::PIN_DT6, OUT);
+        SetMode(C::PIN_DT7, OUT);
+        SetMode(C::PIN_DP, OUT);
     }
 
     // Initialize all signals
@@ -395,199 +402,220 @@ void GPIOBUS_Raspberry::Reset()
 #endif // ifdef __x86_64__ || __X86__
 }
 
-void GPIOBUS_Raspberry::SetENB(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetENB(bool ast)
 {
-    PinSetSignal(PIN_ENB, ast ? ENB_ON : ENB_OFF);
+    PinSetSignal(C::PIN_ENB, ast ? C::ENB_ON : !C::ENB_ON);
 }
 
-bool GPIOBUS_Raspberry::GetBSY() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetBSY() const
 {
-    return GetSignal(PIN_BSY);
+    return GetSignal(C::PIN_BSY);
 }
 
-void GPIOBUS_Raspberry::SetBSY(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetBSY(bool ast)
 {
     // Set BSY signal
-    SetSignal(PIN_BSY, ast);
+    SetSignal(C::PIN_BSY, ast);
 
     if (ast) {
         // Turn on ACTIVE signal
-        SetControl(PIN_ACT, ACT_ON);
+        SetControl(C::PIN_ACT, C::ACT_ON);
 
         // Set Target signal to output
-        SetControl(PIN_TAD, TAD_OUT);
+        SetControl(C::PIN_TAD, !C::TAD_IN);
 
-    	SetMode(PIN_BSY, OUT);
-    	SetMode(PIN_MSG, OUT);
-    	SetMode(PIN_CD, OUT);
-    	SetMode(PIN_REQ, OUT);
-    	SetMode(PIN_IO, OUT);
+    	SetMode(C::PIN_BSY, OUT);
+    	SetMode(C::PIN_MSG, OUT);
+    	SetMode(C::PIN_CD, OUT);
+    	SetMode(C::PIN_REQ, OUT);
+    	SetMode(C::PIN_IO, OUT);
     } else {
         // Turn off the ACTIVE signal
-        SetControl(PIN_ACT, ACT_OFF);
+        SetControl(C::PIN_ACT, !C::ACT_ON);
 
         // Set the target signal to input
-    	SetControl(PIN_TAD, TAD_IN);
+    	SetControl(C::PIN_TAD, C::TAD_IN);
 
-    	SetMode(PIN_BSY, IN);
-    	SetMode(PIN_MSG, IN);
-    	SetMode(PIN_CD, IN);
-    	SetMode(PIN_REQ, IN);
-    	SetMode(PIN_IO, IN);
+    	SetMode(C::PIN_BSY, IN);
+    	SetMode(C::PIN_MSG, IN);
+    	SetMode(C::PIN_CD, IN);
+    	SetMode(C::PIN_REQ, IN);
+    	SetMode(C::PIN_IO, IN);
     }
 }
 
-bool GPIOBUS_Raspberry::GetSEL() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetSEL() const
 {
-    return GetSignal(PIN_SEL);
+    return GetSignal(C::PIN_SEL);
 }
 
-void GPIOBUS_Raspberry::SetSEL(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetSEL(bool ast)
 {
     if (actmode == mode_e::INITIATOR && ast) {
         // Turn on ACTIVE signal
-        SetControl(PIN_ACT, ACT_ON);
+        SetControl(C::PIN_ACT, C::ACT_ON);
     }
 
     // Set SEL signal
-    SetSignal(PIN_SEL, ast);
+    SetSignal(C::PIN_SEL, ast);
 }
 
-bool GPIOBUS_Raspberry::GetATN() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetATN() const
 {
-    return GetSignal(PIN_ATN);
+    return GetSignal(C::PIN_ATN);
 }
 
-void GPIOBUS_Raspberry::SetATN(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetATN(bool ast)
 {
-    SetSignal(PIN_ATN, ast);
+    SetSignal(C::PIN_ATN, ast);
 }
 
-bool GPIOBUS_Raspberry::GetACK() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetACK() const
 {
-    return GetSignal(PIN_ACK);
+    return GetSignal(C::PIN_ACK);
 }
 
-void GPIOBUS_Raspberry::SetACK(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetACK(bool ast)
 {
-    SetSignal(PIN_ACK, ast);
+    SetSignal(C::PIN_ACK, ast);
 }
 
-bool GPIOBUS_Raspberry::GetACT() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetACT() const
 {
-    return GetSignal(PIN_ACT);
+    return GetSignal(C::PIN_ACT);
 }
 
-void GPIOBUS_Raspberry::SetACT(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetACT(bool ast)
 {
-    SetSignal(PIN_ACT, ast);
+    SetSignal(C::PIN_ACT, ast);
 }
 
-bool GPIOBUS_Raspberry::GetRST() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetRST() const
 {
-    return GetSignal(PIN_RST);
+    return GetSignal(C::PIN_RST);
 }
 
-void GPIOBUS_Raspberry::SetRST(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetRST(bool ast)
 {
-    SetSignal(PIN_RST, ast);
+    SetSignal(C::PIN_RST, ast);
 }
 
-bool GPIOBUS_Raspberry::GetMSG() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetMSG() const
 {
-    return GetSignal(PIN_MSG);
+    return GetSignal(C::PIN_MSG);
 }
 
-void GPIOBUS_Raspberry::SetMSG(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetMSG(bool ast)
 {
-    SetSignal(PIN_MSG, ast);
+    SetSignal(C::PIN_MSG, ast);
 }
 
-bool GPIOBUS_Raspberry::GetCD() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetCD() const
 {
-    return GetSignal(PIN_CD);
+    return GetSignal(C::PIN_CD);
 }
 
-void GPIOBUS_Raspberry::SetCD(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetCD(bool ast)
 {
-    SetSignal(PIN_CD, ast);
+    SetSignal(C::PIN_CD, ast);
 }
 
-bool GPIOBUS_Raspberry::GetIO()
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetIO()
 {
-    bool ast = GetSignal(PIN_IO);
+    bool ast = GetSignal(C::PIN_IO);
 
     if (actmode == mode_e::INITIATOR) {
         // Change the data input/output direction by IO signal
         if (ast) {
-            SetControl(PIN_DTD, DTD_IN);
-            SetMode(PIN_DT0, IN);
-            SetMode(PIN_DT1, IN);
-            SetMode(PIN_DT2, IN);
-            SetMode(PIN_DT3, IN);
-            SetMode(PIN_DT4, IN);
-            SetMode(PIN_DT5, IN);
-            SetMode(PIN_DT6, IN);
-            SetMode(PIN_DT7, IN);
-            SetMode(PIN_DP, IN);
+            SetControl(C::PIN_DTD, C::DTD_IN);
+            SetMode(C::PIN_DT0, IN);
+            SetMode(C::PIN_DT1, IN);
+            SetMode(C::PIN_DT2, IN);
+            SetMode(C::PIN_DT3, IN);
+            SetMode(C::PIN_DT4, IN);
+            SetMode(C::PIN_DT5, IN);
+            SetMode(C::PIN_DT6, IN);
+            SetMode(C::PIN_DT7, IN);
+            SetMode(C::PIN_DP, IN);
         } else {
-            SetControl(PIN_DTD, DTD_OUT);
-            SetMode(PIN_DT0, OUT);
-            SetMode(PIN_DT1, OUT);
-            SetMode(PIN_DT2, OUT);
-            SetMode(PIN_DT3, OUT);
-            SetMode(PIN_DT4, OUT);
-            SetMode(PIN_DT5, OUT);
-            SetMode(PIN_DT6, OUT);
-            SetMode(PIN_DT7, OUT);
-            SetMode(PIN_DP, OUT);
+            SetControl(C::PIN_DTD, !C::DTD_IN);
+            SetMode(C::PIN_DT0, OUT);
+            SetMode(C::PIN_DT1, OUT);
+            SetMode(C::PIN_DT2, OUT);
+            SetMode(C::PIN_DT3, OUT);
+            SetMode(C::PIN_DT4, OUT);
+            SetMode(C::PIN_DT5, OUT);
+            SetMode(C::PIN_DT6, OUT);
+            SetMode(C::PIN_DT7, OUT);
+            SetMode(C::PIN_DP, OUT);
         }
     }
 
     return ast;
 }
 
-void GPIOBUS_Raspberry::SetIO(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetIO(bool ast)
 {
-    SetSignal(PIN_IO, ast);
+    SetSignal(C::PIN_IO, ast);
 
     if (actmode == mode_e::TARGET) {
         // Change the data input/output direction by IO signal
         if (ast) {
-            SetControl(PIN_DTD, DTD_OUT);
+            SetControl(C::PIN_DTD, !C::DTD_IN);
             SetDAT(0);
-            SetMode(PIN_DT0, OUT);
-            SetMode(PIN_DT1, OUT);
-            SetMode(PIN_DT2, OUT);
-            SetMode(PIN_DT3, OUT);
-            SetMode(PIN_DT4, OUT);
-            SetMode(PIN_DT5, OUT);
-            SetMode(PIN_DT6, OUT);
-            SetMode(PIN_DT7, OUT);
-            SetMode(PIN_DP, OUT);
+            SetMode(C::PIN_DT0, OUT);
+            SetMode(C::PIN_DT1, OUT);
+            SetMode(C::PIN_DT2, OUT);
+            SetMode(C::PIN_DT3, OUT);
+            SetMode(C::PIN_DT4, OUT);
+            SetMode(C::PIN_DT5, OUT);
+            SetMode(C::PIN_DT6, OUT);
+            SetMode(C::PIN_DT7, OUT);
+            SetMode(C::PIN_DP, OUT);
         } else {
-            SetControl(PIN_DTD, DTD_IN);
-            SetMode(PIN_DT0, IN);
-            SetMode(PIN_DT1, IN);
-            SetMode(PIN_DT2, IN);
-            SetMode(PIN_DT3, IN);
-            SetMode(PIN_DT4, IN);
-            SetMode(PIN_DT5, IN);
-            SetMode(PIN_DT6, IN);
-            SetMode(PIN_DT7, IN);
-            SetMode(PIN_DP, IN);
+            SetControl(C::PIN_DTD, C::DTD_IN);
+            SetMode(C::PIN_DT0, IN);
+            SetMode(C::PIN_DT1, IN);
+            SetMode(C::PIN_DT2, IN);
+            SetMode(C::PIN_DT3, IN);
+            SetMode(C::PIN_DT4, IN);
+            SetMode(C::PIN_DT5, IN);
+            SetMode(C::PIN_DT6, IN);
+            SetMode(C::PIN_DT7, IN);
+            SetMode(C::PIN_DP, IN);
         }
     }
 }
 
-bool GPIOBUS_Raspberry::GetREQ() const
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::GetREQ() const
 {
-    return GetSignal(PIN_REQ);
+    return GetSignal(C::PIN_REQ);
 }
 
-void GPIOBUS_Raspberry::SetREQ(bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetREQ(bool ast)
 {
-    SetSignal(PIN_REQ, ast);
+    SetSignal(C::PIN_REQ, ast);
 }
 
 //---------------------------------------------------------------------------
@@ -595,61 +623,110 @@ void GPIOBUS_Raspberry::SetREQ(bool ast)
 // Get data signals
 //
 //---------------------------------------------------------------------------
-uint8_t GPIOBUS_Raspberry::GetDAT()
+template <typename C>
+uint8_t GPIOBUS_RaspberryConnection<C>::GetDAT()
 {
     uint32_t data = Acquire();
-    data          = ((data >> (PIN_DT0 - 0)) & (1 << 0)) | ((data >> (PIN_DT1 - 1)) & (1 << 1)) |
-           ((data >> (PIN_DT2 - 2)) & (1 << 2)) | ((data >> (PIN_DT3 - 3)) & (1 << 3)) |
-           ((data >> (PIN_DT4 - 4)) & (1 << 4)) | ((data >> (PIN_DT5 - 5)) & (1 << 5)) |
-           ((data >> (PIN_DT6 - 6)) & (1 << 6)) | ((data >> (PIN_DT7 - 7)) & (1 << 7));
+    data          = ((data >> (C::PIN_DT0 - 0)) & (1 << 0)) | ((data >> (C::PIN_DT1 - 1)) & (1 << 1)) |
+           ((data >> (C::PIN_DT2 - 2)) & (1 << 2)) | ((data >> (C::PIN_DT3 - 3)) & (1 << 3)) |
+           ((data >> (C::PIN_DT4 - 4)) & (1 << 4)) | ((data >> (C::PIN_DT5 - 5)) & (1 << 5)) |
+           ((data >> (C::PIN_DT6 - 6)) & (1 << 6)) | ((data >> (C::PIN_DT7 - 7)) & (1 << 7));
 
     return (uint8_t)data;
 }
 
-void GPIOBUS_Raspberry::SetDAT(uint8_t dat)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetDAT(uint8_t dat)
 {
     // Write to ports
-#if SIGNAL_CONTROL_MODE == 0
-    uint32_t fsel = gpfsel[0];
-    fsel &= tblDatMsk[0][dat];
-    fsel |= tblDatSet[0][dat];
-    gpfsel[0] = fsel;
-    gpio[GPIO_FSEL_0] = fsel;
-
-    fsel = gpfsel[1];
-    fsel &= tblDatMsk[1][dat];
-    fsel |= tblDatSet[1][dat];
-    gpfsel[1] = fsel;
-    gpio[GPIO_FSEL_1] = fsel;
-
-    fsel = gpfsel[2];
-    fsel &= tblDatMsk[2][dat];
-    fsel |= tblDatSet[2][dat];
-    gpfsel[2] = fsel;
-    gpio[GPIO_FSEL_2] = fsel;
-#else
-    gpio[GPIO_CLR_0] = tblDatMsk[dat];
-    gpio[GPIO_SET_0] = tblDatSet[dat];
-#endif
+    if constexpr (C::SIGNAL_CONTROL_MODE == 0) {
+        uint32_t fsel = gpfsel[0];
+        fsel &= tblDatMsk[0][dat];
+        fsel |= tblDatSet[0][dat];
+        gpfsel[0] = fsel;
+        gpio[GPIO_FSEL_0] = fsel;
+
+        fsel = gpfsel[1];
+        fsel &= tblDatMsk[1][dat];
+        fsel |= tblDatSet[1][dat];
+        gpfsel[1] = fsel;
+        gpio[GPIO_FSEL_1] = fsel;
+
+        fsel = gpfsel[2];
+        fsel &= tblDatMsk[2][dat];
+        fsel |= tblDatSet[2][dat];
+        gpfsel[2] = fsel;
+        gpio[GPIO_FSEL_2] = fsel;
+    } else {
+        gpio[GPIO_CLR_0] = tblDatMsk[dat];
+        gpio[GPIO_SET_0] = tblDatSet[dat];
+    }
 }
 
-//---------------------------------------------------------------------------
-//
-//	Signal table
-//
-//---------------------------------------------------------------------------
-const array<int, 19> GPIOBUS_Raspberry::SignalTable = {PIN_DT0, PIN_DT1, PIN_DT2, PIN_DT3, PIN_DT4, PIN_DT5, PIN_DT6,
-                                                       PIN_DT7, PIN_DP,  PIN_SEL, PIN_ATN, PIN_RST, PIN_ACK, PIN_BSY,
-                                                       PIN_MSG, PIN_CD,  PIN_IO,  PIN_REQ, -1};
+template <typename C>
+bool GPIOBUS_RaspberryConnection<C>::Reselect(int target_id, int initiator_id)
+{
+    if constexpr (!HAS_OPEN_COLLECTOR_SIGNALS) {
+        (void)target_id;
+        (void)initiator_id;
+        return false;
+    } else {
+        if (actmode != mode_e::TARGET) {
+            return false;
+        }
+
+        // Arbitration requires a free bus
+        Acquire();
+        if (GetBSY() || GetSEL()) {
+            return false;
+        }
+
+        SetBSY(true);
+        SetDAT(static_cast<uint8_t>(1 << target_id));
+        SysTimer::SleepNsec(SCSI_DELAY_ARBITRATION_DELAY_NS);
+
+        // Arbitration is lost if a device with a higher ID or an initiator selecting another device is on the bus
+        if ((GetDAT() >> target_id) > 1 || GetSEL()) {
+            SetDAT(0);
+            SetBSY(false);
+            return false;
+        }
+
+        // Reselection: SEL, I/O and the IDs of both devices, then BSY is released
+        SetSignal(C::PIN_SEL, true);
+        SetSignal(C::PIN_IO, true);
+        SetDAT(static_cast<uint8_t>((1 << target_id) | (1 << initiator_id)));
+        SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+        SetSignal(C::PIN_BSY, false);
+
+        // The initiator responds with BSY within the selection timeout recommended by SCSI-2
+        if (!WaitSignal(C::PIN_BSY, true, 250ms)) {
+            SetSignal(C::PIN_SEL, false);
+            SetDAT(0);
+            SetSignal(C::PIN_IO, false);
+            SetBSY(false);
+            return false;
+        }
+
+        // The target takes over BSY and ends the reselection by releasing SEL
+        SetSignal(C::PIN_BSY, true);
+        SetSignal(C::PIN_SEL, false);
+        SetDAT(0);
+
+        return true;
+    }
+}
 
 //---------------------------------------------------------------------------
 //
 //	Create work table
 //
 //---------------------------------------------------------------------------
-void GPIOBUS_Raspberry::MakeTable(void)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::MakeTable(void)
 {
-    const array<int, 9> pintbl = {PIN_DT0, PIN_DT1, PIN_DT2, PIN_DT3, PIN_DT4, PIN_DT5, PIN_DT6, PIN_DT7, PIN_DP};
+    constexpr array<int, 9> pintbl = {C::PIN_DT0, C::PIN_DT1, C::PIN_DT2, C::PIN_DT3, C::PIN_DT4, C::PIN_DT5,
+                                      C::PIN_DT6, C::PIN_DT7, C::PIN_DP};
 
     array<bool, 256> tblParity;
 
@@ -665,72 +742,72 @@ void GPIOBUS_Raspberry::MakeTable(void)
         tblParity[i] = parity & 1;
     }
 
-#if SIGNAL_CONTROL_MODE == 0
-    // Mask and setting data generation
-    for (auto &tbl : tblDatMsk) {
-        tbl.fill(-1);
-    }
-    for (auto &tbl : tblDatSet) {
-        tbl.fill(0);
-    }
+    if constexpr (C::SIGNAL_CONTROL_MODE == 0) {
+        // Mask and setting data generation
+        for (auto &tbl : tblDatMsk) {
+            tbl.fill(-1);
+        }
+        for (auto &tbl : tblDatSet) {
+            tbl.fill(0);
+        }
 
-    for (uint32_t i = 0; i < 0x100; i++) {
-        // Bit string for inspection
-        uint32_t bits = i;
+        for (uint32_t i = 0; i < 0x100; i++) {
+            // Bit string for inspection
+            uint32_t bits = i;
 
-        // Get parity
-        if (tblParity[i]) {
-            bits |= (1 << 8);
-        }
+            // Get parity
+            if (tblParity[i]) {
+                bits |= (1 << 8);
+            }
 
-        // Bit check
-        for (int j = 0; j < 9; j++) {
-            // Index and shift amount calculation
-            int index = pintbl[j] / 10;
-            int shift = (pintbl[j] % 10) * 3;
+            // Bit check
+            for (int j = 0; j < 9; j++) {
+                // Index and shift amount calculation
+                int index = pintbl[j] / 10;
+                int shift = (pintbl[j] % 10) * 3;
 
-            // Mask data
-            tblDatMsk[index][i] &= ~(0x7 << shift);
+                // Mask data
+                tblDatMsk[index][i] &= ~(0x7 << shift);
 
-            // Setting data
-            if (bits & 1) {
-                tblDatSet[index][i] |= (1 << shift);
-            }
+                // Setting data
+                if (bits & 1) {
+                    tblDatSet[index][i] |= (1 << shift);
+                }
 
-            bits >>= 1;
+                bits >>= 1;
+            }
         }
-    }
-#else
-    for (uint32_t i = 0; i < 0x100; i++) {
-        // Bit string for inspection
-        uint32_t bits = i;
+    } else {
+        for (uint32_t i = 0; i < 0x100; i++) {
+            // Bit string for inspection
+            uint32_t bits = i;
 
-        // Get parity
-        if (tblParity[i]) {
-            bits |= (1 << 8);
-        }
+            // Get parity
+            if (tblParity[i]) {
+                bits |= (1 << 8);
+            }
 
-#if SIGNAL_CONTROL_MODE == 1
-        // Negative logic is inverted
-        bits = ~bits;
-#endif
+            if constexpr (C::SIGNAL_CONTROL_MODE == 1) {
+                // Negative logic is inverted
+                bits = ~bits;
+            }
 
-        // Create GPIO register information
-        uint32_t gpclr = 0;
-        uint32_t gpset = 0;
-        for (int j = 0; j < 9; j++) {
-            if (bits & 1) {
-                gpset |= (1 << pintbl[j]);
-            } else {
-                gpclr |= (1 << pintbl[j]);
+            // Create GPIO register information
+            uint32_t gpclr = 0;
+            uint32_t gpset = 0;
+            for (int j = 0; j < 9; j++) {
+                if (bits & 1) {
+                    gpset |= (1 << pintbl[j]);
+                } else {
+                    gpclr |= (1 << pintbl[j]);
+                }
+                bits >>= 1;
             }
-            bits >>= 1;
-        }
 
-        tblDatMsk[i] = gpclr;
-        tblDatSet[i] = gpset;
+            tblDatMsk[i] = gpclr;
+            tblDatSet[i] = gpset;
+        }
     }
-#endif
 }
 
 //---------------------------------------------------------------------------
@@ -751,13 +828,14 @@ void GPIOBUS_Raspberry::SetControl(int pin, bool ast)
 //   Used with: TAD, BSY, MSG, CD, REQ, O, SEL, IND, ATN, ACK, RST, DT*
 //
 //---------------------------------------------------------------------------
-void GPIOBUS_Raspberry::SetMode(int pin, int mode)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetMode(int pin, int mode)
 {
-#if SIGNAL_CONTROL_MODE == 0
-    if (mode == OUT) {
-        return;
+    if constexpr (C::SIGNAL_CONTROL_MODE == 0) {
+        if (mode == OUT) {
+            return;
+        }
     }
-#endif // SIGNAL_CONTROL_MODE
 
     int index     = pin / 10;
     int shift     = (pin % 10) * 3;
@@ -788,32 +866,33 @@ bool GPIOBUS_Raspberry::GetSignal(int pin) const
 //     PIN_ENB, ACT, TAD, IND, DTD, BSY, SignalTable
 //
 //---------------------------------------------------------------------------
-void GPIOBUS_Raspberry::SetSignal(int pin, bool ast)
+template <typename C>
+void GPIOBUS_RaspberryConnection<C>::SetSignal(int pin, bool ast)
 {
-#if SIGNAL_CONTROL_MODE == 0
-    int index     = pin / 10;
-    int shift     = (pin % 10) * 3;
-    uint32_t data = gpfsel[index];
-    if (ast) {
-        data |= (1 << shift);
-    } else {
-        data &= ~(0x7 << shift);
-    }
-    gpio[index]   = data;
-    gpfsel[index] = data;
-#elif SIGNAL_CONTROL_MODE == 1
-    if (ast) {
-        gpio[GPIO_CLR_0] = 0x1 << pin;
-    } else {
-        gpio[GPIO_SET_0] = 0x1 << pin;
-    }
-#elif SIGNAL_CONTROL_MODE == 2
-    if (ast) {
-        gpio[GPIO_SET_0] = 0x1 << pin;
+    if constexpr (C::SIGNAL_CONTROL_MODE == 0) {
+        int index     = pin / 10;
+        int shift     = (pin % 10) * 3;
+        uint32_t data = gpfsel[index];
+        if (ast) {
+            data |= (1 << shift);
+        } else {
+            data &= ~(0x7 << shift);
+        }
+        gpio[index]   = data;
+        gpfsel[index] = data;
+    } else if constexpr (C::SIGNAL_CONTROL_MODE == 1) {
+        if (ast) {
+            gpio[GPIO_CLR_0] = 0x1 << pin;
+        } else {
+            gpio[GPIO_SET_0] = 0x1 << pin;
+        }
     } else {
-        gpio[GPIO_CLR_0] = 0x1 << pin;
+        if (ast) {
+            gpio[GPIO_SET_0] = 0x1 << pin;
+        } else {
+            gpio[GPIO_CLR_0] = 0x1 << pin;
+        }
     }
-#endif // SIGNAL_CONTROL_MODE
 }
 
 void GPIOBUS_Raspberry::DisableIRQ()
@@ -953,14 +1032,20 @@ void GPIOBUS_Raspberry::DrvConfig(uint32_t drive)
 //	Bus signal acquisition
 //
 //---------------------------------------------------------------------------
-uint32_t GPIOBUS_Raspberry::Acquire()
+template <typename C>
+uint32_t GPIOBUS_RaspberryConnection<C>::Acquire()
 {
     signals = *level;
 
-#if SIGNAL_CONTROL_MODE < 2
-    // Invert if negative logic (internal processing is unified to positive logic)
-    signals = ~signals;
-#endif // SIGNAL_CONTROL_MODE
+    if constexpr (C::SIGNAL_CONTROL_MODE < 2) {
+        // Invert if negative logic (internal processing is unified to positive logic)
+        signals = ~signals;
+    }
 
     return signals;
 }
+
+template class GPIOBUS_RaspberryConnection<ConnectionStandard>;
+template class GPIOBUS_RaspberryConnection<ConnectionFullspec>;
+template class GPIOBUS_RaspberryConnection<ConnectionAibom>;
+template class GPIOBUS_RaspberryConnection<ConnectionGamernium>;
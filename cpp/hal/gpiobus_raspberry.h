@@ -15,23 +15,7 @@
 #include "hal/gpiobus.h"
 #include "shared/scsi.h"
 #include <map>
-
-//---------------------------------------------------------------------------
-//
-//	SCSI signal pin assignment setting
-//	  GPIO pin mapping table for SCSI signals.
-//	  PIN_DT0～PIN_SEL
-//
-//---------------------------------------------------------------------------
-
-#define ALL_SCSI_PINS                                                                                      \
-    ((1 << PIN_DT0) | (1 << PIN_DT1) | (1 << PIN_DT2) | (1 << PIN_DT3) | (1 << PIN_DT4) | (1 << PIN_DT5) | \
-     (1 << PIN_DT6) | (1 << PIN_DT7) | (1 << PIN_DP) | (1 << PIN_ATN) | (1 << PIN_RST) | (1 << PIN_ACK) |  \
-     (1 << PIN_REQ) | (1 << PIN_MSG) | (1 << PIN_CD) | (1 << PIN_IO) | (1 << PIN_BSY) | (1 << PIN_SEL))
-
-#define GPIO_INEDGE ((1 << PIN_BSY) | (1 << PIN_SEL) | (1 << PIN_ATN) | (1 << PIN_ACK) | (1 << PIN_RST))
-
-#define GPIO_MCI ((1 << PIN_MSG) | (1 << PIN_CD) | (1 << PIN_IO))
+#include <type_traits>
 
 //---------------------------------------------------------------------------
 //
@@ -76,106 +60,22 @@ class GPIOBUS_Raspberry : public GPIOBUS
   public:
     GPIOBUS_Raspberry()           = default;
     ~GPIOBUS_Raspberry() override = default;
-    bool Init(mode_e mode = mode_e::TARGET) override;
-
-    void Reset() override;
-    void Cleanup() override;
-
-    //	Bus signal acquisition
-    uint32_t Acquire() override;
-
-    // Set ENB signal
-    void SetENB(bool ast) override;
-
-    // Get BSY signal
-    bool GetBSY() const override;
-    // Set BSY signal
-    void SetBSY(bool ast) override;
-
-    // Get SEL signal
-    bool GetSEL() const override;
-    // Set SEL signal
-    void SetSEL(bool ast) override;
-
-    // Get ATN signal
-    bool GetATN() const override;
-    // Set ATN signal
-    void SetATN(bool ast) override;
-
-    // Get ACK signal
-    bool GetACK() const override;
-    // Set ACK signal
-    void SetACK(bool ast) override;
-
-    // Get ACT signal
-    bool GetACT() const override;
-    // Set ACT signal
-    void SetACT(bool ast) override;
-
-    // Get RST signal
-    bool GetRST() const override;
-    // Set RST signal
-    void SetRST(bool ast) override;
-
-    // Get MSG signal
-    bool GetMSG() const override;
-    // Set MSG signal
-    void SetMSG(bool ast) override;
 
-    // Get CD signal
-    bool GetCD() const override;
-    // Set CD signal
-    void SetCD(bool ast) override;
-
-    // Get IO signal
-    bool GetIO() override;
-    // Set IO signal
-    void SetIO(bool ast) override;
-
-    // Get REQ signal
-    bool GetREQ() const override;
-    // Set REQ signal
-    void SetREQ(bool ast) override;
-
-    // Get DAT signal
-    uint8_t GetDAT() override;
-    // Set DAT signal
-    void SetDAT(uint8_t dat) override;
+    // Maps the peripheral registers, the pins are set up by the connection type specific subclass
+    bool Init(mode_e mode = mode_e::TARGET) override;
 
-    bool WaitREQ(bool ast) override
-    {
-        return WaitSignal(PIN_REQ, ast);
-    }
-    bool WaitACK(bool ast) override
-    {
-        return WaitSignal(PIN_ACK, ast);
-    }
     static uint32_t bcm_host_get_peripheral_address();
 
-    unique_ptr<DataSample> GetSample(uint64_t timestamp) override
-    {
-        Acquire();
-        return make_unique<DataSample_Raspberry>(signals, timestamp);
-    }
-
   protected:
     // All bus signals
     uint32_t signals = 0;
     // GPIO input level
     volatile uint32_t *level = nullptr;
 
-  private:
-    // SCSI I/O signal control
-    void MakeTable() override;
     // Create work data
     void SetControl(int pin, bool ast) override;
-    // Set Control Signal
-    void SetMode(int pin, int mode) override;
-    // Set SCSI I/O mode
-    bool GetSignal(int pin) const override;
     // Get SCSI input signal value
-    void SetSignal(int pin, bool ast) override;
-    // Set SCSI output signal value
+    bool GetSignal(int pin) const override;
 
     // Interrupt control
     void DisableIRQ() override;
@@ -193,8 +93,6 @@ class GPIOBUS_Raspberry : public GPIOBUS
     void DrvConfig(uint32_t drive) override;
     // Set GPIO drive strength
 
-    static uint32_t get_dt_ranges(const char *filename, uint32_t offset);
-
     uint32_t baseaddr = 0; // Base address
 
     int rpitype = 0; // Type of Raspberry Pi
@@ -230,20 +128,6 @@ class GPIOBUS_Raspberry : public GPIOBUS
     // RAM copy of GPFSEL0-4  values (GPIO Function Select)
     array<uint32_t, 4> gpfsel;
 
-#if SIGNAL_CONTROL_MODE == 0
-    // Data mask table
-    array<array<uint32_t, 256>, 3> tblDatMsk;
-    // Data setting table
-    array<array<uint32_t, 256>, 3> tblDatSet;
-#else
-    // Data mask table
-    array<uint32_t, 256> tblDatMsk = {};
-    // Table setting table
-    array<uint32_t, 256> tblDatSet = {};
-#endif
-
-    static const array<int, 19> SignalTable;
-
     const static int GPIO_FSEL_0     = 0;
     const static int GPIO_FSEL_1     = 1;
     const static int GPIO_FSEL_2     = 2;
@@ -283,4 +167,147 @@ class GPIOBUS_Raspberry : public GPIOBUS
     const static uint32_t PADS_OFFSET = 0x00100000;
     const static uint32_t GPIO_OFFSET = 0x00200000;
     const static uint32_t QA7_OFFSET  = 0x01000000;
+
+  private:
+    static uint32_t get_dt_ranges(const char *filename, uint32_t offset);
+};
+
+//---------------------------------------------------------------------------
+//
+//	The pin assignment and the signal logic of the connection type are compile-time constants,
+//	i.e. the handshake code is as fast as with a connection type selected at build time.
+//	The connection type is selected once when creating the bus.
+//
+//---------------------------------------------------------------------------
+template <typename C>
+class GPIOBUS_RaspberryConnection : public GPIOBUS_Raspberry
+{
+  public:
+    GPIOBUS_RaspberryConnection()           = default;
+    ~GPIOBUS_RaspberryConnection() override = default;
+    bool Init(mode_e mode = mode_e::TARGET) override;
+
+    void Reset() override;
+    void Cleanup() override;
+
+    //	Bus signal acquisition
+    uint32_t Acquire() override;
+
+    // Set ENB signal
+    void SetENB(bool ast) override;
+
+    // Get BSY signal
+    bool GetBSY() const override;
+    // Set BSY signal
+    void SetBSY(bool ast) override;
+
+    // Get SEL signal
+    bool GetSEL() const override;
+    // Set SEL signal
+    void SetSEL(bool ast) override;
+
+    // Get ATN signal
+    bool GetATN() const override;
+    // Set ATN signal
+    void SetATN(bool ast) override;
+
+    // Get ACK signal
+    bool GetACK() const override;
+    // Set ACK signal
+    void SetACK(bool ast) override;
+
+    // Get ACT signal
+    bool GetACT() const override;
+    // Set ACT signal
+    void SetACT(bool ast) override;
+
+    // Get RST signal
+    bool GetRST() const override;
+    // Set RST signal
+    void SetRST(bool ast) override;
+
+    // Get MSG signal
+    bool GetMSG() const override;
+    // Set MSG signal
+    void SetMSG(bool ast) override;
+
+    // Get CD signal
+    bool GetCD() const override;
+    // Set CD signal
+    void SetCD(bool ast) override;
+
+    // Get IO signal
+    bool GetIO() override;
+    // Set IO signal
+    void SetIO(bool ast) override;
+
+    // Get REQ signal
+    bool GetREQ() const override;
+    // Set REQ signal
+    void SetREQ(bool ast) override;
+
+    // Get DAT signal
+    uint8_t GetDAT() override;
+    // Set DAT signal
+    void SetDAT(uint8_t dat) override;
+
+    // Reselection requires reading BSY while driving the other target signals. With the direction control of the
+    // FULLSPEC, AIBOM and GAMERnium boards the target signals are either all inputs or all outputs.
+    bool CanReselect() const override
+    {
+        return actmode == mode_e::TARGET && HAS_OPEN_COLLECTOR_SIGNALS;
+    }
+    bool Reselect(int, int) override;
+
+    bool WaitREQ(bool ast) override
+    {
+        return WaitSignal(C::PIN_REQ, ast);
+    }
+    bool WaitACK(bool ast) override
+    {
+        return WaitSignal(C::PIN_ACK, ast);
+    }
+
+    unique_ptr<DataSample> GetSample(uint64_t timestamp) override
+    {
+        Acquire();
+        return make_unique<DataSample_Raspberry<C>>(signals, timestamp);
+    }
+
+    BusTracer::decoder GetSampleDecoder() const override
+    {
+        return [](uint32_t s, uint64_t timestamp) -> unique_ptr<DataSample> {
+            return make_unique<DataSample_Raspberry<C>>(s, timestamp);
+        };
+    }
+
+  protected:
+    // SCSI I/O signal control
+    void MakeTable() override;
+
+  private:
+    static constexpr bool HAS_OPEN_COLLECTOR_SIGNALS = C::SIGNAL_CONTROL_MODE == 0 && C::PIN_TAD < 0 &&
+            C::PIN_IND < 0 && C::PIN_DTD < 0;
+
+    // Set SCSI I/O mode
+    void SetMode(int pin, int mode) override;
+    // Set SCSI output signal value
+    void SetSignal(int pin, bool ast) override;
+
+    // With the SCSI logic the pins are driven by switching their function, otherwise by setting their level
+    using data_table = conditional_t<C::SIGNAL_CONTROL_MODE == 0, array<array<uint32_t, 256>, 3>, array<uint32_t, 256>>;
+
+    // Data mask table
+    data_table tblDatMsk = {};
+    // Data setting table
+    data_table tblDatSet = {};
+
+    static constexpr array<int, 19> SignalTable = { C::PIN_DT0, C::PIN_DT1, C::PIN_DT2, C::PIN_DT3, C::PIN_DT4,
+            C::PIN_DT5, C::PIN_DT6, C::PIN_DT7, C::PIN_DP, C::PIN_SEL, C::PIN_ATN, C::PIN_RST, C::PIN_ACK, C::PIN_BSY,
+            C::PIN_MSG, C::PIN_CD, C::PIN_IO, C::PIN_REQ, -1 };
 };
+
+extern template class GPIOBUS_RaspberryConnection<ConnectionStandard>;
+extern template class GPIOBUS_RaspberryConnection<ConnectionFullspec>;
+extern template class GPIOBUS_RaspberryConnection<ConnectionAibom>;
+extern template class GPIOBUS_RaspberryConnection<ConnectionGamernium>;
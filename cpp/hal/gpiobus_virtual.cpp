@@ -10,16 +10,26 @@
 
 #include "hal/gpiobus_virtual.h"
 #include "hal/gpiobus.h"
+#include "hal/deadline.h"
 #include "hal/systimer.h"
 #include "hal/log.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <map>
 #include <memory>
-#include <string.h>
+#include <sched.h>
+#include <unistd.h>
 #ifdef __linux__
-#include <sys/epoll.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #endif
-#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/time.h>
 
@@ -30,37 +40,97 @@ bool GPIOBUS_Virtual::Init(mode_e mode)
     GPIO_FUNCTION_TRACE
     GPIOBUS::Init(mode);
 
-#ifdef SHARED_MEMORY_GPIO
-    // Create a shared memory region that can be accessed as a virtual "SCSI bus"
-    //  mutual exclusion semaphore, mutex_sem with an initial value 0.
-    if ((mutex_sem = sem_open(SHARED_MEM_MUTEX_NAME.c_str(), O_CREAT, 0660, 0)) == SEM_FAILED) {
-        LOGERROR("Unable to open shared memory semaphore %s. Are you running as root?", SHARED_MEM_MUTEX_NAME.c_str());
-    }
-    // Get shared memory
-    if ((fd_shm = shm_open(SHARED_MEM_NAME.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660)) == -1) {
-        LOGERROR("Unable to open shared memory %s. Are you running as root?", SHARED_MEM_NAME.c_str());
-        sem_close(mutex_sem);
-    }
-    if (ftruncate(fd_shm, sizeof(uint32_t)) == -1) {
-        LOGERROR("Unable to read shared memory");
-        sem_close(mutex_sem);
-        shm_unlink(SHARED_MEM_NAME.c_str());
+    SysTimer::Init();
+
+    spin = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+
+    if (shared_memory_name.empty()) {
+        local_bus  = make_unique<shared_bus_t>();
+        shared_bus = local_bus.get();
+        slot       = 0;
+        shared_bus->pids[slot] = getpid();
+        return true;
+    }
+
+    // Create the shared memory region that is accessed as a virtual SCSI bus, or open it if another participant
+    // has already created it. A new region is zero-filled, i.e. all slots are free and no signal is asserted.
+    const int fd = shm_open(shared_memory_name.c_str(), O_RDWR | O_CREAT, 0660);
+    if (fd == -1) {
+        spdlog::error("Can't open shared memory '" + shared_memory_name + "': " + strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(shared_bus_t)) == -1) {
+        spdlog::error("Can't resize shared memory '" + shared_memory_name + "': " + strerror(errno));
+        close(fd);
         return false;
     }
 
-    signals = static_cast<uint32_t *>(mmap(NULL, sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd_shm, 0));
-    if (static_cast<void *>(signals) == MAP_FAILED) {
-        LOGERROR("Unabled to map shared memory");
-        sem_close(mutex_sem);
-        shm_unlink(SHARED_MEM_NAME.c_str());
+    void *memory = mmap(nullptr, sizeof(shared_bus_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        spdlog::error("Can't map shared memory '" + shared_memory_name + "': " + strerror(errno));
+        return false;
     }
-#else
-    signals = make_shared<uint32_t>(0);
-#endif
+    shared_bus = static_cast<shared_bus_t *>(memory);
+
+    if (!ClaimSlot()) {
+        spdlog::error("Virtual SCSI bus '" + shared_memory_name + "' already has " + to_string(MAX_PARTICIPANTS) +
+                      " participants");
+        munmap(memory, sizeof(shared_bus_t));
+        shared_bus = nullptr;
+        return false;
+    }
+
+    spdlog::info("Connected to virtual SCSI bus '" + shared_memory_name + "'");
 
     return true;
 }
 
+bool GPIOBUS_Virtual::ClaimSlot()
+{
+    // Signals of terminated participants must not remain asserted, even if there is a free slot
+    ReleaseDeadSlots();
+
+    const int32_t pid = getpid();
+
+    for (int i = 0; i < MAX_PARTICIPANTS; i++) {
+        int32_t owner = 0;
+        if (shared_bus->pids[i].compare_exchange_strong(owner, pid)) {
+            slot = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GPIOBUS_Virtual::ReleaseDeadSlots()
+{
+    bool released = false;
+
+    for (int i = 0; i < MAX_PARTICIPANTS; i++) {
+        // The signals are cleared before the slot is free, i.e. they cannot reset the signals of a new owner
+        if (int32_t owner = shared_bus->pids[i]; owner && kill(owner, 0) == -1 && errno == ESRCH) {
+            shared_bus->drivers[i] = 0;
+            if (shared_bus->pids[i].compare_exchange_strong(owner, 0)) {
+                released = true;
+            }
+        }
+    }
+
+    if (released) {
+        shared_bus->generation++;
+        WakeUp();
+    }
+}
+
+GPIOBUS_Virtual::~GPIOBUS_Virtual()
+{
+    if (!shared_memory_name.empty() && shared_bus != nullptr) {
+        munmap(shared_bus, sizeof(shared_bus_t));
+    }
+}
+
 void GPIOBUS_Virtual::Cleanup()
 {
     // Set control signals
@@ -82,18 +152,26 @@ void GPIOBUS_Virtual::Cleanup()
         PullConfig(pin, GPIO_PULLNONE);
     }
 
-#ifdef SHARED_MEMORY_GPIO
-    munmap(static_cast<void *>(signals), sizeof(uint32_t));
-    shm_unlink(SHARED_MEM_NAME.c_str());
-    sem_close(mutex_sem);
-#endif
+    if (shared_bus == nullptr) {
+        return;
+    }
+
+    // Release the bus. It remains mapped until destruction, because Cleanup() may be called by a signal handler
+    // while the bus is still being accessed.
+    driven      = 0;
+    output_pins = 0;
+    Publish();
+    shared_bus->pids[slot] = 0;
+
+    // The last participant removes the bus
+    if (!shared_memory_name.empty() &&
+        ranges::all_of(shared_bus->pids, [](const auto &pid) { return !pid; })) {
+        shm_unlink(shared_memory_name.c_str());
+    }
 }
 
 void GPIOBUS_Virtual::Reset()
 {
-#if defined(__x86_64__) || defined(__X86__)
-    return;
-#else
     int i;
     int j;
 
@@ -171,8 +249,8 @@ void GPIOBUS_Virtual::Reset()
     }
 
     // Initialize all signals
-    signals = 0;
-#endif // ifdef __x86_64__ || __X86__
+    driven = 0;
+    Publish();
 }
 
 void GPIOBUS_Virtual::SetENB(bool ast)
@@ -216,6 +294,9 @@ void GPIOBUS_Virtual::SetBSY(bool ast)
             SetMode(PIN_REQ, IN);
             SetMode(PIN_IO, IN);
         }
+    } else {
+        // The initiator responds to a reselection with BSY
+        SetMode(PIN_BSY, ast ? OUT : IN);
     }
 }
 
@@ -397,16 +478,76 @@ void GPIOBUS_Virtual::SetDAT(uint8_t dat)
 {
     GPIO_FUNCTION_TRACE
 
-    auto new_dat = static_cast<byte>(dat);
+    // All data signals change at once, like with a real bus
+    constexpr uint32_t data_pins = (1 << PIN_DT0) | (1 << PIN_DT1) | (1 << PIN_DT2) | (1 << PIN_DT3) |
+                                   (1 << PIN_DT4) | (1 << PIN_DT5) | (1 << PIN_DT6) | (1 << PIN_DT7);
+    const uint32_t data = ((dat & (1 << 0)) << (PIN_DT0 - 0)) | ((dat & (1 << 1)) << (PIN_DT1 - 1)) |
+                          ((dat & (1 << 2)) << (PIN_DT2 - 2)) | ((dat & (1 << 3)) << (PIN_DT3 - 3)) |
+                          ((dat & (1 << 4)) << (PIN_DT4 - 4)) | ((dat & (1 << 5)) << (PIN_DT5 - 5)) |
+                          ((dat & (1 << 6)) << (PIN_DT6 - 6)) | ((dat & (1 << 7)) << (PIN_DT7 - 7));
+
+    driven = (driven & ~data_pins) | data;
+    Publish();
+}
+
+bool GPIOBUS_Virtual::Reselect(int target_id, int initiator_id)
+{
+    if (actmode != mode_e::TARGET) {
+        return false;
+    }
+
+    // Arbitration requires a free bus
+    Acquire();
+    if (GetBSY() || GetSEL()) {
+        return false;
+    }
+
+    SetBSY(true);
+    SetDataMode(OUT);
+    SetDAT(static_cast<uint8_t>(1 << target_id));
+    SysTimer::SleepNsec(SCSI_DELAY_ARBITRATION_DELAY_NS);
+
+    // Arbitration is lost if a device with a higher ID or an initiator selecting another device is on the bus
+    if ((GetDAT() >> target_id) > 1 || GetSEL()) {
+        SetDAT(0);
+        SetDataMode(IN);
+        SetBSY(false);
+        return false;
+    }
+
+    // Reselection: SEL, I/O and the IDs of both devices, then BSY is released
+    SetMode(PIN_SEL, OUT);
+    SetSignal(PIN_SEL, true);
+    SetSignal(PIN_IO, true);
+    SetDAT(static_cast<uint8_t>((1 << target_id) | (1 << initiator_id)));
+    SysTimer::SleepNsec(SCSI_DELAY_BUS_SETTLE_DELAY_NS);
+    SetSignal(PIN_BSY, false);
+
+    // The initiator responds with BSY within the selection timeout recommended by SCSI-2
+    if (!WaitBusSignal(PIN_BSY, true, 250ms)) {
+        SetSignal(PIN_SEL, false);
+        SetMode(PIN_SEL, IN);
+        SetDAT(0);
+        SetDataMode(IN);
+        SetSignal(PIN_IO, false);
+        SetBSY(false);
+        return false;
+    }
+
+    // The target takes over BSY and ends the reselection by releasing SEL
+    SetSignal(PIN_BSY, true);
+    SetSignal(PIN_SEL, false);
+    SetMode(PIN_SEL, IN);
+    SetDAT(0);
 
-    PinSetSignal(PIN_DT0, (new_dat & ((byte)1 << 0)) != (byte)0);
-    PinSetSignal(PIN_DT1, (new_dat & ((byte)1 << 1)) != (byte)0);
-    PinSetSignal(PIN_DT2, (new_dat & ((byte)1 << 2)) != (byte)0);
-    PinSetSignal(PIN_DT3, (new_dat & ((byte)1 << 3)) != (byte)0);
-    PinSetSignal(PIN_DT4, (new_dat & ((byte)1 << 4)) != (byte)0);
-    PinSetSignal(PIN_DT5, (new_dat & ((byte)1 << 5)) != (byte)0);
-    PinSetSignal(PIN_DT6, (new_dat & ((byte)1 << 6)) != (byte)0);
-    PinSetSignal(PIN_DT7, (new_dat & ((byte)1 << 7)) != (byte)0);
+    return true;
+}
+
+void GPIOBUS_Virtual::SetDataMode(int mode)
+{
+    for (const int pin : { PIN_DT0, PIN_DT1, PIN_DT2, PIN_DT3, PIN_DT4, PIN_DT5, PIN_DT6, PIN_DT7, PIN_DP }) {
+        SetMode(pin, mode);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -426,7 +567,6 @@ void GPIOBUS_Virtual::MakeTable(void)
 //---------------------------------------------------------------------------
 void GPIOBUS_Virtual::SetControl(int pin, bool ast)
 {
-    LOGTRACE("%s hwpin: %d", __PRETTY_FUNCTION__, (int)pin)
     PinSetSignal(pin, ast);
 }
 
@@ -437,9 +577,18 @@ void GPIOBUS_Virtual::SetControl(int pin, bool ast)
 //---------------------------------------------------------------------------
 void GPIOBUS_Virtual::SetMode(int hw_pin, int mode)
 {
-    // Doesn't do anything for virtual gpio bus
-    (void)hw_pin;
-    (void)mode;
+    if (hw_pin < 0) {
+        return;
+    }
+
+    // Only outputs drive the bus, an input does not contribute to the wired-OR
+    if (mode == OUT) {
+        output_pins |= 1 << hw_pin;
+    } else {
+        output_pins &= ~(1 << hw_pin);
+    }
+
+    Publish();
 }
 
 //---------------------------------------------------------------------------
@@ -451,21 +600,7 @@ bool GPIOBUS_Virtual::GetSignal(int hw_pin) const
 {
     GPIO_FUNCTION_TRACE
 
-    uint32_t signal_value = 0;
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_wait(mutex_sem) == -1) {
-        LOGERROR("Unable to lock the shared memory")
-        return false;
-    }
-#endif
-    signal_value = *signals;
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_post(mutex_sem) == -1) {
-        LOGERROR("Unable to release the shared memory")
-        return false;
-    }
-#endif
-    return (signal_value >> hw_pin) & 1;
+    return (GetBusSignals() >> hw_pin) & 1;
 }
 
 //---------------------------------------------------------------------------
@@ -498,31 +633,20 @@ void GPIOBUS_Virtual::EnableIRQ()
 //---------------------------------------------------------------------------
 void GPIOBUS_Virtual::PinSetSignal(int hw_pin, bool ast)
 {
-    LOGTRACE("%s hwpin: %d", __PRETTY_FUNCTION__, (int)hw_pin)
-
     // Check for invalid pin
     if (hw_pin < 0) {
         return;
     }
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_wait(mutex_sem) == -1) {
-        LOGERROR("Unable to lock the shared memory")
-        return;
-    }
-#endif
+
     if (ast) {
         // Set the "gpio" bit
-        *signals |= 0x1 << hw_pin;
+        driven |= 1 << hw_pin;
     } else {
         // Clear the "gpio" bit
-        *signals ^= ~(0x1 << hw_pin);
-    }
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_post(mutex_sem) == -1) {
-        LOGERROR("Unable to release the shared memory")
-        return;
+        driven &= ~(1 << hw_pin);
     }
-#endif
+
+    Publish();
 }
 
 //---------------------------------------------------------------------------
@@ -540,20 +664,141 @@ uint32_t GPIOBUS_Virtual::Acquire()
 {
     GPIO_FUNCTION_TRACE;
 
-    uint32_t signal_value = 0;
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_wait(mutex_sem) == -1) {
-        LOGERROR("Unable to lock the shared memory")
-        return false;
+    signals = GetBusSignals();
+
+    return signals;
+}
+
+bool GPIOBUS_Virtual::WaitBusSignal(int pin, bool ast, chrono::nanoseconds timeout)
+{
+    // By default wait up to 3 s, like GPIOBUS::WaitSignal()
+    const Deadline deadline(timeout);
+
+    const Deadline spin_deadline(SPIN_TIME);
+    while (true) {
+        // The generation has to be read before the signals, otherwise a change in between would be missed
+        const uint32_t generation = shared_bus->generation;
+        const uint32_t value      = GetBusSignals();
+
+        if (static_cast<bool>((value >> pin) & 1) == ast) {
+            return true;
+        }
+
+        // Abort on a reset
+        if ((value >> PIN_RST) & 1) {
+            return false;
+        }
+
+        if (deadline.IsExpired()) {
+            return false;
+        }
+
+        if (!spin || spin_deadline.IsExpired()) {
+            WaitForChange(generation);
+        }
+    }
+}
+
+uint32_t GPIOBUS_Virtual::GetBusSignals() const
+{
+    // The board control signals are not shared
+    uint32_t value = driven & ~scsi_pins;
+
+    if (shared_bus != nullptr) {
+        for (const auto &d : shared_bus->drivers) {
+            value |= d;
+        }
+    }
+
+    return value;
+}
+
+void GPIOBUS_Virtual::Publish()
+{
+    if (shared_bus == nullptr) {
+        return;
     }
+
+    if (const uint32_t value = driven & output_pins & scsi_pins; shared_bus->drivers[slot].exchange(value) != value) {
+        shared_bus->generation++;
+        WakeUp();
+    }
+}
+
+bool GPIOBUS_Virtual::PollSelectEvent()
+{
+    const Deadline deadline(WAIT_SLICE);
+
+    do {
+        // Sampled before the bus is checked, i.e. a change after the check ends the wait immediately
+        const uint32_t generation = shared_bus->generation;
+
+        Acquire();
+        if (GetSEL()) {
+            return true;
+        }
+
+        // The caller stops waiting if the wait was interrupted by a signal
+        errno = 0;
+        WaitForChange(generation);
+        if (errno == EINTR) {
+            return false;
+        }
+    } while (!deadline.IsExpired());
+
+    return false;
+}
+
+void GPIOBUS_Virtual::WaitForChange(uint32_t generation) const
+{
+    shared_bus->waiters++;
+#ifdef __linux__
+    // Returns immediately if the generation has already changed
+    constexpr timespec timeout = { .tv_sec = 0, .tv_nsec = chrono::nanoseconds(WAIT_SLICE).count() };
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&shared_bus->generation), FUTEX_WAIT, generation, &timeout,
+            nullptr, 0);
+#else
+    (void)generation;
+    sched_yield();
 #endif
-    signal_value = *signals;
-#ifdef SHARED_MEMORY_GPIO
-    if (sem_post(mutex_sem) == -1) {
-        LOGERROR("Unable to release the shared memory")
-        return false;
+    shared_bus->waiters--;
+}
+
+void GPIOBUS_Virtual::WakeUp() const
+{
+#ifdef __linux__
+    // Avoid the system call as long as nobody is waiting
+    if (shared_bus->waiters) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&shared_bus->generation), FUTEX_WAKE, INT_MAX, nullptr,
+                nullptr, 0);
     }
 #endif
-    return signal_value;
 }
 
+uint32_t GPIOBUS_Virtual::GetScsiPins()
+{
+    uint32_t pins = 0;
+    for (int i = 0; SignalTable[i] >= 0; i++) {
+        pins |= 1 << SignalTable[i];
+    }
+
+    return pins;
+}
+
+string GPIOBUS_Virtual::GetSharedMemoryName()
+{
+    const char *name = getenv(SHARED_MEMORY_ENV.c_str());
+
+    // POSIX shared memory object names start with a slash
+    if (name == nullptr || !*name) {
+        return "";
+    }
+
+    if (name[0] == '/') {
+        return name;
+    }
+
+    string shm_name = "/";
+    shm_name += name;
+    return shm_name;
+}
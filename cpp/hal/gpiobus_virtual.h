@@ -14,20 +14,29 @@
 #include "hal/gpiobus.h"
 #include "shared/scsi.h"
 
+#include <atomic>
+#include <chrono>
 #include <map>
-#include <semaphore.h>
+#include <string>
 
 //---------------------------------------------------------------------------
 //
 //	Class definition
 //
+//	Without a name the bus only exists in the current process. With a name the bus is a POSIX shared memory
+//	object, which lets piscsi in target mode and an initiator like scsidump talk to each other without any
+//	SCSI hardware. Like with a real SCSI bus each signal is the wired-OR of what all participants drive, and
+//	a participant only drives the signals it has configured as outputs.
+//
 //---------------------------------------------------------------------------
 class GPIOBUS_Virtual final : public GPIOBUS
 {
   public:
     // Basic Functions
-    GPIOBUS_Virtual()           = default;
-    ~GPIOBUS_Virtual() override = default;
+    explicit GPIOBUS_Virtual(const string &name = "") : shared_memory_name(name)
+    {
+    }
+    ~GPIOBUS_Virtual() override;
     // Destructor
     bool Init(mode_e mode = mode_e::TARGET) override;
 
@@ -99,17 +108,35 @@ class GPIOBUS_Virtual final : public GPIOBUS
 
     bool WaitREQ(bool ast) override
     {
-        return WaitSignal(PIN_REQ, ast);
+        return WaitBusSignal(PIN_REQ, ast);
     }
     bool WaitACK(bool ast) override
     {
-        return WaitSignal(PIN_ACK, ast);
+        return WaitBusSignal(PIN_ACK, ast);
     }
 
     uint8_t GetDAT() override;
     // Get DAT signal
     void SetDAT(uint8_t dat) override;
     // Set DAT signal
+
+    bool CanReselect() const override
+    {
+        return actmode == mode_e::TARGET;
+    }
+    bool Reselect(int, int) override;
+
+    // There are no SEL edge events, a change of the bus state is awaited instead. Returns false if SEL has not been
+    // asserted after some time, in order to let the caller check whether to continue waiting.
+    bool PollSelectEvent() override;
+
+    // The name of the shared memory object for the environment variable below, empty if not set
+    static string GetSharedMemoryName();
+
+    inline static const string SHARED_MEMORY_ENV = "PISCSI_VIRTUAL_BUS";
+
+    static const int MAX_PARTICIPANTS = 8;
+
   private:
     // SCSI I/O signal control
     void MakeTable() override;
@@ -122,6 +149,8 @@ class GPIOBUS_Virtual final : public GPIOBUS
     // Get SCSI input signal value
     void SetSignal(int pin, bool ast) override;
     // Wait for a signal to change
+    bool WaitBusSignal(int pin, bool ast, chrono::nanoseconds = 3s);
+    void SetDataMode(int);
     // Interrupt control
     void DisableIRQ() override;
     // IRQ Disabled
@@ -146,19 +175,66 @@ class GPIOBUS_Virtual final : public GPIOBUS
     void DrvConfig(uint32_t drive) override;
     // Set GPIO drive strength
 
-    array<int, 19> SignalTable;
-    shared_ptr<uint32_t> signals; // All bus signals
-
     unique_ptr<DataSample> GetSample(uint64_t timestamp) override
     {
-        return make_unique<DataSample_Raspberry>(*signals, timestamp);
+        return make_unique<DataSample_Raspberry<>>(signals, timestamp);
     }
 
-#ifdef SHARED_MEMORY_GPIO
-    inline static const string SHARED_MEM_MUTEX_NAME = "/sem-mutex";
-    inline static const string SHARED_MEM_NAME       = "/posix-shared-mem-example";
+    BusTracer::decoder GetSampleDecoder() const override
+    {
+        return [](uint32_t s, uint64_t timestamp) -> unique_ptr<DataSample> {
+            return make_unique<DataSample_Raspberry<>>(s, timestamp);
+        };
+    }
 
-    sem_t *mutex_sem, *buffer_count_sem, *spool_signal_sem;
-    int fd_shm, fd_log;
-#endif
+    // The state of the bus, either in shared memory or local
+    struct shared_bus_t {
+        // Incremented on each signal change, the participants wait for changes with a futex on this counter
+        atomic<uint32_t> generation;
+        // The number of participants sleeping on the futex, there is no wakeup call without sleepers
+        atomic<uint32_t> waiters;
+        // The process IDs of the participants, 0 for an unused slot
+        array<atomic<int32_t>, MAX_PARTICIPANTS> pids;
+        // The SCSI signals driven by each participant
+        array<atomic<uint32_t>, MAX_PARTICIPANTS> drivers;
+    };
+    static_assert(atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock-free atomics");
+
+    bool ClaimSlot();
+    // Releases the slots of the participants that terminated without a cleanup, e.g. after a crash
+    void ReleaseDeadSlots();
+    // Updates the signals this participant drives on the bus
+    void Publish();
+    uint32_t GetBusSignals() const;
+    void WaitForChange(uint32_t) const;
+    void WakeUp() const;
+
+    static uint32_t GetScsiPins();
+
+    const string shared_memory_name;
+
+    shared_bus_t *shared_bus = nullptr;
+    unique_ptr<shared_bus_t> local_bus;
+
+    // This participant's slot in the shared state
+    int slot = -1;
+
+    // All signals set by this participant, and the pins configured as outputs
+    uint32_t driven = 0;
+    uint32_t output_pins = 0;
+
+    // Only the SCSI signals are shared, the board control signals (ACT, ENB etc.) are local
+    const uint32_t scsi_pins = GetScsiPins();
+
+    // The signals of the most recent Acquire()
+    uint32_t signals = 0;
+
+    // The other participant usually responds within a few us, which is shorter than a futex wakeup.
+    // With a single CPU spinning is useless, because the other participant cannot run in the meantime.
+    static constexpr chrono::microseconds SPIN_TIME = 20us;
+    bool spin = false;
+    static constexpr chrono::milliseconds WAIT_SLICE = 100ms;
+
+    static constexpr array<int, 19> SignalTable = { PIN_DT0, PIN_DT1, PIN_DT2, PIN_DT3, PIN_DT4, PIN_DT5, PIN_DT6,
+            PIN_DT7, PIN_DP, PIN_SEL, PIN_ATN, PIN_RST, PIN_ACK, PIN_BSY, PIN_MSG, PIN_CD, PIN_IO, PIN_REQ, -1 };
 };
@@ -0,0 +1,116 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Per-transfer timing totals of the target mode handshakes. The time spent waiting for ACK is spent by the
+// initiator, the remaining time is spent by the target. Recording costs a few counter reads per byte and
+// nothing but a branch when disabled.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/deadline.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+class HandshakeTiming
+{
+  public:
+    // All times are in counter ticks, see TickCounter
+    struct totals_t {
+        uint32_t bytes;
+        uint64_t ack_assert_ticks;
+        uint64_t ack_deassert_ticks;
+        // Bus settle delays and deliberate delays, e.g. for the DaynaPort
+        uint64_t delay_ticks;
+        uint64_t slowest_byte_ticks;
+        // From the start of the first byte to the end of the last byte
+        uint64_t total_ticks;
+    };
+
+    HandshakeTiming()  = default;
+    ~HandshakeTiming() = default;
+
+    void SetEnabled(bool b)
+    {
+        enabled = b;
+    }
+    bool IsEnabled() const
+    {
+        return enabled;
+    }
+
+    void StartTransfer()
+    {
+        totals = {};
+        if (enabled) {
+            transfer_start = TickCounter::Now();
+            last           = transfer_start;
+        }
+    }
+    void EndTransfer()
+    {
+        if (enabled) {
+            totals.total_ticks = last - transfer_start;
+        }
+    }
+
+    void StartByte()
+    {
+        if (enabled) {
+            byte_start = TickCounter::Now();
+            last       = byte_start;
+        }
+    }
+    void EndByte()
+    {
+        if (enabled) {
+            totals.bytes++;
+            totals.slowest_byte_ticks = max(totals.slowest_byte_ticks, last - byte_start);
+        }
+    }
+
+    // Each of these methods attributes the time since the previous event to its category
+    void AckAsserted()
+    {
+        Record(totals.ack_assert_ticks);
+    }
+    void AckDeasserted()
+    {
+        Record(totals.ack_deassert_ticks);
+    }
+    void Delayed()
+    {
+        Record(totals.delay_ticks);
+    }
+
+    // The totals of the most recent transfer
+    const totals_t &GetTotals() const
+    {
+        return totals;
+    }
+
+  private:
+    void Record(uint64_t &ticks)
+    {
+        if (enabled) {
+            const uint64_t now = TickCounter::Now();
+            ticks += now - last;
+            last = now;
+        }
+    }
+
+    bool enabled = false;
+
+    totals_t totals = {};
+
+    uint64_t transfer_start = 0;
+    uint64_t byte_start     = 0;
+    uint64_t last           = 0;
+};
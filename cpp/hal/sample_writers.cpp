@@ -0,0 +1,151 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2020-2021 akuker
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/bus.h"
+#include "hal/sample_writers.h"
+#include <spdlog/spdlog.h>
+#include <ctime>
+
+using namespace std;
+
+// Symbol definition for the VCD file
+// These are just arbitrary symbols. They can be anything allowed by the VCD file format,
+// as long as they're consistently used.
+const char SYMBOL_PIN_DAT   = '#';
+const char SYMBOL_PIN_ATN   = '+';
+const char SYMBOL_PIN_RST   = '$';
+const char SYMBOL_PIN_ACK   = '%';
+const char SYMBOL_PIN_REQ   = '^';
+const char SYMBOL_PIN_MSG   = '&';
+const char SYMBOL_PIN_CD    = '*';
+const char SYMBOL_PIN_IO    = '(';
+const char SYMBOL_PIN_BSY   = ')';
+const char SYMBOL_PIN_SEL   = '-';
+const char SYMBOL_PIN_PHASE = '=';
+
+// The indices of the previous values
+enum vcd_value { PHASE, BSY, SEL, CD, IO, MSG, REQ, ACK, ATN, RST, DAT };
+
+void VcdWriter::WriteHeader()
+{
+    // Get the current time
+    time_t rawtime;
+    time(&rawtime);
+    struct tm timeinfo;
+    localtime_r(&rawtime, &timeinfo);
+    string timestamp;
+    timestamp.resize(256);
+    strftime(&timestamp[0], timestamp.size(), "%d-%m-%Y %H-%M-%S", &timeinfo);
+
+    out << "$date" << '\n'
+        << timestamp << '\n'
+        << "$end" << '\n'
+        << "$version" << '\n'
+        << "   VCD generator tool version info text." << '\n'
+        << "$end" << '\n'
+        << "$comment" << '\n'
+        << "   Tool build date:" << __TIMESTAMP__ << '\n'
+        << "$end" << '\n'
+        << "$timescale 1 ns $end" << '\n'
+        << "$scope module logic $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_BSY << " BSY $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_SEL << " SEL $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_CD << " CD $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_IO << " IO $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_MSG << " MSG $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_REQ << " REQ $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_ACK << " ACK $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_ATN << " ATN $end" << '\n'
+        << "$var wire 1 " << SYMBOL_PIN_RST << " RST $end" << '\n'
+        << "$var wire 8 " << SYMBOL_PIN_DAT << " data $end" << '\n'
+        << "$var string 1 " << SYMBOL_PIN_PHASE << " phase $end" << '\n'
+        << "$upscope $end" << '\n'
+        << "$enddefinitions $end" << '\n';
+
+    // Initial values - default to zeros
+    out << "$dumpvars" << '\n'
+        << "0" << SYMBOL_PIN_BSY << '\n'
+        << "0" << SYMBOL_PIN_SEL << '\n'
+        << "0" << SYMBOL_PIN_CD << '\n'
+        << "0" << SYMBOL_PIN_IO << '\n'
+        << "0" << SYMBOL_PIN_MSG << '\n'
+        << "0" << SYMBOL_PIN_REQ << '\n'
+        << "0" << SYMBOL_PIN_ACK << '\n'
+        << "0" << SYMBOL_PIN_ATN << '\n'
+        << "0" << SYMBOL_PIN_RST << '\n'
+        << "b00000000 " << SYMBOL_PIN_DAT << '\n'
+        << "$end" << '\n';
+}
+
+void VcdWriter::WriteSample(const DataSample &sample, uint64_t timestamp)
+{
+    out << "#" << timestamp << '\n';
+    WriteIfChanged(sample.GetBSY(), BSY, SYMBOL_PIN_BSY);
+    WriteIfChanged(sample.GetSEL(), SEL, SYMBOL_PIN_SEL);
+    WriteIfChanged(sample.GetCD(), CD, SYMBOL_PIN_CD);
+    WriteIfChanged(sample.GetIO(), IO, SYMBOL_PIN_IO);
+    WriteIfChanged(sample.GetMSG(), MSG, SYMBOL_PIN_MSG);
+    WriteIfChanged(sample.GetREQ(), REQ, SYMBOL_PIN_REQ);
+    WriteIfChanged(sample.GetACK(), ACK, SYMBOL_PIN_ACK);
+    WriteIfChanged(sample.GetATN(), ATN, SYMBOL_PIN_ATN);
+    WriteIfChanged(sample.GetRST(), RST, SYMBOL_PIN_RST);
+    WriteIfChanged(sample.GetDAT(), DAT, SYMBOL_PIN_DAT);
+    WriteIfChanged(sample.GetPhase(), PHASE, SYMBOL_PIN_PHASE);
+}
+
+void VcdWriter::WriteIfChanged(bool data, int index, char symbol)
+{
+    if (prev_values[index] != data) {
+        prev_values[index] = data;
+        out << data << symbol << '\n';
+    }
+}
+
+void VcdWriter::WriteIfChanged(uint8_t data, int index, char symbol)
+{
+    if (prev_values[index] != data) {
+        prev_values[index] = data;
+        out << "b" << fmt::format("{0:b}", data) << " " << symbol << '\n';
+    }
+}
+
+void VcdWriter::WriteIfChanged(phase_t data, int index, char symbol)
+{
+    if (prev_values[index] != static_cast<uint8_t>(data)) {
+        prev_values[index] = static_cast<uint8_t>(data);
+        out << "s" << BUS::GetPhaseStrRaw(data) << " " << symbol << '\n';
+    }
+}
+
+void JsonWriter::WriteHeader()
+{
+    out << "[" << '\n';
+}
+
+void JsonWriter::WriteSample(const DataSample &sample)
+{
+    // The separator of the previous sample, there is none after the last sample
+    if (count) {
+        out << "," << '\n';
+    }
+
+    out << fmt::format("{{\"id\": \"{0:d}\", \"timestamp\":\"{1:#016x}\", \"data\":\"{2:#08x}\"}}", count,
+                       sample.GetTimestamp(), sample.GetRawCapture());
+
+    count++;
+}
+
+void JsonWriter::WriteFooter()
+{
+    if (count) {
+        out << '\n';
+    }
+    out << "]" << '\n';
+}
@@ -0,0 +1,58 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2020-2021 akuker
+// Copyright (C) 2023 Uwe Seimet
+//
+// Streaming writers for the Value Change Dump and JSON formats of scsimon. Each sample is written as soon as
+// it is available, so that long captures do not have to be kept in memory.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/data_sample.h"
+#include <array>
+#include <ostream>
+
+using namespace std;
+
+class VcdWriter
+{
+  public:
+    explicit VcdWriter(ostream &out) : out(out) {}
+    ~VcdWriter() = default;
+
+    void WriteHeader();
+    // The timestamp is in ns
+    void WriteSample(const DataSample &, uint64_t);
+
+  private:
+    void WriteIfChanged(bool, int, char);
+    void WriteIfChanged(uint8_t, int, char);
+    void WriteIfChanged(phase_t, int, char);
+
+    ostream &out;
+
+    // The phase is initially unknown, i.e. it is always written for the first sample
+    array<uint8_t, 11> prev_values = {0xff};
+};
+
+class JsonWriter
+{
+  public:
+    explicit JsonWriter(ostream &out) : out(out) {}
+    ~JsonWriter() = default;
+
+    void WriteHeader();
+    // The raw capture and the timestamp of the sample, which scsimon can import
+    void WriteSample(const DataSample &);
+    void WriteFooter();
+
+  private:
+    ostream &out;
+
+    uint64_t count = 0;
+};
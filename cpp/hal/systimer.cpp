@@ -13,6 +13,7 @@
 
 #include "hal/systimer.h"
 #include "hal/systimer_raspberry.h"
+#include "hal/systimer_generic.h"
 #include <spdlog/spdlog.h>
 
 #include "hal/gpiobus.h"
@@ -32,6 +33,9 @@ void SysTimer::Init()
             systimer_ptr = make_unique<SysTimer_Raspberry>();
             is_raspberry = true;
         }
+        else {
+            systimer_ptr = make_unique<SysTimer_Generic>();
+        }
         systimer_ptr->Init();
         initialized = true;
     }
@@ -0,0 +1,42 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/deadline.h"
+#include "hal/systimer_generic.h"
+
+using namespace std;
+
+void SysTimer_Generic::Init()
+{
+    ticks_per_us = max(TickCounter::GetFrequency() / 1'000'000, static_cast<uint64_t>(1));
+}
+
+// Like the Raspberry Pi system timer this is a free running 32 bit microsecond counter
+uint32_t SysTimer_Generic::GetTimerLow()
+{
+    return static_cast<uint32_t>(TickCounter::Now() / ticks_per_us);
+}
+
+void SysTimer_Generic::SleepNsec(uint32_t nsec)
+{
+    if (nsec) {
+        const Deadline deadline{chrono::nanoseconds(nsec)};
+        while (!deadline.IsExpired())
+            ;
+    }
+}
+
+void SysTimer_Generic::SleepUsec(uint32_t usec)
+{
+    if (usec) {
+        const Deadline deadline{chrono::microseconds(usec)};
+        while (!deadline.IsExpired())
+            ;
+    }
+}
@@ -0,0 +1,29 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// System timer for platforms without the Raspberry Pi timer peripherals, based on the HAL tick counter
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/systimer.h"
+
+class SysTimer_Generic : public PlatformSpecificTimer
+{
+  public:
+    SysTimer_Generic()           = default;
+    ~SysTimer_Generic() override = default;
+
+    void Init() override;
+    uint32_t GetTimerLow() override;
+    void SleepNsec(uint32_t nsec) override;
+    void SleepUsec(uint32_t usec) override;
+
+  private:
+    uint64_t ticks_per_us = 1;
+};
@@ -0,0 +1,195 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Powered by XM6 TypeG Technology.
+// Copyright (C) 2016-2020 GIMONS
+// Copyright (C) 2022 akuker
+// Copyright (C) 2022-2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+// TODO Send IDENTIFY message in order to support LUNS > 7
+
+#include "hal/systimer.h"
+#include "initiator/initiator_executor.h"
+#include <spdlog/spdlog.h>
+#include <array>
+#include <ctime>
+
+using namespace std;
+using namespace spdlog;
+
+int InitiatorExecutor::Execute(scsi_command cmd, span<uint8_t> cdb, span<uint8_t> buffer, int length)
+{
+	spdlog::debug(string("Executing ") + GetCommandDescriptor(cmd).name);
+
+	byte_count = 0;
+
+	Selection();
+
+	try {
+		Command(cmd, cdb);
+
+		// The target determines the phase sequence, e.g. there is no data phase in case of a CHECK CONDITION
+		int status = -1;
+		while (true) {
+			switch (const phase_t phase = WaitForRequest(); phase) {
+				case phase_t::datain:
+					DataIn(buffer, length);
+					break;
+
+				case phase_t::dataout:
+					DataOut(buffer, length);
+					break;
+
+				case phase_t::status:
+					status = Status();
+					break;
+
+				case phase_t::msgin:
+					MessageIn();
+					BusFree();
+					return status;
+
+				default:
+					throw phase_exception(string("Unexpected ") + BUS::GetPhaseStrRaw(phase) + " phase");
+			}
+		}
+	}
+	catch (const phase_exception&) {
+		BusFree();
+
+		throw;
+	}
+}
+
+void InitiatorExecutor::ResetBus() const
+{
+	bus.SetRST(true);
+	const timespec ts = { .tv_sec = 0, .tv_nsec = 1000 * 1000 };
+	nanosleep(&ts, nullptr);
+	bus.SetRST(false);
+}
+
+void InitiatorExecutor::Selection() const
+{
+	// Set initiator and target ID
+	auto data = static_cast<byte>(1 << initiator_id);
+	data |= static_cast<byte>(1 << target_id);
+	bus.SetDAT(static_cast<uint8_t>(data));
+
+	bus.SetSEL(true);
+
+	try {
+		WaitForBusy();
+	}
+	catch (const phase_exception&) {
+		bus.SetSEL(false);
+
+		throw;
+	}
+
+	bus.SetSEL(false);
+}
+
+void InitiatorExecutor::Command(scsi_command cmd, span<uint8_t> cdb) const
+{
+	if (WaitForRequest() != phase_t::command) {
+		throw phase_exception(string("Expected COMMAND phase, actual phase is ") + BUS::GetPhaseStrRaw(bus.GetPhase()));
+	}
+
+	cdb[0] = static_cast<uint8_t>(cmd);
+	cdb[1] = static_cast<uint8_t>(static_cast<byte>(cdb[1]) | static_cast<byte>(target_lun << 5));
+	if (static_cast<int>(cdb.size()) != bus.SendHandShake(cdb.data(), static_cast<int>(cdb.size()), BUS::SEND_NO_DELAY)) {
+		throw phase_exception(string(GetCommandDescriptor(cmd).name) + " failed");
+	}
+}
+
+void InitiatorExecutor::DataIn(span<uint8_t> buffer, int length)
+{
+	if (byte_count >= length) {
+		throw phase_exception("DATA IN exceeds " + to_string(length) + " byte(s)");
+	}
+
+	const int count = bus.ReceiveHandShake(buffer.data() + byte_count, length - byte_count);
+	if (!count) {
+		throw phase_exception("DATA IN failed");
+	}
+
+	byte_count += count;
+}
+
+void InitiatorExecutor::DataOut(span<uint8_t> buffer, int length)
+{
+	if (byte_count >= length) {
+		throw phase_exception("DATA OUT exceeds " + to_string(length) + " byte(s)");
+	}
+
+	const int count = bus.SendHandShake(buffer.data() + byte_count, length - byte_count, BUS::SEND_NO_DELAY);
+	if (!count) {
+		throw phase_exception("DATA OUT failed");
+	}
+
+	byte_count += count;
+}
+
+int InitiatorExecutor::Status() const
+{
+	if (array<uint8_t, 1> buf; bus.ReceiveHandShake(buf.data(), 1) == 1) {
+		return buf[0];
+	}
+
+	throw phase_exception("STATUS failed");
+}
+
+void InitiatorExecutor::MessageIn() const
+{
+	if (array<uint8_t, 1> buf; bus.ReceiveHandShake(buf.data(), 1) != 1) {
+		throw phase_exception("MESSAGE IN failed");
+	}
+}
+
+void InitiatorExecutor::BusFree() const
+{
+	bus.Reset();
+}
+
+phase_t InitiatorExecutor::WaitForRequest() const
+{
+	// Timeout (3000 ms)
+	const uint32_t now = SysTimer::GetTimerLow();
+	while ((SysTimer::GetTimerLow() - now) < 3'000'000) {
+		bus.Acquire();
+		if (bus.GetREQ()) {
+			return bus.GetPhase();
+		}
+
+		if (!bus.GetBSY()) {
+			throw phase_exception("Target released the bus");
+		}
+	}
+
+	throw phase_exception("Timeout waiting for REQ, actual phase is " + string(BUS::GetPhaseStrRaw(bus.GetPhase())));
+}
+
+void InitiatorExecutor::WaitForBusy() const
+{
+	// Wait for busy for up to 2 s
+	int count = 10000;
+	do {
+		// Wait 20 us
+		const timespec ts = { .tv_sec = 0, .tv_nsec = 20 * 1000 };
+		nanosleep(&ts, nullptr);
+		bus.Acquire();
+		if (bus.GetBSY()) {
+			break;
+		}
+	} while (count--);
+
+	// Success if the target is busy
+	if (!bus.GetBSY()) {
+		throw phase_exception("SELECTION failed");
+	}
+}
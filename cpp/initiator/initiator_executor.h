@@ -0,0 +1,68 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Executes SCSI commands as an initiator, i.e. drives the SCSI phases of a command from the initiator side.
+// This is the common initiator stack of scsidump and scsibench.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/bus.h"
+#include "shared/scsi.h"
+#include <span>
+#include <stdexcept>
+
+using namespace std;
+using namespace scsi_defs;
+
+class phase_exception : public runtime_error
+{
+	using runtime_error::runtime_error;
+};
+
+class InitiatorExecutor
+{
+
+public:
+
+	InitiatorExecutor(BUS& bus, int id) : bus(bus), initiator_id(id) {}
+	~InitiatorExecutor() = default;
+
+	void SetTarget(int id, int lun) { target_id = id; target_lun = lun; }
+
+	// Executes a command with a data phase of up to length bytes from/to the buffer and returns the status byte.
+	// Throws a phase_exception if the target does not respond as expected.
+	int Execute(scsi_command, span<uint8_t>, span<uint8_t>, int);
+
+	// The number of bytes transferred in the data phase of the most recent command
+	int GetByteCount() const { return byte_count; }
+
+	// Asserts RST for 1 ms
+	void ResetBus() const;
+
+private:
+
+	void Selection() const;
+	void Command(scsi_command, span<uint8_t>) const;
+	void DataIn(span<uint8_t>, int);
+	void DataOut(span<uint8_t>, int);
+	int Status() const;
+	void MessageIn() const;
+	void BusFree() const;
+	phase_t WaitForRequest() const;
+	void WaitForBusy() const;
+
+	BUS& bus;
+
+	int initiator_id;
+
+	int target_id = -1;
+	int target_lun = 0;
+
+	int byte_count = 0;
+};
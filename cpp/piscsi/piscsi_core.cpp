@@ -16,8 +16,10 @@
 #include "shared/piscsi_exceptions.h"
 #include "shared/piscsi_version.h"
 #include "controllers/scsi_controller.h"
+#include "controllers/command_queue.h"
 #include "devices/device_logger.h"
 #include "devices/storage_device.h"
+#include "hal/deadline.h"
 #include "hal/gpiobus_factory.h"
 #include "hal/gpiobus.h"
 #include "piscsi/piscsi_core.h"
@@ -28,7 +30,6 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <chrono>
 
 using namespace std;
 using namespace filesystem;
@@ -40,8 +41,7 @@ using namespace scsi_defs;
 
 void Piscsi::Banner(span<char *> args) const
 {
-	cout << piscsi_util::Banner("(Backend Service)");
-	cout << "Connection type: " << CONNECT_DESC << '\n' << flush;
+	cout << piscsi_util::Banner("(Backend Service)") << flush;
 
 	if ((args.size() > 1 && strcmp(args[1], "-h") == 0) || (args.size() > 1 && strcmp(args[1], "--help") == 0)){
 		cout << "\nUsage: " << args[0] << " [-idID[:LUN] FILE] ...\n\n"
@@ -58,11 +58,13 @@ void Piscsi::Banner(span<char *> args) const
 
 bool Piscsi::InitBus()
 {
-	bus = GPIOBUS_Factory::Create(BUS::mode_e::TARGET);
+	bus = GPIOBUS_Factory::Create(BUS::mode_e::TARGET, connection_type);
 	if (bus == nullptr) {
 		return false;
 	}
 
+	bus->GetHandshakeTiming().SetEnabled(handshake_timing);
+
 	executor = make_unique<PiscsiExecutor>(*bus, controller_manager);
 
 	return true;
@@ -74,12 +76,24 @@ void Piscsi::CleanUp()
 		service.Stop();
 	}
 
+	controller_manager.GetIdleScheduler().Stop();
+
 	executor->DetachAll();
 
+	// Keep what adaptive delay profiles have learned
+	if (!delay_profiles_file.empty()) {
+		if (const string error = controller_manager.GetDelayProfiles().Save(delay_profiles_file); !error.empty()) {
+			spdlog::warn(error);
+		}
+	}
+
 	// TODO Check why there are rare cases where bus is NULL on a remote interface shutdown
 	// even though it is never set to NULL anywhere
 	assert(bus);
 	if (bus) {
+		// Write the remaining samples
+		bus->StopTrace();
+
 		bus->Cleanup();
 	}
 }
@@ -127,9 +141,8 @@ void Piscsi::LogDevices(string_view devices) const
 
 void Piscsi::TerminationHandler(int)
 {
-	instance->CleanUp();
-
-	// Process will terminate automatically
+	// Only async-signal-safe operations are permitted, the bus thread cleans up when it has stopped
+	stop_requested = 1;
 }
 
 string Piscsi::ParseArguments(span<char *> args, PbCommand& command, int& port, string& reserved_ids)
@@ -147,7 +160,7 @@ string Piscsi::ParseArguments(span<char *> args, PbCommand& command, int& port,
 
 	opterr = 1;
 	int opt;
-	while ((opt = getopt(static_cast<int>(args.size()), args.data(), "-Iib:d:n:p:r:s:t:z:D:F:L:P:R:C:v")) != -1) {
+	while ((opt = getopt(static_cast<int>(args.size()), args.data(), "-Iib:c:d:l:mn:p:q:r:s:t:w:x:y:z:B:D:F:L:P:R:C:T:v")) != -1) {
 		switch (opt) {
 			// The two options below are kind of a compound option with two letters
 			case 'i':
@@ -201,6 +214,17 @@ string Piscsi::ParseArguments(span<char *> args, PbCommand& command, int& port,
 				ReadAccessToken(optarg);
 				continue;
 
+			case 'q':
+				{
+					int depth;
+					if (!GetAsUnsignedInt(optarg, depth) || depth > CommandQueue::MAX_DEPTH) {
+						throw parser_exception("Invalid queue depth " + string(optarg) + ", depth must be between 0 and " +
+								to_string(CommandQueue::MAX_DEPTH));
+					}
+					CommandQueue::SetMaxDepth(depth);
+				}
+				continue;
+
 			case 'r':
 				reserved_ids = optarg;
 				continue;
@@ -219,6 +243,71 @@ string Piscsi::ParseArguments(span<char *> args, PbCommand& command, int& port,
 				type = ParseDeviceType(optarg);
 				continue;
 
+			case 'B':
+				{
+					int size;
+					// The READ BUFFER descriptor has a 24 bit capacity field
+					if (!GetAsUnsignedInt(optarg, size) || size > 0xffffff) {
+						throw parser_exception("Invalid buffer size " + string(optarg));
+					}
+					AbstractController::SetDataBufferSize(size);
+				}
+				continue;
+
+			case 'c':
+				if (!GPIOBUS_Factory::IsValidConnectionType(optarg)) {
+					throw parser_exception("Invalid connection type '" + string(optarg) + "', valid types are " +
+							Join(GPIOBUS_Factory::GetConnectionTypes()));
+				}
+				connection_type = optarg;
+				continue;
+
+			case 'l':
+				{
+					int threshold;
+					if (!GetAsUnsignedInt(optarg, threshold)) {
+						throw parser_exception("Invalid selection warning threshold " + string(optarg));
+					}
+					controller_manager.GetSelectionStatistics().SetWarningThreshold(threshold);
+				}
+				continue;
+
+			case 'm':
+				handshake_timing = true;
+				continue;
+
+			case 'w':
+				if (const string error = select_waiter.SetMode(optarg); !error.empty()) {
+					throw parser_exception(error);
+				}
+				if (select_waiter.GetMode() != SelectWaiter::wait_mode::spin && !SelectWaiter::IsEventSupported()) {
+					throw parser_exception("Wait mode '" + string(optarg) + "' requires the PiSCSI hardware");
+				}
+				continue;
+
+			case 'x':
+				if (const string error = rt_profile.SetProfile(optarg); !error.empty()) {
+					throw parser_exception(error);
+				}
+				continue;
+
+			case 'y':
+				// A missing file is created as soon as a profile is set
+				delay_profiles_file = optarg;
+				if (exists(path(delay_profiles_file))) {
+					if (const string error = controller_manager.GetDelayProfiles().Load(delay_profiles_file);
+							!error.empty()) {
+						throw parser_exception(error);
+					}
+				}
+				continue;
+
+			case 'T':
+				if (!controller_manager.GetCommandRecorder().Open(optarg)) {
+					throw parser_exception("Can't open command recording file '" + string(optarg) + "'");
+				}
+				continue;
+
 			case 1:
 				// Encountered filename
 				break;
@@ -363,7 +452,8 @@ bool Piscsi::ExecuteCommand(const CommandContext& context)
 
 		case SERVER_INFO:
 			response.GetServerInfo(*result.mutable_server_info(), command, controller_manager.GetAllDevices(),
-					executor->GetReservedIds(), piscsi_image.GetDefaultFolder(), piscsi_image.GetDepth());
+					controller_manager.GetMetrics(), executor->GetReservedIds(), piscsi_image.GetDefaultFolder(),
+					piscsi_image.GetDepth());
 			context.WriteSuccessResult(result);
 			break;
 
@@ -408,10 +498,22 @@ bool Piscsi::ExecuteCommand(const CommandContext& context)
 			return context.WriteSuccessResult(result);
 
 		case STATISTICS_INFO:
-			response.GetStatisticsInfo(*result.mutable_statistics_info(), controller_manager.GetAllDevices());
+			response.GetStatisticsInfo(*result.mutable_statistics_info(), controller_manager.GetAllDevices(),
+					controller_manager.GetMetrics());
 			context.WriteSuccessResult(result);
 			break;
 
+		case COMMAND_TRACE_INFO:
+			if (const string format = GetParam(command, "format"); !format.empty() && format != "raw" && format != "chrome") {
+				context.ReturnErrorStatus("Invalid command trace format '" + format + "'");
+			}
+			else {
+				response.GetCommandTraceInfo(*result.mutable_command_trace_info(), controller_manager.GetCommandTrace(),
+						format == "chrome");
+				context.WriteSuccessResult(result);
+			}
+			break;
+
 		case OPERATION_INFO:
 			response.GetOperationInfo(*result.mutable_operation_info(), piscsi_image.GetDepth());
 			return context.WriteSuccessResult(result);
@@ -420,6 +522,20 @@ bool Piscsi::ExecuteCommand(const CommandContext& context)
 			response.GetReservedIds(*result.mutable_reserved_ids_info(), executor->GetReservedIds());
 			return context.WriteSuccessResult(result);
 
+		case DELAY_PROFILES_INFO:
+			{
+				scoped_lock<mutex> lock(execution_locker);
+				response.GetDelayProfilesInfo(*result.mutable_delay_profiles_info(),
+						controller_manager.GetDelayProfiles().GetProfiles(ScsiController::MIN_EXEC_TIME));
+			}
+			return context.WriteSuccessResult(result);
+
+		case DELAY_PROFILE:
+			return SetDelayProfile(context);
+
+		case BUS_TRACE:
+			return SetBusTrace(context);
+
 		case SHUT_DOWN:
 			return ShutDown(context, GetParam(command, "mode"));
 
@@ -457,6 +573,52 @@ bool Piscsi::ExecuteCommand(const CommandContext& context)
 	return true;
 }
 
+bool Piscsi::SetDelayProfile(const CommandContext& context)
+{
+	const PbCommand& command = context.GetCommand();
+
+	int id;
+	if (const string initiator_id = GetParam(command, "id"); !GetAsUnsignedInt(initiator_id, id)) {
+		return context.ReturnErrorStatus("Invalid initiator ID '" + initiator_id + "'");
+	}
+
+	const string profile = GetParam(command, "profile");
+
+	// The profiles are used by the bus thread while a command is being processed
+	scoped_lock<mutex> lock(execution_locker);
+
+	if (const string error = controller_manager.GetDelayProfiles().SetProfile(id, profile); !error.empty()) {
+		return context.ReturnErrorStatus(error);
+	}
+
+	spdlog::info("Delay profile of initiator ID " + to_string(id) + " set to '" + profile + "'");
+
+	if (!delay_profiles_file.empty()) {
+		if (const string error = controller_manager.GetDelayProfiles().Save(delay_profiles_file); !error.empty()) {
+			return context.ReturnErrorStatus(error);
+		}
+	}
+
+	return context.ReturnSuccessStatus();
+}
+
+bool Piscsi::SetBusTrace(const CommandContext& context)
+{
+	const string file = GetParam(context.GetCommand(), "file");
+
+	// The trace must not start or stop during a handshake
+	scoped_lock<mutex> lock(execution_locker);
+
+	if (file.empty()) {
+		bus->StopTrace();
+	}
+	else if (const string error = bus->StartTrace(file); !error.empty()) {
+		return context.ReturnErrorStatus(error);
+	}
+
+	return context.ReturnSuccessStatus();
+}
+
 bool Piscsi::ExecuteWithLock(const CommandContext& context)
 {
 	scoped_lock<mutex> lock(execution_locker);
@@ -503,12 +665,24 @@ int Piscsi::run(span<char *> args)
 		return EXIT_FAILURE;
 	}
 
+	// The connection type may have been selected with -c
+	cout << "Connection type: " << GPIOBUS_Factory::GetConnectionDescription(connection_type) << '\n' << flush;
+
 	if (!InitBus()) {
 		cerr << "Error: Can't initialize bus" << endl;
 
 		return EXIT_FAILURE;
 	}
 
+	// Queued commands are executed after reselecting the initiator
+	if (CommandQueue::GetMaxDepth() && !bus->CanReselect()) {
+		cerr << "Error: Tagged command queuing is not supported by this board, reselection is not possible" << endl;
+
+		CleanUp();
+
+		return EXIT_FAILURE;
+	}
+
 	if (const string error = service.Init([this] (CommandContext& context) {
 			context.SetDefaultFolder(piscsi_image.GetDefaultFolder());
 			return ExecuteCommand(context);
@@ -521,6 +695,17 @@ int Piscsi::run(span<char *> args)
 	}
 
 	spdlog::info("SCSI command execution time set to " + to_string(ScsiController::MIN_EXEC_TIME) + " microseconds");
+	spdlog::info("Selection wait mode: " + select_waiter.GetDescription());
+	if (const uint32_t threshold = controller_manager.GetSelectionStatistics().GetWarningThreshold(); threshold) {
+		spdlog::info("Selection response warning threshold set to " + to_string(threshold) + " microseconds");
+	}
+	if (CommandQueue::GetMaxDepth()) {
+		spdlog::info("Tagged command queuing enabled with a queue depth of " + to_string(CommandQueue::GetMaxDepth()));
+	}
+	if (AbstractController::GetDataBufferSize() != AbstractController::DEFAULT_DATA_BUFFER_SIZE) {
+		spdlog::info("READ BUFFER/WRITE BUFFER data buffer size set to " +
+				to_string(AbstractController::GetDataBufferSize()) + " bytes");
+	}
 
 	if (const string error = executor->SetReservedIds(reserved_ids); !error.empty()) {
 		cerr << "Error: " << error << endl;
@@ -551,7 +736,6 @@ int Piscsi::run(span<char *> args)
 	LogDevices(device_list);
 	cout << device_list << flush;
 
-	instance = this;
 	// Signal handler to detach all devices on a KILL or TERM signal
 	struct sigaction termination_handler;
 	termination_handler.sa_handler = TerminationHandler;
@@ -561,33 +745,81 @@ int Piscsi::run(span<char *> args)
 	sigaction(SIGTERM, &termination_handler, nullptr);
 	signal(SIGPIPE, SIG_IGN);
 
-    // Set the affinity to a specific processor core
-	FixCpu(3);
+	// The other threads inherit the blocked signals, i.e. only the bus thread receives them.
+	// This interrupts a blocking wait for a selection.
+	sigset_t termination_signals;
+	sigemptyset(&termination_signals);
+	sigaddset(&termination_signals, SIGINT);
+	sigaddset(&termination_signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &termination_signals, nullptr);
+
+	// Threads started by the bus thread inherit its CPU affinity
+	rt_profile.PrepareThreads();
+
+	controller_manager.GetCommandRecorder().Start();
 
 	service.Start();
 
+	controller_manager.GetIdleScheduler().Start();
+
+	rt_profile.PlaceBusThread();
+	for (const auto& line : rt_profile.GetLayout()) {
+		spdlog::info(line);
+	}
+
+	pthread_sigmask(SIG_UNBLOCK, &termination_signals, nullptr);
+
 	Process();
 
+	// Nothing the bus thread uses must be released while it is still processing
+	CleanUp();
+
+	switch (shutdown_mode) {
+	case AbstractController::piscsi_shutdown_mode::STOP_PI:
+		if (system("init 0") == -1) {
+			spdlog::error("Raspberry Pi shutdown failed");
+		}
+		break;
+
+	case AbstractController::piscsi_shutdown_mode::RESTART_PI:
+		if (system("init 6") == -1) {
+			spdlog::error("Raspberry Pi restart failed");
+		}
+		break;
+
+	default:
+		break;
+	}
+
 	return EXIT_SUCCESS;
 }
 
 void Piscsi::Process()
 {
-#ifdef USE_SEL_EVENT_ENABLE
-	// Scheduling policy setting (highest priority)
-	// TODO Check whether this results in any performance gain
-	sched_param schparam;
-	schparam.sched_priority = sched_get_priority_max(SCHED_FIFO);
-	sched_setscheduler(0, SCHED_FIFO, &schparam);
-#else
+#ifndef USE_SEL_EVENT_ENABLE
 	cout << "Note: No PiSCSI hardware support, only client interface calls are supported" << endl;
 #endif
 
 	// Main Loop
-	while (service.IsRunning()) {
-#ifdef USE_SEL_EVENT_ENABLE
-		// SEL signal polling
-		if (!bus->PollSelectEvent()) {
+	while (!stop_requested) {
+		uint64_t select_timestamp = 0;
+
+		// With queued commands the bus is polled without blocking, and they are executed while there is no selection.
+		// Selections take precedence, i.e. a queue fills up as long as the initiator has further commands.
+		if (controller_manager.HasQueuedCommands()) {
+			bus->Acquire();
+			if (!bus->GetSEL()) {
+				if (!bus->GetBSY()) {
+					ProcessQueuedCommand();
+				}
+				continue;
+			}
+		}
+		// Wait for SEL, the bus has been acquired when the wait succeeds
+		else if (select_waiter.Wait(*bus)) {
+			select_timestamp = select_waiter.GetSelectTimestamp();
+		}
+		else {
 			// Stop on interrupt
 			if (errno == EINTR) {
 				break;
@@ -595,29 +827,39 @@ void Piscsi::Process()
 			continue;
 		}
 
-		// Get the bus
-		bus->Acquire();
-#else
-		bus->Acquire();
-		if (!bus->GetSEL()) {
-			const timespec ts = { .tv_sec = 0, .tv_nsec = 0};
-			nanosleep(&ts, nullptr);
-			continue;
-		}
-#endif
+		// Background tasks must not delay the response to the selection
+		controller_manager.GetIdleScheduler().BusBusy();
 
 		// Only process the SCSI command if the bus is not busy and no other device responded
 		if (IsNotBusy() && bus->GetSEL()) {
 			scoped_lock<mutex> lock(execution_locker);
 
 			// Process command on the responsible controller based on the current initiator and target ID
-			if (const auto shutdown_mode = controller_manager.ProcessOnController(bus->GetDAT());
-				shutdown_mode != AbstractController::piscsi_shutdown_mode::NONE) {
+			if (const auto mode = controller_manager.ProcessOnController(bus->GetDAT(), select_timestamp);
+				mode != AbstractController::piscsi_shutdown_mode::NONE) {
 				// When the bus is free PiSCSI or the Pi may be shut down.
-				ShutDown(shutdown_mode);
+				ShutDown(mode);
 			}
 		}
+
+		controller_manager.GetIdleScheduler().BusFree();
+	}
+}
+
+void Piscsi::ProcessQueuedCommand()
+{
+	controller_manager.GetIdleScheduler().BusBusy();
+
+	{
+		scoped_lock<mutex> lock(execution_locker);
+
+		if (const auto mode = controller_manager.ProcessQueuedCommand();
+			mode != AbstractController::piscsi_shutdown_mode::NONE) {
+			ShutDown(mode);
+		}
 	}
+
+	controller_manager.GetIdleScheduler().BusFree();
 }
 
 // Shutdown on a remote interface command
@@ -653,36 +895,34 @@ bool Piscsi::ShutDown(const CommandContext& context, const string& m) {
 }
 
 // Shutdown on a SCSI command
-bool Piscsi::ShutDown(AbstractController::piscsi_shutdown_mode shutdown_mode)
+bool Piscsi::ShutDown(AbstractController::piscsi_shutdown_mode mode)
 {
-	switch(shutdown_mode) {
+	switch(mode) {
 	case AbstractController::piscsi_shutdown_mode::STOP_PISCSI:
 		spdlog::info("PiSCSI shutdown requested");
-		CleanUp();
-		return true;
+		break;
 
 	case AbstractController::piscsi_shutdown_mode::STOP_PI:
 		spdlog::info("Raspberry Pi shutdown requested");
-		CleanUp();
-		if (system("init 0") == -1) {
-			spdlog::error("Raspberry Pi shutdown failed");
-		}
 		break;
 
 	case AbstractController::piscsi_shutdown_mode::RESTART_PI:
 		spdlog::info("Raspberry Pi restart requested");
-		CleanUp();
-		if (system("init 6") == -1) {
-			spdlog::error("Raspberry Pi restart failed");
-		}
 		break;
 
 	case AbstractController::piscsi_shutdown_mode::NONE:
 		assert(false);
-		break;
+		return false;
 	}
 
-	return false;
+	// The cleanup and the shutdown of the Pi follow when the bus thread has stopped
+	shutdown_mode = mode;
+	stop_requested = 1;
+
+	// Wake up the bus thread if this is a remote interface command. The signal is only delivered to the bus thread.
+	kill(getpid(), SIGTERM);
+
+	return true;
 }
 
 bool Piscsi::IsNotBusy() const
@@ -690,8 +930,8 @@ bool Piscsi::IsNotBusy() const
     // Wait until BSY is released as there is a possibility for the
     // initiator to assert it while setting the ID (for up to 3 seconds)
     if (bus->GetBSY()) {
-        const auto now = chrono::steady_clock::now();
-        while ((chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - now).count()) < 3) {
+        const Deadline deadline(3s);
+        while (!deadline.IsExpired()) {
             bus->Acquire();
 
             if (!bus->GetBSY()) {
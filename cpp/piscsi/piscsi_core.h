@@ -15,9 +15,13 @@
 #include "piscsi/piscsi_image.h"
 #include "piscsi/piscsi_response.h"
 #include "piscsi/piscsi_executor.h"
+#include "piscsi/select_waiter.h"
+#include "piscsi/rt_profile.h"
 #include "generated/piscsi_interface.pb.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include <span>
+#include <atomic>
+#include <csignal>
 #include <string>
 #include <mutex>
 
@@ -47,12 +51,15 @@ private:
 	string ParseArguments(span<char *>, PbCommand&, int&, string&);
 	void Process();
 	bool IsNotBusy() const;
+	void ProcessQueuedCommand();
 
 	bool ShutDown(AbstractController::piscsi_shutdown_mode);
 	bool ShutDown(const CommandContext&, const string&);
 
 	bool ExecuteCommand(const CommandContext&);
 	bool ExecuteWithLock(const CommandContext&);
+	bool SetDelayProfile(const CommandContext&);
+	bool SetBusTrace(const CommandContext&);
 	bool HandleDeviceListChange(const CommandContext&, PbOperation) const;
 
 	bool SetLogLevel(const string&) const;
@@ -65,6 +72,15 @@ private:
 
 	string access_token;
 
+	// The delay profiles are persisted if set
+	string delay_profiles_file;
+
+	// Empty for the connection type the binary was built for
+	string connection_type;
+
+	// Records the per-byte handshake timings, see HandshakeStatistics
+	bool handshake_timing = false;
+
 	PiscsiImage piscsi_image;
 
 	[[no_unique_address]] PiscsiResponse response;
@@ -75,8 +91,15 @@ private:
 
 	ControllerManager controller_manager;
 
+	// Must be declared after the controller manager, which owns the registry of the statistics
+	SelectWaiter select_waiter { controller_manager.GetMetrics() };
+
+	RtProfile rt_profile;
+
 	unique_ptr<BUS> bus;
 
-	// Required for the termination handler
-	static inline Piscsi *instance;
+	// Set by the termination handler and on a shutdown request, the bus thread then stops processing commands
+	static inline volatile sig_atomic_t stop_requested = 0;
+
+	atomic<AbstractController::piscsi_shutdown_mode> shutdown_mode = AbstractController::piscsi_shutdown_mode::NONE;
 };
@@ -191,7 +191,7 @@ void PiscsiResponse::GetReservedIds(PbReservedIdsInfo& reserved_ids_info, const
 	}
 }
 
-void PiscsiResponse::GetDevices(const unordered_set<shared_ptr<PrimaryDevice>>& devices, PbServerInfo& server_info,
+void PiscsiResponse::GetDevices(const vector<shared_ptr<PrimaryDevice>>& devices, PbServerInfo& server_info,
 		const string& default_folder) const
 {
 	for (const auto& device : devices) {
@@ -200,7 +200,7 @@ void PiscsiResponse::GetDevices(const unordered_set<shared_ptr<PrimaryDevice>>&
 	}
 }
 
-void PiscsiResponse::GetDevicesInfo(const unordered_set<shared_ptr<PrimaryDevice>>& devices, PbResult& result,
+void PiscsiResponse::GetDevicesInfo(const vector<shared_ptr<PrimaryDevice>>& devices, PbResult& result,
 		const PbCommand& command, const string& default_folder) const
 {
 	set<id_set> id_sets;
@@ -233,8 +233,8 @@ void PiscsiResponse::GetDevicesInfo(const unordered_set<shared_ptr<PrimaryDevice
 }
 
 void PiscsiResponse::GetServerInfo(PbServerInfo& server_info, const PbCommand& command,
-		const unordered_set<shared_ptr<PrimaryDevice>>& devices, const unordered_set<int>& reserved_ids,
-		const string& default_folder, int scan_depth) const
+		const vector<shared_ptr<PrimaryDevice>>& devices, const MetricsRegistry& metrics,
+		const unordered_set<int>& reserved_ids, const string& default_folder, int scan_depth) const
 {
 	const vector<string> command_operations = Split(GetParam(command, "operations"), ',');
 	set<string, less<>> operations;
@@ -274,7 +274,7 @@ void PiscsiResponse::GetServerInfo(PbServerInfo& server_info, const PbCommand& c
 	}
 
 	if (HasOperation(operations, PbOperation::STATISTICS_INFO)) {
-		GetStatisticsInfo(*server_info.mutable_statistics_info(), devices);
+		GetStatisticsInfo(*server_info.mutable_statistics_info(), devices, metrics);
 	}
 
 	if (HasOperation(operations, PbOperation::DEVICES_INFO)) {
@@ -321,18 +321,55 @@ void PiscsiResponse::GetMappingInfo(PbMappingInfo& mapping_info) const
 }
 
 void PiscsiResponse::GetStatisticsInfo(PbStatisticsInfo& statistics_info,
-		const unordered_set<shared_ptr<PrimaryDevice>>& devices) const
+		const vector<shared_ptr<PrimaryDevice>>& devices, const MetricsRegistry& metrics) const
 {
 	for (const auto& device : devices) {
 		for (const auto& statistics : device->GetStatistics()) {
-			auto s = statistics_info.add_statistics();
-			s->set_id(statistics.id());
-			s->set_unit(statistics.unit());
-			s->set_category(statistics.category());
-			s->set_key(statistics.key());
-			s->set_value(statistics.value());
+			*statistics_info.add_statistics() = statistics;
 		}
 	}
+
+	for (const auto& statistics : metrics.GetStatistics()) {
+		*statistics_info.add_statistics() = statistics;
+	}
+}
+
+void PiscsiResponse::GetDelayProfilesInfo(PbDelayProfilesInfo& delay_profiles_info,
+		const vector<DelayProfiles::profile_t>& profiles) const
+{
+	for (const auto& [initiator_id, name, delay] : profiles) {
+		auto profile = delay_profiles_info.add_profiles();
+		profile->set_initiator_id(initiator_id);
+		profile->set_profile(name);
+		profile->set_delay(delay);
+	}
+}
+
+void PiscsiResponse::GetCommandTraceInfo(PbCommandTraceInfo& command_trace_info, const CommandTrace& command_trace,
+		bool chrome) const
+{
+	const auto& records = command_trace.GetRecords();
+
+	if (chrome) {
+		command_trace_info.set_chrome_trace(CommandTrace::GetChromeTrace(records));
+		return;
+	}
+
+	for (const auto& record : records) {
+		auto r = command_trace_info.add_records();
+		r->set_timestamp(record.timestamp);
+		r->set_initiator_id(record.initiator_id);
+		r->set_id(record.target_id);
+		r->set_unit(record.lun);
+		r->set_opcode(record.opcode);
+		r->set_lba(record.lba);
+		r->set_length(record.length);
+		r->set_status(record.status);
+		r->set_selection_duration(record.selection_duration);
+		r->set_command_duration(record.command_duration);
+		r->set_data_duration(record.data_duration);
+		r->set_status_duration(record.status_duration);
+	}
 }
 
 void PiscsiResponse::GetOperationInfo(PbOperationInfo& operation_info, int depth) const
@@ -389,8 +426,13 @@ void PiscsiResponse::GetOperationInfo(PbOperationInfo& operation_info, int depth
 
 	CreateOperation(operation_info, STATISTICS_INFO, "Get statistics");
 
+	operation = CreateOperation(operation_info, COMMAND_TRACE_INFO, "Get phase timings of recent SCSI commands");
+	AddOperationParameter(*operation, "format", "Record format", "raw", false, { "raw", "chrome" } );
+
 	CreateOperation(operation_info, RESERVED_IDS_INFO, "Get list of reserved device IDs");
 
+	CreateOperation(operation_info, DELAY_PROFILES_INFO, "Get the delay profiles of the initiators");
+
 	operation = CreateOperation(operation_info, DEFAULT_FOLDER, "Set default image file folder");
 	AddOperationParameter(*operation, "folder", "Default image file folder name", "", true);
 
@@ -400,6 +442,14 @@ void PiscsiResponse::GetOperationInfo(PbOperationInfo& operation_info, int depth
 	operation = CreateOperation(operation_info, RESERVE_IDS, "Reserve device IDs");
 	AddOperationParameter(*operation, "ids", "Comma-separated device ID list", "", true);
 
+	operation = CreateOperation(operation_info, DELAY_PROFILE, "Set the delay profile of an initiator");
+	AddOperationParameter(*operation, "id", "Initiator ID", "", true);
+	AddOperationParameter(*operation, "profile", "default, none, fast, slow, adaptive or delay in microseconds", "",
+			true);
+
+	operation = CreateOperation(operation_info, BUS_TRACE, "Start or stop tracing the bus signals");
+	AddOperationParameter(*operation, "file", "Base name of the VCD and JSON files, stops the trace if empty");
+
 	operation = CreateOperation(operation_info, SHUT_DOWN, "Shut down or reboot");
 	if (getuid()) {
 		AddOperationParameter(*operation, "mode", "Shutdown mode", "", true, { "rascsi" } );
@@ -464,7 +514,7 @@ void PiscsiResponse::AddOperationParameter(PbOperationMetaData& meta_data, const
 	}
 }
 
-set<id_set> PiscsiResponse::MatchDevices(const unordered_set<shared_ptr<PrimaryDevice>>& devices, PbResult& result,
+set<id_set> PiscsiResponse::MatchDevices(const vector<shared_ptr<PrimaryDevice>>& devices, PbResult& result,
 		const PbCommand& command) const
 {
 	set<id_set> id_sets;
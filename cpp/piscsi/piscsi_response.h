@@ -11,11 +11,15 @@
 
 #include "devices/device_factory.h"
 #include "devices/primary_device.h"
+#include "controllers/command_trace.h"
+#include "controllers/delay_profiles.h"
 #include "shared/piscsi_util.h"
 #include "generated/piscsi_interface.pb.h"
 #include <string>
 #include <span>
 #include <set>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 using namespace filesystem;
@@ -31,16 +35,19 @@ public:
 	bool GetImageFile(PbImageFile&, const string&, const string&) const;
 	void GetImageFilesInfo(PbImageFilesInfo&, const string&, const string&, const string&, int) const;
 	void GetReservedIds(PbReservedIdsInfo&, const unordered_set<int>&) const;
-	void GetDevices(const unordered_set<shared_ptr<PrimaryDevice>>&, PbServerInfo&, const string&) const;
-	void GetDevicesInfo(const unordered_set<shared_ptr<PrimaryDevice>>&, PbResult&, const PbCommand&, const string&) const;
+	void GetDevices(const vector<shared_ptr<PrimaryDevice>>&, PbServerInfo&, const string&) const;
+	void GetDevicesInfo(const vector<shared_ptr<PrimaryDevice>>&, PbResult&, const PbCommand&, const string&) const;
 	void GetDeviceTypesInfo(PbDeviceTypesInfo&) const;
 	void GetVersionInfo(PbVersionInfo&) const;
-	void GetServerInfo(PbServerInfo&, const PbCommand&, const unordered_set<shared_ptr<PrimaryDevice>>&,
-			const unordered_set<int>&, const string&, int) const;
+	void GetServerInfo(PbServerInfo&, const PbCommand&, const vector<shared_ptr<PrimaryDevice>>&,
+			const MetricsRegistry&, const unordered_set<int>&, const string&, int) const;
 	void GetNetworkInterfacesInfo(PbNetworkInterfacesInfo&) const;
 	void GetMappingInfo(PbMappingInfo&) const;
 	void GetLogLevelInfo(PbLogLevelInfo&) const;
-	void GetStatisticsInfo(PbStatisticsInfo&, const unordered_set<shared_ptr<PrimaryDevice>>&) const;
+	// The statistics of the devices and the statistics which are not device specific
+	void GetStatisticsInfo(PbStatisticsInfo&, const vector<shared_ptr<PrimaryDevice>>&, const MetricsRegistry&) const;
+	void GetCommandTraceInfo(PbCommandTraceInfo&, const CommandTrace&, bool) const;
+	void GetDelayProfilesInfo(PbDelayProfilesInfo&, const vector<DelayProfiles::profile_t>&) const;
 	void GetOperationInfo(PbOperationInfo&, int) const;
 
 private:
@@ -57,7 +64,7 @@ private:
 	PbOperationMetaData *CreateOperation(PbOperationInfo&, const PbOperation&, const string&) const;
 	void AddOperationParameter(PbOperationMetaData&, const string&, const string&,
 			const string& = "", bool = false, const vector<string>& = EMPTY_VECTOR) const;
-	set<id_set> MatchDevices(const unordered_set<shared_ptr<PrimaryDevice>>&, PbResult&, const PbCommand&) const;
+	set<id_set> MatchDevices(const vector<shared_ptr<PrimaryDevice>>&, PbResult&, const PbCommand&) const;
 
 	static bool ValidateImageFile(const path&);
 
@@ -0,0 +1,236 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_util.h"
+#include "piscsi/rt_profile.h"
+#include <spdlog/spdlog.h>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+using namespace std;
+using namespace piscsi_util;
+
+string RtProfile::SetProfile(const string& p)
+{
+	const auto& components = Split(p, COMPONENT_SEPARATOR, 2);
+	if (components.empty()) {
+		return "Missing runtime profile";
+	}
+
+	if (components[0] == "default" && components.size() == 1) {
+		realtime = false;
+		requested_cpu = -1;
+	}
+	else if (components[0] == "realtime") {
+		int cpu = -1;
+		if (components.size() == 2 && !GetAsUnsignedInt(components[1], cpu)) {
+			return "Invalid CPU '" + components[1] + "'";
+		}
+
+		realtime = true;
+		requested_cpu = cpu;
+	}
+	else {
+		return "Invalid runtime profile '" + p + "'";
+	}
+
+	return "";
+}
+
+void RtProfile::PrepareThreads()
+{
+	if (!realtime) {
+		FixCpu(DEFAULT_CPU);
+		return;
+	}
+
+	online_cpus = ReadCpuList("/sys/devices/system/cpu/online");
+	isolated_cpus = ReadCpuList("/sys/devices/system/cpu/isolated");
+	nohz_full_cpus = ReadCpuList("/sys/devices/system/cpu/nohz_full");
+
+	bus_cpu = requested_cpu != -1 ? requested_cpu : SelectBusCpu(online_cpus, isolated_cpus, nohz_full_cpus);
+
+	// Isolated CPUs are left alone, unless there are no other CPUs
+	for (const int cpu : online_cpus) {
+		if (cpu != bus_cpu && !isolated_cpus.contains(cpu)) {
+			housekeeping_cpus.insert(cpu);
+		}
+	}
+	if (housekeeping_cpus.empty()) {
+		for (const int cpu : online_cpus) {
+			if (cpu != bus_cpu) {
+				housekeeping_cpus.insert(cpu);
+			}
+		}
+	}
+
+	LockMemory();
+
+	// Threads started from now on inherit this affinity
+	if (!housekeeping_cpus.empty() && !SetAffinity(housekeeping_cpus)) {
+		spdlog::warn("Can't set the CPU affinity of the service threads: " + string(strerror(errno)));
+	}
+}
+
+void RtProfile::PlaceBusThread()
+{
+	if (!realtime) {
+		return;
+	}
+
+	if (!SetAffinity({ bus_cpu })) {
+		spdlog::warn("Can't move the bus thread to CPU " + to_string(bus_cpu) + ": " + strerror(errno));
+	}
+
+	sched_param param = {};
+	param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+	if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
+		spdlog::warn("Can't set the bus thread scheduling policy: " + string(strerror(errno)));
+	}
+}
+
+vector<string> RtProfile::GetLayout() const
+{
+	if (!realtime) {
+		return { "Runtime profile: default, all threads on CPU " + to_string(DEFAULT_CPU) };
+	}
+
+	vector<string> layout;
+	layout.push_back("Runtime profile: realtime, " + memory_status);
+	layout.push_back("Online CPUs: " + Join(online_cpus, ",") + ", isolated: " +
+			(isolated_cpus.empty() ? "none" : Join(isolated_cpus, ",")) + ", nohz_full: " +
+			(nohz_full_cpus.empty() ? "none" : Join(nohz_full_cpus, ",")));
+	layout.push_back("Bus thread: CPU " + to_string(bus_cpu) + " (SCHED_FIFO), service threads: CPUs " +
+			(housekeeping_cpus.empty() ? "none" : Join(housekeeping_cpus, ",")));
+	if (!isolated_cpus.empty() && !isolated_cpus.contains(bus_cpu)) {
+		layout.push_back("Note: The bus thread does not run on an isolated CPU");
+	}
+
+	return layout;
+}
+
+set<int> RtProfile::ParseCpuList(const string& list)
+{
+	set<int> cpus;
+
+	for (const auto& range : Split(list, ',')) {
+		if (range.empty()) {
+			continue;
+		}
+
+		const auto& bounds = Split(range, '-', 2);
+		int first;
+		int last;
+		if (!GetAsUnsignedInt(bounds[0], first)) {
+			continue;
+		}
+		if (bounds.size() == 1) {
+			last = first;
+		}
+		else if (!GetAsUnsignedInt(bounds[1], last)) {
+			continue;
+		}
+
+		for (int cpu = first; cpu <= last; cpu++) {
+			cpus.insert(cpu);
+		}
+	}
+
+	return cpus;
+}
+
+int RtProfile::SelectBusCpu(const set<int>& online, const set<int>& isolated, const set<int>& nohz_full)
+{
+	// Highest CPUs first, because the kernel prefers the low ones for interrupts and housekeeping
+	for (auto it = isolated.rbegin(); it != isolated.rend(); ++it) {
+		if (online.contains(*it) && nohz_full.contains(*it)) {
+			return *it;
+		}
+	}
+
+	for (auto it = isolated.rbegin(); it != isolated.rend(); ++it) {
+		if (online.contains(*it)) {
+			return *it;
+		}
+	}
+
+	for (auto it = nohz_full.rbegin(); it != nohz_full.rend(); ++it) {
+		if (online.contains(*it)) {
+			return *it;
+		}
+	}
+
+	return online.empty() ? 0 : *online.rbegin();
+}
+
+void RtProfile::LockMemory()
+{
+	// Freed memory must remain mapped, otherwise prefaulting the heap would be useless
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+		memory_status = "memory not locked (" + string(strerror(errno)) + ")";
+		spdlog::warn("Can't lock memory: " + string(strerror(errno)));
+	}
+	else {
+		memory_status = "memory locked";
+	}
+
+	PrefaultStack();
+	PrefaultHeap();
+
+	memory_status += ", " + to_string(STACK_PREFAULT_SIZE / 1024) + " KiB stack and " +
+			to_string(HEAP_PREFAULT_SIZE / 1024 / 1024) + " MiB heap prefaulted";
+}
+
+void RtProfile::PrefaultStack()
+{
+	// Each page has to be written, volatile prevents the compiler from optimizing this away
+	array<volatile uint8_t, STACK_PREFAULT_SIZE> stack;
+	for (size_t i = 0; i < stack.size(); i += 4096) {
+		stack[i] = 0;
+	}
+}
+
+void RtProfile::PrefaultHeap()
+{
+	auto heap = static_cast<volatile uint8_t *>(malloc(HEAP_PREFAULT_SIZE));
+	if (heap != nullptr) {
+		for (size_t i = 0; i < HEAP_PREFAULT_SIZE; i += 4096) {
+			heap[i] = 0;
+		}
+
+		free(const_cast<uint8_t *>(heap));
+	}
+}
+
+bool RtProfile::SetAffinity(const set<int>& cpus)
+{
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	for (const int cpu : cpus) {
+		CPU_SET(cpu, &mask);
+	}
+
+	return !sched_setaffinity(0, sizeof(cpu_set_t), &mask);
+}
+
+set<int> RtProfile::ReadCpuList(const string& filename)
+{
+	ifstream file(filename);
+	string list;
+	getline(file, list);
+
+	return ParseCpuList(list);
+}
@@ -0,0 +1,74 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Runtime profile of the bus thread:
+//   "default":  The bus thread and all threads it starts run on CPU 3, as piscsi always did
+//   "realtime": All memory is locked and the stack and heap of the bus thread are prefaulted, i.e. there are no
+//               page faults while processing commands. The bus thread runs with SCHED_FIFO on a CPU reserved with
+//               isolcpus/nohz_full (if available) and all other threads run on the remaining CPUs.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class RtProfile
+{
+
+public:
+
+	RtProfile() = default;
+	~RtProfile() = default;
+
+	// Format: "default" or "realtime[:CPU]", returns an error message, which is empty on success
+	string SetProfile(const string&);
+	bool IsRealtime() const { return realtime; }
+
+	// Must be called by the bus thread before any other thread is started, which inherits the CPU affinity
+	void PrepareThreads();
+	// Must be called by the bus thread after the other threads have been started
+	void PlaceBusThread();
+
+	vector<string> GetLayout() const;
+
+	// Parses the kernel CPU list format, e.g. "0,2-3"
+	static set<int> ParseCpuList(const string&);
+	// Prefers CPUs without scheduler ticks, then isolated CPUs, then the last CPU
+	static int SelectBusCpu(const set<int>&, const set<int>&, const set<int>&);
+
+	static inline const int DEFAULT_CPU = 3;
+
+	static const size_t STACK_PREFAULT_SIZE = 256 * 1024;
+	static const size_t HEAP_PREFAULT_SIZE = 8 * 1024 * 1024;
+
+private:
+
+	void LockMemory();
+	static void PrefaultStack();
+	static void PrefaultHeap();
+	static bool SetAffinity(const set<int>&);
+	static set<int> ReadCpuList(const string&);
+
+	bool realtime = false;
+
+	// -1 if the bus CPU is to be selected automatically
+	int requested_cpu = -1;
+
+	int bus_cpu = DEFAULT_CPU;
+
+	set<int> online_cpus;
+	set<int> isolated_cpus;
+	set<int> nohz_full_cpus;
+	set<int> housekeeping_cpus;
+
+	string memory_status;
+};
@@ -0,0 +1,240 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_util.h"
+#include "hal/deadline.h"
+#include "piscsi/select_waiter.h"
+#include <cassert>
+#include <chrono>
+#include <ctime>
+
+using namespace std;
+using namespace piscsi_util;
+
+SelectWaiter::SelectWaiter(MetricsRegistry& metrics)
+	: wakeup_count(metrics.AddCounter(WAIT_WAKEUP_COUNT)),
+	  spin_count(metrics.AddCounter(WAIT_SPIN_COUNT)),
+	  event_count(metrics.AddCounter(WAIT_EVENT_COUNT)),
+	  latency_histogram(metrics.AddHistogram(WAIT_LATENCY)),
+	  latency_max(metrics.AddGauge(WAIT_LATENCY_MAX)),
+	  wait_time(metrics.AddCounter(WAIT_TIME)),
+	  cpu_time(metrics.AddCounter(WAIT_CPU_TIME))
+{
+}
+
+string SelectWaiter::SetMode(const string& m)
+{
+	const auto& components = Split(m, ':', 2);
+	if (components.empty()) {
+		return "Missing wait mode";
+	}
+
+	if (components[0] == "spin" && components.size() == 1) {
+		mode = wait_mode::spin;
+	}
+	else if (components[0] == "event" && components.size() == 1) {
+		mode = wait_mode::event;
+	}
+	else if (components[0] == "hybrid") {
+		int budget = DEFAULT_SPIN_BUDGET;
+		if (components.size() == 2 && !GetAsUnsignedInt(components[1], budget)) {
+			return "Invalid spin budget '" + components[1] + "'";
+		}
+
+		mode = wait_mode::hybrid;
+		spin_budget = budget;
+	}
+	else {
+		return "Invalid wait mode '" + m + "'";
+	}
+
+	return "";
+}
+
+string SelectWaiter::GetDescription() const
+{
+	switch (mode) {
+	case wait_mode::spin:
+		return "spin";
+
+	case wait_mode::event:
+		return "event";
+
+	case wait_mode::hybrid:
+		return "hybrid with a spin budget of " + to_string(spin_budget) + " us";
+
+	default:
+		assert(false);
+		return "";
+	}
+}
+
+bool SelectWaiter::Wait(BUS& bus)
+{
+	errno = 0;
+
+	// Sampled before waiting, i.e. not between detecting a selection and processing it
+	const uint64_t start = GetTime();
+	cpu_sample = GetCpuTime();
+
+	bool selected = false;
+	switch (mode) {
+	case wait_mode::spin:
+		selected = Spin(bus, SPIN_INTERVAL);
+		break;
+
+	case wait_mode::event:
+		selected = WaitForEvent(bus, start);
+		break;
+
+	case wait_mode::hybrid:
+		selected = Spin(bus, chrono::microseconds(spin_budget)) || WaitForEvent(bus, start);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+
+	if (selected) {
+		wait_time.Increment(detection_time - start);
+	}
+	else {
+		// Neither clock modifies errno, i.e. the caller can still check for an interrupted wait
+		UpdateCpuTime();
+		wait_time.Increment(GetTime() - start);
+	}
+
+	return selected;
+}
+
+bool SelectWaiter::Spin(BUS& bus, chrono::nanoseconds budget)
+{
+	const uint64_t start = TickCounter::Now();
+	const uint64_t end = start + TickCounter::ToTicks(budget);
+
+	// The time of the latest sample without SEL
+	uint64_t previous = start;
+
+	uint64_t count = 0;
+
+	// The counter value read for the deadline check is also the time of the next sample
+	for (uint64_t now = start;; now = TickCounter::Now()) {
+		count++;
+
+		bus.Acquire();
+		if (bus.GetSEL()) {
+			detection_time = GetTime();
+			select_timestamp = detection_time;
+
+			spin_count.Increment(count);
+			wakeup_count.Increment();
+
+			// Spinning keeps the core busy, i.e. the CPU time does not have to be sampled
+			cpu_time.Increment(TickCounter::ToDuration(now - start).count());
+
+			// SEL was asserted after the previous sample, i.e. the wakeup latency is at most the time between
+			// both samples. If SEL was already asserted with the first sample the latency is unknown.
+			if (count > 1) {
+				AddLatency(TickCounter::ToDuration(now - previous).count());
+			}
+
+			return true;
+		}
+
+		if (now >= end) {
+			break;
+		}
+
+		previous = now;
+	}
+
+	spin_count.Increment(count);
+
+	return false;
+}
+
+bool SelectWaiter::WaitForEvent(BUS& bus, uint64_t start)
+{
+	// The thread is about to block, i.e. sampling does not delay a selection. The CPU time of the wakeup itself
+	// is not included.
+	UpdateCpuTime();
+
+	while (bus.PollSelectEvent()) {
+		event_count.Increment();
+
+		bus.Acquire();
+
+		// Edges from while the bus thread was busy or spinning are still queued. They are only relevant if SEL
+		// is still asserted, and their timestamps do not represent the wakeup latency.
+		const uint64_t timestamp = bus.GetSelectEventTimestamp();
+		if (timestamp && timestamp < start) {
+			if (bus.GetSEL()) {
+				detection_time = GetTime();
+				select_timestamp = detection_time;
+				wakeup_count.Increment();
+				return true;
+			}
+
+			UpdateCpuTime();
+			continue;
+		}
+
+		wakeup_count.Increment();
+
+		// The kernel timestamps are based on the monotonic clock (since Linux 5.7), like steady_clock
+		detection_time = GetTime();
+		if (timestamp && detection_time > timestamp) {
+			AddLatency(detection_time - timestamp);
+			select_timestamp = timestamp;
+		}
+		else {
+			select_timestamp = detection_time;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void SelectWaiter::AddLatency(uint64_t latency)
+{
+	latency_histogram.Record(latency);
+	latency_max.SetMax(latency);
+}
+
+bool SelectWaiter::IsEventSupported()
+{
+#ifdef USE_SEL_EVENT_ENABLE
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SelectWaiter::UpdateCpuTime()
+{
+	const uint64_t now = GetCpuTime();
+	cpu_time.Increment(now - cpu_sample);
+	cpu_sample = now;
+}
+
+uint64_t SelectWaiter::GetTime()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t SelectWaiter::GetCpuTime()
+{
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
@@ -0,0 +1,101 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Strategies for waiting for a selection in the main loop:
+//   "spin":   Samples the bus without ever blocking. Lowest latency, but keeps a core busy.
+//   "event":  Blocks until the kernel reports a SEL edge. No CPU load when idle, but the wakeup takes longer.
+//   "hybrid": Samples the bus for the spin budget, then blocks like "event". Selections following shortly
+//             after the previous command are detected fast without keeping a core busy when idle.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/bus.h"
+#include "devices/metrics_registry.h"
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+class SelectWaiter
+{
+
+public:
+
+	enum class wait_mode { spin, event, hybrid };
+
+	// The statistics are added to the registry, they are not device specific
+	explicit SelectWaiter(MetricsRegistry&);
+	~SelectWaiter() = default;
+
+	// Format: "spin", "event" or "hybrid[:SPIN_BUDGET]" with the budget in us.
+	// Returns an error message, which is empty on success
+	string SetMode(const string&);
+	wait_mode GetMode() const { return mode; }
+	uint32_t GetSpinBudget() const { return spin_budget; }
+	string GetDescription() const;
+
+	// Returns true as soon as SEL may be asserted, with the bus signals acquired.
+	// On false the caller has to check whether to continue waiting, errno is EINTR if the wait was interrupted.
+	bool Wait(BUS&);
+
+	// The time of the SEL edge in ns (steady clock) after a successful wait. The time SEL was detected at if the
+	// edge time is unknown.
+	uint64_t GetSelectTimestamp() const { return select_timestamp; }
+
+	// Blocking requires SEL edge events, which are only available with the PiSCSI hardware
+	static bool IsEventSupported();
+
+	static inline const uint32_t DEFAULT_SPIN_BUDGET = 100;
+
+	inline static const string WAIT_WAKEUP_COUNT = "wait_wakeup_count";
+	inline static const string WAIT_SPIN_COUNT = "wait_spin_count";
+	inline static const string WAIT_EVENT_COUNT = "wait_event_count";
+	// From the SEL edge to its detection. When spinning this is the time since the previous sample without SEL,
+	// i.e. an upper bound.
+	inline static const string WAIT_LATENCY = "wait_latency_ns";
+	inline static const string WAIT_LATENCY_MAX = "wait_latency_max_ns";
+	// The ratio of the CPU time and the wait time is the CPU load caused by waiting. The CPU time is not sampled
+	// between detecting a selection and processing it. Spinning until a selection counts as CPU time, a wakeup
+	// from blocking does not.
+	inline static const string WAIT_TIME = "wait_time_ns";
+	inline static const string WAIT_CPU_TIME = "wait_cpu_time_ns";
+
+private:
+
+	bool Spin(BUS&, chrono::nanoseconds);
+	bool WaitForEvent(BUS&, uint64_t);
+	void AddLatency(uint64_t);
+	void UpdateCpuTime();
+
+	static uint64_t GetTime();
+	static uint64_t GetCpuTime();
+
+	// In spin mode Wait() returns after this time in order to let the caller check whether to continue
+	static constexpr chrono::milliseconds SPIN_INTERVAL = 10ms;
+
+	wait_mode mode = IsEventSupported() ? wait_mode::event : wait_mode::spin;
+
+	// In us
+	uint32_t spin_budget = DEFAULT_SPIN_BUDGET;
+
+	// Updated by the bus thread and read by the service thread. Times are in ns.
+	Counter& wakeup_count;
+	Counter& spin_count;
+	Counter& event_count;
+	// Not all wakeups provide a latency
+	Histogram& latency_histogram;
+	Gauge& latency_max;
+	Counter& wait_time;
+	Counter& cpu_time;
+
+	// Only accessed by the bus thread
+	uint64_t select_timestamp = 0;
+	uint64_t detection_time = 0;
+	uint64_t cpu_sample = 0;
+};
@@ -0,0 +1,19 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "scsibench/scsibench_core.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	vector<char *> args(argv, argv + argc);
+
+	return ScsiBench().run(args);
+}
@@ -0,0 +1,430 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "hal/gpiobus_factory.h"
+#include "hal/gpiobus_virtual.h"
+#include "controllers/controller_manager.h"
+#include "shared/piscsi_exceptions.h"
+#include "shared/piscsi_util.h"
+#include "scsibench/scsibench_core.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <unistd.h>
+
+using namespace std;
+using namespace spdlog;
+using namespace scsi_defs;
+using namespace piscsi_util;
+
+void ScsiBench::CleanUp()
+{
+	if (bus != nullptr) {
+		bus->Cleanup();
+	}
+}
+
+void ScsiBench::TerminationHandler(int)
+{
+	// Stop after the current command and report the results so far
+	stop = true;
+}
+
+bool ScsiBench::Banner(span<char *> args) const
+{
+	cout << piscsi_util::Banner("(SCSI Benchmark Utility)");
+
+	if (args.size() < 2 || string(args[1]) == "-h" || string(args[1]) == "--help") {
+		cout << "Usage: " << args[0] << " -t ID[:LUN] [-i BID] [-p PATTERN] [-w PERCENTAGE] [-b TRANSFER_SIZE]"
+				<< " [-o START] [-n SECTORS] [-d DURATION] [-B] [-v]\n"
+				<< " ID is the target device ID (0-" << (ControllerManager::GetScsiIdMax() - 1) << ").\n"
+				<< " LUN is the optional target device LUN (0-" << (ControllerManager::GetScsiLunMax() -1 ) << ")."
+				<< " Default is 0.\n"
+				<< " BID is the PiSCSI board ID (0-7). Default is 7.\n"
+				<< " PATTERN is the access pattern, 'seq' or 'rand'. Default is 'seq'.\n"
+				<< " PERCENTAGE is the percentage of WRITE commands (0-100). Default is 0.\n"
+				<< "   Write commands destroy the data on the target device!\n"
+				<< " TRANSFER_SIZE is the number of bytes per command. Default is 4096.\n"
+				<< " START and SECTORS are the sector range. Default is the whole medium.\n"
+				<< " DURATION is the duration in seconds. Default is " << DEFAULT_DURATION << ".\n"
+				<< " -B uses READ BUFFER/WRITE BUFFER instead of READ/WRITE, i.e. only the bus is measured.\n\n"
+				<< "See the scsibench man page for all supported parameters\n"
+				<< flush;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool ScsiBench::Init()
+{
+	struct sigaction termination_handler;
+	termination_handler.sa_handler = TerminationHandler;
+	sigemptyset(&termination_handler.sa_mask);
+	termination_handler.sa_flags = 0;
+	sigaction(SIGINT, &termination_handler, nullptr);
+	sigaction(SIGTERM, &termination_handler, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+
+	bus = GPIOBUS_Factory::Create(BUS::mode_e::INITIATOR);
+	if (bus == nullptr) {
+		return false;
+	}
+
+	executor = make_unique<InitiatorExecutor>(*bus, initiator_id);
+	executor->SetTarget(target_id, target_lun);
+
+	return true;
+}
+
+void ScsiBench::ParseArguments(span<char *> args)
+{
+	opterr = 0;
+	int opt;
+	while ((opt = getopt(static_cast<int>(args.size()), args.data(), "b:d:i:n:o:p:t:w:vB")) != -1) {
+		switch (opt) {
+			case 'b': {
+				int transfer_size;
+				if (!GetAsUnsignedInt(optarg, transfer_size) || !transfer_size) {
+					throw parser_exception("Invalid transfer size " + string(optarg));
+				}
+				settings.transfer_size = transfer_size;
+				break;
+			}
+
+			case 'd':
+				if (!GetAsUnsignedInt(optarg, duration) || !duration) {
+					throw parser_exception("Invalid duration " + string(optarg));
+				}
+				break;
+
+			case 'i':
+				if (!GetAsUnsignedInt(optarg, initiator_id) || initiator_id > 7) {
+					throw parser_exception("Invalid PiSCSI board ID " + string(optarg) + " (0-7)");
+				}
+				break;
+
+			case 'n':
+				settings.lba_count = strtoull(optarg, nullptr, 0);
+				break;
+
+			case 'o':
+				settings.first_lba = strtoull(optarg, nullptr, 0);
+				break;
+
+			case 'p':
+				if (!Workload::ParsePattern(optarg, settings.access_pattern)) {
+					throw parser_exception("Invalid access pattern '" + string(optarg) + "', must be 'seq' or 'rand'");
+				}
+				break;
+
+			case 't':
+				if (const string error = ProcessId(optarg, target_id, target_lun); !error.empty()) {
+					throw parser_exception(error);
+				}
+				break;
+
+			case 'w':
+				if (!GetAsUnsignedInt(optarg, settings.write_percentage) || settings.write_percentage > 100) {
+					throw parser_exception("Invalid write percentage " + string(optarg) + " (0-100)");
+				}
+				break;
+
+			case 'v':
+				set_level(level::debug);
+				break;
+
+			case 'B':
+				buffer_mode = true;
+				break;
+
+			default:
+				throw parser_exception("Parser error");
+		}
+	}
+
+	if (target_id == -1) {
+		throw parser_exception("Missing target ID");
+	}
+
+	if (target_id == initiator_id) {
+		throw parser_exception("Target ID and PiSCSI board ID must not be identical");
+	}
+
+	if (target_lun == -1) {
+		target_lun = 0;
+	}
+
+	// At least 256 bytes are required for REQUEST SENSE and READ CAPACITY
+	buffer = vector<uint8_t>(max(settings.transfer_size, static_cast<uint32_t>(256)));
+}
+
+pair<uint64_t, uint32_t> ScsiBench::GetCapacity()
+{
+	// Report a pending UNIT ATTENTION, e.g. after a reset, before reading the capacity
+	for (int i = 0; i < 3; i++) {
+		vector<uint8_t> cdb(6);
+		if (executor->Execute(scsi_command::eCmdTestUnitReady, cdb, buffer, 0) == static_cast<int>(status::good)) {
+			break;
+		}
+
+		cdb[4] = 0xff;
+		executor->Execute(scsi_command::eCmdRequestSense, cdb, buffer, 256);
+	}
+
+	vector<uint8_t> cdb(10);
+	if (executor->Execute(scsi_command::eCmdReadCapacity10, cdb, buffer, 8) != static_cast<int>(status::good)) {
+		return { 0, 0 };
+	}
+
+	// READ CAPACITY returns the last LBA
+	uint64_t last_lba = (static_cast<uint32_t>(buffer[0]) << 24) | (static_cast<uint32_t>(buffer[1]) << 16) |
+			(static_cast<uint32_t>(buffer[2]) << 8) | static_cast<uint32_t>(buffer[3]);
+	int sector_size_offset = 4;
+
+	if (last_lba == 0xffffffff) {
+		cdb.resize(16);
+		// READ CAPACITY(16), not READ LONG(16)
+		cdb[1] = 0x10;
+		cdb[13] = 32;
+		if (executor->Execute(scsi_command::eCmdReadCapacity16_ReadLong16, cdb, buffer, 32) !=
+				static_cast<int>(status::good)) {
+			return { 0, 0 };
+		}
+
+		last_lba = 0;
+		for (int i = 0; i < 8; i++) {
+			last_lba = (last_lba << 8) | buffer[i];
+		}
+		sector_size_offset = 8;
+	}
+
+	const uint32_t sector_size = (static_cast<uint32_t>(buffer[sector_size_offset]) << 24) |
+			(static_cast<uint32_t>(buffer[sector_size_offset + 1]) << 16) |
+			(static_cast<uint32_t>(buffer[sector_size_offset + 2]) << 8) |
+			static_cast<uint32_t>(buffer[sector_size_offset + 3]);
+
+	return { last_lba + 1, sector_size };
+}
+
+uint32_t ScsiBench::GetBufferCapacity()
+{
+	// The READ BUFFER descriptor mode returns the capacity of the data buffer
+	vector<uint8_t> cdb(10);
+	cdb[1] = 0x03;
+	cdb[8] = 4;
+	if (executor->Execute(scsi_command::eCmdReadBuffer10, cdb, buffer, 4) != static_cast<int>(status::good)) {
+		return 0;
+	}
+
+	return (static_cast<uint32_t>(buffer[1]) << 16) | (static_cast<uint32_t>(buffer[2]) << 8) |
+			static_cast<uint32_t>(buffer[3]);
+}
+
+int ScsiBench::ReadWriteBuffer(bool write)
+{
+	// Data mode, buffer 0, offset 0
+	vector<uint8_t> cdb(10);
+	cdb[1] = 0x02;
+	cdb[6] = static_cast<uint8_t>(settings.transfer_size >> 16);
+	cdb[7] = static_cast<uint8_t>(settings.transfer_size >> 8);
+	cdb[8] = static_cast<uint8_t>(settings.transfer_size);
+
+	return executor->Execute(write ? scsi_command::eCmdWriteBuffer10 : scsi_command::eCmdReadBuffer10, cdb, buffer,
+			static_cast<int>(settings.transfer_size));
+}
+
+int ScsiBench::ReadWrite(const Workload::command_t& command)
+{
+	vector<uint8_t> cdb;
+	scsi_command cmd;
+	int blocks_offset;
+	// The 16 byte commands are only used when required, not every device supports them
+	if (command.lba > 0xffffffff) {
+		cmd = command.write ? scsi_command::eCmdWrite16 : scsi_command::eCmdRead16;
+		cdb.resize(16);
+		for (int i = 0; i < 8; i++) {
+			cdb[2 + i] = static_cast<uint8_t>(command.lba >> (56 - 8 * i));
+		}
+		blocks_offset = 12;
+	}
+	else {
+		cmd = command.write ? scsi_command::eCmdWrite10 : scsi_command::eCmdRead10;
+		cdb.resize(10);
+		for (int i = 0; i < 4; i++) {
+			cdb[2 + i] = static_cast<uint8_t>(command.lba >> (24 - 8 * i));
+		}
+		blocks_offset = 7;
+	}
+	cdb[blocks_offset] = static_cast<uint8_t>(command.blocks >> 8);
+	cdb[blocks_offset + 1] = static_cast<uint8_t>(command.blocks);
+
+	return executor->Execute(cmd, cdb, buffer, static_cast<int>(settings.transfer_size));
+}
+
+void ScsiBench::Run(Workload& workload)
+{
+	// Recognizable data for the WRITE commands
+	iota(buffer.begin(), buffer.end(), 0);
+
+	const auto start = chrono::steady_clock::now();
+	const auto end = start + chrono::seconds(duration);
+
+	auto now = start;
+	while (!stop && now < end) {
+		const auto command = workload.GetNextCommand();
+
+		const int s = buffer_mode ? ReadWriteBuffer(command.write) : ReadWrite(command);
+
+		const auto command_end = chrono::steady_clock::now();
+		statistics.latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(command_end - now).count());
+		now = command_end;
+
+		if (s != static_cast<int>(status::good)) {
+			++statistics.failed;
+		}
+
+		if (command.write) {
+			++statistics.writes;
+			statistics.bytes_written += executor->GetByteCount();
+		}
+		else {
+			++statistics.reads;
+			statistics.bytes_read += executor->GetByteCount();
+		}
+	}
+
+	statistics.elapsed_ns = chrono::duration_cast<chrono::nanoseconds>(now - start).count();
+}
+
+void ScsiBench::Report(const statistics_t& statistics)
+{
+	vector<uint64_t> sorted = statistics.latencies;
+	ranges::sort(sorted);
+
+	const double seconds = static_cast<double>(statistics.elapsed_ns) / 1'000'000'000;
+	const auto per_second = [seconds] (double value) { return seconds > 0 ? value / seconds : 0; };
+	const auto usec = [&sorted] (double percentile) {
+		return static_cast<double>(GetPercentile(sorted, percentile)) / 1000;
+	};
+
+	cout << fixed << setprecision(3)
+			<< "Commands executed: " << sorted.size() << " (" << statistics.reads << " READ, " << statistics.writes
+			<< " WRITE, " << statistics.failed << " with status other than GOOD)\n"
+			<< "Elapsed time:      " << seconds << " s\n"
+			<< "IOPS:              " << per_second(static_cast<double>(sorted.size())) << '\n'
+			<< "Read:              " << statistics.bytes_read << " bytes, "
+			<< per_second(static_cast<double>(statistics.bytes_read)) / 1000 / 1000 << " MB/s\n"
+			<< "Written:           " << statistics.bytes_written << " bytes, "
+			<< per_second(static_cast<double>(statistics.bytes_written)) / 1000 / 1000 << " MB/s\n"
+			<< "Latency (us):      p50 " << usec(50) << ", p90 " << usec(90) << ", p99 " << usec(99)
+			<< ", p99.9 " << usec(99.9) << ", max " << usec(100) << '\n'
+			<< flush;
+}
+
+int ScsiBench::run(span<char *> args)
+{
+	if (!Banner(args)) {
+		return EXIT_SUCCESS;
+	}
+
+	try {
+		ParseArguments(args);
+	}
+	catch (const parser_exception& e) {
+		cerr << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	// A shared virtual bus requires neither root permissions nor any hardware
+	const bool is_virtual_bus = !GPIOBUS_Virtual::GetSharedMemoryName().empty();
+
+	if (!is_virtual_bus && getuid()) {
+		cerr << "Error: GPIO bus access requires root permissions. Are you running as root?" << endl;
+		return EXIT_FAILURE;
+	}
+
+#ifndef USE_SEL_EVENT_ENABLE
+	if (!is_virtual_bus) {
+		cerr << "Error: No PiSCSI hardware support" << endl;
+		return EXIT_FAILURE;
+	}
+#endif
+
+	if (!Init()) {
+		cerr << "Error: Can't initialize bus" << endl;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		executor->ResetBus();
+
+		uint64_t capacity;
+		uint32_t sector_size;
+		if (buffer_mode) {
+			const uint32_t buffer_capacity = GetBufferCapacity();
+			if (settings.transfer_size > buffer_capacity) {
+				cerr << "Error: Transfer size exceeds the buffer capacity of device " << target_id << ":" << target_lun
+						<< " (" << buffer_capacity << " bytes)" << endl;
+				CleanUp();
+				return EXIT_FAILURE;
+			}
+
+			// Only the READ/WRITE ratio of the workload is relevant, there is a single transfer at offset 0
+			capacity = 1;
+			sector_size = settings.transfer_size;
+			settings.first_lba = 0;
+			settings.lba_count = 0;
+
+			cout << "Device " << target_id << ":" << target_lun << " has a buffer of " << buffer_capacity
+					<< " bytes\n";
+		}
+		else {
+			tie(capacity, sector_size) = GetCapacity();
+			if (!capacity) {
+				cerr << "Error: Can't read capacity of device " << target_id << ":" << target_lun << endl;
+				CleanUp();
+				return EXIT_FAILURE;
+			}
+
+			cout << "Device " << target_id << ":" << target_lun << " has " << capacity << " sectors of "
+					<< sector_size << " bytes\n";
+		}
+
+		Workload workload(settings);
+		if (const string error = workload.Init(sector_size, capacity); !error.empty()) {
+			cerr << "Error: " << error << endl;
+			CleanUp();
+			return EXIT_FAILURE;
+		}
+
+		cout << "Running " << (buffer_mode ? "buffer" :
+				(settings.access_pattern == Workload::pattern::random ? "random" : "sequential"))
+				<< " workload with " << settings.write_percentage << "% WRITE and " << settings.transfer_size
+				<< " bytes per command for " << duration << " s\n" << flush;
+
+		Run(workload);
+	}
+	catch (const phase_exception& e) {
+		cerr << "Error: " << e.what() << endl;
+		CleanUp();
+		return EXIT_FAILURE;
+	}
+
+	CleanUp();
+
+	Report(statistics);
+
+	return EXIT_SUCCESS;
+}
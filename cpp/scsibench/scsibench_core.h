@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Runs a READ/WRITE workload against a SCSI target as an initiator and reports the throughput and latency
+// distribution. Works with piscsi (also on a virtual bus) and with real drives.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/bus.h"
+#include "initiator/initiator_executor.h"
+#include "scsibench/workload.h"
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class ScsiBench
+{
+
+public:
+
+	ScsiBench() = default;
+	~ScsiBench() = default;
+
+	int run(span<char *>);
+
+	struct statistics_t {
+		uint64_t reads = 0;
+		uint64_t writes = 0;
+		uint64_t bytes_read = 0;
+		uint64_t bytes_written = 0;
+		// Commands with a status other than GOOD
+		uint64_t failed = 0;
+		uint64_t elapsed_ns = 0;
+		vector<uint64_t> latencies;
+	};
+
+	static void Report(const statistics_t&);
+
+private:
+
+	bool Banner(span<char *>) const;
+	bool Init();
+	void ParseArguments(span<char *>);
+	pair<uint64_t, uint32_t> GetCapacity();
+	uint32_t GetBufferCapacity();
+	void Run(Workload&);
+	int ReadWrite(const Workload::command_t&);
+	int ReadWriteBuffer(bool);
+
+	static void CleanUp();
+	static void TerminationHandler(int);
+
+	// A static instance is needed because of the signal handler
+	static inline unique_ptr<BUS> bus;
+
+	static inline atomic_bool stop;
+
+	unique_ptr<InitiatorExecutor> executor;
+
+	vector<uint8_t> buffer;
+
+	int target_id = -1;
+
+	int target_lun = 0;
+
+	int initiator_id = 7;
+
+	int duration = DEFAULT_DURATION;
+
+	// READ BUFFER/WRITE BUFFER instead of READ/WRITE, i.e. there is no access to the medium
+	bool buffer_mode = false;
+
+	Workload::settings_t settings;
+
+	statistics_t statistics;
+
+	static const int DEFAULT_DURATION = 10;
+};
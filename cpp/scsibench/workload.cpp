@@ -0,0 +1,80 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "scsibench/workload.h"
+
+using namespace std;
+
+string Workload::Init(uint32_t sector_size, uint64_t capacity)
+{
+	if (!sector_size || settings.transfer_size % sector_size) {
+		return "Transfer size must be a multiple of the sector size (" + to_string(sector_size) + " bytes)";
+	}
+
+	blocks = settings.transfer_size / sector_size;
+	if (blocks > 65535) {
+		return "Transfer size must not exceed 65535 sectors";
+	}
+
+	if (settings.first_lba >= capacity) {
+		return "Start sector must be smaller than the capacity (" + to_string(capacity) + " sectors)";
+	}
+
+	if (!settings.lba_count) {
+		settings.lba_count = capacity - settings.first_lba;
+	}
+	else if (settings.lba_count > capacity - settings.first_lba) {
+		return "Sector range exceeds the capacity (" + to_string(capacity) + " sectors)";
+	}
+
+	slots = settings.lba_count / blocks;
+	if (!slots) {
+		return "Sector range must comprise at least one transfer";
+	}
+
+	next_slot = 0;
+
+	// A fixed seed, so that each run uses the same sequence of commands
+	random_generator.seed(0);
+	slot_distribution = uniform_int_distribution<uint64_t>(0, slots - 1);
+
+	return "";
+}
+
+Workload::command_t Workload::GetNextCommand()
+{
+	uint64_t slot;
+	if (settings.access_pattern == pattern::random) {
+		slot = slot_distribution(random_generator);
+	}
+	else {
+		slot = next_slot;
+		next_slot = (next_slot + 1) % slots;
+	}
+
+	const bool write = settings.write_percentage &&
+			percentage_distribution(random_generator) < settings.write_percentage;
+
+	return { settings.first_lba + slot * blocks, blocks, write };
+}
+
+bool Workload::ParsePattern(const string& value, pattern& result)
+{
+	if (value == "seq" || value == "sequential") {
+		result = pattern::sequential;
+		return true;
+	}
+
+	if (value == "rand" || value == "random") {
+		result = pattern::random;
+		return true;
+	}
+
+	return false;
+}
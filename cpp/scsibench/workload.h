@@ -0,0 +1,69 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Generates the sequence of READ/WRITE commands of a benchmark run. The sequence only depends on the
+// settings, i.e. different targets are benchmarked with exactly the same commands.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace std;
+
+class Workload
+{
+
+public:
+
+	enum class pattern { sequential, random };
+
+	struct settings_t {
+		pattern access_pattern = pattern::sequential;
+		// 0-100
+		int write_percentage = 0;
+		// Bytes per command
+		uint32_t transfer_size = 4096;
+		uint64_t first_lba = 0;
+		// 0 means up to the end of the medium
+		uint64_t lba_count = 0;
+	};
+
+	struct command_t {
+		uint64_t lba;
+		uint32_t blocks;
+		bool write;
+	};
+
+	explicit Workload(const settings_t& settings) : settings(settings) {}
+	~Workload() = default;
+
+	// Returns an error message if the settings do not match the medium
+	string Init(uint32_t, uint64_t);
+
+	command_t GetNextCommand();
+
+	static bool ParsePattern(const string&, pattern&);
+
+private:
+
+	settings_t settings;
+
+	uint32_t blocks = 0;
+
+	// The number of commands in the LBA range
+	uint64_t slots = 0;
+
+	uint64_t next_slot = 0;
+
+	mt19937_64 random_generator;
+	uniform_int_distribution<uint64_t> slot_distribution;
+	uniform_int_distribution<int> percentage_distribution { 0, 99 };
+};
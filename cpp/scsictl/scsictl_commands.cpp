@@ -84,6 +84,12 @@ bool ScsictlCommands::Execute(string_view log_level, string_view default_folder,
 		case STATISTICS_INFO:
 			return CommandStatisticsInfo();
 
+		case DELAY_PROFILES_INFO:
+			return CommandDelayProfilesInfo();
+
+		case COMMAND_TRACE_INFO:
+			return CommandCommandTraceInfo();
+
 		case OPERATION_INFO:
 			return CommandOperationInfo();
 
@@ -365,6 +371,24 @@ bool ScsictlCommands::CommandStatisticsInfo()
 	return true;
 }
 
+bool ScsictlCommands::CommandDelayProfilesInfo()
+{
+	SendCommand();
+
+	cout << scsictl_display.DisplayDelayProfilesInfo(result.delay_profiles_info()) << flush;
+
+	return true;
+}
+
+bool ScsictlCommands::CommandCommandTraceInfo()
+{
+	SendCommand();
+
+	cout << scsictl_display.DisplayCommandTraceInfo(result.command_trace_info()) << flush;
+
+	return true;
+}
+
 bool ScsictlCommands::CommandOperationInfo()
 {
 	SendCommand();
@@ -49,6 +49,8 @@ private:
 	bool CommandReservedIdsInfo();
 	bool CommandMappingInfo();
 	bool CommandStatisticsInfo();
+	bool CommandDelayProfilesInfo();
+	bool CommandCommandTraceInfo();
 	bool CommandOperationInfo();
 	bool SendCommand();
 	bool EvaluateParams(string_view, const string&, const string&);
@@ -69,7 +69,7 @@ int ScsiCtl::run(const vector<char *>& args) const
 	opterr = 1;
 	int opt;
 	while ((opt = getopt(static_cast<int>(args.size()), args.data(),
-			"e::lmos::vDINOSTVXa:b:c:d:f:h:i:n:p:r:t:x:z:C:E:F:L:P::R:")) != -1) {
+			"e::lmos::vDINOSTVXYa:b:c:d:f:h:i:n:p:r:t:x:y:z:B::C:E:F:K::L:P::R:")) != -1) {
 		switch (opt) {
 			case 'i':
 				if (const string error = SetIdAndLun(*device, optarg); !error.empty()) {
@@ -233,6 +233,37 @@ int ScsiCtl::run(const vector<char *>& args) const
 				SetParam(command, "mode", "rascsi");
 				break;
 
+			case 'y':
+				if (const auto& components = Split(optarg, ':', 2); components.size() == 2) {
+					command.set_operation(DELAY_PROFILE);
+					SetParam(command, "id", components[0]);
+					SetParam(command, "profile", components[1]);
+				}
+				else {
+					cerr << "Error: Invalid delay profile '" << optarg << "', format is ID:PROFILE" << endl;
+					exit(EXIT_FAILURE);
+				}
+				break;
+
+			case 'Y':
+				command.set_operation(DELAY_PROFILES_INFO);
+				break;
+
+			case 'K':
+				command.set_operation(COMMAND_TRACE_INFO);
+				if (optarg) {
+					SetParam(command, "format", optarg);
+				}
+				break;
+
+			case 'B':
+				// Without a file name the trace is stopped
+				command.set_operation(BUS_TRACE);
+				if (optarg) {
+					SetParam(command, "file", optarg);
+				}
+				break;
+
 			case 'z':
 				locale = optarg;
 				break;
@@ -231,6 +231,55 @@ string ScsictlDisplay::DisplayMappingInfo(const PbMappingInfo& mapping_info) con
 	return s.str();
 }
 
+string ScsictlDisplay::DisplayDelayProfilesInfo(const PbDelayProfilesInfo& delay_profiles_info) const
+{
+	ostringstream s;
+
+	s << "Delay profiles:\n";
+
+	vector<PbDelayProfile> sorted_profiles = { delay_profiles_info.profiles().begin(), delay_profiles_info.profiles().end() };
+	ranges::sort(sorted_profiles, [] (const PbDelayProfile& a, const PbDelayProfile& b)
+			{ return a.initiator_id() < b.initiator_id(); });
+
+	for (const auto& profile : sorted_profiles) {
+		s << "  " << profile.initiator_id() << "  " << profile.profile() << ": " << profile.delay() << " us\n";
+	}
+
+	return s.str();
+}
+
+string ScsictlDisplay::DisplayCommandTraceInfo(const PbCommandTraceInfo& command_trace_info) const
+{
+	// The Chrome trace event JSON is meant to be redirected to a file
+	if (!command_trace_info.chrome_trace().empty()) {
+		return command_trace_info.chrome_trace() + "\n";
+	}
+
+	ostringstream s;
+
+	s << "Command trace (durations in us):\n";
+
+	if (command_trace_info.records().empty()) {
+		s << "  No commands have been traced\n";
+		return s.str();
+	}
+
+	// The records are sorted oldest first, the timestamps are relative to the first record
+	const uint64_t start = command_trace_info.records(0).timestamp();
+	for (const auto& record : command_trace_info.records()) {
+		s << "  +" << (record.timestamp() - start) / 1000 << " us  " << record.initiator_id() << " -> "
+				<< record.id() << ":" << record.unit() << "  $" << setfill('0') << setw(2) << hex << record.opcode()
+				<< "  LBA " << dec << record.lba() << ", length " << record.length() << ", status $" << setw(2)
+				<< hex << record.status() << dec << setfill(' ')
+				<< "  selection " << record.selection_duration() / 1000
+				<< ", command " << record.command_duration() / 1000
+				<< ", data " << record.data_duration() / 1000
+				<< ", status " << record.status_duration() / 1000 << '\n';
+	}
+
+	return s.str();
+}
+
 string ScsictlDisplay::DisplayStatisticsInfo(const PbStatisticsInfo& statistics_info) const
 {
 	ostringstream s;
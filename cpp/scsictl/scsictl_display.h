@@ -33,6 +33,8 @@ public:
 	string DisplayNetworkInterfaces(const PbNetworkInterfacesInfo&) const;
 	string DisplayMappingInfo(const PbMappingInfo&) const;
 	string DisplayStatisticsInfo(const PbStatisticsInfo&) const;
+	string DisplayDelayProfilesInfo(const PbDelayProfilesInfo&) const;
+	string DisplayCommandTraceInfo(const PbCommandTraceInfo&) const;
 	string DisplayOperationInfo(const PbOperationInfo&) const;
 
 private:
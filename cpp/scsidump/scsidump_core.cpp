@@ -11,12 +11,11 @@
 //---------------------------------------------------------------------------
 
 // TODO Evaluate CHECK CONDITION after sending a command
-// TODO Send IDENTIFY message in order to support LUNS > 7
 // TODO Get rid of some fields in favor of method arguments
 
 #include "scsidump/scsidump_core.h"
 #include "hal/gpiobus_factory.h"
-#include "hal/systimer.h"
+#include "hal/gpiobus_virtual.h"
 #include "controllers/controller_manager.h"
 #include "shared/piscsi_exceptions.h"
 #include "shared/piscsi_util.h"
@@ -71,7 +70,7 @@ bool ScsiDump::Banner(span<char *> args) const
     return true;
 }
 
-bool ScsiDump::Init() const
+bool ScsiDump::Init()
 {
 	// Signal handler for cleaning up
 	struct sigaction termination_handler;
@@ -82,8 +81,13 @@ bool ScsiDump::Init() const
 	signal(SIGPIPE, SIG_IGN);
 
     bus = GPIOBUS_Factory::Create(BUS::mode_e::INITIATOR);
+    if (bus == nullptr) {
+        return false;
+    }
+
+    executor = make_unique<InitiatorExecutor>(*bus, initiator_id);
 
-    return bus != nullptr;
+    return true;
 }
 
 void ScsiDump::ParseArguments(span<char *> args)
@@ -170,150 +174,30 @@ void ScsiDump::ParseArguments(span<char *> args)
     buffer = vector<uint8_t>(buffer_size);
 }
 
-void ScsiDump::WaitForPhase(phase_t phase) const
-{
-    spdlog::debug(string("Waiting for ") + BUS::GetPhaseStrRaw(phase) + " phase");
-
-    // Timeout (3000ms)
-    const uint32_t now = SysTimer::GetTimerLow();
-    while ((SysTimer::GetTimerLow() - now) < 3'000'000) {
-        bus->Acquire();
-        if (bus->GetREQ() && bus->GetPhase() == phase) {
-            return;
-        }
-    }
-
-    throw phase_exception("Expected " + string(BUS::GetPhaseStrRaw(phase)) + " phase, actual phase is " +
-    		string(BUS::GetPhaseStrRaw(bus->GetPhase())));
-}
-
-void ScsiDump::Selection() const
-{
-    // Set initiator and target ID
-    auto data = static_cast<byte>(1 << initiator_id);
-    data |= static_cast<byte>(1 << target_id);
-    bus->SetDAT(static_cast<uint8_t>(data));
-
-    bus->SetSEL(true);
-
-    WaitForBusy();
-
-    bus->SetSEL(false);
-}
-
-void ScsiDump::Command(scsi_command cmd, vector<uint8_t>& cdb) const
-{
-    spdlog::debug("Executing " + command_mapping.find(cmd)->second.second);
-
-    Selection();
-
-    WaitForPhase(phase_t::command);
-
-    cdb[0] = static_cast<uint8_t>(cmd);
-    cdb[1] = static_cast<uint8_t>(static_cast<byte>(cdb[1]) | static_cast<byte>(target_lun << 5));
-    if (static_cast<int>(cdb.size()) !=
-        bus->SendHandShake(cdb.data(), static_cast<int>(cdb.size()), BUS::SEND_NO_DELAY)) {
-        BusFree();
-
-        throw phase_exception(command_mapping.find(cmd)->second.second + string(" failed"));
-    }
-}
-
-void ScsiDump::DataIn(int length)
-{
-    WaitForPhase(phase_t::datain);
-
-    if (!bus->ReceiveHandShake(buffer.data(), length)) {
-        throw phase_exception("DATA IN failed");
-    }
-}
-
-void ScsiDump::DataOut(int length)
-{
-    WaitForPhase(phase_t::dataout);
-
-    if (!bus->SendHandShake(buffer.data(), length, BUS::SEND_NO_DELAY)) {
-        throw phase_exception("DATA OUT failed");
-    }
-}
-
-void ScsiDump::Status() const
-{
-    WaitForPhase(phase_t::status);
-
-    if (array<uint8_t, 256> buf; bus->ReceiveHandShake(buf.data(), 1) != 1) {
-        throw phase_exception("STATUS failed");
-    }
-}
-
-void ScsiDump::MessageIn() const
-{
-    WaitForPhase(phase_t::msgin);
-
-    if (array<uint8_t, 256> buf; bus->ReceiveHandShake(buf.data(), 1) != 1) {
-        throw phase_exception("MESSAGE IN failed");
-    }
-}
-
-void ScsiDump::BusFree() const
-{
-    bus->Reset();
-}
-
-void ScsiDump::TestUnitReady() const
+void ScsiDump::TestUnitReady()
 {
     vector<uint8_t> cdb(6);
-    Command(scsi_command::eCmdTestUnitReady, cdb);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
+    executor->Execute(scsi_command::eCmdTestUnitReady, cdb, buffer, 0);
 }
 
 void ScsiDump::RequestSense()
 {
     vector<uint8_t> cdb(6);
     cdb[4] = 0xff;
-    Command(scsi_command::eCmdRequestSense, cdb);
-
-    DataIn(256);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
+    executor->Execute(scsi_command::eCmdRequestSense, cdb, buffer, 256);
 }
 
 void ScsiDump::Inquiry()
 {
     vector<uint8_t> cdb(6);
     cdb[4] = 0xff;
-    Command(scsi_command::eCmdInquiry, cdb);
-
-    DataIn(256);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
+    executor->Execute(scsi_command::eCmdInquiry, cdb, buffer, 256);
 }
 
 pair<uint64_t, uint32_t> ScsiDump::ReadCapacity()
 {
     vector<uint8_t> cdb(10);
-    Command(scsi_command::eCmdReadCapacity10, cdb);
-
-    DataIn(8);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
+    executor->Execute(scsi_command::eCmdReadCapacity10, cdb, buffer, 8);
 
     uint64_t capacity = (static_cast<uint32_t>(buffer[0]) << 24) | (static_cast<uint32_t>(buffer[1]) << 16) |
                         (static_cast<uint32_t>(buffer[2]) << 8) | static_cast<uint32_t>(buffer[3]);
@@ -324,15 +208,7 @@ pair<uint64_t, uint32_t> ScsiDump::ReadCapacity()
         cdb.resize(16);
         // READ CAPACITY(16), not READ LONG(16)
         cdb[1] = 0x10;
-        Command(scsi_command::eCmdReadCapacity16_ReadLong16, cdb);
-
-        DataIn(14);
-
-        Status();
-
-        MessageIn();
-
-        BusFree();
+        executor->Execute(scsi_command::eCmdReadCapacity16_ReadLong16, cdb, buffer, 14);
 
         capacity = (static_cast<uint64_t>(buffer[0]) << 56) | (static_cast<uint64_t>(buffer[1]) << 48) |
                    (static_cast<uint64_t>(buffer[2]) << 40) | (static_cast<uint64_t>(buffer[3]) << 32) |
@@ -359,15 +235,7 @@ void ScsiDump::Read10(uint32_t bstart, uint32_t blength, uint32_t length)
     cdb[5] = (uint8_t)bstart;
     cdb[7] = (uint8_t)(blength >> 8);
     cdb[8] = (uint8_t)blength;
-    Command(scsi_command::eCmdRead10, cdb);
-
-    DataIn(length);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
+    executor->Execute(scsi_command::eCmdRead10, cdb, buffer, length);
 }
 
 void ScsiDump::Write10(uint32_t bstart, uint32_t blength, uint32_t length)
@@ -379,35 +247,7 @@ void ScsiDump::Write10(uint32_t bstart, uint32_t blength, uint32_t length)
     cdb[5] = (uint8_t)bstart;
     cdb[7] = (uint8_t)(blength >> 8);
     cdb[8] = (uint8_t)blength;
-    Command(scsi_command::eCmdWrite10, cdb);
-
-    DataOut(length);
-
-    Status();
-
-    MessageIn();
-
-    BusFree();
-}
-
-void ScsiDump::WaitForBusy() const
-{
-    // Wait for busy for up to 2 s
-    int count = 10000;
-    do {
-        // Wait 20 ms
-        const timespec ts = {.tv_sec = 0, .tv_nsec = 20 * 1000};
-        nanosleep(&ts, nullptr);
-        bus->Acquire();
-        if (bus->GetBSY()) {
-            break;
-        }
-    } while (count--);
-
-    // Success if the target is busy
-    if (!bus->GetBSY()) {
-    	throw phase_exception("SELECTION failed");
-    }
+    executor->Execute(scsi_command::eCmdWrite10, cdb, buffer, length);
 }
 
 int ScsiDump::run(span<char *> args)
@@ -424,14 +264,19 @@ int ScsiDump::run(span<char *> args)
         return EXIT_FAILURE;
     }
 
-    if (getuid()) {
+    // A shared virtual bus requires neither root permissions nor any hardware
+    const bool is_virtual_bus = !GPIOBUS_Virtual::GetSharedMemoryName().empty();
+
+    if (!is_virtual_bus && getuid()) {
     	cerr << "Error: GPIO bus access requires root permissions. Are you running as root?" << endl;
         return EXIT_FAILURE;
     }
 
 #ifndef USE_SEL_EVENT_ENABLE
-    cerr << "Error: No PiSCSI hardware support" << endl;
-    return EXIT_FAILURE;
+    if (!is_virtual_bus) {
+        cerr << "Error: No PiSCSI hardware support" << endl;
+        return EXIT_FAILURE;
+    }
 #endif
 
     if (!Init()) {
@@ -497,11 +342,9 @@ void ScsiDump::ScanBus()
 
 bool ScsiDump::DisplayInquiry(ScsiDump::inquiry_info_t& inq_info, bool check_type)
 {
-    // Assert RST for 1 ms
-    bus->SetRST(true);
-    const timespec ts = {.tv_sec = 0, .tv_nsec = 1000 * 1000};
-    nanosleep(&ts, nullptr);
-    bus->SetRST(false);
+    executor->SetTarget(target_id, target_lun);
+
+    executor->ResetBus();
 
     cout << DIVIDER << "\nTarget device is " << target_id << ":" << target_lun << "\n" << flush;
 
@@ -10,20 +10,15 @@
 #pragma once
 
 #include "hal/bus.h"
+#include "initiator/initiator_executor.h"
 #include <memory>
 #include <string>
 #include <span>
 #include <vector>
 #include <unordered_map>
-#include <stdexcept>
 
 using namespace std;
 
-class phase_exception : public runtime_error
-{
-	using runtime_error::runtime_error;
-};
-
 class ScsiDump
 {
 
@@ -48,28 +43,19 @@ class ScsiDump
   private:
 
     bool Banner(span<char *>) const;
-    bool Init() const;
+    bool Init();
     void ParseArguments(span<char *>);
     void DisplayBoardId() const;
     void ScanBus();
     bool DisplayInquiry(inquiry_info_t&, bool);
     int DumpRestore();
     bool GetDeviceInfo(inquiry_info_t&);
-    void WaitForPhase(phase_t) const;
-    void Selection() const;
-    void Command(scsi_defs::scsi_command, vector<uint8_t>&) const;
-    void DataIn(int);
-    void DataOut(int);
-    void Status() const;
-    void MessageIn() const;
-    void BusFree() const;
-    void TestUnitReady() const;
+    void TestUnitReady();
     void RequestSense();
     void Inquiry();
     pair<uint64_t, uint32_t> ReadCapacity();
     void Read10(uint32_t, uint32_t, uint32_t);
     void Write10(uint32_t, uint32_t, uint32_t);
-    void WaitForBusy() const;
 
     static void CleanUp();
     static void TerminationHandler(int);
@@ -77,6 +63,8 @@ class ScsiDump
     // A static instance is needed because of the signal handler
     static inline unique_ptr<BUS> bus;
 
+    unique_ptr<InitiatorExecutor> executor;
+
     vector<uint8_t> buffer;
 
     int target_id = -1;
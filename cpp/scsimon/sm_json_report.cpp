@@ -11,6 +11,7 @@
 
 #include "hal/data_sample_raspberry.h"
 #include "hal/log.h"
+#include "hal/sample_writers.h"
 #include "sm_reports.h"
 #include "string.h"
 #include <fstream>
@@ -48,7 +49,7 @@ uint32_t scsimon_read_json(const string &json_filename, vector<shared_ptr<DataSa
         data_uint = static_cast<uint32_t>(strtoul(data.c_str(), &ptr, 16));
 
         // For reading in JSON files, we'll just assume raspberry pi data types
-        data_capture_array.push_back(make_unique<DataSample_Raspberry>(data_uint, timestamp_uint));
+        data_capture_array.push_back(make_unique<DataSample_Raspberry<>>(data_uint, timestamp_uint));
 
         sample_count++;
         if (sample_count == UINT32_MAX) {
@@ -73,20 +74,11 @@ void scsimon_generate_json(const string &filename, const vector<shared_ptr<DataS
     ofstream json_ofstream;
     json_ofstream.open(filename.c_str(), ios::out);
 
-    json_ofstream << "[" << endl;
-
-    size_t i             = 0;
-    size_t capture_count = data_capture_array.size();
-    for (auto data : data_capture_array) {
-        json_ofstream << fmt::format("{{\"id\": \"{0:d}\", \"timestamp\":\"{1:#016x}\", \"data\":\"{2:#08x}\"}}", i,
-                                     data->GetTimestamp(), data->GetRawCapture());
-
-        if (i != (capture_count - 1)) {
-            json_ofstream << ",";
-        }
-        json_ofstream << endl;
-        i++;
+    JsonWriter writer(json_ofstream);
+    writer.WriteHeader();
+    for (const auto &data : data_capture_array) {
+        writer.WriteSample(*data);
     }
-    json_ofstream << "]" << endl;
+    writer.WriteFooter();
     json_ofstream.close();
 }
@@ -0,0 +1,188 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_exceptions.h"
+#include "controllers/controller_manager.h"
+#include "devices/primary_device.h"
+#include "scsireplay/replay_controller.h"
+#include <algorithm>
+
+using namespace std;
+using namespace scsi_defs;
+
+ReplayController::ReplayController(BUS& bus, int target_id)
+	: AbstractController(bus, target_id, ControllerManager::GetScsiLunMax())
+{
+	AllocateBuffer(DEFAULT_BUFFER_SIZE);
+}
+
+status ReplayController::Execute(const CommandRecorder::command_t& command)
+{
+	initiator_id = command.initiator_id;
+	lun = command.lun;
+
+	// CDBs are at most 16 bytes long
+	for (size_t i = 0; i < min(command.cdb.size(), GetCmd().size()); i++) {
+		SetCmdByte(static_cast<int>(i), command.cdb[i]);
+	}
+
+	SetPhase(phase_t::command);
+	ResetOffset();
+	SetLength(0);
+	SetBlocks(1);
+	SetByteTransfer(false);
+	ClearTransferHandler();
+
+	if (GetOpcode() != scsi_command::eCmdRequestSense) {
+		SetStatus(status::good);
+	}
+
+	const auto device = GetDeviceForLun(lun);
+	if (device == nullptr) {
+		Error(sense_key::illegal_request, asc::invalid_lun);
+		return GetStatus();
+	}
+
+	if (GetOpcode() != scsi_command::eCmdRequestSense) {
+		device->SetStatusCode(0);
+	}
+
+	if (!device->CheckReservation(initiator_id, GetOpcode(), GetCmdByte(4) & 0x01)) {
+		Error(sense_key::aborted_command, asc::no_additional_sense_information, status::reservation_conflict);
+		return GetStatus();
+	}
+
+	try {
+		device->Dispatch(GetOpcode());
+
+		if (IsDataIn()) {
+			TransferDataIn();
+		}
+		else if (IsDataOut()) {
+			TransferDataOut(command.data_out);
+		}
+	}
+	catch(const scsi_exception& e) {
+		Error(e.get_sense_key(), e.get_asc());
+	}
+
+	return GetStatus();
+}
+
+void ReplayController::Error(sense_key sense_key, asc asc, status status)
+{
+	const int effective_lun = HasDeviceForLun(lun) ? lun : 0;
+
+	if (HasDeviceForLun(effective_lun) &&
+			(sense_key != sense_key::no_sense || asc != asc::no_additional_sense_information)) {
+		LogDebug("Error status: Sense Key ${0:02x}, ASC ${1:02x}", static_cast<int>(sense_key), static_cast<int>(asc));
+
+		// Set Sense Key and ASC for a subsequent REQUEST SENSE
+		GetDeviceForLun(effective_lun)->SetStatusCode((static_cast<int>(sense_key) << 16) | (static_cast<int>(asc) << 8));
+	}
+
+	SetStatus(status);
+	SetMessage(0x00);
+
+	Status();
+}
+
+void ReplayController::DataIn()
+{
+	if (!HasValidLength()) {
+		Status();
+		return;
+	}
+
+	SetPhase(phase_t::datain);
+	ResetOffset();
+}
+
+void ReplayController::DataOut()
+{
+	if (!HasValidLength()) {
+		Status();
+		return;
+	}
+
+	SetPhase(phase_t::dataout);
+	ResetOffset();
+}
+
+// Same block handling as ScsiController::Send(), with the bus handshake replaced by a byte count
+void ReplayController::TransferDataIn()
+{
+	while (IsDataIn()) {
+		bytes_in += GetLength();
+		UpdateOffsetAndLength();
+
+		DecrementBlocks();
+		if (!HasBlocks()) {
+			Status();
+			return;
+		}
+
+		if (!HasTransferHandler()) {
+			Error(sense_key::aborted_command);
+			return;
+		}
+
+		SetLength(TransferBlock(GetNext()));
+		IncrementNext();
+		ResetOffset();
+	}
+}
+
+// Same block handling as ScsiController::Receive(), with the bus handshake replaced by the recorded data
+void ReplayController::TransferDataOut(const vector<vector<uint8_t>>& data_out)
+{
+	auto chunk = data_out.begin();
+
+	while (IsDataOut()) {
+		// The device must request exactly the same amount of data as during the recording
+		if (chunk == data_out.end() || chunk->size() != GetLength()) {
+			LogWarn("Recorded data out phase data do not match the {} byte(s) requested by the device", GetLength());
+			Error(sense_key::aborted_command);
+			return;
+		}
+
+		AllocateBuffer(GetOffset() + chunk->size());
+		ranges::copy(*chunk, GetBuffer().begin() + GetOffset());
+		bytes_out += chunk->size();
+		++chunk;
+
+		if (IsByteTransfer()) {
+			const uint32_t count = GetLength();
+			SetByteTransfer(false);
+			if (!GetDeviceForLun(lun)->WriteByteSequence(span(GetBuffer().data(), count))) {
+				Error(sense_key::aborted_command);
+				return;
+			}
+
+			Status();
+			return;
+		}
+
+		UpdateOffsetAndLength();
+
+		DecrementBlocks();
+		if (HasTransferHandler()) {
+			const int length = TransferBlock(GetNext() - 1);
+			IncrementNext();
+			if (HasBlocks()) {
+				SetLength(length);
+				ResetOffset();
+			}
+		}
+
+		if (!HasBlocks()) {
+			Status();
+		}
+	}
+}
@@ -0,0 +1,65 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Controller that executes recorded commands directly against the devices, without any bus handshake.
+// The data in phase data are discarded, the data out phase data are taken from the recording.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "controllers/abstract_controller.h"
+#include "controllers/command_recorder.h"
+
+using namespace std;
+
+class ReplayController : public AbstractController
+{
+public:
+
+	ReplayController(BUS&, int);
+	~ReplayController() override = default;
+
+	// Returns the status of the command
+	scsi_defs::status Execute(const CommandRecorder::command_t&);
+
+	uint64_t GetBytesIn() const { return bytes_in; }
+	uint64_t GetBytesOut() const { return bytes_out; }
+
+	void Error(scsi_defs::sense_key, scsi_defs::asc = scsi_defs::asc::no_additional_sense_information,
+			scsi_defs::status = scsi_defs::status::check_condition) override;
+
+	int GetInitiatorId() const override { return initiator_id; }
+	int GetEffectiveLun() const override { return lun; }
+
+	// Phases
+	void BusFree() override { SetPhase(phase_t::busfree); }
+	void Selection() override { SetPhase(phase_t::selection); }
+	void Command() override { SetPhase(phase_t::command); }
+	void Status() override { SetPhase(phase_t::status); }
+	void DataIn() override;
+	void DataOut() override;
+	void MsgIn() override { SetPhase(phase_t::msgin); }
+	void MsgOut() override { SetPhase(phase_t::msgout); }
+
+	// There is no bus to process
+	bool Process(int) override { return false; }
+
+private:
+
+	void TransferDataIn();
+	void TransferDataOut(const vector<vector<uint8_t>>&);
+
+	static const int DEFAULT_BUFFER_SIZE = 0x10000;
+
+	int initiator_id = UNKNOWN_INITIATOR_ID;
+
+	int lun = 0;
+
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+};
@@ -0,0 +1,244 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "shared/piscsi_exceptions.h"
+#include "shared/piscsi_util.h"
+#include "controllers/controller_manager.h"
+#include "devices/device_factory.h"
+#include "devices/storage_device.h"
+#include "scsireplay/scsireplay_core.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace spdlog;
+using namespace scsi_defs;
+using namespace piscsi_util;
+
+bool ScsiReplay::Banner(span<char *> args) const
+{
+	cout << piscsi_util::Banner("(Command Replay Utility)");
+
+	if (args.size() < 2 || string(args[1]) == "-h" || string(args[1]) == "--help") {
+		cout << "Usage: " << args[0] << " -f RECORDING [-p] [-L LOG_LEVEL] -d ID[:LUN] FILE ...\n"
+				<< " RECORDING is a command recording created with 'piscsi -T'.\n"
+				<< " ID is the target device ID (0-" << (ControllerManager::GetScsiIdMax() - 1) << ").\n"
+				<< " LUN is the optional target device LUN (0-" << (ControllerManager::GetScsiLunMax() -1 ) << ")."
+				<< " Default is 0.\n"
+				<< " FILE is the image file of the device. It is modified by recorded write commands.\n"
+				<< " -p replays with the recorded delays between the commands instead of as fast as possible.\n\n"
+				<< "See the scsireplay man page for all supported parameters\n"
+				<< flush;
+
+		return false;
+	}
+
+	return true;
+}
+
+void ScsiReplay::ParseArguments(span<char *> args)
+{
+	int id = -1;
+	int lun = 0;
+
+	opterr = 0;
+	int opt;
+	while ((opt = getopt(static_cast<int>(args.size()), args.data(), "-d:f:L:p")) != -1) {
+		switch (opt) {
+			case 'd':
+				if (const string error = ProcessId(optarg, id, lun); !error.empty()) {
+					throw parser_exception(error);
+				}
+				break;
+
+			case 'f':
+				recording = optarg;
+				break;
+
+			case 'L':
+				if (const auto level = level::from_str(optarg); level != level::off || string(optarg) == "off") {
+					set_level(level);
+				}
+				else {
+					throw parser_exception("Invalid log level '" + string(optarg) + "'");
+				}
+				break;
+
+			case 'p':
+				paced = true;
+				break;
+
+			case 1:
+				// Encountered image file
+				if (id == -1) {
+					throw parser_exception("Missing device ID for '" + string(optarg) + "'");
+				}
+				AttachDevice(id, lun, optarg);
+				id = -1;
+				lun = 0;
+				break;
+
+			default:
+				throw parser_exception("Parser error");
+		}
+	}
+
+	if (recording.empty()) {
+		throw parser_exception("Missing command recording, use the -f option");
+	}
+
+	if (controllers.empty()) {
+		throw parser_exception("Missing device, use the -d option");
+	}
+}
+
+void ScsiReplay::AttachDevice(int id, int lun, const string& filename)
+{
+	const auto device = DeviceFactory().CreateDevice(UNDEFINED, lun, filename);
+	if (device == nullptr) {
+		throw parser_exception("Can't derive the device type from the filename '" + filename + "'");
+	}
+
+	device->SetRemoved(false);
+
+	if (const auto storage_device = dynamic_pointer_cast<StorageDevice>(device); storage_device != nullptr) {
+		storage_device->SetFilename(filename);
+		try {
+			storage_device->Open();
+		}
+		catch(const io_exception& e) {
+			throw parser_exception(e.what());
+		}
+	}
+
+	if (!device->Init({})) {
+		throw parser_exception("Can't initialize device " + to_string(id) + ":" + to_string(lun));
+	}
+
+	auto& controller = controllers[id];
+	if (controller == nullptr) {
+		controller = make_unique<ReplayController>(bus, id);
+	}
+
+	if (!controller->AddDevice(device)) {
+		throw parser_exception("Can't attach device " + to_string(id) + ":" + to_string(lun));
+	}
+}
+
+void ScsiReplay::Replay(const vector<CommandRecorder::command_t>& commands)
+{
+	latencies.reserve(commands.size());
+
+	const auto start = chrono::steady_clock::now();
+
+	for (const auto& command : commands) {
+		if (paced) {
+			this_thread::sleep_until(start + chrono::nanoseconds(command.timestamp - commands.front().timestamp));
+		}
+
+		const auto& it = controllers.find(command.target_id);
+		if (it == controllers.end()) {
+			++skipped;
+			continue;
+		}
+
+		const auto command_start = chrono::steady_clock::now();
+		const status s = it->second->Execute(command);
+		latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - command_start).count());
+
+		if (s != status::good) {
+			++failed;
+		}
+	}
+
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+void ScsiReplay::Report() const
+{
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+	for (const auto& [_, controller] : controllers) {
+		bytes_in += controller->GetBytesIn();
+		bytes_out += controller->GetBytesOut();
+	}
+
+	vector<uint64_t> sorted = latencies;
+	ranges::sort(sorted);
+
+	const double seconds = static_cast<double>(elapsed) / 1'000'000'000;
+	const auto per_second = [seconds] (double value) { return seconds > 0 ? value / seconds : 0; };
+	const auto usec = [&sorted] (double percentile) {
+		return static_cast<double>(GetPercentile(sorted, percentile)) / 1000;
+	};
+
+	cout << fixed << setprecision(3)
+			<< "Commands executed: " << latencies.size() << " (" << failed << " with status other than GOOD, "
+			<< skipped << " for unknown targets skipped)\n"
+			<< "Elapsed time:      " << seconds << " s\n"
+			<< "Commands/s:        " << per_second(static_cast<double>(latencies.size())) << '\n'
+			<< "Data in:           " << bytes_in << " bytes, "
+			<< per_second(static_cast<double>(bytes_in)) / 1024 / 1024 << " MiB/s\n"
+			<< "Data out:          " << bytes_out << " bytes, "
+			<< per_second(static_cast<double>(bytes_out)) / 1024 / 1024 << " MiB/s\n"
+			<< "Latency (us):      p50 " << usec(50) << ", p90 " << usec(90) << ", p99 " << usec(99)
+			<< ", max " << usec(100) << '\n'
+			<< flush;
+}
+
+void ScsiReplay::CleanUp() const
+{
+	for (const auto& [_, controller] : controllers) {
+		for (const auto& device : controller->GetDevices()) {
+			device->CleanUp();
+		}
+	}
+}
+
+int ScsiReplay::run(span<char *> args)
+{
+	if (!Banner(args)) {
+		return EXIT_SUCCESS;
+	}
+
+	bus.Init();
+
+	vector<CommandRecorder::command_t> commands;
+	try {
+		ParseArguments(args);
+
+		commands = CommandRecorder::Read(recording);
+	}
+	catch(const parser_exception& e) {
+		cerr << "Error: " << e.what() << endl;
+		CleanUp();
+		return EXIT_FAILURE;
+	}
+	catch(const io_exception& e) {
+		cerr << "Error: " << e.what() << endl;
+		CleanUp();
+		return EXIT_FAILURE;
+	}
+
+	cout << "Replaying " << commands.size() << " command(s) from '" << recording << "'" << (paced ? " with recorded pacing" : "")
+			<< '\n' << flush;
+
+	Replay(commands);
+
+	CleanUp();
+
+	Report();
+
+	return EXIT_SUCCESS;
+}
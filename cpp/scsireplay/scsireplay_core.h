@@ -0,0 +1,60 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// Replays a command recording created with "piscsi -T" against emulated devices, without any SCSI hardware,
+// and reports the throughput and latency distribution
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/gpiobus_virtual.h"
+#include "controllers/command_recorder.h"
+#include "scsireplay/replay_controller.h"
+#include <memory>
+#include <string>
+#include <span>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+class ScsiReplay
+{
+
+public:
+
+	ScsiReplay() = default;
+	~ScsiReplay() = default;
+
+	int run(span<char *>);
+
+private:
+
+	bool Banner(span<char *>) const;
+	void ParseArguments(span<char *>);
+	void AttachDevice(int, int, const string&);
+	void Replay(const vector<CommandRecorder::command_t>&);
+	void Report() const;
+	void CleanUp() const;
+
+	// Only required because the controllers expect a bus, there is no bus access during a replay
+	GPIOBUS_Virtual bus;
+
+	unordered_map<int, unique_ptr<ReplayController>> controllers;
+
+	string recording;
+
+	// Replay with the delays between the commands as recorded instead of as fast as possible
+	bool paced = false;
+
+	// Statistics
+	vector<uint64_t> latencies;
+	uint64_t elapsed = 0;
+	uint64_t skipped = 0;
+	uint64_t failed = 0;
+};
@@ -16,6 +16,7 @@
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <cmath>
 
 using namespace std;
 using namespace filesystem;
@@ -131,6 +132,17 @@ void piscsi_util::LogErrno(const string& msg)
 	spdlog::error(errno ? msg + ": " + string(strerror(errno)) : msg);
 }
 
+uint64_t piscsi_util::GetPercentile(span<const uint64_t> sorted, double percentile)
+{
+	if (sorted.empty()) {
+		return 0;
+	}
+
+	const auto rank = static_cast<size_t>(ceil(percentile / 100 * static_cast<double>(sorted.size())));
+
+	return sorted[clamp(rank, static_cast<size_t>(1), sorted.size()) - 1];
+}
+
 // Pin the thread to a specific CPU
 // TODO Check whether just using a single CPU really makes sense
 void piscsi_util::FixCpu(int cpu)
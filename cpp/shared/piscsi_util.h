@@ -10,6 +10,8 @@
 #pragma once
 
 #include <climits>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -54,5 +56,8 @@ namespace piscsi_util
 
 	void LogErrno(const string&);
 
+	// Nearest-rank percentile of sorted values
+	uint64_t GetPercentile(span<const uint64_t>, double);
+
 	void FixCpu(int);
 }
@@ -10,14 +10,15 @@
 
 #pragma once
 
+#include <array>
 #include <span>
-#include <unordered_map>
 #include <string>
+#include <cstdint>
 
 using namespace std;
 
 // Command Descriptor Block
-using cdb_t = span<const int>;
+using cdb_t = span<const uint8_t>;
 
 namespace scsi_defs
 {
@@ -102,10 +103,14 @@ enum class scsi_command {
     eCmdReadPosition               = 0x34,
     eCmdSynchronizeCache10         = 0x35,
     eCmdReadDefectData10           = 0x37,
+    eCmdWriteBuffer10              = 0x3B,
+    eCmdReadBuffer10               = 0x3C,
     eCmdReadLong10                 = 0x3E,
     eCmdWriteLong10                = 0x3F,
     eCmdReadToc                    = 0x43,
     eCmdGetEventStatusNotification = 0x4A,
+    eCmdLogSelect                  = 0x4C,
+    eCmdLogSense                   = 0x4D,
     eCmdModeSelect10               = 0x55,
     eCmdModeSense10                = 0x5A,
     eCmdRead16                     = 0x88,
@@ -120,7 +125,8 @@ enum class scsi_command {
 enum class status {
 	good 				 = 0x00,
 	check_condition 	 = 0x02,
-	reservation_conflict = 0x18
+	reservation_conflict = 0x18,
+	queue_full			 = 0x28
 };
 
 enum class sense_key {
@@ -147,51 +153,91 @@ enum class asc {
     write_protected                 = 0x27,
     not_ready_to_ready_change       = 0x28,
     power_on_or_reset               = 0x29,
+    command_sequence_error          = 0x2c,
     medium_not_present              = 0x3a,
+    overlapped_commands_attempted   = 0x4e,
     load_or_eject_failed            = 0x53
 };
 
-static const unordered_map<scsi_command, pair<int, string>> command_mapping = {
-    {scsi_command::eCmdTestUnitReady, make_pair(6, "TestUnitReady")},
-    {scsi_command::eCmdRezero, make_pair(6, "Rezero")},
-    {scsi_command::eCmdRequestSense, make_pair(6, "RequestSense")},
-    {scsi_command::eCmdFormatUnit, make_pair(6, "FormatUnit")},
-    {scsi_command::eCmdReassignBlocks, make_pair(6, "ReassignBlocks")},
-    {scsi_command::eCmdRead6, make_pair(6, "Read6/GetMessage10")},
-    {scsi_command::eCmdRetrieveStats, make_pair(6, "RetrieveStats")},
-    {scsi_command::eCmdWrite6, make_pair(6, "Write6/Print/SendMessage10")},
-    {scsi_command::eCmdSeek6, make_pair(6, "Seek6")},
-    {scsi_command::eCmdSetIfaceMode, make_pair(6, "SetIfaceMode")},
-    {scsi_command::eCmdSetMcastAddr, make_pair(6, "SetMcastAddr")},
-    {scsi_command::eCmdEnableInterface, make_pair(6, "EnableInterface")},
-    {scsi_command::eCmdSynchronizeBuffer, make_pair(6, "SynchronizeBuffer")},
-    {scsi_command::eCmdInquiry, make_pair(6, "Inquiry")},
-    {scsi_command::eCmdModeSelect6, make_pair(6, "ModeSelect6")},
-    {scsi_command::eCmdReserve6, make_pair(6, "Reserve6")},
-    {scsi_command::eCmdRelease6, make_pair(6, "Release6")},
-    {scsi_command::eCmdModeSense6, make_pair(6, "ModeSense6")},
-    {scsi_command::eCmdStartStop, make_pair(6, "StartStop")},
-    {scsi_command::eCmdStopPrint, make_pair(6, "StopPrint")},
-    {scsi_command::eCmdSendDiagnostic, make_pair(6, "SendDiagnostic")},
-    {scsi_command::eCmdPreventAllowMediumRemoval, make_pair(6, "PreventAllowMediumRemoval")},
-    {scsi_command::eCmdReadCapacity10, make_pair(10, "ReadCapacity10")},
-    {scsi_command::eCmdRead10, make_pair(10, "Read10")},
-    {scsi_command::eCmdWrite10, make_pair(10, "Write10")},
-    {scsi_command::eCmdSeek10, make_pair(10, "Seek10")},
-    {scsi_command::eCmdVerify10, make_pair(10, "Verify10")},
-    {scsi_command::eCmdSynchronizeCache10, make_pair(10, "SynchronizeCache10")},
-    {scsi_command::eCmdReadDefectData10, make_pair(10, "ReadDefectData10")},
-    {scsi_command::eCmdReadLong10, make_pair(10, "ReadLong10")},
-    {scsi_command::eCmdWriteLong10, make_pair(10, "WriteLong10")},
-    {scsi_command::eCmdReadToc, make_pair(10, "ReadToc")},
-    {scsi_command::eCmdGetEventStatusNotification, make_pair(10, "GetEventStatusNotification")},
-    {scsi_command::eCmdModeSelect10, make_pair(10, "ModeSelect10")},
-    {scsi_command::eCmdModeSense10, make_pair(10, "ModeSense10")},
-    {scsi_command::eCmdRead16, make_pair(16, "Read16")},
-    {scsi_command::eCmdWrite16, make_pair(16, "Write16")},
-    {scsi_command::eCmdVerify16, make_pair(16, "Verify16")},
-    {scsi_command::eCmdSynchronizeCache16, make_pair(16, "SynchronizeCache16")},
-    {scsi_command::eCmdReadCapacity16_ReadLong16, make_pair(16, "ReadCapacity16/ReadLong16")},
-    {scsi_command::eCmdWriteLong16, make_pair(16, "WriteLong16")},
-    {scsi_command::eCmdReportLuns, make_pair(12, "ReportLuns")}};
+enum class transfer_direction {
+    none,
+    in,
+    out
+};
+
+// The command handlers are not part of the descriptor. They are device specific, e.g. $0a is WRITE(6) for disks
+// and PRINT for printers, and are provided by the opcode-indexed handler table of each device.
+struct command_descriptor {
+    scsi_command opcode;
+    // CDB length, 0 if the opcode is not supported
+    int cdb_length;
+    transfer_direction direction;
+    const char *name;
+};
+
+// The properties of all supported commands. Opcodes shared by several device types are only listed once.
+inline constexpr array<command_descriptor, 45> command_descriptors = {{
+    { scsi_command::eCmdTestUnitReady, 6, transfer_direction::none, "TestUnitReady" },
+    { scsi_command::eCmdRezero, 6, transfer_direction::none, "Rezero" },
+    { scsi_command::eCmdRequestSense, 6, transfer_direction::in, "RequestSense" },
+    { scsi_command::eCmdFormatUnit, 6, transfer_direction::none, "FormatUnit" },
+    { scsi_command::eCmdReassignBlocks, 6, transfer_direction::none, "ReassignBlocks" },
+    { scsi_command::eCmdRead6, 6, transfer_direction::in, "Read6/GetMessage10" },
+    { scsi_command::eCmdRetrieveStats, 6, transfer_direction::in, "RetrieveStats" },
+    { scsi_command::eCmdWrite6, 6, transfer_direction::out, "Write6/Print/SendMessage10" },
+    { scsi_command::eCmdSeek6, 6, transfer_direction::none, "Seek6" },
+    { scsi_command::eCmdSetIfaceMode, 6, transfer_direction::out, "SetIfaceMode" },
+    { scsi_command::eCmdSetMcastAddr, 6, transfer_direction::out, "SetMcastAddr" },
+    { scsi_command::eCmdEnableInterface, 6, transfer_direction::none, "EnableInterface" },
+    { scsi_command::eCmdSynchronizeBuffer, 6, transfer_direction::none, "SynchronizeBuffer" },
+    { scsi_command::eCmdInquiry, 6, transfer_direction::in, "Inquiry" },
+    { scsi_command::eCmdModeSelect6, 6, transfer_direction::out, "ModeSelect6" },
+    { scsi_command::eCmdReserve6, 6, transfer_direction::none, "Reserve6" },
+    { scsi_command::eCmdRelease6, 6, transfer_direction::none, "Release6" },
+    { scsi_command::eCmdModeSense6, 6, transfer_direction::in, "ModeSense6" },
+    { scsi_command::eCmdStartStop, 6, transfer_direction::none, "StartStop/StopPrint" },
+    { scsi_command::eCmdSendDiagnostic, 6, transfer_direction::none, "SendDiagnostic" },
+    { scsi_command::eCmdPreventAllowMediumRemoval, 6, transfer_direction::none, "PreventAllowMediumRemoval" },
+    { scsi_command::eCmdReadCapacity10, 10, transfer_direction::in, "ReadCapacity10" },
+    { scsi_command::eCmdRead10, 10, transfer_direction::in, "Read10" },
+    { scsi_command::eCmdWrite10, 10, transfer_direction::out, "Write10" },
+    { scsi_command::eCmdSeek10, 10, transfer_direction::none, "Seek10" },
+    { scsi_command::eCmdVerify10, 10, transfer_direction::out, "Verify10" },
+    { scsi_command::eCmdSynchronizeCache10, 10, transfer_direction::none, "SynchronizeCache10" },
+    { scsi_command::eCmdReadDefectData10, 10, transfer_direction::in, "ReadDefectData10" },
+    { scsi_command::eCmdWriteBuffer10, 10, transfer_direction::out, "WriteBuffer10" },
+    { scsi_command::eCmdReadBuffer10, 10, transfer_direction::in, "ReadBuffer10" },
+    { scsi_command::eCmdReadLong10, 10, transfer_direction::in, "ReadLong10" },
+    { scsi_command::eCmdWriteLong10, 10, transfer_direction::out, "WriteLong10" },
+    { scsi_command::eCmdReadToc, 10, transfer_direction::in, "ReadToc" },
+    { scsi_command::eCmdGetEventStatusNotification, 10, transfer_direction::in, "GetEventStatusNotification" },
+    { scsi_command::eCmdLogSelect, 10, transfer_direction::out, "LogSelect" },
+    { scsi_command::eCmdLogSense, 10, transfer_direction::in, "LogSense" },
+    { scsi_command::eCmdModeSelect10, 10, transfer_direction::out, "ModeSelect10" },
+    { scsi_command::eCmdModeSense10, 10, transfer_direction::in, "ModeSense10" },
+    { scsi_command::eCmdRead16, 16, transfer_direction::in, "Read16" },
+    { scsi_command::eCmdWrite16, 16, transfer_direction::out, "Write16" },
+    { scsi_command::eCmdVerify16, 16, transfer_direction::out, "Verify16" },
+    { scsi_command::eCmdSynchronizeCache16, 16, transfer_direction::none, "SynchronizeCache16" },
+    { scsi_command::eCmdReadCapacity16_ReadLong16, 16, transfer_direction::in, "ReadCapacity16/ReadLong16" },
+    { scsi_command::eCmdWriteLong16, 16, transfer_direction::out, "WriteLong16" },
+    { scsi_command::eCmdReportLuns, 12, transfer_direction::in, "ReportLuns" }
+}};
+
+// Flat lookup table for the command properties, indexed by opcode
+inline constexpr auto command_table = [] {
+    array<command_descriptor, 256> table = {};
+    for (int opcode = 0; opcode < 256; opcode++) {
+        table[opcode] = { static_cast<scsi_command>(opcode), 0, transfer_direction::none, "Unsupported" };
+    }
+    for (const auto& descriptor : command_descriptors) {
+        table[static_cast<int>(descriptor.opcode)] = descriptor;
+    }
+    return table;
+}();
+
+inline constexpr const command_descriptor& GetCommandDescriptor(scsi_command opcode)
+{
+    return command_table[static_cast<uint8_t>(opcode)];
+}
 }; // namespace scsi_defs
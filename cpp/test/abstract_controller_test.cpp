@@ -13,13 +13,14 @@
 
 using namespace scsi_defs;
 
-TEST(AbstractControllerTest, AllocateCmd)
+TEST(AbstractControllerTest, GetCmd)
 {
 	MockAbstractController controller;
 
 	EXPECT_EQ(16, controller.GetCmd().size());
-	controller.AllocateCmd(1234);
-	EXPECT_EQ(1234, controller.GetCmd().size());
+	controller.SetCmdByte(15, 0x12);
+	EXPECT_EQ(0x12, controller.GetCmd()[15]);
+	EXPECT_EQ(controller.GetCmd().data(), controller.GetCmd().data()) << "CDB must not be copied";
 }
 
 TEST(AbstractControllerTest, AllocateBuffer)
@@ -187,3 +188,25 @@ TEST(AbstractControllerTest, Offset)
 	controller.UpdateOffsetAndLength();
 	EXPECT_EQ(0, controller.GetOffset());
 }
+
+TEST(AbstractControllerTest, TransferHandler)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	MockAbstractController controller(bus, 0);
+
+	EXPECT_FALSE(controller.HasTransferHandler());
+
+	uint64_t transferred_block = 0;
+	controller.SetTransferHandler([&transferred_block] (uint64_t block) { transferred_block = block; return 512; });
+	EXPECT_TRUE(controller.HasTransferHandler());
+	EXPECT_EQ(512, controller.TransferBlock(0x1234));
+	EXPECT_EQ(0x1234, transferred_block);
+
+	controller.ClearTransferHandler();
+	EXPECT_FALSE(controller.HasTransferHandler());
+
+	controller.SetTransferHandler([] (uint64_t) { return 0; });
+	EXPECT_CALL(*bus, Reset());
+	controller.Reset();
+	EXPECT_FALSE(controller.HasTransferHandler()) << "Reset must discard the transfer handler";
+}
@@ -0,0 +1,80 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "mocks.h"
+#include "controllers/controller_manager.h"
+#include "devices/scsihd.h"
+#include "test/bench_bus.h"
+#include <spdlog/spdlog.h>
+
+using namespace std;
+using namespace filesystem;
+
+// The complete command processing by ScsiController, from the selection to the bus free phase
+TEST(AllocationTest, CommandExecution)
+{
+	const unsigned int min_exec_time = ScsiController::MIN_EXEC_TIME;
+	ScsiController::SetMinExecTime(0);
+
+	// Plays the initiator without any gmock bookkeeping, which would allocate
+	BenchBus bus;
+	ControllerManager controller_manager;
+
+	const path filename = CreateTempFile(65536);
+	auto hd = make_shared<SCSIHD>(0, false, scsi_level::scsi_2);
+	hd->SetFilename(filename.string());
+	hd->Open();
+	EXPECT_TRUE(hd->Init({}));
+	EXPECT_TRUE(controller_manager.AttachToController(bus, 0, hd));
+
+	const vector<vector<uint8_t>> commands = {
+		// INQUIRY
+		{ 0x12, 0x00, 0x00, 0x00, 0x24, 0x00 },
+		// TEST UNIT READY
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+		// MODE SENSE(6), all pages
+		{ 0x1a, 0x00, 0x3f, 0x00, 0xff, 0x00 },
+		// MODE SENSE(10), all pages
+		{ 0x5a, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00 },
+		// WRITE(10) of 4 blocks
+		{ 0x2a, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x04, 0x00 },
+		// READ(10) of 4 blocks
+		{ 0x28, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x04, 0x00 },
+		// READ(6) of 1 block
+		{ 0x08, 0x00, 0x00, 0x20, 0x01, 0x00 }
+	};
+
+	// Initiator ID 7, target ID 0
+	const int id_data = 0b10000001;
+
+	// The first execution sets up the caches
+	for (const auto& cdb : commands) {
+		bus.Select(id_data, cdb);
+		controller_manager.ProcessOnController(bus.GetDAT());
+		EXPECT_EQ(static_cast<uint8_t>(status::good), bus.GetStatus());
+	}
+
+	// Formatting enabled log messages allocates, which is not part of what is measured
+	const auto level = spdlog::get_level();
+	spdlog::set_level(spdlog::level::off);
+
+	const uint64_t count = GetAllocationCount();
+	for (const auto& cdb : commands) {
+		bus.Select(id_data, cdb);
+		controller_manager.ProcessOnController(bus.GetDAT());
+	}
+	EXPECT_EQ(count, GetAllocationCount()) << "Command execution must not allocate heap memory";
+
+	spdlog::set_level(level);
+
+	hd->CleanUp();
+	remove(filename);
+
+	ScsiController::SetMinExecTime(min_exec_time);
+}
@@ -0,0 +1,159 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// A bus for benchmarking the target side without any bus access. It plays the initiator of a single command:
+// It releases SEL as soon as the target asserts BSY, provides the CDB and accepts or provides any data.
+// In contrast to MockBus there is no gmock overhead on each signal access. Used by the benchmarks and by the
+// allocation test, which runs the benchmarked code paths.
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include "hal/bus.h"
+#include "hal/deadline.h"
+#include "hal/systimer.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+class BenchBus final : public BUS
+{
+
+public:
+
+	// Like with the GPIO buses the controllers need the system timer
+	BenchBus() { SysTimer::Init(); }
+	~BenchBus() override = default;
+
+	// Starts the selection phase of the next command
+	void Select(int id_data, const vector<uint8_t>& command) {
+		cdb = command;
+		dat = static_cast<uint8_t>(id_data);
+		sel = true;
+	}
+
+	uint64_t GetBytesIn() const { return bytes_in; }
+	uint64_t GetBytesOut() const { return bytes_out; }
+	// The status byte of the latest command
+	uint8_t GetStatus() const { return status; }
+	// The TickCounter value when the target asserted BSY the last time
+	uint64_t GetBsyTicks() const { return bsy_ticks; }
+
+	bool Init(mode_e) override { return true; }
+	void Reset() override {
+		bsy = false;
+		sel = false;
+		msg = false;
+		cd = false;
+		io = false;
+		req = false;
+	}
+	void Cleanup() override {
+		// Nothing to clean up
+	}
+
+	uint32_t Acquire() override { return 0; }
+	unique_ptr<DataSample> GetSample(uint64_t) override { return nullptr; }
+
+	int CommandHandShake(vector<uint8_t>& buf) override {
+		ranges::copy(cdb, buf.begin());
+		return static_cast<int>(cdb.size());
+	}
+	int ReceiveHandShake(uint8_t *, int count) override {
+		bytes_out += count;
+		return count;
+	}
+	int SendHandShake(uint8_t *buf, int count, int) override {
+		// Status phase
+		if (cd && io && !msg) {
+			status = buf[0];
+		}
+		bytes_in += count;
+		return count;
+	}
+
+	bool PollSelectEvent() override { return false; }
+	uint64_t GetSelectEventTimestamp() const override { return 0; }
+
+	bool GetSignal(int) const override { return false; }
+	void SetSignal(int, bool) override {
+		// Not used by the controllers
+	}
+
+	bool GetBSY() const override { return bsy; }
+	void SetBSY(bool ast) override {
+		bsy = ast;
+		// The initiator ends the selection
+		if (ast) {
+			bsy_ticks = TickCounter::Now();
+			sel = false;
+		}
+	}
+	bool GetSEL() const override { return sel; }
+	void SetSEL(bool ast) override { sel = ast; }
+	bool GetATN() const override { return false; }
+	void SetATN(bool) override {
+		// Only asserted by an initiator
+	}
+	bool GetACK() const override { return false; }
+	void SetACK(bool) override {
+		// Only asserted by an initiator
+	}
+	bool GetRST() const override { return false; }
+	void SetRST(bool) override {
+		// Only asserted by an initiator
+	}
+	bool GetMSG() const override { return msg; }
+	void SetMSG(bool ast) override { msg = ast; }
+	bool GetCD() const override { return cd; }
+	void SetCD(bool ast) override { cd = ast; }
+	bool GetIO() override { return io; }
+	void SetIO(bool ast) override { io = ast; }
+	bool GetREQ() const override { return req; }
+	void SetREQ(bool ast) override { req = ast; }
+	bool GetACT() const override { return false; }
+	void SetACT(bool) override {
+		// There is no board
+	}
+	uint8_t GetDAT() override { return dat; }
+	void SetDAT(uint8_t d) override { dat = d; }
+	void SetENB(bool) override {
+		// There is no board
+	}
+	void PinConfig(int, int) override {
+		// There are no pins
+	}
+	void PullConfig(int, int) override {
+		// There are no pins
+	}
+	void SetControl(int, bool) override {
+		// There are no pins
+	}
+	void SetMode(int, int) override {
+		// There are no pins
+	}
+
+private:
+
+	vector<uint8_t> cdb;
+
+	bool bsy = false;
+	bool sel = false;
+	bool msg = false;
+	bool cd = false;
+	bool io = false;
+	bool req = false;
+	uint8_t dat = 0;
+	uint8_t status = 0;
+
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+
+	uint64_t bsy_ticks = 0;
+};
@@ -12,7 +12,7 @@
 
 TEST(BusTest, GetCommandByteCount)
 {
-    EXPECT_EQ(41, scsi_defs::command_mapping.size());
+    EXPECT_EQ(45U, scsi_defs::command_descriptors.size());
     EXPECT_EQ(6, BUS::GetCommandByteCount(0x00));
     EXPECT_EQ(6, BUS::GetCommandByteCount(0x01));
     EXPECT_EQ(6, BUS::GetCommandByteCount(0x03));
@@ -57,6 +57,20 @@ TEST(BusTest, GetCommandByteCount)
     EXPECT_EQ(0, BUS::GetCommandByteCount(0x1f));
 }
 
+TEST(BusTest, GetCommandDescriptor)
+{
+    for (const auto& descriptor : scsi_defs::command_descriptors) {
+        EXPECT_EQ(descriptor.opcode, GetCommandDescriptor(descriptor.opcode).opcode);
+        EXPECT_EQ(descriptor.cdb_length, BUS::GetCommandByteCount(static_cast<uint8_t>(descriptor.opcode)));
+    }
+
+    EXPECT_STREQ("Inquiry", GetCommandDescriptor(scsi_command::eCmdInquiry).name);
+    EXPECT_EQ(transfer_direction::in, GetCommandDescriptor(scsi_command::eCmdRead10).direction);
+    EXPECT_EQ(transfer_direction::out, GetCommandDescriptor(scsi_command::eCmdModeSelect6).direction);
+    EXPECT_EQ(transfer_direction::none, GetCommandDescriptor(scsi_command::eCmdTestUnitReady).direction);
+    EXPECT_STREQ("Unsupported", GetCommandDescriptor(static_cast<scsi_command>(0x1f)).name);
+}
+
 TEST(BusTest, GetPhase)
 {
     EXPECT_EQ(phase_t::dataout, BUS::GetPhase(0b000));
@@ -0,0 +1,128 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "test_shared.h"
+#include "hal/bus.h"
+#include "hal/bus_tracer.h"
+#include "hal/data_sample_raspberry.h"
+#include "hal/sample_writers.h"
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static string ReadFile(const path& filename)
+{
+	ifstream in(filename);
+	stringstream buffer;
+	buffer << in.rdbuf();
+
+	return buffer.str();
+}
+
+static const BusTracer::decoder DECODER = [] (uint32_t signals, uint64_t timestamp) -> unique_ptr<DataSample> {
+	return make_unique<DataSample_Raspberry<>>(signals, timestamp);
+};
+
+TEST(BusTracerTest, VcdWriter)
+{
+	ostringstream out;
+	VcdWriter writer(out);
+
+	writer.WriteHeader();
+	const string header = out.str();
+	EXPECT_NE(string::npos, header.find("$timescale 1 ns $end"));
+	EXPECT_NE(string::npos, header.find("$var wire 8 # data $end"));
+	EXPECT_TRUE(header.ends_with("$end\n"));
+
+	out.str("");
+	writer.WriteSample(DataSample_Raspberry<>(1 << DefaultConnection::PIN_BSY, 0), 100);
+	EXPECT_EQ("#100\n1)\ns" + string(BUS::GetPhaseStrRaw(phase_t::dataout)) + " =\n", out.str());
+
+	out.str("");
+	writer.WriteSample(DataSample_Raspberry<>(1 << DefaultConnection::PIN_BSY, 0), 200);
+	EXPECT_EQ("#200\n", out.str()) << "Only changes must be written";
+
+	out.str("");
+	writer.WriteSample(DataSample_Raspberry<>((1 << DefaultConnection::PIN_BSY) |
+			(1 << DefaultConnection::PIN_DT0), 0), 300);
+	EXPECT_EQ("#300\nb1 #\n", out.str());
+}
+
+TEST(BusTracerTest, JsonWriter)
+{
+	ostringstream out;
+	JsonWriter writer(out);
+
+	writer.WriteHeader();
+	writer.WriteFooter();
+	EXPECT_EQ("[\n]\n", out.str());
+
+	out.str("");
+	JsonWriter writer2(out);
+	writer2.WriteHeader();
+	writer2.WriteSample(DataSample_Raspberry<>(0x12345678, 0x10));
+	writer2.WriteSample(DataSample_Raspberry<>(0x87654321, 0x20));
+	writer2.WriteFooter();
+	EXPECT_EQ(R"([
+{"id": "0", "timestamp":"0x00000000000010", "data":"0x12345678"},
+{"id": "1", "timestamp":"0x00000000000020", "data":"0x87654321"}
+]
+)", out.str());
+}
+
+TEST(BusTracerTest, StartStop)
+{
+	BusTracer tracer;
+	EXPECT_FALSE(tracer.IsActive());
+	EXPECT_FALSE(tracer.Start("", DECODER).empty());
+	EXPECT_FALSE(tracer.IsActive());
+	EXPECT_FALSE(tracer.Start("/non_existing_folder/trace", DECODER).empty());
+	EXPECT_FALSE(tracer.IsActive());
+
+	const auto [fd, base_name] = OpenTempFile();
+	close(fd);
+
+	EXPECT_TRUE(tracer.Start(base_name, DECODER).empty());
+	EXPECT_TRUE(tracer.IsActive());
+	EXPECT_FALSE(tracer.Start(base_name, DECODER).empty()) << "Tracing must not be started twice";
+
+	const uint32_t dt0 = 1 << DefaultConnection::PIN_DT0;
+	const uint32_t dt1 = 1 << DefaultConnection::PIN_DT1;
+	tracer.Add(dt0);
+	tracer.Add(dt0);
+	tracer.Add(dt0 | dt1);
+	tracer.Add(dt0);
+	tracer.Stop();
+	EXPECT_FALSE(tracer.IsActive());
+	EXPECT_EQ(3U, tracer.GetSampleCount()) << "Unchanged signals must not be recorded";
+	EXPECT_EQ(0U, tracer.GetDroppedCount());
+
+	const string json = ReadFile(base_name.string() + ".json");
+	EXPECT_NE(string::npos, json.find(R"("id": "2")"));
+	EXPECT_NE(string::npos, json.find(fmt::format(R"("data":"{:#08x}")", dt0 | dt1)));
+	EXPECT_TRUE(json.ends_with("}\n]\n"));
+
+	const string vcd = ReadFile(base_name.string() + ".vcd");
+	EXPECT_NE(string::npos, vcd.find("$enddefinitions $end"));
+	EXPECT_NE(string::npos, vcd.find("b11 #"));
+
+	// Restarting must not append to the previous trace
+	EXPECT_TRUE(tracer.Start(base_name, DECODER).empty());
+	tracer.Add(dt0);
+	tracer.Stop();
+	EXPECT_EQ(1U, tracer.GetSampleCount());
+	EXPECT_EQ(string::npos, ReadFile(base_name.string() + ".json").find(R"("id": "1")"));
+
+	remove(base_name);
+	remove(base_name.string() + ".json");
+	remove(base_name.string() + ".vcd");
+}
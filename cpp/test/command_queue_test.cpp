@@ -0,0 +1,159 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "controllers/command_queue.h"
+#include <vector>
+
+using tag_type = CommandQueue::tag_type;
+
+static vector<uint8_t> CreateRead10(uint32_t block, uint16_t count)
+{
+	return { 0x28, 0x00, static_cast<uint8_t>(block >> 24), static_cast<uint8_t>(block >> 16),
+		static_cast<uint8_t>(block >> 8), static_cast<uint8_t>(block), 0x00, static_cast<uint8_t>(count >> 8),
+		static_cast<uint8_t>(count), 0x00 };
+}
+
+static vector<uint8_t> CreateWrite6(uint32_t block, uint8_t count)
+{
+	return { 0x0a, static_cast<uint8_t>((block >> 16) & 0x1f), static_cast<uint8_t>(block >> 8),
+		static_cast<uint8_t>(block), count, 0x00 };
+}
+
+static const vector<uint8_t> TEST_UNIT_READY = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static vector<uint8_t> PopTags(CommandQueue& queue)
+{
+	vector<uint8_t> tags;
+	while (!queue.IsEmpty()) {
+		tags.push_back(queue.Pop().tag);
+	}
+
+	return tags;
+}
+
+TEST(CommandQueueTest, AddRemove)
+{
+	CommandQueue queue(2);
+
+	EXPECT_TRUE(queue.IsEmpty());
+	EXPECT_EQ(nullptr, queue.Peek());
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateRead10(0, 1)));
+	EXPECT_TRUE(queue.Add(6, 1, tag_type::simple, CreateRead10(0, 1)));
+	EXPECT_FALSE(queue.Add(7, 2, tag_type::simple, CreateRead10(0, 1))) << "The queue must be full";
+	EXPECT_EQ(2, queue.GetSize());
+
+	EXPECT_TRUE(queue.Contains(7, 1));
+	EXPECT_TRUE(queue.Contains(6, 1));
+	EXPECT_FALSE(queue.Contains(7, 2));
+
+	EXPECT_FALSE(queue.Remove(7, 2));
+	EXPECT_TRUE(queue.Remove(7, 1));
+	EXPECT_FALSE(queue.Contains(7, 1));
+	EXPECT_EQ(1, queue.GetSize());
+
+	queue.RemoveAll(5);
+	EXPECT_EQ(1, queue.GetSize());
+	queue.RemoveAll(6);
+	EXPECT_TRUE(queue.IsEmpty());
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, TEST_UNIT_READY));
+	queue.Clear();
+	EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(CommandQueueTest, BlockRange)
+{
+	CommandQueue queue(4);
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateWrite6(0x12345, 0)));
+	const auto& command = queue.Pop();
+	EXPECT_TRUE(command.has_blocks);
+	EXPECT_FALSE(command.is_read);
+	EXPECT_EQ(0x12345U, command.start);
+	EXPECT_EQ(256U, command.count) << "A count of 0 means 256 blocks";
+	EXPECT_EQ(0x0a, command.cdb[0]);
+
+	const vector<uint8_t> read16 = { 0x88, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x10, 0x00, 0x00 };
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::simple, read16));
+	const auto& read = queue.Pop();
+	EXPECT_TRUE(read.has_blocks);
+	EXPECT_TRUE(read.is_read);
+	EXPECT_EQ(0x100000000U, read.start);
+	EXPECT_EQ(16U, read.count);
+
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::simple, TEST_UNIT_READY));
+	EXPECT_FALSE(queue.Pop().has_blocks);
+}
+
+TEST(CommandQueueTest, ElevatorOrder)
+{
+	CommandQueue queue(8);
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateRead10(500, 10)));
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::simple, CreateRead10(100, 10)));
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::simple, TEST_UNIT_READY));
+	EXPECT_TRUE(queue.Add(7, 4, tag_type::simple, CreateWrite6(300, 10)));
+	EXPECT_TRUE(queue.Add(7, 5, tag_type::simple, CreateRead10(110, 10)));
+
+	// Commands without blocks first, then in ascending block order
+	EXPECT_EQ((vector<uint8_t>{ 3, 2, 5, 4, 1 }), PopTags(queue));
+
+	// The head is at block 510, lower blocks are only executed after wrapping around
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateRead10(100, 10)));
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::simple, CreateRead10(600, 10)));
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::simple, CreateRead10(510, 10)));
+	EXPECT_TRUE(queue.Add(7, 4, tag_type::simple, CreateRead10(50, 10)));
+	EXPECT_EQ((vector<uint8_t>{ 3, 2, 4, 1 }), PopTags(queue));
+}
+
+TEST(CommandQueueTest, HeadOfQueue)
+{
+	CommandQueue queue(4);
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, TEST_UNIT_READY));
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::head_of_queue, CreateRead10(100, 1)));
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::head_of_queue, CreateRead10(0, 1)));
+
+	EXPECT_EQ((vector<uint8_t>{ 2, 3, 1 }), PopTags(queue)) << "HEAD OF QUEUE commands must be executed first";
+}
+
+TEST(CommandQueueTest, Ordered)
+{
+	CommandQueue queue(8);
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateRead10(300, 1)));
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::simple, CreateRead10(200, 1)));
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::ordered, CreateRead10(500, 1)));
+	EXPECT_TRUE(queue.Add(7, 4, tag_type::simple, CreateRead10(100, 1)));
+	EXPECT_TRUE(queue.Add(7, 5, tag_type::simple, TEST_UNIT_READY));
+
+	// The ORDERED command is a barrier for the commands received after it
+	EXPECT_EQ((vector<uint8_t>{ 2, 1, 3, 5, 4 }), PopTags(queue));
+}
+
+TEST(CommandQueueTest, GetMergedReadRange)
+{
+	CommandQueue queue(8);
+
+	EXPECT_TRUE(queue.Add(7, 1, tag_type::simple, CreateRead10(100, 10)));
+	EXPECT_TRUE(queue.Add(7, 2, tag_type::simple, CreateRead10(120, 10)));
+	EXPECT_TRUE(queue.Add(7, 3, tag_type::simple, CreateRead10(110, 10)));
+	EXPECT_TRUE(queue.Add(7, 4, tag_type::simple, CreateWrite6(130, 10)));
+	EXPECT_TRUE(queue.Add(7, 5, tag_type::simple, CreateRead10(200, 10)));
+
+	const auto *next = queue.Peek();
+	ASSERT_NE(nullptr, next);
+	EXPECT_EQ(1, next->tag);
+	const auto [start, count] = queue.GetMergedReadRange(*next);
+	EXPECT_EQ(100U, start);
+	EXPECT_EQ(30U, count) << "Only adjacent READs must be merged";
+}
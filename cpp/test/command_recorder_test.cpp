@@ -0,0 +1,177 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "test/test_shared.h"
+#include "shared/piscsi_exceptions.h"
+#include "controllers/command_recorder.h"
+
+using namespace std;
+using namespace filesystem;
+
+TEST(CommandRecorderTest, AddAndRead)
+{
+	const string filename = CreateTempFile(0).string();
+	const array<uint8_t, 6> write6 = { 0x0a, 0x00, 0x00, 0x01, 0x01, 0x00 };
+	const array<uint8_t, 10> read10 = { 0x28, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x08, 0x00 };
+
+	CommandRecorder recorder;
+	EXPECT_FALSE(recorder.IsOpen());
+	recorder.AddCommand(0, 7, 0, 0, write6);
+
+	EXPECT_TRUE(recorder.Open(filename));
+	EXPECT_TRUE(recorder.IsOpen());
+	recorder.Start();
+	recorder.AddCommand(1000, 7, 2, 1, write6);
+	recorder.AddDataOut(vector<uint8_t>(256, 0x55));
+	recorder.AddDataOut(vector<uint8_t>(256, 0xaa));
+	recorder.AddCommand(2000, -1, 3, 0, read10);
+	recorder.Close();
+	EXPECT_FALSE(recorder.IsOpen());
+
+	const auto commands = CommandRecorder::Read(filename);
+	EXPECT_EQ(2, commands.size());
+	EXPECT_EQ(1000, commands[0].timestamp);
+	EXPECT_EQ(7, commands[0].initiator_id);
+	EXPECT_EQ(2, commands[0].target_id);
+	EXPECT_EQ(1, commands[0].lun);
+	EXPECT_TRUE(ranges::equal(write6, commands[0].cdb));
+	EXPECT_EQ(2, commands[0].data_out.size());
+	EXPECT_EQ(vector<uint8_t>(256, 0x55), commands[0].data_out[0]);
+	EXPECT_EQ(vector<uint8_t>(256, 0xaa), commands[0].data_out[1]);
+	EXPECT_EQ(2000, commands[1].timestamp);
+	EXPECT_EQ(-1, commands[1].initiator_id);
+	EXPECT_EQ(3, commands[1].target_id);
+	EXPECT_TRUE(ranges::equal(read10, commands[1].cdb));
+	EXPECT_TRUE(commands[1].data_out.empty());
+
+	// The values are little endian regardless of the host byte order
+	ifstream in(filename, ios::binary);
+	vector<uint8_t> data(32);
+	in.read(reinterpret_cast<char *>(data.data()), data.size());
+	in.close();
+	EXPECT_EQ((vector<uint8_t>{ 0x01, 0x00, 0x00, 0x00 }), vector<uint8_t>(data.begin() + 8, data.begin() + 12));
+	EXPECT_EQ('C', data[12]);
+	EXPECT_EQ((vector<uint8_t>{ 0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }),
+			vector<uint8_t>(data.begin() + 13, data.begin() + 21));
+
+	resize_file(filename, file_size(filename) - 1);
+	EXPECT_THROW(CommandRecorder::Read(filename), io_exception) << "Truncated recording";
+
+	remove(filename);
+}
+
+TEST(CommandRecorderTest, HandOver)
+{
+	const string filename = CreateTempFile(0).string();
+	const array<uint8_t, 6> write6 = { 0x0a, 0x00, 0x00, 0x00, 0x08, 0x00 };
+
+	// Several times the amount of data the bus thread hands over to the writer at once
+	CommandRecorder recorder;
+	EXPECT_TRUE(recorder.Open(filename));
+	recorder.Start();
+	for (int i = 0; i < 100; i++) {
+		recorder.AddCommand(i, 7, 0, 0, write6);
+		recorder.AddDataOut(vector<uint8_t>(4096, static_cast<uint8_t>(i)));
+	}
+	recorder.Close();
+
+	const auto commands = CommandRecorder::Read(filename);
+	ASSERT_EQ(100U, commands.size());
+	for (int i = 0; i < 100; i++) {
+		EXPECT_EQ(static_cast<uint64_t>(i), commands[i].timestamp);
+		ASSERT_EQ(1U, commands[i].data_out.size());
+		EXPECT_EQ(vector<uint8_t>(4096, static_cast<uint8_t>(i)), commands[i].data_out[0]);
+	}
+
+	remove(filename);
+}
+
+TEST(CommandRecorderTest, DropRecords)
+{
+	const string filename = CreateTempFile(0).string();
+	const array<uint8_t, 6> write6 = { 0x0a, 0x00, 0x00, 0x00, 0x08, 0x00 };
+
+	// Data that can never be buffered are dropped instead of growing the buffer
+	CommandRecorder recorder;
+	EXPECT_TRUE(recorder.Open(filename));
+	recorder.AddCommand(1, 7, 0, 0, write6);
+	recorder.AddDataOut(vector<uint8_t>(2 * 1024 * 1024));
+	EXPECT_EQ(1U, recorder.GetDroppedRecords());
+	recorder.AddDataOut(vector<uint8_t>(16, 0x55));
+	recorder.Close();
+	EXPECT_FALSE(recorder.HasWriteError());
+
+	const auto commands = CommandRecorder::Read(filename);
+	ASSERT_EQ(1U, commands.size());
+	ASSERT_EQ(1U, commands[0].data_out.size());
+	EXPECT_EQ(vector<uint8_t>(16, 0x55), commands[0].data_out[0]);
+
+	remove(filename);
+}
+
+TEST(CommandRecorderTest, WriteError)
+{
+	if (!exists("/dev/full")) {
+		GTEST_SKIP() << "/dev/full is not available";
+	}
+
+	const array<uint8_t, 6> write6 = { 0x0a, 0x00, 0x00, 0x00, 0x08, 0x00 };
+
+	// Writing the header is only buffered, the error is reported by the writer
+	CommandRecorder recorder;
+	EXPECT_TRUE(recorder.Open("/dev/full"));
+	recorder.Start();
+	recorder.AddCommand(1, 7, 0, 0, write6);
+	recorder.Close();
+	EXPECT_TRUE(recorder.HasWriteError());
+
+	// Without a writer thread the data are written when closing
+	EXPECT_TRUE(recorder.Open("/dev/full"));
+	recorder.AddCommand(1, 7, 0, 0, write6);
+	recorder.Close();
+	EXPECT_TRUE(recorder.HasWriteError());
+}
+
+TEST(CommandRecorderTest, Open)
+{
+	CommandRecorder recorder;
+	EXPECT_FALSE(recorder.Open(test_data_temp_path.string() + "/non_existing_folder/recording"));
+	EXPECT_FALSE(recorder.IsOpen());
+}
+
+TEST(CommandRecorderTest, Read)
+{
+	EXPECT_THROW(CommandRecorder::Read("/non_existing_file"), io_exception);
+
+	const string empty = CreateTempFile(0).string();
+	EXPECT_THROW(CommandRecorder::Read(empty), io_exception) << "Missing header";
+	remove(empty);
+
+	const array<byte, 12> data = {};
+	const string invalid = CreateTempFileWithData(data).string();
+	EXPECT_THROW(CommandRecorder::Read(invalid), io_exception) << "Invalid header";
+	remove(invalid);
+
+	const string filename = CreateTempFile(0).string();
+	CommandRecorder recorder;
+	EXPECT_TRUE(recorder.Open(filename));
+	recorder.AddDataOut(vector<uint8_t>(1));
+	recorder.Close();
+	EXPECT_THROW(CommandRecorder::Read(filename), io_exception) << "Data without command";
+	remove(filename);
+
+	// Header, TEST UNIT READY and a data record with a length of 0x7fffffff
+	const array<uint8_t, 32> invalid_length = { 'P', 'I', 'S', 'C', 'S', 'I', 'R', 'C', 0x01, 0x00, 0x00, 0x00,
+			'C', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+			'D', 0xff, 0xff, 0xff, 0x7f, 0x00, 0x00 };
+	const string corrupt = CreateTempFileWithData(as_bytes(span(invalid_length))).string();
+	EXPECT_THROW(CommandRecorder::Read(corrupt), io_exception) << "Invalid data length";
+	remove(corrupt);
+}
@@ -0,0 +1,64 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "controllers/command_trace.h"
+
+TEST(CommandTraceTest, GetRecords)
+{
+	auto trace = make_unique<CommandTrace>();
+
+	EXPECT_TRUE(trace->GetRecords().empty());
+
+	CommandTrace::command_record record = {};
+	record.opcode = 0x28;
+	record.lba = 1;
+	trace->Add(record);
+	auto records = trace->GetRecords();
+	EXPECT_EQ(1, trace->GetCount());
+	EXPECT_EQ(1, records.size());
+	EXPECT_EQ(0x28, records[0].opcode);
+	EXPECT_EQ(1, records[0].lba);
+
+	for (uint64_t lba = 2; lba <= CommandTrace::CAPACITY + 10; lba++) {
+		record.lba = lba;
+		trace->Add(record);
+	}
+	records = trace->GetRecords();
+	EXPECT_EQ(CommandTrace::CAPACITY + 10, trace->GetCount());
+	EXPECT_EQ(CommandTrace::CAPACITY, records.size()) << "Older records must have been overwritten";
+	EXPECT_EQ(11, records.front().lba);
+	EXPECT_EQ(CommandTrace::CAPACITY + 10, records.back().lba);
+}
+
+TEST(CommandTraceTest, GetChromeTrace)
+{
+	EXPECT_EQ(R"({"traceEvents":[]})", CommandTrace::GetChromeTrace({}));
+
+	CommandTrace::command_record record = {};
+	record.timestamp = 1000;
+	record.opcode = 0x28;
+	record.lba = 0x1234;
+	record.length = 8;
+	record.initiator_id = 7;
+	record.target_id = 2;
+	record.lun = 1;
+	record.selection_duration = 2000;
+	record.command_duration = 3000;
+	record.status_duration = 500;
+	const vector<CommandTrace::command_record> records = { record };
+
+	const string json = CommandTrace::GetChromeTrace(records);
+	EXPECT_NE(string::npos, json.find(R"({"name":"Read10","cat":"scsi","ph":"X","ts":1.000,"dur":5.500,"pid":2,"tid":1,)"
+			R"("args":{"opcode":"$28","lba":4660,"length":8,"status":"$00","initiator_id":7}})"));
+	EXPECT_NE(string::npos, json.find(R"("name":"selection","cat":"scsi","ph":"X","ts":1.000,"dur":2.000)"));
+	EXPECT_NE(string::npos, json.find(R"("name":"command","cat":"scsi","ph":"X","ts":3.000,"dur":3.000)"));
+	EXPECT_EQ(string::npos, json.find(R"("name":"data")")) << "Phases that were not entered must be skipped";
+	EXPECT_NE(string::npos, json.find(R"("name":"status","cat":"scsi","ph":"X","ts":6.000,"dur":0.500)"));
+}
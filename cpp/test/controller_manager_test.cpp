@@ -81,7 +81,46 @@ TEST(ControllerManagerTest, AttachToController)
 
 TEST(ControllerManager, ProcessOnController)
 {
+	auto bus = make_shared<MockBus>();
 	ControllerManager controller_manager;
+	DeviceFactory device_factory;
 
 	EXPECT_EQ(AbstractController::piscsi_shutdown_mode::NONE, controller_manager.ProcessOnController(0));
+
+	EXPECT_TRUE(controller_manager.AttachToController(*bus, 3, device_factory.CreateDevice(SCHS, 0, "")));
+	EXPECT_CALL(*bus, Acquire).Times(0);
+	EXPECT_EQ(AbstractController::piscsi_shutdown_mode::NONE, controller_manager.ProcessOnController(0b11110111))
+		<< "Selections of IDs without controller must be ignored";
+}
+
+TEST(ControllerManagerTest, GetServedIds)
+{
+	auto bus = make_shared<MockBus>();
+	ControllerManager controller_manager;
+	DeviceFactory device_factory;
+
+	EXPECT_EQ(0, controller_manager.GetServedIds());
+
+	EXPECT_TRUE(controller_manager.AttachToController(*bus, 0, device_factory.CreateDevice(SCHS, 0, "")));
+	EXPECT_TRUE(controller_manager.AttachToController(*bus, 7, device_factory.CreateDevice(SCHS, 0, "")));
+	EXPECT_TRUE(controller_manager.AttachToController(*bus, 7, device_factory.CreateDevice(SCHS, 1, "")));
+	EXPECT_EQ(0b10000001, controller_manager.GetServedIds());
+	const auto& devices = controller_manager.GetAllDevices();
+	ASSERT_EQ(3U, devices.size());
+	EXPECT_EQ(0, devices[0]->GetId());
+	EXPECT_EQ(7, devices[1]->GetId());
+	EXPECT_EQ(0, devices[1]->GetLun());
+	EXPECT_EQ(7, devices[2]->GetId());
+	EXPECT_EQ(1, devices[2]->GetLun());
+
+	EXPECT_FALSE(controller_manager.HasController(-1));
+	EXPECT_FALSE(controller_manager.HasController(8));
+	EXPECT_EQ(nullptr, controller_manager.FindController(8));
+
+	EXPECT_TRUE(controller_manager.DeleteController(*controller_manager.FindController(0)));
+	EXPECT_EQ(0b10000000, controller_manager.GetServedIds());
+
+	controller_manager.DeleteAllControllers();
+	EXPECT_EQ(0, controller_manager.GetServedIds());
+	EXPECT_TRUE(controller_manager.GetAllDevices().empty());
 }
@@ -40,3 +40,62 @@ TEST(CTapDriverTest, Crc32)
 	}
 	EXPECT_EQ(0xe7870705, CTapDriver::Crc32(span(buf.data(), ETH_FRAME_LEN)));
 }
+
+static void ExpectEqualCrc32(span<const uint8_t> data)
+{
+	const uint32_t crc = CTapDriver::Crc32Bitwise(data);
+	EXPECT_EQ(crc, CTapDriver::Crc32Table(data)) << "Length " << data.size();
+	EXPECT_EQ(crc, CTapDriver::Crc32(data)) << "Length " << data.size();
+	if (CTapDriver::HasHardwareCrc32()) {
+		EXPECT_EQ(crc, CTapDriver::Crc32Hardware(data)) << "Length " << data.size();
+	}
+}
+
+TEST(CTapDriverTest, Crc32Implementations)
+{
+	array<uint8_t, 2> pair;
+	for (int i = 0; i <= 0xffff; i++) {
+		pair[0] = static_cast<uint8_t>(i);
+		pair[1] = static_cast<uint8_t>(i >> 8);
+		ExpectEqualCrc32(span(pair.data(), 1));
+		ExpectEqualCrc32(pair);
+	}
+
+	vector<uint8_t> buf(9000 + 8);
+	uint32_t seed = 1;
+	for (auto& b : buf) {
+		seed = seed * 1103515245 + 12345;
+		b = static_cast<uint8_t>(seed >> 16);
+	}
+
+	// All lengths up to a maximum frame with FCS
+	for (size_t length = 0; length <= ETH_FRAME_LEN + ETH_FCS_LEN; length++) {
+		ExpectEqualCrc32(span(buf).subspan(0, length));
+	}
+
+	// Lengths up to a jumbo frame, at all alignments and with all remainders of the slicing-by-8 loop
+	for (size_t offset = 0; offset < 8; offset++) {
+		for (size_t length = 0; length <= 9000; length += 7) {
+			ExpectEqualCrc32(span(buf).subspan(offset, length));
+		}
+	}
+}
+
+TEST(CTapDriverTest, GetDefaultParams)
+{
+	CTapDriver tap;
+
+	const auto params = tap.GetDefaultParams();
+	EXPECT_EQ(3U, params.size());
+	EXPECT_EQ("10.10.20.1/24", params.at("inet"));
+	EXPECT_EQ("true", params.at("fcs"));
+}
+
+TEST(CTapDriverTest, Init)
+{
+	CTapDriver tap;
+
+	EXPECT_FALSE(tap.Init({ { "fcs", "" } }));
+	EXPECT_FALSE(tap.Init({ { "fcs", "yes" } })) << "Only 'true' and 'false' are valid FCS settings";
+	EXPECT_FALSE(tap.Init({ { "fcs", "False" } }));
+}
@@ -0,0 +1,61 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "hal/deadline.h"
+#include "hal/systimer_generic.h"
+#include <thread>
+
+using namespace std;
+
+TEST(DeadlineTest, TickCounter)
+{
+	EXPECT_LT(0U, TickCounter::GetFrequency());
+
+	const uint64_t ticks = TickCounter::Now();
+	this_thread::sleep_for(1ms);
+	EXPECT_LT(ticks, TickCounter::Now());
+
+	EXPECT_EQ(0U, TickCounter::ToTicks(0ns));
+	EXPECT_NEAR(TickCounter::GetFrequency(), TickCounter::ToTicks(1s), 1);
+	EXPECT_NEAR(1'000'000'000, TickCounter::ToDuration(TickCounter::GetFrequency()).count(), 1);
+}
+
+TEST(DeadlineTest, IsExpired)
+{
+	const Deadline deadline(20ms);
+	EXPECT_FALSE(deadline.IsExpired());
+
+	const Deadline long_deadline(1h);
+
+	const auto start = chrono::steady_clock::now();
+	while (!deadline.IsExpired()) {
+		// Spin like the bus wait loops do
+	}
+	EXPECT_LE(15ms, chrono::steady_clock::now() - start) << "Deadline expired too early";
+	EXPECT_FALSE(long_deadline.IsExpired());
+
+	EXPECT_TRUE(Deadline(0ns).IsExpired());
+}
+
+TEST(DeadlineTest, SysTimerGeneric)
+{
+	SysTimer_Generic timer;
+	timer.Init();
+
+	const uint32_t start = timer.GetTimerLow();
+	timer.SleepUsec(2000);
+	const uint32_t elapsed = timer.GetTimerLow() - start;
+	EXPECT_LE(2000U, elapsed);
+	EXPECT_GT(1'000'000U, elapsed);
+
+	const auto now = chrono::steady_clock::now();
+	timer.SleepNsec(500'000);
+	EXPECT_LE(400us, chrono::steady_clock::now() - now);
+}
@@ -0,0 +1,120 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "mocks.h"
+#include "controllers/delay_profiles.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+using namespace filesystem;
+
+TEST(DelayProfilesTest, SetProfile)
+{
+	DelayProfiles profiles;
+
+	EXPECT_EQ(50, profiles.GetDelay(0, 50)) << "Default profile must use the default delay";
+	EXPECT_EQ(50, profiles.GetDelay(-1, 50)) << "Unknown initiators must use the default delay";
+	EXPECT_EQ(50, profiles.GetDelay(8, 50));
+
+	EXPECT_TRUE(profiles.SetProfile(1, "none").empty());
+	EXPECT_EQ(0, profiles.GetDelay(1, 50));
+	EXPECT_TRUE(profiles.SetProfile(2, "fast").empty());
+	EXPECT_EQ(10, profiles.GetDelay(2, 50));
+	EXPECT_TRUE(profiles.SetProfile(3, "slow").empty());
+	EXPECT_EQ(200, profiles.GetDelay(3, 50));
+	EXPECT_TRUE(profiles.SetProfile(4, "123").empty());
+	EXPECT_EQ(123, profiles.GetDelay(4, 50));
+	EXPECT_TRUE(profiles.SetProfile(4, "default").empty());
+	EXPECT_EQ(50, profiles.GetDelay(4, 50));
+
+	EXPECT_FALSE(profiles.SetProfile(-1, "none").empty());
+	EXPECT_FALSE(profiles.SetProfile(8, "none").empty());
+	EXPECT_FALSE(profiles.SetProfile(0, "").empty());
+	EXPECT_FALSE(profiles.SetProfile(0, "unknown").empty());
+	EXPECT_FALSE(profiles.SetProfile(0, "-1").empty());
+
+	const auto& p = profiles.GetProfiles(50);
+	EXPECT_EQ(8U, p.size());
+	EXPECT_EQ(1, p[1].initiator_id);
+	EXPECT_EQ("none", p[1].name);
+	EXPECT_EQ(0U, p[1].delay);
+	EXPECT_EQ("default", p[0].name);
+	EXPECT_EQ(50U, p[0].delay);
+}
+
+TEST(DelayProfilesTest, Adaptive)
+{
+	DelayProfiles profiles;
+
+	EXPECT_TRUE(profiles.SetProfile(0, "adaptive").empty());
+	EXPECT_EQ(50, profiles.GetDelay(0, 50));
+
+	for (int i = 0; i < DelayProfiles::ADAPTIVE_INTERVAL - 1; i++) {
+		profiles.AddResult(0, true, 50);
+	}
+	EXPECT_EQ(50, profiles.GetDelay(0, 50));
+	profiles.AddResult(0, true, 50);
+	EXPECT_EQ(50 - DelayProfiles::ADAPTIVE_STEP, profiles.GetDelay(0, 50));
+
+	for (int i = 0; i < DelayProfiles::ADAPTIVE_INTERVAL * 20; i++) {
+		profiles.AddResult(0, true, 50);
+	}
+	EXPECT_EQ(0, profiles.GetDelay(0, 50)) << "Delay must not become negative";
+
+	profiles.AddResult(0, false, 50);
+	EXPECT_EQ(DelayProfiles::ADAPTIVE_BACKOFF, profiles.GetDelay(0, 50));
+
+	for (int i = 0; i < DelayProfiles::ADAPTIVE_INTERVAL * 20; i++) {
+		profiles.AddResult(0, true, 50);
+	}
+	EXPECT_EQ(DelayProfiles::ADAPTIVE_BACKOFF, profiles.GetDelay(0, 50)) << "Delay must not go below the backoff delay";
+
+	for (int i = 0; i < 10; i++) {
+		profiles.AddResult(0, false, 50);
+	}
+	EXPECT_EQ(50, profiles.GetDelay(0, 50)) << "Delay must not be increased beyond the default delay";
+
+	profiles.AddResult(1, false, 50);
+	EXPECT_EQ(50, profiles.GetDelay(1, 50)) << "Only adaptive profiles may change";
+}
+
+TEST(DelayProfilesTest, LoadAndSave)
+{
+	const string filename = (temp_directory_path() / ("piscsi_test_delay_profiles-" + to_string(getpid()))).string();
+
+	DelayProfiles profiles;
+	EXPECT_TRUE(profiles.SetProfile(2, "fast").empty());
+	EXPECT_TRUE(profiles.SetProfile(5, "adaptive").empty());
+	for (int i = 0; i < DelayProfiles::ADAPTIVE_INTERVAL * 3; i++) {
+		profiles.AddResult(5, true, 50);
+	}
+	profiles.AddResult(5, false, 50);
+	EXPECT_TRUE(profiles.Save(filename).empty());
+
+	DelayProfiles loaded;
+	EXPECT_TRUE(loaded.Load(filename).empty());
+	EXPECT_EQ(50, loaded.GetDelay(0, 50));
+	EXPECT_EQ(10, loaded.GetDelay(2, 50));
+	EXPECT_EQ(profiles.GetDelay(5, 50), loaded.GetDelay(5, 50)) << "The learned delay must have been restored";
+	EXPECT_EQ("adaptive", loaded.GetProfiles(50)[5].name);
+
+	ofstream(filename) << "# Comment\n\n3 slow\n";
+	EXPECT_TRUE(loaded.Load(filename).empty());
+	EXPECT_EQ(200, loaded.GetDelay(3, 50));
+
+	ofstream(filename) << "x slow\n";
+	EXPECT_FALSE(loaded.Load(filename).empty());
+	ofstream(filename) << "3 unknown\n";
+	EXPECT_FALSE(loaded.Load(filename).empty());
+
+	remove(filename);
+
+	EXPECT_FALSE(loaded.Load(filename).empty()) << "Missing file must be reported";
+}
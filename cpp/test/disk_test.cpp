@@ -597,6 +597,39 @@ TEST(DiskTest, Eject)
 	EXPECT_TRUE(disk.Eject(true));
 }
 
+static bool HasStatistics(const Disk& disk, const string& key)
+{
+	const auto& statistics = disk.GetStatistics();
+	return ranges::any_of(statistics, [&] (const PbStatistics& s) { return s.key() == key && !s.id() && !s.unit(); });
+}
+
+static uint64_t GetStatisticsValue(const Disk& disk, const string& key)
+{
+	for (const auto& s : disk.GetStatistics()) {
+		if (s.key() == key) {
+			return s.value();
+		}
+	}
+
+	ADD_FAILURE() << "Missing statistics item '" << key << "'";
+	return 0;
+}
+
+TEST(DiskTest, GetStatistics)
+{
+	auto [controller, disk] = CreateDisk();
+
+	disk->SetReadOnly(false);
+	EXPECT_TRUE(HasStatistics(*disk, "sector_read_count"));
+	EXPECT_TRUE(HasStatistics(*disk, "sector_write_count"));
+	EXPECT_TRUE(HasStatistics(*disk, "start_stop_cycle_count"));
+	EXPECT_TRUE(HasStatistics(*disk, "command_time_us_count"));
+
+	disk->SetReadOnly(true);
+	EXPECT_TRUE(HasStatistics(*disk, "sector_read_count"));
+	EXPECT_FALSE(HasStatistics(*disk, "sector_write_count")) << "There are no write statistics for read-only media";
+}
+
 void DiskTest_ValidateFormatPage(AbstractController& controller, int offset)
 {
 	const auto& buf = controller.GetBuffer();
@@ -761,6 +794,71 @@ TEST(DiskTest, SynchronizeCache)
 	EXPECT_EQ(status::good, controller->GetStatus());
 }
 
+TEST(DiskTest, IdleScheduler)
+{
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+	auto [controller, disk] = CreateDisk();
+
+	disk->SetIdleScheduler(scheduler);
+	EXPECT_EQ(1, scheduler.RunTasks());
+	disk->SetIdleScheduler(scheduler);
+	EXPECT_EQ(1, scheduler.RunTasks()) << "The write-back task must only be added once";
+
+	disk->CleanUp();
+	EXPECT_EQ(0, scheduler.RunTasks());
+
+	disk->SetIdleScheduler(scheduler);
+	disk.reset();
+	controller.reset();
+	EXPECT_EQ(0, scheduler.RunTasks()) << "The write-back task must be removed when the disk is destroyed";
+}
+
+TEST(DiskTest, SaveChangedSectors)
+{
+	const path filename = CreateTempFile(512 * 512);
+	MetricsRegistry metrics;
+	DiskCache cache(metrics, filename, 9, 512);
+	EXPECT_FALSE(cache.SaveChangedSectors());
+
+	vector<uint8_t> sector(512);
+	EXPECT_TRUE(cache.ReadSector(sector, 0));
+	EXPECT_FALSE(cache.SaveChangedSectors()) << "Reading must not change a track";
+
+	sector[0] = 0x12;
+	EXPECT_TRUE(cache.WriteSector(sector, 0));
+	sector[0] = 0x34;
+	EXPECT_TRUE(cache.WriteSector(sector, 256));
+	EXPECT_TRUE(cache.SaveChangedSectors());
+	EXPECT_TRUE(cache.SaveChangedSectors());
+	EXPECT_FALSE(cache.SaveChangedSectors());
+
+	ifstream in(filename, ios::binary);
+	in.seekg(256 * 512);
+	EXPECT_EQ(0x34, in.get());
+	in.seekg(0);
+	EXPECT_EQ(0x12, in.get());
+	in.close();
+
+	// A step saves a limited number of sectors, i.e. a track may require several steps
+	sector[0] = 0x56;
+	for (int i = 0; i < 40; i++) {
+		EXPECT_TRUE(cache.WriteSector(sector, i));
+	}
+	EXPECT_TRUE(cache.SaveChangedSectors());
+	in.open(filename, ios::binary);
+	in.seekg(39 * 512);
+	EXPECT_EQ(0x00, in.get()) << "The last sectors must not have been saved yet";
+	in.close();
+	EXPECT_TRUE(cache.SaveChangedSectors());
+	EXPECT_FALSE(cache.SaveChangedSectors());
+	in.open(filename, ios::binary);
+	in.seekg(39 * 512);
+	EXPECT_EQ(0x56, in.get());
+
+	remove(filename);
+}
+
 TEST(DiskTest, ReadDefectData)
 {
 	auto [controller, disk] = CreateDisk();
@@ -770,6 +868,129 @@ TEST(DiskTest, ReadDefectData)
 	EXPECT_EQ(status::good, controller->GetStatus());
 }
 
+TEST(DiskTest, LogSense)
+{
+	auto [controller, disk] = CreateDisk();
+	disk->SetSectorSizeInBytes(512);
+	const auto& buf = controller->GetBuffer();
+
+	// Allocation length
+	controller->SetCmdByte(8, 255);
+
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(0x00, buf[0]);
+	EXPECT_EQ(6, GetInt16(buf, 2));
+	EXPECT_EQ(0x00, buf[4]);
+	EXPECT_EQ(0x02, buf[5]);
+	EXPECT_EQ(0x03, buf[6]);
+	EXPECT_EQ(0x0e, buf[7]);
+	EXPECT_EQ(0x30, buf[8]);
+	EXPECT_EQ(0x37, buf[9]);
+	EXPECT_EQ(10U, controller->GetLength());
+
+	// Start-stop cycle counter page, cumulative values
+	controller->SetCmdByte(2, 0x40 | 0x0e);
+	controller->SetCmdByte(4, 0x00);
+	disk->Dispatch(scsi_command::eCmdStartStop);
+	controller->SetCmdByte(4, 0x01);
+	disk->Dispatch(scsi_command::eCmdStartStop);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(0x0e, buf[0]);
+	EXPECT_EQ(4 * 4 + 2 * 6 + 2 * 4, GetInt16(buf, 2));
+	EXPECT_EQ(0x0004, GetInt16(buf, 4 + 2 * 10 + 8));
+	EXPECT_EQ(1, GetInt16(buf, 4 + 2 * 10 + 8 + 6)) << "Wrong number of start-stop cycles";
+
+	// Default cumulative values
+	controller->SetCmdByte(2, 0xc0 | 0x0e);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(0, GetInt16(buf, 4 + 2 * 10 + 8 + 6));
+
+	// Parameter pointer
+	controller->SetCmdByte(2, 0x40 | 0x0e);
+	controller->SetCmdByte(6, 0x04);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(8, GetInt16(buf, 2));
+	EXPECT_EQ(0x0004, GetInt16(buf, 4));
+
+	// Read error counter page
+	controller->SetCmdByte(2, 0x40 | 0x03);
+	controller->SetCmdByte(6, 0x05);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(0x0005, GetInt16(buf, 4));
+	EXPECT_EQ(8, buf[7]);
+	EXPECT_EQ(0x0006, GetInt16(buf, 16));
+
+	// piscsi statistics page
+	controller->SetCmdByte(2, 0x40 | 0x30);
+	controller->SetCmdByte(6, 0x00);
+	disk->AddCommandTime(10);
+	disk->AddCommandTime(20);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(0x30, buf[0]);
+	EXPECT_EQ(0x0001, GetInt16(buf, 4 + 6));
+	EXPECT_EQ(15, GetInt16(buf, 4 + 6 + 6)) << "Wrong average command time";
+
+	// Allocation length
+	controller->SetCmdByte(8, 2);
+	EXPECT_CALL(*controller, DataIn);
+	disk->Dispatch(scsi_command::eCmdLogSense);
+	EXPECT_EQ(2U, controller->GetLength());
+
+	controller->SetCmdByte(2, 0x40 | 0x01);
+	EXPECT_THAT([&] { disk->Dispatch(scsi_command::eCmdLogSense); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "Unsupported log page";
+
+	controller->SetCmdByte(2, 0x00);
+	controller->SetCmdByte(6, 0x01);
+	EXPECT_THAT([&] { disk->Dispatch(scsi_command::eCmdLogSense); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "The supported pages page has no parameter codes";
+
+	controller->SetCmdByte(6, 0x00);
+	controller->SetCmdByte(1, 0x01);
+	EXPECT_THAT([&] { disk->Dispatch(scsi_command::eCmdLogSense); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "Saving parameters is not supported";
+}
+
+TEST(DiskTest, LogSelect)
+{
+	auto [controller, disk] = CreateDisk();
+
+	controller->SetCmdByte(4, 0x00);
+	disk->Dispatch(scsi_command::eCmdStartStop);
+	controller->SetCmdByte(4, 0x01);
+	disk->Dispatch(scsi_command::eCmdStartStop);
+	EXPECT_EQ(1U, GetStatisticsValue(*disk, "start_stop_cycle_count"));
+
+	controller->SetCmdByte(4, 0x00);
+	EXPECT_CALL(*controller, Status);
+	disk->Dispatch(scsi_command::eCmdLogSelect);
+	EXPECT_EQ(1U, GetStatisticsValue(*disk, "start_stop_cycle_count"));
+
+	// Parameter code reset
+	controller->SetCmdByte(1, 0x02);
+	EXPECT_CALL(*controller, Status);
+	disk->Dispatch(scsi_command::eCmdLogSelect);
+	EXPECT_EQ(0U, GetStatisticsValue(*disk, "start_stop_cycle_count"));
+
+	controller->SetCmdByte(8, 1);
+	EXPECT_THAT([&] { disk->Dispatch(scsi_command::eCmdLogSelect); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "Setting parameter values is not supported";
+}
+
 TEST(DiskTest, SectorSize)
 {
 	MockDisk disk;
@@ -7,12 +7,13 @@
 //
 //---------------------------------------------------------------------------
 
+#include "hal/gpiobus_factory.h"
 #include "hal/gpiobus_raspberry.h"
 #include "mocks.h"
 #include <cstdlib>
 #include "test/test_shared.h"
 
-class SetableGpiobusRaspberry : public GPIOBUS_Raspberry
+class SetableGpiobusRaspberry : public GPIOBUS_RaspberryConnection<DefaultConnection>
 {
   public:
     void TestSetGpios(uint32_t value)
@@ -34,6 +35,20 @@ class SetableGpiobusRaspberry : public GPIOBUS_Raspberry
     }
 };
 
+// AIBOM boards use positive logic
+class SetableGpiobusRaspberryAibom : public GPIOBUS_RaspberryConnection<ConnectionAibom>
+{
+  public:
+    void TestSetGpios(uint32_t value)
+    {
+        *level = value;
+    }
+    SetableGpiobusRaspberryAibom()
+    {
+        level = new uint32_t(); // NOSONAR: This is a pointer to a register on the real hardware
+    }
+};
+
 extern "C" {
 uint32_t get_dt_ranges(const char *filename, uint32_t offset);
 uint32_t bcm_host_get_peripheral_address();
@@ -219,3 +234,32 @@ TEST(GpiobusRaspberry, GetREQ)
     bus.Acquire();
     EXPECT_EQ(false, bus.GetREQ());
 }
+
+TEST(GpiobusRaspberry, ConnectionType)
+{
+    SetableGpiobusRaspberryAibom bus;
+
+    bus.TestSetGpios(1 << ConnectionAibom::PIN_DT0 | 1 << ConnectionAibom::PIN_DT7);
+    EXPECT_EQ(0x81, bus.GetDAT());
+
+    bus.TestSetGpios(1 << ConnectionAibom::PIN_SEL);
+    bus.Acquire();
+    EXPECT_TRUE(bus.GetSEL());
+    EXPECT_FALSE(bus.GetBSY());
+    EXPECT_EQ(0, bus.GetDAT());
+    const auto sample = bus.GetSample(0);
+    EXPECT_TRUE(sample->GetSEL()) << "Samples must be decoded with the pin assignment of the connection type";
+    EXPECT_FALSE(sample->GetBSY());
+
+    EXPECT_EQ(4U, GPIOBUS_Factory::GetConnectionTypes().size());
+    EXPECT_TRUE(GPIOBUS_Factory::IsValidConnectionType("standard"));
+    EXPECT_TRUE(GPIOBUS_Factory::IsValidConnectionType("fullspec"));
+    EXPECT_TRUE(GPIOBUS_Factory::IsValidConnectionType("aibom"));
+    EXPECT_TRUE(GPIOBUS_Factory::IsValidConnectionType("gamernium"));
+    EXPECT_FALSE(GPIOBUS_Factory::IsValidConnectionType(""));
+    EXPECT_FALSE(GPIOBUS_Factory::IsValidConnectionType("AIBOM"));
+
+    EXPECT_EQ("AIBOM PRODUCTS version", GPIOBUS_Factory::GetConnectionDescription("aibom"));
+    EXPECT_EQ(DefaultConnection::DESC, GPIOBUS_Factory::GetConnectionDescription(""));
+    EXPECT_EQ("", GPIOBUS_Factory::GetConnectionDescription("AIBOM"));
+}
@@ -0,0 +1,283 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "hal/gpiobus_virtual.h"
+#include <unistd.h>
+#include <sys/wait.h>
+#include <csignal>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+
+static string GetBusName()
+{
+	return "/piscsi_test_bus_" + to_string(getpid());
+}
+
+TEST(GpiobusVirtualTest, GetSharedMemoryName)
+{
+	unsetenv(GPIOBUS_Virtual::SHARED_MEMORY_ENV.c_str());
+	EXPECT_EQ("", GPIOBUS_Virtual::GetSharedMemoryName());
+
+	setenv(GPIOBUS_Virtual::SHARED_MEMORY_ENV.c_str(), "piscsi", 1);
+	EXPECT_EQ("/piscsi", GPIOBUS_Virtual::GetSharedMemoryName());
+
+	setenv(GPIOBUS_Virtual::SHARED_MEMORY_ENV.c_str(), "/piscsi", 1);
+	EXPECT_EQ("/piscsi", GPIOBUS_Virtual::GetSharedMemoryName());
+
+	unsetenv(GPIOBUS_Virtual::SHARED_MEMORY_ENV.c_str());
+}
+
+TEST(GpiobusVirtualTest, WiredOr)
+{
+	GPIOBUS_Virtual target(GetBusName());
+	GPIOBUS_Virtual initiator(GetBusName());
+	ASSERT_TRUE(target.Init(BUS::mode_e::TARGET));
+	ASSERT_TRUE(initiator.Init(BUS::mode_e::INITIATOR));
+	target.Reset();
+	initiator.Reset();
+
+	EXPECT_FALSE(target.GetSEL());
+	initiator.SetSEL(true);
+	EXPECT_TRUE(target.GetSEL());
+	initiator.SetDAT(0x81);
+	EXPECT_EQ(0x81, target.GetDAT());
+
+	// In target mode the data signals are inputs until IO is asserted
+	target.SetDAT(0x42);
+	EXPECT_EQ(0x81, initiator.GetDAT());
+
+	initiator.SetSEL(false);
+	EXPECT_FALSE(target.GetSEL());
+
+	target.SetBSY(true);
+	EXPECT_TRUE(initiator.GetBSY());
+	target.SetIO(true);
+	target.SetDAT(0x42);
+	EXPECT_TRUE(initiator.GetIO()) << "Initiator must switch the data signals to inputs";
+	EXPECT_EQ(0x42, initiator.GetDAT());
+
+	target.SetBSY(false);
+	EXPECT_FALSE(initiator.GetBSY());
+
+	// In target mode RST is an input
+	target.SetRST(true);
+	EXPECT_FALSE(initiator.GetRST());
+
+	// A signal remains asserted as long as any participant asserts it
+	GPIOBUS_Virtual initiator2(GetBusName());
+	ASSERT_TRUE(initiator2.Init(BUS::mode_e::INITIATOR));
+	initiator2.Reset();
+	initiator.SetRST(true);
+	initiator2.SetRST(true);
+	initiator.SetRST(false);
+	EXPECT_TRUE(target.GetRST());
+	initiator2.SetRST(false);
+	EXPECT_FALSE(target.GetRST());
+
+	initiator2.Cleanup();
+	initiator.Cleanup();
+	target.Cleanup();
+}
+
+TEST(GpiobusVirtualTest, HandShake)
+{
+	GPIOBUS_Virtual target(GetBusName());
+	GPIOBUS_Virtual initiator(GetBusName());
+	ASSERT_TRUE(target.Init(BUS::mode_e::TARGET));
+	ASSERT_TRUE(initiator.Init(BUS::mode_e::INITIATOR));
+	target.Reset();
+	initiator.Reset();
+
+	vector<uint8_t> out(1024);
+	iota(out.begin(), out.end(), 0);
+	vector<uint8_t> in(out.size());
+
+	// DATA OUT
+	target.SetBSY(true);
+	target.SetMSG(false);
+	target.SetCD(false);
+	target.SetIO(false);
+	int received = 0;
+	thread receiver([&] { received = target.ReceiveHandShake(in.data(), static_cast<int>(in.size())); });
+	EXPECT_EQ(static_cast<int>(out.size()),
+			initiator.SendHandShake(out.data(), static_cast<int>(out.size()), BUS::SEND_NO_DELAY));
+	receiver.join();
+	EXPECT_EQ(static_cast<int>(in.size()), received);
+	EXPECT_EQ(out, in);
+
+	// DATA IN
+	ranges::fill(in, 0);
+	target.SetIO(true);
+	int sent = 0;
+	thread sender([&] { sent = target.SendHandShake(out.data(), static_cast<int>(out.size()), BUS::SEND_NO_DELAY); });
+	EXPECT_EQ(static_cast<int>(in.size()), initiator.ReceiveHandShake(in.data(), static_cast<int>(in.size())));
+	sender.join();
+	EXPECT_EQ(static_cast<int>(out.size()), sent);
+	EXPECT_EQ(out, in);
+
+	// A reset aborts the handshake
+	initiator.SetRST(true);
+	EXPECT_EQ(0, target.ReceiveHandShake(in.data(), 1));
+
+	initiator.Cleanup();
+	target.Cleanup();
+}
+
+TEST(GpiobusVirtualTest, Participants)
+{
+	vector<unique_ptr<GPIOBUS_Virtual>> buses;
+	for (int i = 0; i < GPIOBUS_Virtual::MAX_PARTICIPANTS; i++) {
+		buses.push_back(make_unique<GPIOBUS_Virtual>(GetBusName()));
+		EXPECT_TRUE(buses.back()->Init(BUS::mode_e::INITIATOR));
+	}
+
+	GPIOBUS_Virtual bus(GetBusName());
+	EXPECT_FALSE(bus.Init(BUS::mode_e::INITIATOR)) << "There must be no free slot";
+
+	buses.front()->Cleanup();
+	EXPECT_TRUE(bus.Init(BUS::mode_e::INITIATOR));
+	bus.Cleanup();
+
+	for (size_t i = 1; i < buses.size(); i++) {
+		buses[i]->Cleanup();
+	}
+}
+
+TEST(GpiobusVirtualTest, DeadParticipant)
+{
+	const string name = GetBusName();
+	GPIOBUS_Virtual target(name);
+	ASSERT_TRUE(target.Init(BUS::mode_e::TARGET));
+	target.Reset();
+
+	array<int, 2> fds;
+	ASSERT_EQ(0, pipe(fds.data()));
+
+	// The child asserts RST and terminates without a cleanup
+	const pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (!pid) {
+		close(fds[0]);
+		GPIOBUS_Virtual initiator(name);
+		if (!initiator.Init(BUS::mode_e::INITIATOR)) {
+			_exit(EXIT_FAILURE);
+		}
+		initiator.Reset();
+		initiator.SetRST(true);
+		if (constexpr char ready = 0; write(fds[1], &ready, 1) != 1) {
+			_exit(EXIT_FAILURE);
+		}
+		pause();
+		_exit(EXIT_SUCCESS);
+	}
+
+	close(fds[1]);
+	char ready;
+	const bool is_ready = read(fds[0], &ready, 1) == 1;
+	close(fds[0]);
+	if (is_ready) {
+		EXPECT_TRUE(target.GetRST());
+	}
+	kill(pid, SIGKILL);
+	waitpid(pid, nullptr, 0);
+	ASSERT_TRUE(is_ready) << "The child process could not assert RST";
+
+	EXPECT_TRUE(target.GetRST()) << "Nobody has noticed the termination yet";
+
+	// A new participant releases the signals of the terminated one
+	GPIOBUS_Virtual initiator(name);
+	ASSERT_TRUE(initiator.Init(BUS::mode_e::INITIATOR));
+	EXPECT_FALSE(target.GetRST());
+
+	initiator.Cleanup();
+	target.Cleanup();
+}
+
+TEST(GpiobusVirtualTest, PollSelectEvent)
+{
+	GPIOBUS_Virtual target(GetBusName());
+	GPIOBUS_Virtual initiator(GetBusName());
+	ASSERT_TRUE(target.Init(BUS::mode_e::TARGET));
+	ASSERT_TRUE(initiator.Init(BUS::mode_e::INITIATOR));
+	target.Reset();
+	initiator.Reset();
+
+	// Without a selection the wait ends in order to let the caller check whether to continue
+	EXPECT_FALSE(target.PollSelectEvent());
+
+	thread selector([&initiator] {
+		this_thread::sleep_for(10ms);
+		initiator.SetDAT(0x81);
+		initiator.SetSEL(true);
+	});
+	EXPECT_TRUE(target.PollSelectEvent());
+	selector.join();
+	EXPECT_TRUE(target.GetSEL());
+	EXPECT_EQ(0x81, target.GetDAT());
+
+	initiator.Cleanup();
+	target.Cleanup();
+}
+
+TEST(GpiobusVirtualTest, Reselect)
+{
+	GPIOBUS_Virtual target(GetBusName());
+	GPIOBUS_Virtual initiator(GetBusName());
+	ASSERT_TRUE(target.Init(BUS::mode_e::TARGET));
+	ASSERT_TRUE(initiator.Init(BUS::mode_e::INITIATOR));
+	target.Reset();
+	initiator.Reset();
+
+	EXPECT_TRUE(target.CanReselect());
+	EXPECT_FALSE(initiator.CanReselect());
+	EXPECT_FALSE(initiator.Reselect(3, 7));
+
+	// The initiator responds to its ID with BSY and releases BSY after the target has released SEL
+	bool reselected = false;
+	thread responder([&] {
+		const auto deadline = chrono::steady_clock::now() + 1s;
+		while (chrono::steady_clock::now() < deadline) {
+			initiator.Acquire();
+			if (initiator.GetSEL() && initiator.GetIO() && !initiator.GetBSY() && initiator.GetDAT() == 0x88) {
+				reselected = true;
+				initiator.SetBSY(true);
+				while (initiator.GetSEL() && chrono::steady_clock::now() < deadline) {
+					initiator.Acquire();
+				}
+				initiator.SetBSY(false);
+				return;
+			}
+		}
+	});
+	EXPECT_TRUE(target.Reselect(3, 7));
+	responder.join();
+	EXPECT_TRUE(reselected);
+	EXPECT_TRUE(initiator.GetBSY()) << "The target must keep BSY asserted";
+	EXPECT_FALSE(initiator.GetSEL());
+
+	target.SetIO(false);
+	target.SetBSY(false);
+
+	EXPECT_FALSE(target.Reselect(3, 6)) << "There is no initiator with ID 6";
+	EXPECT_FALSE(initiator.GetBSY());
+	EXPECT_FALSE(initiator.GetSEL());
+	EXPECT_FALSE(initiator.GetIO());
+
+	// Arbitration requires a free bus
+	initiator.SetBSY(true);
+	EXPECT_FALSE(target.Reselect(3, 7));
+	initiator.SetBSY(false);
+
+	initiator.Cleanup();
+	target.Cleanup();
+}
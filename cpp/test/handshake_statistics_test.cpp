@@ -0,0 +1,103 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "controllers/handshake_statistics.h"
+#include <thread>
+
+using namespace std;
+
+static uint64_t GetStatistics(const MetricsRegistry& metrics, const string& key)
+{
+	for (const auto& s : metrics.GetStatistics()) {
+		if (s.key() == key) {
+			EXPECT_EQ(-1, s.id());
+			EXPECT_EQ(-1, s.unit());
+			return s.value();
+		}
+	}
+
+	ADD_FAILURE() << "Missing statistics item '" << key << "'";
+	return 0;
+}
+
+TEST(HandshakeStatisticsTest, HandshakeTiming)
+{
+	HandshakeTiming timing;
+	EXPECT_FALSE(timing.IsEnabled());
+
+	timing.StartTransfer();
+	timing.StartByte();
+	timing.AckAsserted();
+	timing.EndByte();
+	timing.EndTransfer();
+	EXPECT_EQ(0U, timing.GetTotals().bytes) << "Nothing must be recorded when disabled";
+
+	timing.SetEnabled(true);
+	EXPECT_TRUE(timing.IsEnabled());
+	timing.StartTransfer();
+	for (int i = 0; i < 2; i++) {
+		timing.StartByte();
+		this_thread::sleep_for(1ms);
+		timing.AckAsserted();
+		timing.Delayed();
+		timing.AckDeasserted();
+		timing.EndByte();
+	}
+	timing.EndTransfer();
+
+	const auto& totals = timing.GetTotals();
+	EXPECT_EQ(2U, totals.bytes);
+	EXPECT_LE(TickCounter::ToTicks(2ms), totals.ack_assert_ticks);
+	EXPECT_LE(TickCounter::ToTicks(1ms), totals.slowest_byte_ticks);
+	EXPECT_LE(totals.ack_assert_ticks + totals.ack_deassert_ticks + totals.delay_ticks, totals.total_ticks);
+
+	timing.StartTransfer();
+	EXPECT_EQ(0U, timing.GetTotals().bytes);
+}
+
+TEST(HandshakeStatisticsTest, Add)
+{
+	MetricsRegistry metrics;
+	HandshakeStatistics statistics(metrics);
+	EXPECT_TRUE(metrics.GetStatistics().empty());
+
+	HandshakeTiming::totals_t totals = {};
+	statistics.Add(3, totals);
+	EXPECT_TRUE(metrics.GetStatistics().empty()) << "Empty transfers must be ignored";
+
+	// 10 bytes, 1.5 us per byte spent by the initiator, 900 ns per byte spent by piscsi
+	totals.bytes = 10;
+	totals.ack_assert_ticks = TickCounter::ToTicks(10us);
+	totals.ack_deassert_ticks = TickCounter::ToTicks(5us);
+	totals.delay_ticks = TickCounter::ToTicks(4us);
+	totals.slowest_byte_ticks = TickCounter::ToTicks(3us);
+	totals.total_ticks = TickCounter::ToTicks(24us);
+	statistics.Add(3, totals);
+	statistics.Add(3, totals);
+
+	EXPECT_EQ(2U, GetStatistics(metrics, "handshake_transfers_initiator_3"));
+	EXPECT_EQ(20U, GetStatistics(metrics, "handshake_bytes_initiator_3"));
+	EXPECT_NEAR(20'000, GetStatistics(metrics, "handshake_ack_assert_ns_initiator_3"), 10);
+	EXPECT_NEAR(10'000, GetStatistics(metrics, "handshake_ack_deassert_ns_initiator_3"), 10);
+	EXPECT_NEAR(8'000, GetStatistics(metrics, "handshake_delay_ns_initiator_3"), 10);
+	EXPECT_NEAR(18'000, GetStatistics(metrics, "handshake_target_ns_initiator_3"), 10);
+	EXPECT_NEAR(3'000, GetStatistics(metrics, "handshake_slowest_byte_ns_initiator_3"), 10);
+	EXPECT_EQ(2U, GetStatistics(metrics, "handshake_host_ns_per_byte_initiator_3_count"));
+	EXPECT_EQ(2U, GetStatistics(metrics, "handshake_host_ns_per_byte_initiator_3_le_2047"));
+	EXPECT_EQ(2U, GetStatistics(metrics, "handshake_target_ns_per_byte_initiator_3_le_1023"));
+
+	totals.bytes = 1;
+	totals.ack_assert_ticks = TickCounter::ToTicks(100us);
+	totals.total_ticks = TickCounter::ToTicks(114us);
+	statistics.Add(-1, totals);
+	EXPECT_EQ(1U, GetStatistics(metrics, "handshake_host_ns_per_byte_initiator_unknown_le_131071"));
+	EXPECT_EQ(1U, GetStatistics(metrics, "handshake_target_ns_per_byte_initiator_unknown_le_16383"));
+	EXPECT_EQ(2U, GetStatistics(metrics, "handshake_transfers_initiator_3"));
+}
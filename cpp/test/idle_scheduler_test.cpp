@@ -0,0 +1,155 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "controllers/idle_scheduler.h"
+
+using namespace std;
+
+TEST(IdleSchedulerTest, IsIdle)
+{
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+	scheduler.SetIdleDelay(0ms);
+	EXPECT_TRUE(scheduler.IsIdle());
+	EXPECT_FALSE(scheduler.IsPreempted());
+
+	scheduler.BusBusy();
+	EXPECT_FALSE(scheduler.IsIdle());
+	EXPECT_TRUE(scheduler.IsPreempted());
+
+	scheduler.BusFree();
+	EXPECT_TRUE(scheduler.IsIdle());
+	EXPECT_FALSE(scheduler.IsPreempted());
+
+	scheduler.SetIdleDelay(1h);
+	EXPECT_FALSE(scheduler.IsIdle()) << "The bus has just been busy";
+}
+
+TEST(IdleSchedulerTest, RunTasks)
+{
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+	EXPECT_EQ(0, scheduler.RunTasks());
+
+	vector<int> calls;
+	int steps1 = 3;
+	const int id1 = scheduler.AddTask([&] (const IdleScheduler&) { calls.push_back(1); return --steps1 > 0; });
+	const int id2 = scheduler.AddTask([&] (const IdleScheduler&) { calls.push_back(2); return false; });
+	EXPECT_NE(id1, id2);
+
+	EXPECT_EQ(4, scheduler.RunTasks());
+	EXPECT_EQ((vector<int>{ 1, 2, 1, 1 }), calls) << "The tasks must run round-robin";
+	EXPECT_EQ(4U, metrics.GetValue(IdleScheduler::IDLE_TASK_STEP_COUNT));
+	for (const auto& s : metrics.GetStatistics()) {
+		EXPECT_EQ(-1, s.id()) << "The statistics are not device specific";
+		EXPECT_EQ(-1, s.unit());
+	}
+
+	calls.clear();
+	scheduler.RemoveTask(id1);
+	EXPECT_EQ(1, scheduler.RunTasks());
+	EXPECT_EQ(vector<int>{ 2 }, calls);
+
+	scheduler.RemoveTask(id2);
+	scheduler.RemoveTask(id2);
+	EXPECT_EQ(0, scheduler.RunTasks());
+}
+
+TEST(IdleSchedulerTest, Preemption)
+{
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+
+	int count = 0;
+	scheduler.AddTask([&count] (const IdleScheduler& s) {
+		count++;
+		return !s.IsPreempted();
+	});
+
+	scheduler.BusBusy();
+	EXPECT_EQ(0, scheduler.RunTasks()) << "A preempted task must not be started";
+	EXPECT_EQ(1U, metrics.GetValue(IdleScheduler::IDLE_TASK_PREEMPTED_COUNT));
+	scheduler.BusFree();
+
+	// A selection while a task is running
+	scheduler.AddTask([&scheduler] (const IdleScheduler&) {
+		scheduler.BusBusy();
+		return true;
+	});
+	EXPECT_EQ(2, scheduler.RunTasks());
+	EXPECT_EQ(1, count);
+	EXPECT_EQ(2U, metrics.GetValue(IdleScheduler::IDLE_TASK_PREEMPTED_COUNT));
+}
+
+TEST(IdleSchedulerTest, StartStop)
+{
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+	scheduler.SetIdleDelay(0ms);
+
+	atomic<int> count = 0;
+	scheduler.AddTask([&count] (const IdleScheduler&) {
+		count++;
+		return false;
+	});
+
+	scheduler.Start();
+	for (int i = 0; i < 100 && !count; i++) {
+		this_thread::sleep_for(10ms);
+	}
+	scheduler.Stop();
+	EXPECT_LT(0, count.load());
+
+	count = 0;
+	scheduler.BusBusy();
+	scheduler.Start();
+	this_thread::sleep_for(50ms);
+	scheduler.Stop();
+	EXPECT_EQ(0, count.load()) << "There must be no tasks while the bus is busy";
+}
+
+TEST(IdleSchedulerTest, SelectionDuringTask)
+{
+	// The lock the bus thread holds while processing a command
+	mutex execution_locker;
+	MetricsRegistry metrics;
+	IdleScheduler scheduler(metrics);
+	scheduler.SetIdleDelay(0ms);
+
+	// A task step which takes long, e.g. because of slow I/O
+	atomic<bool> running = false;
+	atomic<bool> selected = false;
+	atomic<bool> finished = false;
+	scheduler.AddTask([&] (const IdleScheduler&) {
+		running = true;
+		for (int i = 0; i < 500 && !selected; i++) {
+			this_thread::sleep_for(10ms);
+		}
+		finished = true;
+		return false;
+	});
+
+	scheduler.Start();
+	for (int i = 0; i < 100 && !running; i++) {
+		this_thread::sleep_for(10ms);
+	}
+	ASSERT_TRUE(running);
+
+	// What the bus thread does when SEL is asserted
+	scheduler.BusBusy();
+	{
+		scoped_lock<mutex> lock(execution_locker);
+		EXPECT_FALSE(finished) << "The response to a selection must not wait for a running task";
+	}
+	selected = true;
+
+	scheduler.Stop();
+	EXPECT_TRUE(finished);
+}
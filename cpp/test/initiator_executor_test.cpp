@@ -0,0 +1,189 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "hal/gpiobus_virtual.h"
+#include "initiator/initiator_executor.h"
+#include <unistd.h>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+
+static string GetBusName()
+{
+	return "/piscsi_test_initiator_" + to_string(getpid());
+}
+
+// A minimal target on the other side of a shared virtual bus, which executes a single command
+class TestTarget
+{
+
+public:
+
+	TestTarget() : bus(GetBusName()) {
+		bus.Init(BUS::mode_e::TARGET);
+		bus.Reset();
+	}
+	~TestTarget() {
+		if (target_thread.joinable()) {
+			target_thread.join();
+		}
+		bus.Cleanup();
+	}
+
+	void Start(phase_t data_phase, int data_length, uint8_t status, int cdb_length = 10) {
+		cdb.resize(cdb_length);
+		target_thread = thread([this, data_phase, data_length, status] { Execute(data_phase, data_length, status); });
+	}
+
+	void Join() { target_thread.join(); }
+
+	vector<uint8_t> cdb;
+	vector<uint8_t> data = vector<uint8_t>(512);
+	int received = 0;
+
+private:
+
+	void Execute(phase_t data_phase, int data_length, uint8_t status) {
+		while (!bus.GetSEL()) {
+			this_thread::yield();
+		}
+		bus.SetBSY(true);
+		while (bus.GetSEL()) {
+			this_thread::yield();
+		}
+
+		SetPhase(false, true, false);
+		bus.ReceiveHandShake(cdb.data(), static_cast<int>(cdb.size()));
+
+		if (data_phase == phase_t::datain) {
+			SetPhase(false, false, true);
+			bus.SendHandShake(data.data(), data_length, BUS::SEND_NO_DELAY);
+		}
+		else if (data_phase == phase_t::dataout) {
+			SetPhase(false, false, false);
+			received = bus.ReceiveHandShake(data.data(), data_length);
+		}
+
+		SetPhase(false, true, true);
+		bus.SendHandShake(&status, 1, BUS::SEND_NO_DELAY);
+
+		SetPhase(true, true, true);
+		uint8_t message = 0;
+		bus.SendHandShake(&message, 1, BUS::SEND_NO_DELAY);
+
+		SetPhase(false, false, false);
+		bus.SetBSY(false);
+	}
+
+	void SetPhase(bool msg, bool cd, bool io) {
+		bus.SetMSG(msg);
+		bus.SetCD(cd);
+		bus.SetIO(io);
+	}
+
+	GPIOBUS_Virtual bus;
+
+	thread target_thread;
+};
+
+TEST(InitiatorExecutorTest, DataIn)
+{
+	TestTarget target;
+	iota(target.data.begin(), target.data.end(), 0);
+
+	GPIOBUS_Virtual bus(GetBusName());
+	ASSERT_TRUE(bus.Init(BUS::mode_e::INITIATOR));
+	bus.Reset();
+	InitiatorExecutor executor(bus, 7);
+	executor.SetTarget(0, 1);
+
+	target.Start(phase_t::datain, 512, 0);
+	vector<uint8_t> cdb(10);
+	cdb[8] = 1;
+	vector<uint8_t> buffer(1024);
+	EXPECT_EQ(static_cast<int>(status::good), executor.Execute(scsi_command::eCmdRead10, cdb, buffer, 512));
+	target.Join();
+	EXPECT_EQ(512, executor.GetByteCount());
+	EXPECT_EQ(static_cast<uint8_t>(scsi_command::eCmdRead10), target.cdb[0]);
+	EXPECT_EQ(0x20, target.cdb[1]) << "LUN must be set";
+	EXPECT_EQ(1, target.cdb[8]);
+	EXPECT_TRUE(equal(target.data.begin(), target.data.end(), buffer.begin()));
+
+	// The target may return less data than requested
+	target.Start(phase_t::datain, 36, 0, 6);
+	vector<uint8_t> inquiry_cdb(6);
+	inquiry_cdb[4] = 0xff;
+	EXPECT_EQ(static_cast<int>(status::good), executor.Execute(scsi_command::eCmdInquiry, inquiry_cdb, buffer, 256));
+	target.Join();
+	EXPECT_EQ(36, executor.GetByteCount());
+
+	bus.Cleanup();
+}
+
+TEST(InitiatorExecutorTest, DataOut)
+{
+	TestTarget target;
+
+	GPIOBUS_Virtual bus(GetBusName());
+	ASSERT_TRUE(bus.Init(BUS::mode_e::INITIATOR));
+	bus.Reset();
+	InitiatorExecutor executor(bus, 7);
+	executor.SetTarget(0, 0);
+
+	target.Start(phase_t::dataout, 512, 0);
+	vector<uint8_t> cdb(10);
+	vector<uint8_t> buffer(512);
+	iota(buffer.begin(), buffer.end(), 1);
+	EXPECT_EQ(static_cast<int>(status::good), executor.Execute(scsi_command::eCmdWrite10, cdb, buffer, 512));
+	target.Join();
+	EXPECT_EQ(512, executor.GetByteCount());
+	EXPECT_EQ(512, target.received);
+	EXPECT_EQ(buffer, target.data);
+
+	bus.Cleanup();
+}
+
+TEST(InitiatorExecutorTest, CheckCondition)
+{
+	TestTarget target;
+
+	GPIOBUS_Virtual bus(GetBusName());
+	ASSERT_TRUE(bus.Init(BUS::mode_e::INITIATOR));
+	bus.Reset();
+	InitiatorExecutor executor(bus, 7);
+	executor.SetTarget(0, 0);
+
+	// No data phase
+	target.Start(phase_t::status, 0, static_cast<uint8_t>(status::check_condition));
+	vector<uint8_t> cdb(10);
+	vector<uint8_t> buffer(512);
+	EXPECT_EQ(static_cast<int>(status::check_condition), executor.Execute(scsi_command::eCmdRead10, cdb, buffer, 512));
+	target.Join();
+	EXPECT_EQ(0, executor.GetByteCount());
+
+	bus.Cleanup();
+}
+
+TEST(InitiatorExecutorTest, SelectionTimeout)
+{
+	GPIOBUS_Virtual bus(GetBusName());
+	ASSERT_TRUE(bus.Init(BUS::mode_e::INITIATOR));
+	bus.Reset();
+	InitiatorExecutor executor(bus, 7);
+	executor.SetTarget(0, 0);
+
+	vector<uint8_t> cdb(6);
+	vector<uint8_t> buffer(1);
+	EXPECT_THROW(executor.Execute(scsi_command::eCmdTestUnitReady, cdb, buffer, 0), phase_exception);
+	EXPECT_FALSE(bus.GetSEL());
+
+	bus.Cleanup();
+}
@@ -0,0 +1,161 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "devices/metrics_registry.h"
+
+using namespace std;
+
+static const PbStatistics *Find(const vector<PbStatistics>& statistics, const string& key)
+{
+	const auto& it = ranges::find_if(statistics, [&key] (const PbStatistics& s) { return s.key() == key; });
+	return it != statistics.end() ? &*it : nullptr;
+}
+
+TEST(MetricsRegistryTest, Counter)
+{
+	MetricsRegistry metrics;
+
+	Counter& counter = metrics.AddCounter("counter");
+	EXPECT_EQ(&counter, &metrics.AddCounter("counter")) << "Adding an existing key must return the existing metric";
+	counter.Increment();
+	counter.Increment(10);
+	EXPECT_EQ(11U, counter.Get());
+
+	Counter& errors = metrics.AddCounter("errors", PbStatisticsCategory::CATEGORY_ERROR);
+	errors.Increment();
+
+	const auto& statistics = metrics.GetStatistics(3, 4);
+	EXPECT_EQ(2U, statistics.size());
+	EXPECT_EQ("counter", statistics[0].key()) << "The metrics must be reported in the order they were added";
+	EXPECT_EQ(11U, statistics[0].value());
+	EXPECT_EQ(3, statistics[0].id());
+	EXPECT_EQ(4, statistics[0].unit());
+	EXPECT_EQ(PbStatisticsCategory::CATEGORY_INFO, statistics[0].category());
+	EXPECT_EQ("errors", statistics[1].key());
+	EXPECT_EQ(1U, statistics[1].value());
+	EXPECT_EQ(PbStatisticsCategory::CATEGORY_ERROR, statistics[1].category());
+
+	metrics.Reset();
+	EXPECT_EQ(0U, counter.Get());
+	EXPECT_EQ(0U, errors.Get());
+}
+
+TEST(MetricsRegistryTest, Gauge)
+{
+	MetricsRegistry metrics;
+
+	Gauge& gauge = metrics.AddGauge("gauge", PbStatisticsCategory::CATEGORY_WARNING);
+	gauge.Set(5);
+	gauge.Set(3);
+	EXPECT_EQ(3U, gauge.Get());
+	gauge.SetMax(2);
+	EXPECT_EQ(3U, gauge.Get()) << "A smaller value must not replace the maximum";
+	gauge.SetMax(7);
+	EXPECT_EQ(7U, gauge.Get());
+	gauge.Set(3);
+
+	const auto& statistics = metrics.GetStatistics(0, 0);
+	EXPECT_EQ(1U, statistics.size());
+	EXPECT_EQ(3U, statistics[0].value());
+	EXPECT_EQ(PbStatisticsCategory::CATEGORY_WARNING, statistics[0].category());
+
+	metrics.Reset();
+	EXPECT_EQ(0U, gauge.Get());
+}
+
+TEST(MetricsRegistryTest, Histogram)
+{
+	EXPECT_EQ(0U, Histogram::GetUpperBound(0));
+	EXPECT_EQ(1U, Histogram::GetUpperBound(1));
+	EXPECT_EQ(1023U, Histogram::GetUpperBound(10));
+	EXPECT_EQ(UINT64_MAX, Histogram::GetUpperBound(64));
+
+	MetricsRegistry metrics;
+
+	Histogram& histogram = metrics.AddHistogram("latency");
+	histogram.Record(0);
+	histogram.Record(512);
+	histogram.Record(1023);
+	histogram.Record(1024);
+	histogram.Record(UINT64_MAX);
+	EXPECT_EQ(5U, histogram.GetCount());
+	EXPECT_EQ(1U, histogram.GetBucket(0));
+	EXPECT_EQ(2U, histogram.GetBucket(10));
+	EXPECT_EQ(1U, histogram.GetBucket(11));
+	EXPECT_EQ(1U, histogram.GetBucket(64));
+
+	const auto& statistics = metrics.GetStatistics(0, 0);
+	EXPECT_EQ(2U + 4U, statistics.size()) << "Only non-empty buckets must be reported";
+	ASSERT_NE(nullptr, Find(statistics, "latency_count"));
+	EXPECT_EQ(5U, Find(statistics, "latency_count")->value());
+	ASSERT_NE(nullptr, Find(statistics, "latency_le_1023"));
+	EXPECT_EQ(2U, Find(statistics, "latency_le_1023")->value());
+	ASSERT_NE(nullptr, Find(statistics, "latency_le_2047"));
+	EXPECT_EQ(nullptr, Find(statistics, "latency_le_4095"));
+
+	metrics.Reset();
+	EXPECT_EQ(0U, histogram.GetCount());
+	EXPECT_EQ(0U, histogram.GetSum());
+	EXPECT_EQ(0U, histogram.GetBucket(10));
+}
+
+TEST(MetricsRegistryTest, Condition)
+{
+	MetricsRegistry metrics;
+
+	bool enabled = false;
+	metrics.SetCondition("writes", [&enabled] { return enabled; });
+	metrics.AddCounter("reads");
+	metrics.AddCounter("writes");
+
+	auto statistics = metrics.GetStatistics(0, 0);
+	EXPECT_NE(nullptr, Find(statistics, "reads"));
+	EXPECT_EQ(nullptr, Find(statistics, "writes")) << "A condition set before adding the metric must be applied";
+
+	enabled = true;
+	statistics = metrics.GetStatistics(0, 0);
+	EXPECT_NE(nullptr, Find(statistics, "writes"));
+}
+
+TEST(MetricsRegistryTest, Labels)
+{
+	MetricsRegistry metrics;
+
+	Counter& counter = metrics.AddCounter("selections");
+	Counter& counter2 = metrics.AddCounter("selections", PbStatisticsCategory::CATEGORY_INFO, { .id = 2 });
+	Counter& counter5 = metrics.AddCounter("selections", PbStatisticsCategory::CATEGORY_INFO, { .id = 5, .lun = 1 });
+	EXPECT_NE(&counter, &counter2) << "Metrics with different labels must be different metrics";
+	EXPECT_NE(&counter2, &counter5);
+	EXPECT_EQ(&counter2, &metrics.AddCounter("selections", PbStatisticsCategory::CATEGORY_INFO, { .id = 2 }));
+	counter.Increment(1);
+	counter2.Increment(2);
+	counter5.Increment(5);
+	EXPECT_EQ(1U, metrics.GetValue("selections"));
+	EXPECT_EQ(2U, metrics.GetValue("selections", { .id = 2 }));
+	EXPECT_EQ(5U, metrics.GetValue("selections", { .id = 5, .lun = 1 }));
+	EXPECT_EQ(0U, metrics.GetValue("selections", { .id = 5 }));
+
+	auto statistics = metrics.GetStatistics();
+	ASSERT_EQ(3U, statistics.size());
+	EXPECT_EQ(-1, statistics[0].id()) << "Metrics without labels must not be device specific";
+	EXPECT_EQ(-1, statistics[0].unit());
+	EXPECT_EQ(2, statistics[1].id());
+	EXPECT_EQ(-1, statistics[1].unit());
+	EXPECT_EQ(5, statistics[2].id());
+	EXPECT_EQ(1, statistics[2].unit());
+
+	statistics = metrics.GetStatistics(3, 4);
+	EXPECT_EQ(3, statistics[0].id()) << "Metrics without labels must get the ID and LUN of the device";
+	EXPECT_EQ(4, statistics[0].unit());
+	EXPECT_EQ(2, statistics[1].id()) << "Labels must not be replaced";
+	EXPECT_EQ(4, statistics[1].unit());
+	EXPECT_EQ(5, statistics[2].id());
+	EXPECT_EQ(1, statistics[2].unit());
+}
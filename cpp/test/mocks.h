@@ -60,6 +60,9 @@ public:
 	MOCK_METHOD(bool, GetSignal, (int), (const override));
 	MOCK_METHOD(void, SetSignal, (int, bool), (override));
 	MOCK_METHOD(bool, PollSelectEvent, (), (override));
+	MOCK_METHOD(uint64_t, GetSelectEventTimestamp, (), (const override));
+	MOCK_METHOD(bool, CanReselect, (), (const override));
+	MOCK_METHOD(bool, Reselect, (int, int), (override));
 	MOCK_METHOD(unique_ptr<DataSample>, GetSample, (uint64_t), (override));
 	MOCK_METHOD(void, PinConfig, (int, int), (override));
     MOCK_METHOD(void, PullConfig, (int , int ), (override));
@@ -98,7 +101,7 @@ class MockAbstractController : public AbstractController //NOSONAR Having many f
 
 	friend shared_ptr<PrimaryDevice> CreateDevice(piscsi_interface::PbDeviceType, AbstractController&, int);
 
-	FRIEND_TEST(AbstractControllerTest, AllocateCmd);
+	FRIEND_TEST(AbstractControllerTest, GetCmd);
 	FRIEND_TEST(AbstractControllerTest, Reset);
 	FRIEND_TEST(AbstractControllerTest, DeviceLunLifeCycle);
 	FRIEND_TEST(AbstractControllerTest, ExtractInitiatorId);
@@ -108,6 +111,7 @@ class MockAbstractController : public AbstractController //NOSONAR Having many f
 	FRIEND_TEST(AbstractControllerTest, Length);
 	FRIEND_TEST(AbstractControllerTest, UpdateOffsetAndLength);
 	FRIEND_TEST(AbstractControllerTest, Offset);
+	FRIEND_TEST(AbstractControllerTest, TransferHandler);
 	FRIEND_TEST(ScsiControllerTest, Selection);
 	FRIEND_TEST(PrimaryDeviceTest, Inquiry);
 	FRIEND_TEST(PrimaryDeviceTest, TestUnitReady);
@@ -115,6 +119,8 @@ class MockAbstractController : public AbstractController //NOSONAR Having many f
 	FRIEND_TEST(PrimaryDeviceTest, SendDiagnostic);
 	FRIEND_TEST(PrimaryDeviceTest, ReportLuns);
 	FRIEND_TEST(PrimaryDeviceTest, UnknownCommand);
+	FRIEND_TEST(PrimaryDeviceTest, ReadWriteBuffer10);
+	FRIEND_TEST(PrimaryDeviceTest, EchoBuffer);
 	FRIEND_TEST(ModePageDeviceTest, ModeSense6);
 	FRIEND_TEST(ModePageDeviceTest, ModeSense10);
 	FRIEND_TEST(ModePageDeviceTest, ModeSelect6);
@@ -142,6 +148,8 @@ class MockAbstractController : public AbstractController //NOSONAR Having many f
 	FRIEND_TEST(DiskTest, PreventAllowMediumRemoval);
 	FRIEND_TEST(DiskTest, SynchronizeCache);
 	FRIEND_TEST(DiskTest, ReadDefectData);
+	FRIEND_TEST(DiskTest, LogSense);
+	FRIEND_TEST(DiskTest, LogSelect);
 	FRIEND_TEST(DiskTest, StartStopUnit);
 	FRIEND_TEST(DiskTest, ModeSense6);
 	FRIEND_TEST(DiskTest, ModeSense10);
@@ -189,13 +197,19 @@ class MockScsiController : public ScsiController
 	FRIEND_TEST(ScsiControllerTest, Process);
 	FRIEND_TEST(ScsiControllerTest, BusFree);
 	FRIEND_TEST(ScsiControllerTest, Selection);
+	FRIEND_TEST(ScsiControllerTest, SelectionLatency);
 	FRIEND_TEST(ScsiControllerTest, Command);
 	FRIEND_TEST(ScsiControllerTest, MsgIn);
 	FRIEND_TEST(ScsiControllerTest, MsgOut);
 	FRIEND_TEST(ScsiControllerTest, DataIn);
 	FRIEND_TEST(ScsiControllerTest, DataOut);
+	FRIEND_TEST(ScsiControllerTest, SendBlocks);
+	FRIEND_TEST(ScsiControllerTest, ReceiveBlocks);
 	FRIEND_TEST(ScsiControllerTest, Error);
 	FRIEND_TEST(ScsiControllerTest, RequestSense);
+	FRIEND_TEST(ScsiControllerTest, ParseMessage);
+	FRIEND_TEST(ScsiControllerTest, MessageExchange);
+	FRIEND_TEST(ScsiControllerTest, QueueCommand);
 	FRIEND_TEST(PrimaryDeviceTest, RequestSense);
 
 public:
@@ -258,8 +272,8 @@ class MockModePageDevice : public ModePageDevice
 public:
 
 	MOCK_METHOD(vector<uint8_t>, InquiryInternal, (), (const));
-	MOCK_METHOD(int, ModeSense6, (span<const int>, vector<uint8_t>&), (const override));
-	MOCK_METHOD(int, ModeSense10, (span<const int>, vector<uint8_t>&), (const override));
+	MOCK_METHOD(int, ModeSense6, (span<const uint8_t>, vector<uint8_t>&), (const override));
+	MOCK_METHOD(int, ModeSense10, (span<const uint8_t>, vector<uint8_t>&), (const override));
 
 	MockModePageDevice() : ModePageDevice(UNDEFINED, 0) {}
 	~MockModePageDevice() override = default;
@@ -304,8 +318,8 @@ public:
 	MOCK_METHOD(void ,Write, (span<const uint8_t>, uint64_t), (override));
 	MOCK_METHOD(int , Read, (span<uint8_t>, uint64_t), (override));
 
-	MOCK_METHOD(int, ModeSense6, (span<const int>, vector<uint8_t>&), (const override));
-	MOCK_METHOD(int, ModeSense10, (span<const int>, vector<uint8_t>&), (const override));
+	MOCK_METHOD(int, ModeSense6, (span<const uint8_t>, vector<uint8_t>&), (const override));
+	MOCK_METHOD(int, ModeSense10, (span<const uint8_t>, vector<uint8_t>&), (const override));
 	MOCK_METHOD(void, SetUpModePages, ((map<int, vector<byte>>&), int, bool), (const override));
 
 	MockStorageDevice() : StorageDevice(UNDEFINED, 0, {512}) {}
@@ -343,6 +357,8 @@ class MockDisk : public Disk
 	FRIEND_TEST(DiskTest, ModeSense10);
 	FRIEND_TEST(DiskTest, SynchronizeCache);
 	FRIEND_TEST(DiskTest, ReadDefectData);
+	FRIEND_TEST(DiskTest, LogSense);
+	FRIEND_TEST(DiskTest, LogSelect);
 	FRIEND_TEST(DiskTest, SectorSize);
 	FRIEND_TEST(DiskTest, BlockCount);
 
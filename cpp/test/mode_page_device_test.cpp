@@ -26,7 +26,7 @@ TEST(ModePageDeviceTest, SupportsSaveParameters)
 
 TEST(ModePageDeviceTest, AddModePages)
 {
-	vector<int> cdb(6);
+	vector<uint8_t> cdb(6);
 	vector<uint8_t> buf(512);
 	MockModePageDevice device;
 
@@ -58,7 +58,7 @@ TEST(ModePageDeviceTest, AddModePages)
 
 TEST(ModePageDeviceTest, Page0)
 {
-	vector<int> cdb(6);
+	vector<uint8_t> cdb(6);
 	vector<uint8_t> buf(512);
 	MockPage0ModePageDevice device;
 
@@ -105,7 +105,7 @@ TEST(ModePageDeviceTest, ModeSense10)
 TEST(ModePageDeviceTest, ModeSelect)
 {
 	MockModePageDevice device;
-	vector<int> cmd;
+	vector<uint8_t> cmd;
 	vector<uint8_t> buf;
 
 	EXPECT_THAT([&] { device.ModeSelect(scsi_command::eCmdModeSelect6, cmd, buf, 0); }, Throws<scsi_exception>(AllOf(
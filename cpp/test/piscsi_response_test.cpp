@@ -178,12 +178,13 @@ TEST(PiscsiResponseTest, GetServerInfo)
 {
 	auto bus = make_shared<MockBus>();
 	PiscsiResponse response;
-	const unordered_set<shared_ptr<PrimaryDevice>> devices;
+	const vector<shared_ptr<PrimaryDevice>> devices;
+	const MetricsRegistry metrics;
 	const unordered_set<int> ids = { 1, 3 };
 
 	PbCommand command;
 	PbServerInfo info1;
-	response.GetServerInfo(info1, command, devices, ids, "default_folder", 1234);
+	response.GetServerInfo(info1, command, devices, metrics, ids, "default_folder", 1234);
 	EXPECT_TRUE(info1.has_version_info());
 	EXPECT_TRUE(info1.has_log_level_info());
 	EXPECT_TRUE(info1.has_device_types_info());
@@ -205,7 +206,7 @@ TEST(PiscsiResponseTest, GetServerInfo)
 
 	SetParam(command, "operations", "log_level_info,mapping_info");
 	PbServerInfo info2;
-	response.GetServerInfo(info2, command, devices, ids, "default_folder", 1234);
+	response.GetServerInfo(info2, command, devices, metrics, ids, "default_folder", 1234);
 	EXPECT_FALSE(info2.has_version_info());
 	EXPECT_TRUE(info2.has_log_level_info());
 	EXPECT_FALSE(info2.has_device_types_info());
@@ -256,3 +257,60 @@ TEST(PiscsiResponseTest, GetMappingInfo)
 	response.GetMappingInfo(info);
 	EXPECT_EQ(14, info.mapping().size());
 }
+
+TEST(PiscsiResponseTest, GetStatisticsInfo)
+{
+	auto bus = make_shared<MockBus>();
+	ControllerManager controller_manager;
+	DeviceFactory device_factory;
+	PiscsiResponse response;
+
+	EXPECT_TRUE(controller_manager.AttachToController(*bus, 2, device_factory.CreateDevice(SCHS, 0, "")));
+
+	PbStatisticsInfo info;
+	response.GetStatisticsInfo(info, controller_manager.GetAllDevices(), controller_manager.GetMetrics());
+	bool has_device_statistics = false;
+	bool has_global_statistics = false;
+	for (const auto& s : info.statistics()) {
+		if (s.key() == IdleScheduler::IDLE_TASK_STEP_COUNT) {
+			EXPECT_EQ(-1, s.id());
+			EXPECT_EQ(-1, s.unit());
+			has_global_statistics = true;
+		}
+		else if (s.id() == 2) {
+			EXPECT_EQ(0, s.unit());
+			has_device_statistics = true;
+		}
+	}
+	EXPECT_TRUE(has_device_statistics);
+	EXPECT_TRUE(has_global_statistics) << "The statistics which are not device specific must be reported";
+}
+
+TEST(PiscsiResponseTest, GetCommandTraceInfo)
+{
+	PiscsiResponse response;
+	auto command_trace = make_unique<CommandTrace>();
+
+	CommandTrace::command_record record = {};
+	record.opcode = 0x2a;
+	record.lba = 4;
+	record.length = 2;
+	record.target_id = 3;
+	record.command_duration = 1000;
+	command_trace->Add(record);
+
+	PbCommandTraceInfo info1;
+	response.GetCommandTraceInfo(info1, *command_trace, false);
+	EXPECT_EQ(1, info1.records_size());
+	EXPECT_TRUE(info1.chrome_trace().empty());
+	EXPECT_EQ(0x2a, info1.records(0).opcode());
+	EXPECT_EQ(4, info1.records(0).lba());
+	EXPECT_EQ(2, info1.records(0).length());
+	EXPECT_EQ(3, info1.records(0).id());
+	EXPECT_EQ(1000, info1.records(0).command_duration());
+
+	PbCommandTraceInfo info2;
+	response.GetCommandTraceInfo(info2, *command_trace, true);
+	EXPECT_EQ(0, info2.records_size());
+	EXPECT_NE(string::npos, info2.chrome_trace().find("Write10"));
+}
@@ -141,6 +141,18 @@ TEST(PiscsiUtilTest, GetExtensionLowerCase)
 	EXPECT_EQ("ext", GetExtensionLowerCase(".XYZ.EXT"));
 }
 
+TEST(PiscsiUtilTest, GetPercentile)
+{
+	EXPECT_EQ(0, GetPercentile({}, 50));
+
+	const vector<uint64_t> values = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	EXPECT_EQ(1, GetPercentile(values, 0));
+	EXPECT_EQ(5, GetPercentile(values, 50));
+	EXPECT_EQ(9, GetPercentile(values, 90));
+	EXPECT_EQ(10, GetPercentile(values, 99));
+	EXPECT_EQ(10, GetPercentile(values, 100));
+}
+
 #ifdef __linux__
 TEST(PiscsiUtilTest, FixCpu)
 {
@@ -325,6 +325,126 @@ TEST(PrimaryDeviceTest, ReportLuns)
 		<< "Only SELECT REPORT mode 0 is supported";
 }
 
+TEST(PrimaryDeviceTest, ReadWriteBuffer10)
+{
+	auto [controller, device] = CreatePrimaryDevice();
+	// Required by the bullseye clang++ compiler
+	auto d = device;
+
+	// Descriptor mode, ALLOCATION LENGTH
+	controller->SetCmdByte(1, 0x03);
+	controller->SetCmdByte(8, 4);
+	EXPECT_CALL(*controller, DataIn);
+	device->Dispatch(scsi_command::eCmdReadBuffer10);
+	EXPECT_EQ(4, controller->GetLength());
+	EXPECT_EQ(0, controller->GetBuffer()[0]) << "The offset boundary must be 0";
+	EXPECT_EQ(AbstractController::DEFAULT_DATA_BUFFER_SIZE,
+			static_cast<uint32_t>(GetInt16(controller->GetBuffer(), 1) << 8 | controller->GetBuffer()[3]))
+		<< "Wrong buffer capacity";
+
+	// Data mode, offset 16, 8 bytes
+	controller->SetCmdByte(1, 0x02);
+	controller->SetCmdByte(5, 16);
+	controller->SetCmdByte(8, 8);
+	EXPECT_CALL(*controller, DataOut);
+	device->Dispatch(scsi_command::eCmdWriteBuffer10);
+	EXPECT_EQ(8, controller->GetLength());
+	ranges::fill_n(controller->GetBuffer().begin(), 8, 0x5a);
+	EXPECT_EQ(0, controller->TransferBlock(0));
+	EXPECT_EQ(0x5a, controller->GetDataBuffer()[16]);
+	EXPECT_EQ(0x5a, controller->GetDataBuffer()[23]);
+	EXPECT_EQ(0, controller->GetDataBuffer()[24]);
+
+	// Offset 20, 8 bytes
+	controller->SetCmdByte(5, 20);
+	EXPECT_CALL(*controller, DataIn);
+	device->Dispatch(scsi_command::eCmdReadBuffer10);
+	EXPECT_EQ(8, controller->GetLength());
+	EXPECT_EQ(0x5a, controller->GetBuffer()[3]);
+	EXPECT_EQ(0, controller->GetBuffer()[4]);
+
+	// Offset and length exceed the buffer capacity
+	// Offset 65532
+	controller->SetCmdByte(4, 0xff);
+	controller->SetCmdByte(5, 0xfc);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdWriteBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "WRITE BUFFER must fail when exceeding the buffer capacity";
+	// Offset 65537
+	controller->SetCmdByte(3, 0x01);
+	controller->SetCmdByte(4, 0x00);
+	controller->SetCmdByte(5, 0x01);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdReadBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "READ BUFFER must fail when the offset exceeds the buffer capacity";
+	controller->SetCmdByte(3, 0);
+	controller->SetCmdByte(5, 0);
+
+	controller->SetCmdByte(2, 1);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdReadBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "There is only buffer 0";
+	controller->SetCmdByte(2, 0);
+
+	controller->SetCmdByte(1, 0x03);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdWriteBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "Descriptor mode is not supported by WRITE BUFFER";
+	controller->SetCmdByte(1, 0x00);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdReadBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "Only data, descriptor and echo modes are supported";
+}
+
+TEST(PrimaryDeviceTest, EchoBuffer)
+{
+	auto [controller, device] = CreatePrimaryDevice();
+	// Required by the bullseye clang++ compiler
+	auto d = device;
+
+	// Echo buffer descriptor mode
+	controller->SetCmdByte(1, 0x0b);
+	controller->SetCmdByte(8, 4);
+	EXPECT_CALL(*controller, DataIn);
+	device->Dispatch(scsi_command::eCmdReadBuffer10);
+	EXPECT_EQ(AbstractController::ECHO_BUFFER_SIZE, GetInt16(controller->GetBuffer(), 2)) << "Wrong echo buffer capacity";
+
+	// Echo mode, 3 bytes
+	controller->SetCmdByte(1, 0x0a);
+	controller->SetCmdByte(8, 3);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdReadBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::command_sequence_error))))
+		<< "READ BUFFER in echo mode must fail without a preceding WRITE BUFFER";
+
+	EXPECT_CALL(*controller, DataOut);
+	device->Dispatch(scsi_command::eCmdWriteBuffer10);
+	controller->GetBuffer()[0] = 1;
+	controller->GetBuffer()[1] = 2;
+	controller->GetBuffer()[2] = 3;
+	EXPECT_EQ(0, controller->TransferBlock(0));
+
+	controller->SetCmdByte(8, 255);
+	EXPECT_CALL(*controller, DataIn);
+	device->Dispatch(scsi_command::eCmdReadBuffer10);
+	EXPECT_EQ(3, controller->GetLength()) << "Exactly the data of the last write must be returned";
+	EXPECT_EQ(1, controller->GetBuffer()[0]);
+	EXPECT_EQ(3, controller->GetBuffer()[2]);
+
+	// 4097 bytes
+	controller->SetCmdByte(7, 0x10);
+	controller->SetCmdByte(8, 0x01);
+	EXPECT_THAT([&] { d->Dispatch(scsi_command::eCmdWriteBuffer10); }, Throws<scsi_exception>(AllOf(
+			Property(&scsi_exception::get_sense_key, sense_key::illegal_request),
+			Property(&scsi_exception::get_asc, asc::invalid_field_in_cdb))))
+		<< "WRITE BUFFER must fail when exceeding the echo buffer capacity";
+}
+
 TEST(PrimaryDeviceTest, Dispatch)
 {
 	auto [controller, device] = CreatePrimaryDevice();
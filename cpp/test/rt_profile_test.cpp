@@ -0,0 +1,57 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "piscsi/rt_profile.h"
+
+using namespace std;
+
+TEST(RtProfileTest, SetProfile)
+{
+	RtProfile profile;
+
+	EXPECT_FALSE(profile.IsRealtime());
+
+	EXPECT_TRUE(profile.SetProfile("realtime").empty());
+	EXPECT_TRUE(profile.IsRealtime());
+	EXPECT_TRUE(profile.SetProfile("default").empty());
+	EXPECT_FALSE(profile.IsRealtime());
+	EXPECT_TRUE(profile.SetProfile("realtime:2").empty());
+	EXPECT_TRUE(profile.IsRealtime());
+
+	EXPECT_FALSE(profile.SetProfile("").empty());
+	EXPECT_FALSE(profile.SetProfile("fast").empty());
+	EXPECT_FALSE(profile.SetProfile("default:1").empty());
+	EXPECT_FALSE(profile.SetProfile("realtime:x").empty());
+	EXPECT_TRUE(profile.IsRealtime()) << "An invalid profile must not change the profile";
+
+	EXPECT_TRUE(profile.SetProfile("default").empty());
+	EXPECT_EQ(1U, profile.GetLayout().size());
+}
+
+TEST(RtProfileTest, ParseCpuList)
+{
+	EXPECT_TRUE(RtProfile::ParseCpuList("").empty());
+	EXPECT_EQ(set<int>({ 3 }), RtProfile::ParseCpuList("3"));
+	EXPECT_EQ(set<int>({ 0, 1, 2, 3 }), RtProfile::ParseCpuList("0-3"));
+	EXPECT_EQ(set<int>({ 0, 2, 3, 5 }), RtProfile::ParseCpuList("0,2-3,5"));
+	EXPECT_EQ(set<int>({ 1 }), RtProfile::ParseCpuList("x,1,2-y"));
+}
+
+TEST(RtProfileTest, SelectBusCpu)
+{
+	const set<int> online = { 0, 1, 2, 3 };
+
+	EXPECT_EQ(3, RtProfile::SelectBusCpu(online, {}, {})) << "Without reserved CPUs the last CPU must be used";
+	EXPECT_EQ(2, RtProfile::SelectBusCpu(online, { 1, 2 }, {}));
+	EXPECT_EQ(1, RtProfile::SelectBusCpu(online, { 1, 2 }, { 1 })) << "Isolated CPUs without ticks must be preferred";
+	EXPECT_EQ(2, RtProfile::SelectBusCpu(online, {}, { 2 }));
+	EXPECT_EQ(3, RtProfile::SelectBusCpu(online, { 5 }, { 5 })) << "Offline CPUs must be ignored";
+	EXPECT_EQ(0, RtProfile::SelectBusCpu({}, {}, {}));
+}
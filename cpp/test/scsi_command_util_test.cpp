@@ -18,7 +18,7 @@ TEST(ScsiCommandUtilTest, ModeSelect6)
 {
 	const int LENGTH = 26;
 
-	vector<int> cdb(6);
+	vector<uint8_t> cdb(6);
 	vector<uint8_t> buf(LENGTH);
 
 	// PF (vendor-specific parameter format) must not fail but be ignored
@@ -69,7 +69,7 @@ TEST(ScsiCommandUtilTest, ModeSelect10)
 {
 	const int LENGTH = 30;
 
-	vector<int> cdb(10);
+	vector<uint8_t> cdb(10);
 	vector<uint8_t> buf(LENGTH);
 
 	// PF (vendor-specific parameter format) must not fail but be ignored
@@ -154,25 +154,25 @@ TEST(ScsiCommandUtilTest, GetInt16)
 	vector<uint8_t> b = { 0xfe, 0xdc };
 	EXPECT_EQ(0xfedc, GetInt16(b, 0));
 
-	vector<int> v = { 0x12, 0x34 };
+	vector<uint8_t> v = { 0x12, 0x34 };
 	EXPECT_EQ(0x1234, GetInt16(v, 0));
 }
 
 TEST(ScsiCommandUtilTest, GetInt24)
 {
-	vector<int> v = { 0x12, 0x34, 0x56 };
+	vector<uint8_t> v = { 0x12, 0x34, 0x56 };
 	EXPECT_EQ(0x123456, GetInt24(v, 0));
 }
 
 TEST(ScsiCommandUtilTest, GetInt32)
 {
-	vector<int> v = { 0x12, 0x34, 0x56, 0x78 };
+	vector<uint8_t> v = { 0x12, 0x34, 0x56, 0x78 };
 	EXPECT_EQ(0x12345678, GetInt32(v, 0));
 }
 
 TEST(ScsiCommandUtilTest, GetInt64)
 {
-	vector<int> v = { 0x12, 0x34, 0x56, 0x78, 0x87, 0x65, 0x43, 0x21 };
+	vector<uint8_t> v = { 0x12, 0x34, 0x56, 0x78, 0x87, 0x65, 0x43, 0x21 };
 	EXPECT_EQ(0x1234567887654321, GetInt64(v, 0));
 }
 
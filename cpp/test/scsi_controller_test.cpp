@@ -31,7 +31,6 @@ TEST(ScsiControllerTest, Process)
 {
 	auto bus = make_shared<NiceMock<MockBus>>();
 	MockScsiController controller(bus, 0);
-	controller.Init();
 
 	controller.SetPhase(phase_t::reserved);
 	ON_CALL(*bus, GetRST).WillByDefault(Return(true));
@@ -131,6 +130,26 @@ TEST(ScsiControllerTest, Selection)
 	EXPECT_EQ(phase_t::selection, controller->GetPhase());
 }
 
+TEST(ScsiControllerTest, SelectionLatency)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	auto controller = make_shared<MockScsiController>(bus, 3);
+	MetricsRegistry metrics;
+	SelectionStatistics statistics(metrics);
+	controller->SetSelectionStatistics(&statistics);
+
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp());
+	EXPECT_CALL(*bus, SetBSY(true));
+	controller->Selection();
+	EXPECT_EQ(phase_t::selection, controller->GetPhase());
+
+	const auto& s = metrics.GetStatistics();
+	EXPECT_FALSE(s.empty());
+	EXPECT_EQ(3, s[0].id());
+	EXPECT_EQ(SelectionStatistics::SELECTION_LATENCY + "_count", s[0].key());
+	EXPECT_EQ(1U, s[0].value());
+}
+
 TEST(ScsiControllerTest, Command)
 {
 	auto bus = make_shared<NiceMock<MockBus>>();
@@ -228,6 +247,64 @@ TEST(ScsiControllerTest, DataOut)
 	EXPECT_EQ(0, controller.GetOffset());
 }
 
+TEST(ScsiControllerTest, SendBlocks)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	MockScsiController controller(bus, 0);
+	vector<uint64_t> blocks;
+
+	ON_CALL(*bus, GetIO).WillByDefault(Return(true));
+
+	controller.SetPhase(phase_t::datain);
+	controller.SetLength(512);
+	controller.SetBlocks(3);
+	controller.SetNext(1);
+	controller.SetTransferHandler([&blocks] (uint64_t block) { blocks.push_back(block); return 512; });
+	EXPECT_CALL(*bus, SendHandShake(_, 512, _)).Times(3).WillRepeatedly(Return(512));
+	EXPECT_CALL(controller, Status);
+	controller.DataIn();
+	EXPECT_EQ((vector<uint64_t>{ 1, 2 }), blocks) << "The first block must have been provided by the command";
+	EXPECT_FALSE(controller.HasBlocks());
+
+	blocks.clear();
+	controller.SetLength(512);
+	controller.SetBlocks(3);
+	controller.SetNext(1);
+	EXPECT_CALL(*bus, SendHandShake(_, 512, _)).WillOnce(Return(512)).WillOnce(Return(0));
+	EXPECT_CALL(controller, Status);
+	controller.DataIn();
+	EXPECT_EQ((vector<uint64_t>{ 1 }), blocks);
+	EXPECT_EQ(status::check_condition, controller.GetStatus());
+}
+
+TEST(ScsiControllerTest, ReceiveBlocks)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	MockScsiController controller(bus, 0);
+	vector<uint64_t> blocks;
+
+	controller.SetPhase(phase_t::dataout);
+	controller.SetLength(512);
+	controller.SetBlocks(3);
+	controller.SetNext(1);
+	controller.SetTransferHandler([&blocks] (uint64_t block) { blocks.push_back(block); return 512; });
+	EXPECT_CALL(*bus, ReceiveHandShake(_, 512)).Times(3).WillRepeatedly(Return(512));
+	EXPECT_CALL(controller, Status);
+	controller.DataOut();
+	EXPECT_EQ((vector<uint64_t>{ 0, 1, 2 }), blocks);
+	EXPECT_FALSE(controller.HasBlocks());
+
+	blocks.clear();
+	controller.SetLength(512);
+	controller.SetBlocks(3);
+	controller.SetNext(1);
+	EXPECT_CALL(*bus, ReceiveHandShake(_, 512)).WillOnce(Return(512)).WillOnce(Return(0));
+	EXPECT_CALL(controller, Status);
+	controller.DataOut();
+	EXPECT_EQ((vector<uint64_t>{ 0 }), blocks);
+	EXPECT_EQ(status::check_condition, controller.GetStatus());
+}
+
 TEST(ScsiControllerTest, Error)
 {
 	auto bus = make_shared<NiceMock<MockBus>>();
@@ -286,3 +363,193 @@ TEST(ScsiControllerTest, RequestSense)
 	device->Dispatch(scsi_command::eCmdRequestSense);
 	EXPECT_EQ(status::good, controller->GetStatus()) << "Wrong CHECK CONDITION for non-existing LUN";
 }
+
+TEST(ScsiControllerTest, ParseMessage)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	MockScsiController controller(bus, 0);
+
+	controller.scsi.msb = { 0x81 };
+	controller.scsi.msc = 1;
+	controller.ParseMessage();
+	EXPECT_EQ(1, controller.GetEffectiveLun());
+	EXPECT_FALSE(controller.nexus.can_disconnect);
+
+	// IDENTIFY for LUN 0, HEAD OF QUEUE TAG with a tag that looks like an IDENTIFY message
+	controller.SetPhase(phase_t::msgout);
+	controller.scsi.msb = { 0x80, 0x21, 0x85 };
+	controller.scsi.msc = 3;
+	controller.ParseMessage();
+	EXPECT_EQ(0, controller.GetEffectiveLun()) << "The tag must not be mistaken for an IDENTIFY message";
+	EXPECT_EQ(phase_t::msgin, controller.GetPhase());
+	EXPECT_EQ(0x07, controller.GetBuffer()[0]) << "Queue tag messages must be rejected without queuing";
+
+	CommandQueue::SetMaxDepth(4);
+
+	controller.SetPhase(phase_t::msgout);
+	controller.scsi.msb = { 0xc2, 0x22, 0x85 };
+	controller.scsi.msc = 3;
+	controller.ParseMessage();
+	EXPECT_EQ(2, controller.GetEffectiveLun()) << "The tag must not be mistaken for an IDENTIFY message";
+	EXPECT_EQ(phase_t::msgout, controller.GetPhase());
+	EXPECT_TRUE(controller.nexus.tagged);
+	EXPECT_EQ(CommandQueue::tag_type::ordered, controller.nexus.type);
+	EXPECT_EQ(0x85, controller.nexus.tag);
+	EXPECT_TRUE(controller.nexus.can_disconnect);
+
+	controller.scsi.msb = { 0xc0, 0x20 };
+	controller.scsi.msc = 2;
+	controller.ParseMessage();
+	EXPECT_EQ(phase_t::msgin, controller.GetPhase());
+	EXPECT_EQ(0x07, controller.GetBuffer()[0]) << "A queue tag message without a tag must be rejected";
+
+	// ABORT TAG
+	const vector<uint8_t> cdb = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	controller.GetCommandQueue(0).Add(AbstractController::UNKNOWN_INITIATOR_ID, 0x12, CommandQueue::tag_type::simple,
+			cdb);
+	controller.GetCommandQueue(0).Add(AbstractController::UNKNOWN_INITIATOR_ID, 0x13, CommandQueue::tag_type::simple,
+			cdb);
+	controller.SetPhase(phase_t::msgout);
+	controller.scsi.msb = { 0xc0, 0x20, 0x12, 0x0d };
+	controller.scsi.msc = 4;
+	controller.ParseMessage();
+	EXPECT_EQ(phase_t::busfree, controller.GetPhase());
+	EXPECT_EQ(1, controller.GetCommandQueue(0).GetSize());
+
+	// CLEAR QUEUE
+	controller.SetPhase(phase_t::msgout);
+	controller.scsi.msb = { 0xc0, 0x0e };
+	controller.scsi.msc = 2;
+	controller.ParseMessage();
+	EXPECT_EQ(phase_t::busfree, controller.GetPhase());
+	EXPECT_FALSE(controller.HasQueuedCommands());
+
+	CommandQueue::SetMaxDepth(0);
+}
+
+TEST(ScsiControllerTest, MessageExchange)
+{
+	auto bus = make_shared<NiceMock<MockBus>>();
+	MockScsiController controller(bus, 0);
+
+	// IDENTIFY, SIMPLE QUEUE TAG, tag 5
+	const vector<uint8_t> message_out = { 0xc0, 0x20, 0x05 };
+	size_t received = 0;
+	ON_CALL(*bus, GetATN).WillByDefault([&] { return received < message_out.size(); });
+	ON_CALL(*bus, ReceiveHandShake).WillByDefault([&] (uint8_t *buf, int) {
+		*buf = message_out[received++];
+		return 1;
+	});
+	vector<uint8_t> message_in;
+	ON_CALL(*bus, SendHandShake).WillByDefault([&] (uint8_t *buf, int count, int) {
+		message_in.insert(message_in.end(), buf, buf + count);
+		return count;
+	});
+	ON_CALL(*bus, CommandHandShake).WillByDefault([] (vector<uint8_t>& buf) {
+		ranges::fill(buf.begin(), buf.begin() + 6, 0);
+		return 6;
+	});
+
+	controller.SetPhase(phase_t::selection);
+	controller.MsgOut();
+	EXPECT_EQ(phase_t::msgout, controller.GetPhase());
+
+	// ATN is asserted until the last byte has been received
+	ON_CALL(*bus, GetIO).WillByDefault(Return(false));
+	for (int i = 0; i < 10 && controller.IsMsgOut(); i++) {
+		controller.MsgOut();
+	}
+	EXPECT_EQ(message_out.size(), received);
+	EXPECT_EQ(phase_t::msgin, controller.GetPhase()) << "The queue tag message must be rejected in MESSAGE IN";
+
+	ON_CALL(*bus, GetIO).WillByDefault(Return(true));
+	controller.MsgIn();
+	EXPECT_EQ(vector<uint8_t>{ 0x07 }, message_in) << "MESSAGE REJECT must be sent before the command phase";
+	EXPECT_EQ(phase_t::msgin, controller.GetPhase());
+
+	// After the MESSAGE REJECT the initiator continues with the untagged command
+	EXPECT_CALL(controller, Execute);
+	controller.MsgIn();
+	EXPECT_EQ(phase_t::command, controller.GetPhase());
+}
+
+TEST(ScsiControllerTest, QueueCommand)
+{
+	const int INITIATOR_ID = 7;
+
+	auto bus = make_shared<NiceMock<MockBus>>();
+	auto controller = make_shared<MockScsiController>(bus, 0);
+	auto disk = make_shared<MockDisk>();
+	EXPECT_TRUE(disk->Init({}));
+	controller->AddDevice(disk);
+
+	CommandQueue::SetMaxDepth(2);
+	ON_CALL(*bus, CanReselect).WillByDefault(Return(true));
+	controller->Process(INITIATOR_ID);
+
+	vector<uint8_t> message_in;
+	ON_CALL(*bus, SendHandShake).WillByDefault([&] (uint8_t *buf, int count, int) {
+		message_in.insert(message_in.end(), buf, buf + count);
+		return count;
+	});
+	ON_CALL(*bus, GetIO).WillByDefault(Return(true));
+
+	// Receives a tagged READ(10) in the command phase
+	const auto receive = [&] (uint8_t tag, uint8_t block) {
+		controller->SetPhase(phase_t::msgout);
+		controller->scsi.msb = { 0xc0, 0x20, tag };
+		controller->scsi.msc = 3;
+		controller->ParseMessage();
+		EXPECT_CALL(*bus, CommandHandShake).WillOnce([block] (vector<uint8_t>& buf) {
+			ranges::fill(buf.begin(), buf.begin() + 10, 0);
+			buf[0] = static_cast<uint8_t>(scsi_command::eCmdRead10);
+			buf[5] = block;
+			buf[8] = 1;
+			return 10;
+		});
+		controller->SetPhase(phase_t::reserved);
+		controller->Command();
+	};
+
+	EXPECT_CALL(*controller, Execute).Times(0);
+	receive(1, 200);
+	EXPECT_EQ(phase_t::msgin, controller->GetPhase());
+	EXPECT_EQ(0x04, controller->GetBuffer()[0]) << "The target must disconnect";
+	EXPECT_TRUE(controller->HasQueuedCommands());
+	receive(2, 100);
+	EXPECT_EQ(2, controller->GetCommandQueue(0).GetSize());
+
+	EXPECT_CALL(*controller, Status);
+	receive(3, 50);
+	EXPECT_EQ(status::queue_full, controller->GetStatus());
+	EXPECT_EQ(2, controller->GetCommandQueue(0).GetSize());
+
+	// The initiator does not respond
+	EXPECT_CALL(*bus, Reselect(0, INITIATOR_ID)).Times(3).WillRepeatedly(Return(false));
+	controller->ProcessQueuedCommand();
+	controller->ProcessQueuedCommand();
+	EXPECT_TRUE(controller->HasQueuedCommands());
+	controller->ProcessQueuedCommand();
+	EXPECT_FALSE(controller->HasQueuedCommands()) << "The commands of an unresponsive initiator must be discarded";
+
+	receive(1, 200);
+	receive(2, 100);
+
+	// The command with the lower block is executed first
+	message_in.clear();
+	EXPECT_CALL(*bus, Reselect(0, INITIATOR_ID)).WillOnce(Return(true));
+	EXPECT_CALL(*controller, Execute).WillOnce([&controller] { controller->BusFree(); });
+	controller->ProcessQueuedCommand();
+	EXPECT_EQ((vector<uint8_t>{ 0x80, 0x20, 0x02 }), message_in) << "IDENTIFY and the tag must follow the reselection";
+	EXPECT_EQ(100, controller->GetCmdByte(5));
+	EXPECT_EQ(INITIATOR_ID, controller->GetInitiatorId());
+	EXPECT_EQ(1, controller->GetCommandQueue(0).GetSize());
+
+	// A reused tag aborts the queued commands of the initiator
+	EXPECT_CALL(*controller, Status);
+	receive(1, 10);
+	EXPECT_EQ(status::check_condition, controller->GetStatus());
+	EXPECT_FALSE(controller->HasQueuedCommands());
+
+	CommandQueue::SetMaxDepth(0);
+}
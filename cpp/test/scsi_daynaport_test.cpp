@@ -15,7 +15,7 @@ TEST(ScsiDaynaportTest, GetDefaultParams)
 {
 	const auto [controller, daynaport] = CreateDevice(SCDP);
 	const auto params = daynaport->GetDefaultParams();
-	EXPECT_EQ(2, params.size());
+	EXPECT_EQ(3, params.size());
 }
 
 TEST(ScsiDaynaportTest, Inquiry)
@@ -0,0 +1,124 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "scsibench/scsibench_core.h"
+#include "scsibench/workload.h"
+
+using namespace std;
+
+TEST(ScsiBenchTest, ParsePattern)
+{
+	Workload::pattern pattern = Workload::pattern::random;
+	EXPECT_TRUE(Workload::ParsePattern("seq", pattern));
+	EXPECT_EQ(Workload::pattern::sequential, pattern);
+	EXPECT_TRUE(Workload::ParsePattern("random", pattern));
+	EXPECT_EQ(Workload::pattern::random, pattern);
+	EXPECT_TRUE(Workload::ParsePattern("sequential", pattern));
+	EXPECT_TRUE(Workload::ParsePattern("rand", pattern));
+	EXPECT_FALSE(Workload::ParsePattern("zipf", pattern));
+}
+
+TEST(ScsiBenchTest, Init)
+{
+	Workload::settings_t settings;
+	settings.transfer_size = 1000;
+	EXPECT_FALSE(Workload(settings).Init(512, 1000).empty()) << "Transfer size must be a multiple of the sector size";
+	EXPECT_FALSE(Workload(settings).Init(0, 1000).empty());
+
+	settings.transfer_size = 65536 * 512;
+	EXPECT_FALSE(Workload(settings).Init(512, 1'000'000).empty()) << "Transfer size is limited to 65535 sectors";
+
+	settings.transfer_size = 4096;
+	settings.first_lba = 1000;
+	EXPECT_FALSE(Workload(settings).Init(512, 1000).empty()) << "Start sector must be smaller than the capacity";
+
+	settings.first_lba = 995;
+	EXPECT_FALSE(Workload(settings).Init(512, 1000).empty()) << "Range must comprise at least one transfer";
+
+	settings.first_lba = 990;
+	settings.lba_count = 20;
+	EXPECT_FALSE(Workload(settings).Init(512, 1000).empty()) << "Range must not exceed the capacity";
+
+	settings.lba_count = 10;
+	EXPECT_EQ("", Workload(settings).Init(512, 1000));
+}
+
+TEST(ScsiBenchTest, Sequential)
+{
+	Workload::settings_t settings;
+	settings.transfer_size = 2048;
+	settings.first_lba = 100;
+	settings.lba_count = 10;
+	Workload workload(settings);
+	EXPECT_EQ("", workload.Init(512, 1000));
+
+	// Only complete transfers, the last 2 sectors of the range are not accessed
+	for (const uint64_t lba : { 100, 104, 100, 104 }) {
+		const auto command = workload.GetNextCommand();
+		EXPECT_EQ(lba, command.lba);
+		EXPECT_EQ(4U, command.blocks);
+		EXPECT_FALSE(command.write);
+	}
+}
+
+TEST(ScsiBenchTest, Random)
+{
+	Workload::settings_t settings;
+	settings.access_pattern = Workload::pattern::random;
+	settings.transfer_size = 1024;
+	settings.write_percentage = 50;
+	Workload workload(settings);
+	EXPECT_EQ("", workload.Init(512, 1000));
+
+	vector<Workload::command_t> commands;
+	int writes = 0;
+	for (int i = 0; i < 1000; i++) {
+		const auto command = workload.GetNextCommand();
+		EXPECT_EQ(0U, command.lba % 2) << "Random commands must be aligned to the transfer size";
+		EXPECT_LE(command.lba + command.blocks, 1000U);
+		if (command.write) {
+			writes++;
+		}
+		commands.push_back(command);
+	}
+	EXPECT_NEAR(500, writes, 100);
+
+	// Each run must execute the same commands
+	Workload workload2(settings);
+	workload2.Init(512, 1000);
+	for (const auto& command : commands) {
+		const auto command2 = workload2.GetNextCommand();
+		EXPECT_EQ(command.lba, command2.lba);
+		EXPECT_EQ(command.write, command2.write);
+	}
+
+	settings.write_percentage = 100;
+	Workload write_only(settings);
+	write_only.Init(512, 1000);
+	EXPECT_TRUE(write_only.GetNextCommand().write);
+}
+
+TEST(ScsiBenchTest, Report)
+{
+	ScsiBench::statistics_t statistics;
+	statistics.reads = 3;
+	statistics.bytes_read = 3'000'000;
+	statistics.elapsed_ns = 1'000'000'000;
+	statistics.latencies = { 3000, 1000, 2000 };
+
+	testing::internal::CaptureStdout();
+	ScsiBench::Report(statistics);
+	const string report = testing::internal::GetCapturedStdout();
+	EXPECT_NE(string::npos, report.find("Commands executed: 3 (3 READ, 0 WRITE")) << report;
+	EXPECT_NE(string::npos, report.find("IOPS:              3.000")) << report;
+	EXPECT_NE(string::npos, report.find("3.000 MB/s")) << report;
+	EXPECT_NE(string::npos, report.find("p50 2.000")) << report;
+	EXPECT_NE(string::npos, report.find("max 3.000")) << report;
+}
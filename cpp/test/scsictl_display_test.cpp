@@ -166,6 +166,60 @@ TEST(ScsictlDisplayTest, DisplayReservedIdsInfo)
 	EXPECT_NE(string::npos, s.find("5, 6"));
 }
 
+TEST(ScsictlDisplayTest, DisplayDelayProfilesInfo)
+{
+	ScsictlDisplay display;
+	PbDelayProfilesInfo info;
+
+	auto profile = info.add_profiles();
+	profile->set_initiator_id(7);
+	profile->set_profile("adaptive");
+	profile->set_delay(25);
+	profile = info.add_profiles();
+	profile->set_initiator_id(1);
+	profile->set_profile("default");
+	profile->set_delay(50);
+
+	const string s = display.DisplayDelayProfilesInfo(info);
+	EXPECT_NE(string::npos, s.find("1  default: 50 us"));
+	EXPECT_NE(string::npos, s.find("7  adaptive: 25 us"));
+	EXPECT_LT(s.find("1  default"), s.find("7  adaptive")) << "Profiles must be sorted by initiator ID";
+}
+
+TEST(ScsictlDisplayTest, DisplayCommandTraceInfo)
+{
+	ScsictlDisplay display;
+	PbCommandTraceInfo info;
+
+	string s = display.DisplayCommandTraceInfo(info);
+	EXPECT_NE(string::npos, s.find("No commands"));
+
+	auto record = info.add_records();
+	record->set_timestamp(1'000'000);
+	record->set_initiator_id(7);
+	record->set_id(1);
+	record->set_unit(0);
+	record->set_opcode(0x28);
+	record->set_lba(100);
+	record->set_length(8);
+	record->set_status(0x02);
+	record->set_selection_duration(2000);
+	record->set_command_duration(30'000);
+	record->set_data_duration(400'000);
+	record->set_status_duration(5000);
+	record = info.add_records();
+	record->set_timestamp(3'000'000);
+	record->set_opcode(0x00);
+
+	s = display.DisplayCommandTraceInfo(info);
+	EXPECT_NE(string::npos, s.find("+0 us  7 -> 1:0  $28  LBA 100, length 8, status $02  selection 2, command 30, data 400, status 5"));
+	EXPECT_NE(string::npos, s.find("+2000 us"));
+	EXPECT_NE(string::npos, s.find("$00"));
+
+	info.set_chrome_trace("{}");
+	EXPECT_EQ("{}\n", display.DisplayCommandTraceInfo(info));
+}
+
 TEST(ScsictlDisplayTest, DisplayNetworkInterfacesInfo)
 {
 	ScsictlDisplay display;
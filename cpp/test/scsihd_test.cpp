@@ -104,7 +104,7 @@ TEST(ScsiHdTest, SetUpModePages)
 TEST(ScsiHdTest, ModeSelect)
 {
 	MockSCSIHD hd({ 512 });
-	vector<int> cmd(10);
+	vector<uint8_t> cmd(10);
 	vector<uint8_t> buf(255);
 
 	hd.SetSectorSizeInBytes(512);
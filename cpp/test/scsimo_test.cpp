@@ -136,7 +136,7 @@ TEST(ScsiMoTest, TestAddVendorPage)
 TEST(ScsiMoTest, ModeSelect)
 {
 	MockSCSIMO mo(0);
-	vector<int> cmd(10);
+	vector<uint8_t> cmd(10);
 	vector<uint8_t> buf(255);
 
 	mo.SetSectorSizeInBytes(2048);
@@ -0,0 +1,65 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "mocks.h"
+#include "devices/scsihd.h"
+#include "scsireplay/scsireplay_core.h"
+#include "scsireplay/replay_controller.h"
+
+using namespace std;
+using namespace filesystem;
+
+TEST(ScsiReplayTest, Execute)
+{
+	NiceMock<MockBus> bus;
+	ReplayController controller(bus, 0);
+
+	const path filename = CreateTempFile(4096);
+	auto hd = make_shared<SCSIHD>(0, false, scsi_level::scsi_2);
+	hd->SetFilename(filename.string());
+	hd->Open();
+	EXPECT_TRUE(hd->Init({}));
+	EXPECT_TRUE(controller.AddDevice(hd));
+
+	CommandRecorder::command_t command = {};
+	command.initiator_id = 7;
+
+	// INQUIRY
+	command.cdb = { 0x12, 0x00, 0x00, 0x00, 0x24, 0x00 };
+	EXPECT_EQ(status::good, controller.Execute(command));
+	EXPECT_EQ(36, controller.GetBytesIn());
+
+	// WRITE(6) of 2 blocks, starting at block 1
+	command.cdb = { 0x0a, 0x00, 0x00, 0x01, 0x02, 0x00 };
+	command.data_out = { vector<uint8_t>(512, 0x11), vector<uint8_t>(512, 0x22) };
+	EXPECT_EQ(status::good, controller.Execute(command));
+	EXPECT_EQ(1024, controller.GetBytesOut());
+
+	// READ(6) of 2 blocks, starting at block 1
+	command.cdb = { 0x08, 0x00, 0x00, 0x01, 0x02, 0x00 };
+	command.data_out = {};
+	EXPECT_EQ(status::good, controller.Execute(command));
+	EXPECT_EQ(36 + 1024, controller.GetBytesIn());
+	EXPECT_EQ(0x22, controller.GetBuffer()[0]) << "The second written block must have been read";
+
+	// WRITE(6) with data out phase data missing in the recording
+	command.cdb = { 0x0a, 0x00, 0x00, 0x01, 0x02, 0x00 };
+	command.data_out = { vector<uint8_t>(512) };
+	EXPECT_EQ(status::check_condition, controller.Execute(command));
+	EXPECT_EQ(1024 + 512, controller.GetBytesOut());
+
+	// TEST UNIT READY for a missing LUN
+	command.cdb = { 0x00, 0x20, 0x00, 0x00, 0x00, 0x00 };
+	command.data_out = {};
+	command.lun = 1;
+	EXPECT_EQ(status::check_condition, controller.Execute(command));
+
+	hd->CleanUp();
+	remove(filename);
+}
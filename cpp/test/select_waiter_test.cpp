@@ -0,0 +1,180 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include "mocks.h"
+#include "piscsi/select_waiter.h"
+#include <chrono>
+
+using namespace std;
+
+static uint64_t GetStatistics(const MetricsRegistry& metrics, const string& key)
+{
+	for (const auto& statistics : metrics.GetStatistics()) {
+		if (statistics.key() == key) {
+			EXPECT_EQ(-1, statistics.id());
+			EXPECT_EQ(-1, statistics.unit());
+			return statistics.value();
+		}
+	}
+
+	ADD_FAILURE() << "Missing statistics item '" << key << "'";
+	return 0;
+}
+
+TEST(SelectWaiterTest, SetMode)
+{
+	MetricsRegistry metrics;
+	SelectWaiter waiter(metrics);
+
+	EXPECT_EQ(SelectWaiter::IsEventSupported() ? SelectWaiter::wait_mode::event : SelectWaiter::wait_mode::spin,
+			waiter.GetMode());
+
+	EXPECT_TRUE(waiter.SetMode("spin").empty());
+	EXPECT_EQ(SelectWaiter::wait_mode::spin, waiter.GetMode());
+	EXPECT_EQ("spin", waiter.GetDescription());
+	EXPECT_TRUE(waiter.SetMode("event").empty());
+	EXPECT_EQ(SelectWaiter::wait_mode::event, waiter.GetMode());
+	EXPECT_TRUE(waiter.SetMode("hybrid").empty());
+	EXPECT_EQ(SelectWaiter::wait_mode::hybrid, waiter.GetMode());
+	EXPECT_EQ(SelectWaiter::DEFAULT_SPIN_BUDGET, waiter.GetSpinBudget());
+	EXPECT_TRUE(waiter.SetMode("hybrid:250").empty());
+	EXPECT_EQ(250U, waiter.GetSpinBudget());
+	EXPECT_EQ("hybrid with a spin budget of 250 us", waiter.GetDescription());
+
+	EXPECT_FALSE(waiter.SetMode("").empty());
+	EXPECT_FALSE(waiter.SetMode("poll").empty());
+	EXPECT_FALSE(waiter.SetMode("spin:10").empty());
+	EXPECT_FALSE(waiter.SetMode("hybrid:").empty());
+	EXPECT_FALSE(waiter.SetMode("hybrid:-1").empty());
+	EXPECT_EQ(SelectWaiter::wait_mode::hybrid, waiter.GetMode()) << "An invalid mode must not change the mode";
+	EXPECT_EQ(250U, waiter.GetSpinBudget());
+}
+
+TEST(SelectWaiterTest, Spin)
+{
+	MockBus bus;
+	MetricsRegistry metrics;
+	SelectWaiter waiter(metrics);
+	waiter.SetMode("spin");
+
+	EXPECT_CALL(bus, PollSelectEvent).Times(0);
+	EXPECT_CALL(bus, Acquire).Times(3);
+	EXPECT_CALL(bus, GetSEL)
+		.WillOnce(testing::Return(false))
+		.WillOnce(testing::Return(false))
+		.WillOnce(testing::Return(true));
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_NE(0U, waiter.GetSelectTimestamp());
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(3U, GetStatistics(metrics, SelectWaiter::WAIT_SPIN_COUNT));
+	EXPECT_EQ(0U, GetStatistics(metrics, SelectWaiter::WAIT_EVENT_COUNT));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_LATENCY + "_count"));
+	EXPECT_EQ(GetStatistics(metrics, SelectWaiter::WAIT_LATENCY + "_sum"),
+			GetStatistics(metrics, SelectWaiter::WAIT_LATENCY_MAX));
+
+	// SEL was already asserted when the wait started, i.e. the latency is unknown
+	EXPECT_CALL(bus, Acquire);
+	EXPECT_CALL(bus, GetSEL).WillOnce(testing::Return(true));
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(2U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(4U, GetStatistics(metrics, SelectWaiter::WAIT_SPIN_COUNT));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_LATENCY + "_count"));
+
+	// Without a selection the wait must end in order to let the caller check whether to continue
+	EXPECT_CALL(bus, Acquire).WillRepeatedly(testing::Return(0));
+	EXPECT_CALL(bus, GetSEL).WillRepeatedly(testing::Return(false));
+	EXPECT_FALSE(waiter.Wait(bus));
+	EXPECT_NE(EINTR, errno);
+	EXPECT_EQ(2U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_LT(4U, GetStatistics(metrics, SelectWaiter::WAIT_SPIN_COUNT));
+	EXPECT_LE(10'000'000U, GetStatistics(metrics, SelectWaiter::WAIT_TIME));
+	EXPECT_LT(0U, GetStatistics(metrics, SelectWaiter::WAIT_CPU_TIME)) << "Spinning must cause CPU load";
+}
+
+TEST(SelectWaiterTest, Event)
+{
+	MockBus bus;
+	MetricsRegistry metrics;
+	SelectWaiter waiter(metrics);
+	waiter.SetMode("event");
+
+	const uint64_t now = chrono::duration_cast<chrono::nanoseconds>(
+			chrono::steady_clock::now().time_since_epoch()).count();
+
+	// An edge that occurred before the wait without SEL being asserted anymore must be skipped
+	EXPECT_CALL(bus, PollSelectEvent).Times(2).WillRepeatedly(testing::Return(true));
+	EXPECT_CALL(bus, GetSelectEventTimestamp)
+		.WillOnce(testing::Return(now - 1'000'000))
+		.WillOnce(testing::Return(now + 1'000'000'000));
+	EXPECT_CALL(bus, Acquire).Times(2);
+	EXPECT_CALL(bus, GetSEL).WillOnce(testing::Return(false));
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(2U, GetStatistics(metrics, SelectWaiter::WAIT_EVENT_COUNT));
+	EXPECT_EQ(0U, GetStatistics(metrics, SelectWaiter::WAIT_SPIN_COUNT));
+	EXPECT_EQ(0U, GetStatistics(metrics, SelectWaiter::WAIT_LATENCY_MAX)) << "A timestamp in the future has no latency";
+	EXPECT_LE(now, waiter.GetSelectTimestamp());
+	EXPECT_GT(now + 1'000'000'000, waiter.GetSelectTimestamp()) << "The detection time must be used";
+
+	// A stale edge must still result in a wakeup if SEL is asserted
+	EXPECT_CALL(bus, PollSelectEvent).WillOnce(testing::Return(true));
+	EXPECT_CALL(bus, GetSelectEventTimestamp).WillOnce(testing::Return(now - 1'000'000));
+	EXPECT_CALL(bus, Acquire);
+	EXPECT_CALL(bus, GetSEL).WillOnce(testing::Return(true));
+	EXPECT_TRUE(waiter.Wait(bus));
+
+	EXPECT_LT(now, waiter.GetSelectTimestamp()) << "The stale edge time must not be used";
+
+	// Without a timestamp the latency is unknown, but the wakeup counts
+	EXPECT_CALL(bus, PollSelectEvent).WillOnce(testing::Return(true));
+	EXPECT_CALL(bus, GetSelectEventTimestamp).WillOnce(testing::Return(0));
+	EXPECT_CALL(bus, Acquire);
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(3U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(0U, GetStatistics(metrics, SelectWaiter::WAIT_LATENCY + "_count"));
+
+	// The time of a current edge is the SEL timestamp
+	uint64_t edge = 0;
+	EXPECT_CALL(bus, PollSelectEvent).WillOnce(testing::Return(true));
+	EXPECT_CALL(bus, GetSelectEventTimestamp).WillOnce(testing::Invoke([&edge] {
+		edge = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+		return edge;
+	}));
+	EXPECT_CALL(bus, Acquire);
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(edge, waiter.GetSelectTimestamp());
+
+	EXPECT_CALL(bus, PollSelectEvent).WillOnce(testing::Return(false));
+	EXPECT_FALSE(waiter.Wait(bus));
+}
+
+TEST(SelectWaiterTest, Hybrid)
+{
+	MockBus bus;
+	MetricsRegistry metrics;
+	SelectWaiter waiter(metrics);
+	waiter.SetMode("hybrid:0");
+
+	// A zero budget still results in a single sample before blocking
+	EXPECT_CALL(bus, Acquire).WillRepeatedly(testing::Return(0));
+	EXPECT_CALL(bus, GetSEL).WillRepeatedly(testing::Return(false));
+	EXPECT_CALL(bus, PollSelectEvent).WillOnce(testing::Return(true));
+	EXPECT_CALL(bus, GetSelectEventTimestamp).WillOnce(testing::Return(0));
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_EVENT_COUNT));
+	EXPECT_LT(0U, GetStatistics(metrics, SelectWaiter::WAIT_SPIN_COUNT));
+
+	// A selection while spinning does not block
+	EXPECT_CALL(bus, GetSEL).WillOnce(testing::Return(true));
+	EXPECT_CALL(bus, PollSelectEvent).Times(0);
+	EXPECT_TRUE(waiter.Wait(bus));
+	EXPECT_EQ(2U, GetStatistics(metrics, SelectWaiter::WAIT_WAKEUP_COUNT));
+	EXPECT_EQ(1U, GetStatistics(metrics, SelectWaiter::WAIT_EVENT_COUNT));
+}
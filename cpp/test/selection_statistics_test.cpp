@@ -0,0 +1,80 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+//---------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include "controllers/selection_statistics.h"
+
+using namespace std;
+
+static uint64_t GetStatistics(const MetricsRegistry& metrics, int id, const string& key)
+{
+	for (const auto& s : metrics.GetStatistics()) {
+		if (s.id() == id && s.key() == key) {
+			EXPECT_EQ(-1, s.unit());
+			return s.value();
+		}
+	}
+
+	ADD_FAILURE() << "Missing statistics item '" << key << "' for ID " << id;
+	return 0;
+}
+
+TEST(SelectionStatisticsTest, Threshold)
+{
+	MetricsRegistry metrics;
+	SelectionStatistics statistics(metrics);
+	EXPECT_EQ(0U, statistics.GetWarningThreshold());
+	EXPECT_FALSE(statistics.IsAboveThreshold(UINT64_MAX)) << "Without threshold there must be no warning";
+
+	statistics.SetWarningThreshold(20);
+	EXPECT_EQ(20U, statistics.GetWarningThreshold());
+	EXPECT_FALSE(statistics.IsAboveThreshold(20'000));
+	EXPECT_TRUE(statistics.IsAboveThreshold(20'001));
+}
+
+TEST(SelectionStatisticsTest, Add)
+{
+	MetricsRegistry metrics;
+	SelectionStatistics statistics(metrics);
+	EXPECT_TRUE(metrics.GetStatistics().empty());
+
+	EXPECT_EQ(0U, statistics.Add(2)) << "A selection without SEL timestamp must be ignored";
+	EXPECT_TRUE(metrics.GetStatistics().empty());
+
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp() - 3'000);
+	const uint64_t latency = statistics.Add(2);
+	EXPECT_LE(3'000U, latency);
+	EXPECT_EQ(0U, statistics.Add(2)) << "The SEL timestamp must only be used once";
+
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp() - 50'000'000);
+	statistics.Add(2);
+
+	// A timestamp in the future must not result in an overflow
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp() + 1'000'000'000);
+	EXPECT_EQ(1U, statistics.Add(5));
+
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp());
+	EXPECT_EQ(0U, statistics.Add(8)) << "Invalid target IDs must be ignored";
+
+	EXPECT_EQ(2U, GetStatistics(metrics, 2, SelectionStatistics::SELECTION_LATENCY + "_count"));
+	EXPECT_LE(50'003'000U, GetStatistics(metrics, 2, SelectionStatistics::SELECTION_LATENCY + "_sum"));
+	EXPECT_LE(50'000'000U, GetStatistics(metrics, 2, SelectionStatistics::SELECTION_LATENCY_MAX));
+	EXPECT_EQ(1U, GetStatistics(metrics, 2, SelectionStatistics::SELECTION_LATENCY + "_le_67108863"));
+	EXPECT_EQ(1U, GetStatistics(metrics, 5, SelectionStatistics::SELECTION_LATENCY + "_count"));
+	EXPECT_EQ(1U, GetStatistics(metrics, 5, SelectionStatistics::SELECTION_LATENCY + "_le_1"));
+	for (const auto& s : metrics.GetStatistics()) {
+		EXPECT_NE(SelectionStatistics::SELECTION_THRESHOLD_EXCEEDED, s.key()) << "There is no threshold";
+	}
+
+	statistics.SetWarningThreshold(10'000);
+	statistics.SetSelectTimestamp(SelectionStatistics::GetTimestamp() - 20'000'000);
+	EXPECT_TRUE(statistics.IsAboveThreshold(statistics.Add(2)));
+	EXPECT_EQ(1U, GetStatistics(metrics, 2, SelectionStatistics::SELECTION_THRESHOLD_EXCEEDED));
+	EXPECT_EQ(0U, GetStatistics(metrics, 5, SelectionStatistics::SELECTION_THRESHOLD_EXCEEDED));
+}
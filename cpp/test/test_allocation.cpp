@@ -0,0 +1,50 @@
+//---------------------------------------------------------------------------
+//
+// SCSI Target Emulator PiSCSI
+// for Raspberry Pi
+//
+// Copyright (C) 2023 Uwe Seimet
+//
+// The replaced global allocation functions must not be visible to their callers, otherwise the compiler reports
+// the inlined malloc/operator delete pairs as mismatched.
+//
+//---------------------------------------------------------------------------
+
+#include "test_shared.h"
+#include <new>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+	// Per thread, i.e. threads of other tests that are still running do not affect the count
+	thread_local uint64_t allocation_count;
+}
+
+// Replaces the global allocation functions in order to count the allocations, the array and nothrow variants
+// are implemented in terms of these
+void *operator new(size_t size)
+{
+	allocation_count++;
+
+	if (void *p = malloc(size ? size : 1); p != nullptr) {
+		return p;
+	}
+
+	throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+uint64_t GetAllocationCount()
+{
+	return allocation_count;
+}
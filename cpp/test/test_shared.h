@@ -38,6 +38,9 @@ void DeleteTempFile(const string&);
 
 string ReadTempFileToString(const string& filename);
 
+// Number of heap allocations of the calling thread so far, for asserting that a code path does not allocate
+uint64_t GetAllocationCount();
+
 int GetInt16(const vector<byte>&, int);
 uint32_t GetInt32(const vector<byte>&, int);
 